@@ -19,6 +19,7 @@
 #include "ns3/flow-monitor-module.h"
 #include "ns3/config-store-module.h"
 #include "ns3/mobility-module.h"
+#include "ns3/hap-trace-context.h"
 #include <sstream>
 #include <iomanip>
 #include <iostream>
@@ -51,16 +52,6 @@ std::string GetNodeName(uint32_t id, NodeContainer gwNodes,
     return "Node_" + std::to_string(id);
 }
 
-uint32_t GetNodeIdFromContext(std::string context)
-{
-    std::string prefix = "/NodeList/";
-    size_t pos = context.find(prefix);
-    if (pos == std::string::npos) return 9999;
-    std::string sub = context.substr(pos + prefix.length());
-    size_t slashPos = sub.find("/");
-    return std::stoi(sub.substr(0, slashPos));
-}
-
 std::string IpToString(Ipv4Address addr)
 {
     std::ostringstream oss;
@@ -71,14 +62,14 @@ std::string IpToString(Ipv4Address addr)
 void Ipv4TxTrace(std::string context, Ptr<const Packet> packet, 
     Ptr<Ipv4> ipv4, uint32_t interface)
 {
-    uint32_t nodeId = GetNodeIdFromContext(context);
+    uint32_t nodeId = HapNodeIdFromContext(context);
     g_packetLastSender[packet->GetUid()] = nodeId;
 }
 
 void Ipv4RxTrace(std::string context, Ptr<const Packet> packet,
      Ptr<Ipv4> ipv4, uint32_t interface)
 {
-    uint32_t nodeId = GetNodeIdFromContext(context);
+    uint32_t nodeId = HapNodeIdFromContext(context);
     uint64_t uid = packet->GetUid();
     if (g_packetLastSender.find(uid) != g_packetLastSender.end()) {
         uint32_t senderId = g_packetLastSender[uid];
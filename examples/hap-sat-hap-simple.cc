@@ -8,6 +8,8 @@
 // - Ground-HAP Link: Uses WiFi (AdHoc mode).
 // - HAP-Satellite Link: Uses Ka-band Satellite Channel with specialized models.
 // - Traffic flows from Group 1 to Group 2 via the satellite backbone.
+// - With --scheduledRouting the HAPs route across the satellite from a contact
+//   plan (HapScheduledRouting): HAP 1 loses the satellite during the outage.
 //
 // CORRECTIONS APPLIED (v2 - Separate Frequencies & Restored Stats):
 // 1. Separated Uplink/Downlink channels for HAP_1 and HAP_2.
@@ -24,11 +26,19 @@
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/flow-monitor-module.h"
 #include "ns3/propagation-loss-model.h"
+#include "ns3/spectrum-module.h"
+#include "ns3/hap-range-transmit-filter.h"
+#include "ns3/hap-sat-link-channel.h"
+#include "ns3/hap-sat-link-helper.h"
+#include "ns3/hap-contact-plan.h"
+#include "ns3/hap-scheduled-routing-helper.h"
+#include "ns3/ipv4-list-routing-helper.h"
 #include <map>
 #include <iostream>
 #include <iomanip>
 #include <vector>
 #include <algorithm>
+#include <cmath>
 
 // For work with WiFi headers
 #include "ns3/wifi-mac-header.h"
@@ -163,6 +173,37 @@ void SetupDeviceTraces(NetDeviceContainer devices) {
     }
 }
 
+// --- Callbacks for the abstract HAP-Satellite links ---
+
+void SatLinkTxCallback(uint32_t srcId, uint32_t dstId, Ptr<const Packet> packet) {
+    g_flowStats[std::make_pair(srcId, dstId)].txPackets++;
+}
+
+void SatLinkRxCallback(uint32_t srcId, uint32_t dstId, Ptr<const Packet> packet) {
+    g_flowStats[std::make_pair(srcId, dstId)].rxPackets++;
+}
+
+void SatLinkRxDropCallback(uint32_t srcId, uint32_t dstId, Ptr<const Packet> packet) {
+    g_flowStats[std::make_pair(srcId, dstId)].rxDropped++;
+}
+
+void SetupSatLinkTraces(NetDeviceContainer devices) {
+    for (uint32_t i = 0; i < devices.GetN(); ++i) {
+        Ptr<HapSatLinkNetDevice> dev = DynamicCast<HapSatLinkNetDevice>(devices.Get(i));
+        if (dev) {
+            Ptr<HapSatLinkChannel> channel = DynamicCast<HapSatLinkChannel>(dev->GetChannel());
+            uint32_t selfId = dev->GetNode()->GetId();
+            uint32_t peerId = channel->GetPeer(dev)->GetNode()->GetId();
+            dev->TraceConnectWithoutContext("MacTx",
+                MakeBoundCallback(&SatLinkTxCallback, selfId, peerId));
+            dev->TraceConnectWithoutContext("MacRx",
+                MakeBoundCallback(&SatLinkRxCallback, peerId, selfId));
+            dev->TraceConnectWithoutContext("PhyRxDrop",
+                MakeBoundCallback(&SatLinkRxDropCallback, peerId, selfId));
+        }
+    }
+}
+
 // --- Traffic Generation Callbacks ---
 void ReceivePacket(Ptr<Socket> socket)
 {
@@ -199,6 +240,39 @@ std::string GetNodeNameByIp(Ipv4Address ip, NodeContainer nodes) {
     return "Unknown";
 }
 
+// --- Ground channel on the spectrum framework ---
+// Same delay and loss models as the YANS ground channels. YansWifiChannel
+// schedules a reception for every PHY of the channel and has no hook to skip
+// one, so reception culling needs this channel: with culling a range filter
+// drops the receivers farther than cullingRange before any event is scheduled.
+// cullingRange 0 takes the link budget range, capped at the radio horizon.
+Ptr<SpectrumChannel> CreateSpectrumGroundChannel(double referenceLoss, double txPowerDbm,
+                                                 bool culling, double cullingRange,
+                                                 double horizon,
+                                                 Ptr<HapRangeTransmitFilter>& filter) {
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetAttribute("Exponent", DoubleValue(2.0));
+    loss->SetAttribute("ReferenceDistance", DoubleValue(1.0));
+    loss->SetAttribute("ReferenceLoss", DoubleValue(referenceLoss));
+
+    Ptr<MultiModelSpectrumChannel> channel = CreateObject<MultiModelSpectrumChannel>();
+    channel->AddPropagationLossModel(loss);
+    channel->SetPropagationDelayModel(CreateObject<ConstantSpeedPropagationDelayModel>());
+    if (!culling) {
+        return channel;
+    }
+
+    // -101 dBm is the default WifiPhy RxSensitivity
+    double range = cullingRange > 0
+                       ? cullingRange
+                       : HapRangeTransmitFilter::GetRange(loss, txPowerDbm, -101.0, horizon);
+    filter = CreateObject<HapRangeTransmitFilter>();
+    filter->SetAttribute("MaxRange", DoubleValue(range));
+    channel->AddSpectrumTransmitFilter(filter);
+    NS_LOG_UNCOND("Culling range: " << range / 1000 << " km");
+    return channel;
+}
+
 int 
 main (int argc, char *argv[])
 {
@@ -210,6 +284,18 @@ main (int argc, char *argv[])
   uint32_t numPackets{1000};
   Time interPacketInterval{"265ms"};
   bool verbose = false;
+  bool spectrumGround = false;
+  bool culling = false;
+  double cullingRange{0.0};           // meters, 0 for the link budget range
+  uint32_t extraGroups{0};
+  double extraGroupDistance{1500000.0}; // meters
+  bool wifiSatLinks = false;
+  std::string satDataRate("100Mbps");
+  uint32_t satBatchSize{16};
+  bool scheduledRouting = false;
+  std::string contactPlan;
+  Time outageStart{"60s"};
+  Time outageDuration{"30s"};
   
   double hight{20000.0};    // meters
   double Pdbm{26.};       // WiFi TX Power (dBm)
@@ -247,7 +333,23 @@ main (int argc, char *argv[])
   cmd.AddValue("interval", "interval between packets", interPacketInterval);
   cmd.AddValue("verbose", "turn on logs", verbose);
   cmd.AddValue("hight", "HAP height (m)", hight);
+  cmd.AddValue("wifiSatLinks", "Emulate the Ka-band links with 802.11a at 6 Mbps instead of HapSatLinkNetDevice", wifiSatLinks);
+  cmd.AddValue("satDataRate", "Capacity of the abstract HAP-Satellite links", satDataRate);
+  cmd.AddValue("satBatchSize", "Frames sent as one burst on the abstract HAP-Satellite links", satBatchSize);
+  cmd.AddValue("spectrumGround", "Use SpectrumWifiPhy on spectrum channels for the ground links instead of YANS", spectrumGround);
+  cmd.AddValue("culling", "Ground channels deliver only to receivers within cullingRange (needs spectrumGround)", culling);
+  cmd.AddValue("cullingRange", "Culling range (m), 0 for the link budget range capped at the radio horizon", cullingRange);
+  cmd.AddValue("extraGroups", "Idle HAP groups added to ground channel A, extraGroupDistance apart", extraGroups);
+  cmd.AddValue("extraGroupDistance", "Distance between the extra HAP groups (m)", extraGroupDistance);
+  cmd.AddValue("scheduledRouting", "Route the HAP traffic across the satellite only while in contact, with HapScheduledRouting", scheduledRouting);
+  cmd.AddValue("contactPlan", "Contact plan of the HAPs with the satellite (satId 0), built from the outage options if empty", contactPlan);
+  cmd.AddValue("outageStart", "Start of the HAP 1 satellite outage in the built contact plan", outageStart);
+  cmd.AddValue("outageDuration", "Duration of the HAP 1 satellite outage in the built contact plan", outageDuration);
   cmd.Parse(argc, argv);
+  NS_ABORT_MSG_IF(outageStart <= Seconds(0) || outageDuration <= Seconds(0),
+                  "outageStart and outageDuration must be positive");
+  NS_ABORT_MSG_IF(culling && !spectrumGround,
+                  "culling needs spectrumGround: YansWifiChannel cannot skip a receiver");
 
   std::cout << "Topology: Ground WiFi <-> HAP (" << hight/1000
    << "km) <-> GEO Sat <-> HAP ("
@@ -283,9 +385,15 @@ main (int argc, char *argv[])
   NS_LOG_UNCOND("TX/RX ant gain: " << antGain << " dBi");  
   NS_LOG_UNCOND("Atmospheric Path Loss Calculations for HAP 1, HAP 2 to Ground WiFi: " << totalAtmosphericLossGround << " dB");  
 
+  // Radio horizon between two HAPs, with the 4/3 effective Earth radius
+  double horizon = 2 * std::sqrt(2 * 4.0 / 3.0 * 6371000.0 * hight);
+  Ptr<HapRangeTransmitFilter> filterA;
+  Ptr<HapRangeTransmitFilter> filterB;
   WifiHelper wifiA;
   wifiA.SetStandard(WIFI_STANDARD_80211b);
-  YansWifiPhyHelper wifiPhyA;
+  YansWifiPhyHelper yansPhyA;
+  SpectrumWifiPhyHelper spectrumPhyA;
+  WifiPhyHelper& wifiPhyA = spectrumGround ? static_cast<WifiPhyHelper&>(spectrumPhyA) : yansPhyA;
   wifiPhyA.Set("TxGain", DoubleValue(antGain));
   wifiPhyA.Set("RxGain", DoubleValue(antGain));
   wifiPhyA.Set("TxPowerStart", DoubleValue(Pdbm));
@@ -296,7 +404,13 @@ main (int argc, char *argv[])
                        "Exponent", DoubleValue(2.0),
                        "ReferenceDistance", DoubleValue(1.0),
                        "ReferenceLoss", DoubleValue(40.0 + totalAtmosphericLossGround));
-  wifiPhyA.SetChannel(wifiChannelA.Create());
+  if (spectrumGround) {
+      spectrumPhyA.SetChannel(CreateSpectrumGroundChannel(40.0 + totalAtmosphericLossGround,
+                                                          Pdbm + 2 * antGain, culling,
+                                                          cullingRange, horizon, filterA));
+  } else {
+      yansPhyA.SetChannel(wifiChannelA.Create());
+  }
 
   WifiMacHelper wifiMacA;
   wifiA.SetRemoteStationManager("ns3::ConstantRateWifiManager",
@@ -306,7 +420,9 @@ main (int argc, char *argv[])
 
   WifiHelper wifiB;
   wifiB.SetStandard(WIFI_STANDARD_80211a);
-  YansWifiPhyHelper wifiPhyB;
+  YansWifiPhyHelper yansPhyB;
+  SpectrumWifiPhyHelper spectrumPhyB;
+  WifiPhyHelper& wifiPhyB = spectrumGround ? static_cast<WifiPhyHelper&>(spectrumPhyB) : yansPhyB;
   wifiPhyB.Set("TxGain", DoubleValue(antGain));
   wifiPhyB.Set("RxGain", DoubleValue(antGain));
   wifiPhyB.Set("TxPowerStart", DoubleValue(Pdbm));
@@ -317,7 +433,13 @@ main (int argc, char *argv[])
                                   "Exponent", DoubleValue(2.0),
                                   "ReferenceDistance", DoubleValue(1.0),
                                   "ReferenceLoss", DoubleValue(46.7 + totalAtmosphericLossGround));
-  wifiPhyB.SetChannel(wifiChannelB.Create());
+  if (spectrumGround) {
+      spectrumPhyB.SetChannel(CreateSpectrumGroundChannel(46.7 + totalAtmosphericLossGround,
+                                                          Pdbm + 2 * antGain, culling,
+                                                          cullingRange, horizon, filterB));
+  } else {
+      yansPhyB.SetChannel(wifiChannelB.Create());
+  }
   WifiMacHelper wifiMacB;
   wifiB.SetRemoteStationManager("ns3::ConstantRateWifiManager",
                                 "DataMode", StringValue(phyModeB),
@@ -410,42 +532,90 @@ main (int argc, char *argv[])
   NetDeviceContainer wifiDevicesA = wifiA.Install(wifiPhyA, wifiMacA, NodeContainer(nodes.Get(HAP_1), nodes.Get(UT_1_1), nodes.Get(UT_1_2)));
   NetDeviceContainer wifiDevicesB = wifiB.Install(wifiPhyB, wifiMacB, NodeContainer(nodes.Get(HAP_2), nodes.Get(UT_2_1), nodes.Get(UT_2_2)));
 
+  // Idle HAP groups beyond the horizon on channel A: without culling every
+  // frame of group 1 is still delivered to each of their PHYs
+  NodeContainer extraNodes;
+  extraNodes.Create(3 * extraGroups);
+  wifiA.Install(wifiPhyA, wifiMacA, extraNodes);
+  MobilityHelper extraMobility;
+  Ptr<ListPositionAllocator> extraPositions = CreateObject<ListPositionAllocator>();
+  for (uint32_t group = 1; group <= extraGroups; ++group) {
+      double y = group * extraGroupDistance;
+      extraPositions->Add(Vector(0.0, y, hight));                // HAP
+      extraPositions->Add(Vector(-groundDistance / 2, y, 0.0));  // UT 1
+      extraPositions->Add(Vector(groundDistance / 2, y, 0.0));   // UT 2
+  }
+  extraMobility.SetPositionAllocator(extraPositions);
+  extraMobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+  extraMobility.Install(extraNodes);
+
   // Satellite Devices Containers
   NetDeviceContainer allSatDevices;
   
-  // --- Install HAP 1 Links ---
-  NetDeviceContainer hap1UpDev = wifiSat.Install(wifiPhySatUp_H1, wifiMacSat, nodes.Get(HAP_1));
-  
-  wifiPhySatUp_H1.Set("RxGain", DoubleValue(satAntGain)); 
-  wifiPhySatUp_H1.Set("TxGain", DoubleValue(satAntGain)); 
-  wifiPhySatUp_H1.Set("TxPowerStart", DoubleValue(satTxPower));
-  wifiPhySatUp_H1.Set("TxPowerEnd", DoubleValue(satTxPower));
-  NetDeviceContainer satRxDev_H1 = wifiSat.Install(wifiPhySatUp_H1, wifiMacSat, nodes.Get(SATELLITE));
-  
-  NetDeviceContainer satTxDev_H1 = wifiSat.Install(wifiPhySatDown_H1, wifiMacSat, nodes.Get(SATELLITE));
-  
-  wifiPhySatDown_H1.Set("TxGain", DoubleValue(hapSatAntGain));
-  wifiPhySatDown_H1.Set("RxGain", DoubleValue(hapSatAntGain));
-  wifiPhySatDown_H1.Set("TxPowerStart", DoubleValue(hapSatTxPower));
-  wifiPhySatDown_H1.Set("TxPowerEnd", DoubleValue(hapSatTxPower));
-  NetDeviceContainer hap1DownDev = wifiSat.Install(wifiPhySatDown_H1, wifiMacSat, nodes.Get(HAP_1));
-
-  // --- Install HAP 2 Links ---
-  NetDeviceContainer hap2UpDev = wifiSat.Install(wifiPhySatUp_H2, wifiMacSat, nodes.Get(HAP_2));
-  
-  wifiPhySatUp_H2.Set("RxGain", DoubleValue(satAntGain)); 
-  wifiPhySatUp_H2.Set("TxGain", DoubleValue(satAntGain));
-  wifiPhySatUp_H2.Set("TxPowerStart", DoubleValue(satTxPower));
-  wifiPhySatUp_H2.Set("TxPowerEnd", DoubleValue(satTxPower));
-  NetDeviceContainer satRxDev_H2 = wifiSat.Install(wifiPhySatUp_H2, wifiMacSat, nodes.Get(SATELLITE));
-  
-  NetDeviceContainer satTxDev_H2 = wifiSat.Install(wifiPhySatDown_H2, wifiMacSat, nodes.Get(SATELLITE));
-  
-  wifiPhySatDown_H2.Set("TxGain", DoubleValue(hapSatAntGain));
-  wifiPhySatDown_H2.Set("RxGain", DoubleValue(hapSatAntGain));
-  wifiPhySatDown_H2.Set("TxPowerStart", DoubleValue(hapSatTxPower));
-  wifiPhySatDown_H2.Set("TxPowerEnd", DoubleValue(hapSatTxPower));
-  NetDeviceContainer hap2DownDev = wifiSat.Install(wifiPhySatDown_H2, wifiMacSat, nodes.Get(HAP_2));
+  NetDeviceContainer hap1UpDev, satRxDev_H1, satTxDev_H1, hap1DownDev;
+  NetDeviceContainer hap2UpDev, satRxDev_H2, satTxDev_H2, hap2DownDev;
+  if (wifiSatLinks) {
+      // --- Install HAP 1 Links ---
+      hap1UpDev = wifiSat.Install(wifiPhySatUp_H1, wifiMacSat, nodes.Get(HAP_1));
+
+      wifiPhySatUp_H1.Set("RxGain", DoubleValue(satAntGain)); 
+      wifiPhySatUp_H1.Set("TxGain", DoubleValue(satAntGain)); 
+      wifiPhySatUp_H1.Set("TxPowerStart", DoubleValue(satTxPower));
+      wifiPhySatUp_H1.Set("TxPowerEnd", DoubleValue(satTxPower));
+      satRxDev_H1 = wifiSat.Install(wifiPhySatUp_H1, wifiMacSat, nodes.Get(SATELLITE));
+
+      satTxDev_H1 = wifiSat.Install(wifiPhySatDown_H1, wifiMacSat, nodes.Get(SATELLITE));
+
+      wifiPhySatDown_H1.Set("TxGain", DoubleValue(hapSatAntGain));
+      wifiPhySatDown_H1.Set("RxGain", DoubleValue(hapSatAntGain));
+      wifiPhySatDown_H1.Set("TxPowerStart", DoubleValue(hapSatTxPower));
+      wifiPhySatDown_H1.Set("TxPowerEnd", DoubleValue(hapSatTxPower));
+      hap1DownDev = wifiSat.Install(wifiPhySatDown_H1, wifiMacSat, nodes.Get(HAP_1));
+
+      // --- Install HAP 2 Links ---
+      hap2UpDev = wifiSat.Install(wifiPhySatUp_H2, wifiMacSat, nodes.Get(HAP_2));
+
+      wifiPhySatUp_H2.Set("RxGain", DoubleValue(satAntGain)); 
+      wifiPhySatUp_H2.Set("TxGain", DoubleValue(satAntGain));
+      wifiPhySatUp_H2.Set("TxPowerStart", DoubleValue(satTxPower));
+      wifiPhySatUp_H2.Set("TxPowerEnd", DoubleValue(satTxPower));
+      satRxDev_H2 = wifiSat.Install(wifiPhySatUp_H2, wifiMacSat, nodes.Get(SATELLITE));
+
+      satTxDev_H2 = wifiSat.Install(wifiPhySatDown_H2, wifiMacSat, nodes.Get(SATELLITE));
+
+      wifiPhySatDown_H2.Set("TxGain", DoubleValue(hapSatAntGain));
+      wifiPhySatDown_H2.Set("RxGain", DoubleValue(hapSatAntGain));
+      wifiPhySatDown_H2.Set("TxPowerStart", DoubleValue(hapSatTxPower));
+      wifiPhySatDown_H2.Set("TxPowerEnd", DoubleValue(hapSatTxPower));
+      hap2DownDev = wifiSat.Install(wifiPhySatDown_H2, wifiMacSat, nodes.Get(HAP_2));
+  } else {
+      // Abstract Ka-band links: capacity, geometric delay and link budget only.
+      // The HAP end transmits on the uplink, the satellite end on the downlink.
+      HapSatLinkHelper satLink;
+      satLink.SetDeviceAttribute("DataRate", DataRateValue(DataRate(satDataRate)));
+      satLink.SetDeviceAttribute("MaxBatchSize", UintegerValue(satBatchSize));
+      auto installSatLink = [&](uint32_t hap, double frequency) {
+          satLink.SetChannelAttribute("Frequency", DoubleValue(frequency));
+          NetDeviceContainer link = satLink.Install(nodes.Get(hap), nodes.Get(SATELLITE));
+          link.Get(0)->SetAttribute("TxPower", DoubleValue(hapSatTxPower));
+          link.Get(0)->SetAttribute("AntennaGain", DoubleValue(hapSatAntGain));
+          link.Get(1)->SetAttribute("TxPower", DoubleValue(satTxPower));
+          link.Get(1)->SetAttribute("AntennaGain", DoubleValue(satAntGain));
+          return link;
+      };
+      NetDeviceContainer link = installSatLink(HAP_1, freqHap1Up);
+      hap1UpDev.Add(link.Get(0));
+      satRxDev_H1.Add(link.Get(1));
+      link = installSatLink(HAP_1, freqHap1Down);
+      hap1DownDev.Add(link.Get(0));
+      satTxDev_H1.Add(link.Get(1));
+      link = installSatLink(HAP_2, freqHap2Up);
+      hap2UpDev.Add(link.Get(0));
+      satRxDev_H2.Add(link.Get(1));
+      link = installSatLink(HAP_2, freqHap2Down);
+      hap2DownDev.Add(link.Get(0));
+      satTxDev_H2.Add(link.Get(1));
+  }
 
   // Collect all Sat devices
   allSatDevices.Add(hap1UpDev);
@@ -467,9 +637,19 @@ main (int argc, char *argv[])
   SetupDeviceTraces(wifiDevicesA);
   SetupDeviceTraces(wifiDevicesB);
   SetupDeviceTraces(allSatDevices);
+  SetupSatLinkTraces(allSatDevices);
 
   // --- 6. Install Internet Stack & IP ---
   InternetStackHelper stack;
+  if (scheduledRouting) {
+      // Scheduled routes first, the static ones keep the local and fixed routes
+      Ipv4StaticRoutingHelper staticRouting;
+      HapScheduledRoutingHelper scheduledRoutingHelper;
+      Ipv4ListRoutingHelper listRouting;
+      listRouting.Add(staticRouting, 0);
+      listRouting.Add(scheduledRoutingHelper, 10);
+      stack.SetRoutingHelper(listRouting);
+  }
   stack.Install (nodes);
   Ipv4AddressHelper address;
 
@@ -548,6 +728,14 @@ main (int argc, char *argv[])
   double oxygenLoss = oxygenAbsorption * gasPathLength;
   double vaporLoss = waterVaporAbsorption * gasPathLength;
   double totalAtmosphericLoss = rainLoss + oxygenLoss + vaporLoss;
+
+  // The abstract links apply the atmospheric losses on top of free space
+  for (uint32_t i = 0; i < allSatDevices.GetN(); ++i) {
+      Ptr<HapSatLinkChannel> channel = DynamicCast<HapSatLinkChannel>(allSatDevices.Get(i)->GetChannel());
+      if (channel) {
+          channel->SetAttribute("AdditionalLoss", DoubleValue(totalAtmosphericLoss));
+      }
+  }
   
   NS_LOG_UNCOND("\nPath Loss Calculations (Sat -> HAP 1, HAP 2):");
   NS_LOG_UNCOND("FSPL: " << fsplHap1Sat << " dB");
@@ -575,19 +763,49 @@ main (int argc, char *argv[])
   Ptr<Ipv4> ipv4Ut2_1 = nodes.Get(UT_2_1)->GetObject<Ipv4>();
   staticRoutingHelper.GetStaticRouting(ipv4Ut2_1)->SetDefaultRoute(interfacesWifiB.GetAddress(0), ipv4Ut2_1->GetInterfaceForAddress(interfacesWifiB.GetAddress(1)));
 
+  double simTime = 1.0 + (numPackets * interPacketInterval.GetSeconds()) + 5.0;
+
   // --- HAP 1 Routing ---
   Ptr<Ipv4> ipv4Hap1 = nodes.Get(HAP_1)->GetObject<Ipv4>();
-  Ptr<Ipv4StaticRouting> srHap1 = staticRoutingHelper.GetStaticRouting(ipv4Hap1);
-  srHap1->AddNetworkRouteTo(Ipv4Address("10.1.2.0"), Ipv4Mask("255.255.255.0"), 
-                            interfacesSatUp.GetAddress(1), 
-                            ipv4Hap1->GetInterfaceForAddress(interfacesSatUp.GetAddress(0)));
+  uint32_t hap1SatIf = ipv4Hap1->GetInterfaceForAddress(interfacesSatUp.GetAddress(0));
 
   // --- HAP 2 Routing ---
   Ptr<Ipv4> ipv4Hap2 = nodes.Get(HAP_2)->GetObject<Ipv4>();
-  Ptr<Ipv4StaticRouting> srHap2 = staticRoutingHelper.GetStaticRouting(ipv4Hap2);
-  srHap2->AddNetworkRouteTo(Ipv4Address("10.1.1.0"), Ipv4Mask("255.255.255.0"), 
-                            interfacesSatUp.GetAddress(3), 
-                            ipv4Hap2->GetInterfaceForAddress(interfacesSatUp.GetAddress(2)));
+  uint32_t hap2SatIf = ipv4Hap2->GetInterfaceForAddress(interfacesSatUp.GetAddress(2));
+
+  if (scheduledRouting) {
+      // The satellite is orbiter 0: a HAP forwards across it only while in contact
+      Ptr<HapContactPlan> plan = CreateObject<HapContactPlan>();
+      if (contactPlan.empty()) {
+          Time end = Seconds(simTime);
+          Time outageEnd = outageStart + outageDuration;
+          plan->Reset(1, 1, Seconds(0), Seconds(1), end);
+          uint32_t hap1 = plan->AddObserver(nodes.Get(HAP_1)->GetId(), HapContactPlan::ROLE_HAP);
+          uint32_t hap2 = plan->AddObserver(nodes.Get(HAP_2)->GetId(), HapContactPlan::ROLE_HAP);
+          plan->AddInterval(hap1, 0, Seconds(0), outageStart);
+          plan->AddRankingEpoch(hap1, Seconds(0), {0});
+          plan->AddRankingEpoch(hap1, outageStart, {});
+          if (outageEnd < end) {
+              plan->AddInterval(hap1, 0, outageEnd, end);
+              plan->AddRankingEpoch(hap1, outageEnd, {0});
+          }
+          plan->AddInterval(hap2, 0, Seconds(0), end);
+          plan->AddRankingEpoch(hap2, Seconds(0), {0});
+      } else {
+          plan->Load(contactPlan);
+      }
+      HapScheduledRoutingHelper::GetScheduledRouting(ipv4Hap1)->AddContactPlanRoutes(
+          plan, nodes.Get(HAP_1)->GetId(), Ipv4Address("10.1.2.0"), Ipv4Mask("255.255.255.0"),
+          {{0, {interfacesSatUp.GetAddress(1), hap1SatIf}}});
+      HapScheduledRoutingHelper::GetScheduledRouting(ipv4Hap2)->AddContactPlanRoutes(
+          plan, nodes.Get(HAP_2)->GetId(), Ipv4Address("10.1.1.0"), Ipv4Mask("255.255.255.0"),
+          {{0, {interfacesSatUp.GetAddress(3), hap2SatIf}}});
+  } else {
+      staticRoutingHelper.GetStaticRouting(ipv4Hap1)->AddNetworkRouteTo(
+          Ipv4Address("10.1.2.0"), Ipv4Mask("255.255.255.0"), interfacesSatUp.GetAddress(1), hap1SatIf);
+      staticRoutingHelper.GetStaticRouting(ipv4Hap2)->AddNetworkRouteTo(
+          Ipv4Address("10.1.1.0"), Ipv4Mask("255.255.255.0"), interfacesSatUp.GetAddress(3), hap2SatIf);
+  }
 
   // --- Satellite Routing ---
   Ptr<Ipv4> ipv4Sat = nodes.Get(SATELLITE)->GetObject<Ipv4>();
@@ -621,7 +839,6 @@ main (int argc, char *argv[])
   Simulator::ScheduleWithContext(source->GetNode()->GetId(),
           Seconds(1.0), &GenerateTraffic, source, packetSize, numPackets, interPacketInterval);
 
-  double simTime = 1.0 + (numPackets * interPacketInterval.GetSeconds()) + 5.0;
   Simulator::Stop(Seconds(simTime));
   Simulator::Run();
 
@@ -732,6 +949,11 @@ main (int argc, char *argv[])
   }
   std::cout << std::string(109, '-') << std::endl;
 
+  if (culling) {
+      std::cout << "\nGround receptions culled: " << filterA->GetNCulled() + filterB->GetNCulled()
+                << ", delivered: " << filterA->GetNPassed() + filterB->GetNPassed() << std::endl;
+  }
+
   monitor->SerializeToXmlFile("hap-sat-ka-band-stats.xml", true, true);
   std::cout << "\n=== End of Simulation ===" << std::endl;
 
@@ -12,15 +12,21 @@
 #include "ns3/flow-monitor-module.h"
 #include "ns3/config-store-module.h"
 #include "ns3/mobility-module.h"
-#include "ns3/system-path.h"
+#include "ns3/hap-beam-set-helper.h"
+#include "ns3/hap-cbr-source.h"
+#include "ns3/hap-gateway-association-index.h"
+#include "ns3/hap-scenario-source.h"
+#include "ns3/hap-telemetry-publisher.h"
+#include "ns3/hap-trace-context.h"
+#include "ns3/hap-trace-replay.h"
+#include "ns3/hap-traffic-matrix.h"
+#include "ns3/hap-window-aggregator.h"
 #include <sstream>
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <vector>
 #include <algorithm>
-#include <sys/stat.h>
-#include <unistd.h>
 
 using namespace ns3;
 
@@ -28,6 +34,11 @@ NS_LOG_COMPONENT_DEFINE("HapSatHap");
 
 std::map<uint64_t, uint32_t> g_packetLastSender;
 std::map<std::pair<uint32_t, uint32_t>, uint32_t> g_hopStats;
+Ptr<HapWindowAggregator> g_utRxThroughput;
+std::map<uint32_t, uint32_t> g_utRxSeries; // aggregator series by UT node id
+Ptr<HapTelemetryPublisher> g_telemetry;
+uint32_t g_telemetryTx = 0;
+uint32_t g_telemetryRx = 0;
 
 std::string GetNodeName(uint32_t id, NodeContainer gwNodes,
      NodeContainer userNodes, NodeContainer satNodes, NodeContainer utNodes)
@@ -78,16 +89,6 @@ std::string GetNodeName(uint32_t id, NodeContainer gwNodes,
 }
 
 
-uint32_t GetNodeIdFromContext(std::string context)
-{
-    std::string prefix = "/NodeList/";
-    size_t pos = context.find(prefix);
-    if (pos == std::string::npos) return 9999;
-    std::string sub = context.substr(pos + prefix.length());
-    size_t slashPos = sub.find("/");
-    return std::stoi(sub.substr(0, slashPos));
-}
-
 std::string IpToString(Ipv4Address addr)
 {
     std::ostringstream oss;
@@ -98,14 +99,17 @@ std::string IpToString(Ipv4Address addr)
 void Ipv4TxTrace(std::string context, Ptr<const Packet> packet, 
     Ptr<Ipv4> ipv4, uint32_t interface)
 {
-    uint32_t nodeId = GetNodeIdFromContext(context);
+    uint32_t nodeId = HapNodeIdFromContext(context);
     g_packetLastSender[packet->GetUid()] = nodeId;
+    if (g_telemetry) {
+        g_telemetry->Increment(g_telemetryTx);
+    }
 }
 
 void Ipv4RxTrace(std::string context, Ptr<const Packet> packet,
      Ptr<Ipv4> ipv4, uint32_t interface)
 {
-    uint32_t nodeId = GetNodeIdFromContext(context);
+    uint32_t nodeId = HapNodeIdFromContext(context);
     uint64_t uid = packet->GetUid();
     if (g_packetLastSender.find(uid) != g_packetLastSender.end()) {
         uint32_t senderId = g_packetLastSender[uid];
@@ -113,6 +117,15 @@ void Ipv4RxTrace(std::string context, Ptr<const Packet> packet,
             g_hopStats[std::make_pair(senderId, nodeId)]++;
         }
     }
+    if (g_telemetry) {
+        g_telemetry->Increment(g_telemetryRx);
+    }
+    if (g_utRxThroughput) {
+        auto series = g_utRxSeries.find(nodeId);
+        if (series != g_utRxSeries.end()) {
+            g_utRxThroughput->Add(series->second, packet->GetSize() * 8.0);
+        }
+    }
 }
 
 void ReceivePacket(Ptr<Socket> socket)
@@ -120,99 +133,64 @@ void ReceivePacket(Ptr<Socket> socket)
     while (socket->Recv()) { }
 }
 
-static void GenerateTraffic(Ptr<Socket> socket, uint32_t pktSize,
-     uint32_t pktCount, Time pktInterval)
-{
-    if (pktCount > 0) {
-        socket->Send(Create<Packet>(pktSize));
-        Simulator::Schedule(pktInterval, &GenerateTraffic, socket,
-            pktSize, pktCount - 1, pktInterval);
-    } else {
-        socket->Close();
-    }
-}
-
-
-int MakeLinkToScenario(std::string myScenarioName)
-{
-// === PATH FIXING (Absolute paths) ===
-    
-    // 1. Get the project root directory 
-    // (which is also the Current Working Directory when running via ./ns3)
-    char buffer[1024];
-    std::string ns3Root;
-    if (getcwd(buffer, sizeof(buffer)) != nullptr) {
-        ns3Root = buffer;
-    } else {
-        std::cerr << "Error getting current directory" << std::endl;
-        return 1;
-    }
-    std::cout << "NS-3 Root detected: " << ns3Root << std::endl;
-
-    // 2. Form the ABSOLUTE path to OUR scenario folder (source)
-    // Path: [ROOT]/contrib/sibgu-hap/data/scenarios/geo-33E-hap
-    std::string sourceScenarioPath = SystemPath::Append(ns3Root, 
-        "contrib/sibgu-hap/data/scenarios/" + myScenarioName);
-
-    // Check if this folder exists
-    struct stat info;
-    if (stat(sourceScenarioPath.c_str(), &info) != 0) {
-        std::cerr << "ERROR: Your custom scenario not found at: " 
-        << sourceScenarioPath << std::endl;
-        return 1;
-    }
-    std::cout << "Custom scenario found: " << sourceScenarioPath << std::endl;
-
-    // 3. Form the ABSOLUTE path to the folder the module LOOKS AT (target folder)
-    // Where we will place a link to our scenario folder.
-    // Path: [ROOT]/contrib/satellite/data/scenarios
-    std::string systemScenarioDir = SystemPath::Append(ns3Root, 
-        "contrib/satellite/data/scenarios");
-
-    // Check if the standard folder exists (should be in any normal installation)
-    if (stat(systemScenarioDir.c_str(), &info) != 0) {
-        std::cerr << "ERROR: Standard satellite scenario folder not found at: " 
-        << systemScenarioDir << std::endl;
-        std::cerr << "Check your NS-3 installation." << std::endl;
-        return 1;
-    }
-    std::cout << "System scenario folder found: " << systemScenarioDir << std::endl;
-
-    // 4. Form the full path to the future link
-    std::string linkPath = SystemPath::Append(systemScenarioDir, myScenarioName);
-
-    // 5. Remove the old link if it remains from the previous run
-    unlink(linkPath.c_str());
-
-    // 6. Create a symbolic link
-    // Create a link file inside the standard folder pointing to our scenario folder
-    std::cout << "Creating symlink: " << linkPath << " -> " << sourceScenarioPath << std::endl;
-    if (symlink(sourceScenarioPath.c_str(), linkPath.c_str()) != 0) {
-        std::cerr << "FATAL: Failed to create symlink." << std::endl;
-        perror("symlink"); 
-        return 1;
-    }
-    std::cout << "Symlink created successfully!" << std::endl;
-    return 0;
-}
 
 int main(int argc, char* argv[])
 {
     uint32_t packetSize = 1500;
     uint32_t numPackets = 1000;
     std::string intervalStr("265ms");
+    std::string traceFile;
+    uint32_t usersPerUt = 0;
+    std::string statsFile("stat-per-ut-fwd-ip-throughput.hscat");
+    std::string statsWindow("1s");
+    bool telemetry = false;
     double simLength = 10.; //300.0;
+    std::string scenario("contrib/sibgu-hap/data/scenarios/geo-33E-hap");
+    std::string scenarioCache("/tmp/sibgu-hap-scenarios");
    
     CommandLine cmd;
     cmd.AddValue("packetSize", "Size of packet (bytes)", packetSize);
     cmd.AddValue("numPackets", "Number of packets", numPackets);
     cmd.AddValue("interval", "Interval between packets", intervalStr);
+    cmd.AddValue("traceFile",
+                 "pcap or binary trace replayed from the UTs to the GW users instead of CBR",
+                 traceFile);
+    cmd.AddValue("usersPerUt",
+                 "On/off users per UT loading the GW users on top of the CBR flow",
+                 usersPerUt);
+    cmd.AddValue("statsFile",
+                 "Binary scatter file of the per-UT IP Rx throughput, relative to the SNS3 "
+                 "output folder, empty to disable",
+                 statsFile);
+    cmd.AddValue("statsWindow",
+                 "Throughput averaging window, 0s to write every packet",
+                 statsWindow);
+    cmd.AddValue("telemetry",
+                 "Publish live counters to /dev/shm/sibgu-hap-telemetry for "
+                 "ext-utils/cli_logs_display.py --telemetry",
+                 telemetry);
+    cmd.AddValue("scenario", "Scenario folder or .tsk container", scenario);
+    cmd.AddValue("scenarioCache",
+                 "Folder where .tsk containers are extracted once for SNS3",
+                 scenarioCache);
     cmd.Parse(argc, argv);
+    // Read by ext-utils/bench.py
+    Simulator::ScheduleDestroy([]() {
+        std::cout << "Simulated events: " << Simulator::GetEventCount() << std::endl;
+    });
 
     Time interPacketInterval = Time(intervalStr);
 
-    std::string myScenarioName = "geo-33E-hap";
-    if (MakeLinkToScenario(myScenarioName)) return 1;
+    // SNS3 only reads scenarios below its data path: reach ours through a
+    // relative location instead of a symlink there, which concurrent runs
+    // kept removing and re-creating
+    HapScenarioSource scenarioSource;
+    scenarioSource.Open(scenario);
+    std::string scenarioDir = scenarioSource.GetDirectory(scenarioCache);
+    std::string scenarioLocation = HapScenarioSource::GetRelativePath(
+        Singleton<SatEnvVariables>::Get()->GetDataPath() + "/scenarios", scenarioDir);
+    std::cout << "Scenario: " << scenarioDir << " (SNS3 location " << scenarioLocation << ")"
+              << std::endl;
 
     // === SATELLITE SETUP ===
     
@@ -225,7 +203,22 @@ int main(int argc, char* argv[])
     simulationHelper->SetSimulationTime(simLength);
 
     // 7. Load the scenario
-    simulationHelper->LoadScenario(myScenarioName);
+    simulationHelper->LoadScenario(scenarioLocation);
+
+    // Only the beams serving the configured UTs and GWs are created
+    HapBeamSetHelper beamSetHelper;
+    beamSetHelper.LoadScenario(scenario);
+    std::set<uint32_t> beamSet = beamSetHelper.GetBeamSet();
+    if (beamSetHelper.GetNUncoveredPositions() == 0)
+    {
+        simulationHelper->SetBeamSet(beamSet);
+        std::cout << "Beam set: " << beamSet.size() << " beams" << std::endl;
+    }
+    else
+    {
+        std::cout << "WARNING: " << beamSetHelper.GetNUncoveredPositions()
+                  << " positions outside the antenna patterns, keeping all beams" << std::endl;
+    }
     
     simulationHelper->CreateSatScenario(SatHelper::FULL);   
 
@@ -265,75 +258,34 @@ int main(int argc, char* argv[])
     else 
     {
         std::cout << "Analyzing UT to GW mapping..." << std::endl;
-        
-        // 1. Create a map: Gateway IP address -> The Gateway node itself
-        std::map<Ipv4Address, Ptr<Node>> gwIpToNodeMap;
-        
-        for (uint32_t i = 0; i < gwNodes.GetN (); ++i)
-        {
-            Ptr<Node> gw = gwNodes.Get (i);
-            Ptr<Ipv4> ipv4 = gw->GetObject<Ipv4> ();
-            for (uint32_t j = 1; j < ipv4->GetNInterfaces (); ++j)
-            {
-                // Collect all IP addresses of all gateway interfaces
-                Ipv4Address addr = ipv4->GetAddress (j, 0).GetLocal ();
-                if (addr != Ipv4Address ()) {
-                    gwIpToNodeMap[addr] = gw;
-                }
-            }
-        }
 
-        // 2. Group UTs by the gateways they are connected to (via Default Route)
-        std::map<Ptr<Node>, std::vector<Ptr<Node>>> gwToUtsMap;
-        Ipv4StaticRoutingHelper routingHelper;
+        // The UTs of each gateway, from their default routes
+        Ptr<HapGatewayAssociationIndex> association = CreateObject<HapGatewayAssociationIndex>();
+        association->Build(utNodes, gwNodes);
 
-        for (uint32_t i = 0; i < utNodes.GetN (); ++i)
+        // Select source and sink behind DIFFERENT gateways
+        std::vector<uint32_t> servingGws;
+        for (uint32_t gw = 0; gw < association->GetNGateways(); ++gw)
         {
-            Ptr<Node> ut = utNodes.Get (i);
-            Ptr<Ipv4> ipv4 = ut->GetObject<Ipv4> ();
-            
-            // Get the static routing table for the UT
-            Ptr<Ipv4StaticRouting> staticRouting = routingHelper.GetStaticRouting (ipv4);
-            
-            if (staticRouting)
+            std::cout << "  GW Node " << association->GetGatewayNode(gw)->GetId() << ": "
+                      << association->GetUts(gw).size() << " UTs" << std::endl;
+            if (!association->GetUts(gw).empty())
             {
-                uint32_t numRoutes = staticRouting->GetNRoutes ();
-                for (uint32_t j = 0; j < numRoutes; ++j)
-                {
-                    Ipv4RoutingTableEntry route = staticRouting->GetRoute (j);
-                    
-                    // Use GetZero() to get 0.0.0.0
-                    if (route.GetDest () == Ipv4Address::GetZero () && 
-                        route.GetDestNetworkMask () == Ipv4Mask::GetZero ())
-                    {
-                        Ipv4Address gwIp = route.GetGateway ();
-                        
-                        if (gwIpToNodeMap.count (gwIp) > 0) {
-                            Ptr<Node> associatedGw = gwIpToNodeMap[gwIp];
-                            gwToUtsMap[associatedGw].push_back (ut);
-                        }
-                        break; 
-                    }
-                }
+                servingGws.push_back(gw);
             }
         }
 
-        // 3. Select source and sink from DIFFERENT groups
-        if (gwToUtsMap.size () >= 2)
+        if (servingGws.size () >= 2)
         {
-            auto it = gwToUtsMap.begin ();
-            std::vector<Ptr<Node>> group1 = it->second; // Group of the 1st gateway
-            it++;
-            std::vector<Ptr<Node>> group2 = it->second; // Group of the 2nd gateway
-
-            sourceNode = group1[0];
-            sinkNode = group2[0]; 
+            sourceNode = NodeList::GetNode(association->GetUts(servingGws[0]).front());
+            sinkNode = NodeList::GetNode(association->GetUts(servingGws[1]).front());
 
             std::cout << "Selected Source: UT Node " << sourceNode->GetId() 
-                      << " (via GW Node " << gwToUtsMap.begin ()->first->GetId()
+                      << " (via GW Node " << association->GetGatewayNode(servingGws[0])->GetId()
                       << ")" << std::endl;
             std::cout << "Selected Sink:   UT Node " << sinkNode->GetId() 
-                      << " (via GW Node " << it->first->GetId() << ")" << std::endl;
+                      << " (via GW Node " << association->GetGatewayNode(servingGws[1])->GetId()
+                      << ")" << std::endl;
         }
         else
         {
@@ -355,8 +307,75 @@ int main(int argc, char* argv[])
     Ptr<Socket> recvSink = Socket::CreateSocket(sinkNode, tid);
     recvSink->Bind(InetSocketAddress(Ipv4Address::GetAny(), port));
     recvSink->SetRecvCallback(MakeCallback(&ReceivePacket));
-    Ptr<Socket> source = Socket::CreateSocket(sourceNode, tid);
-    source->Connect(InetSocketAddress(sinkAddr, port));
+    Ptr<HapCbrSource> source = CreateObject<HapCbrSource>();
+    source->SetAttribute("Remote", AddressValue(InetSocketAddress(sinkAddr, port)));
+    source->SetAttribute("PacketSize", UintegerValue(packetSize));
+    source->SetAttribute("Interval", TimeValue(interPacketInterval));
+    source->SetAttribute("MaxPackets", UintegerValue(numPackets));
+    source->SetStartTime(Seconds(1.0));
+    Ptr<HapTraceReplay> replay;
+    if (traceFile.empty())
+    {
+        sourceNode->AddApplication(source);
+    }
+    else
+    {
+        // Trace sources are mapped onto the UTs and destinations onto the GW
+        // users, both chosen by the host part of the address
+        replay = CreateObject<HapTraceReplay>();
+        replay->SetAttribute("Port", UintegerValue(port));
+        replay->Open(traceFile);
+        replay->AddSourceRule(Ipv4Address::GetZero(), Ipv4Mask::GetZero(), utNodes);
+        replay->AddDestinationRule(Ipv4Address::GetZero(), Ipv4Mask::GetZero(), gwUserNodes);
+        replay->Start(Seconds(1.0));
+    }
+
+    Ptr<HapTrafficMatrix> matrix;
+    if (usersPerUt > 0)
+    {
+        matrix = CreateObject<HapTrafficMatrix>();
+        matrix->SetAttribute("Port", UintegerValue(port));
+        matrix->AddDemand(utNodes, gwUserNodes, usersPerUt, CreateObject<HapDemandProfile>());
+        matrix->Start(Seconds(1.0), Seconds(simLength));
+    }
+
+    // === STATISTICS ===
+    // Next to the SNS3 text statistics, where ext-utils/genreport.py reads both
+    Ptr<HapScatterFileWriter> statsWriter;
+    if (!statsFile.empty())
+    {
+        if (statsFile[0] != '/')
+        {
+            statsFile = Singleton<SatEnvVariables>::Get()->GetOutputPath() + "/" + statsFile;
+        }
+        statsWriter = CreateObject<HapScatterFileWriter>();
+        statsWriter->Open(statsFile);
+        g_utRxThroughput = CreateObject<HapWindowAggregator>();
+        if (Time(statsWindow).IsStrictlyPositive())
+        {
+            g_utRxThroughput->SetAttribute("Window", TimeValue(Time(statsWindow)));
+        }
+        else
+        {
+            g_utRxThroughput->SetAttribute("Raw", BooleanValue(true));
+        }
+        g_utRxThroughput->SetWriter(statsWriter);
+        for (uint32_t i = 0; i < utNodes.GetN(); ++i)
+        {
+            g_utRxSeries[utNodes.Get(i)->GetId()] = g_utRxThroughput->AddSeries(
+                "stat-per-ut-fwd-ip-throughput-scatter-" + std::to_string(i + 1),
+                {{"title", "UT_" + std::to_string(i + 1) + " IP Rx throughput"},
+                 {"unit", "bps"}});
+        }
+    }
+
+    if (telemetry)
+    {
+        g_telemetry = CreateObject<HapTelemetryPublisher>();
+        g_telemetryTx = g_telemetry->AddCounter("ip-tx-packets");
+        g_telemetryRx = g_telemetry->AddCounter("ip-rx-packets");
+        g_telemetry->Start();
+    }
 
     // === FLOW MONITOR ===
     FlowMonitorHelper flowmon;
@@ -364,8 +383,6 @@ int main(int argc, char* argv[])
 
     // === RUN ===
     NS_LOG_UNCOND("\n=== Starting Simulation ===");
-    Simulator::ScheduleWithContext(source->GetNode()->GetId(), Seconds(1.0),
-        &GenerateTraffic, source, packetSize, numPackets, interPacketInterval);
     Simulator::Stop(Seconds(simLength));
     Simulator::Run();
 
@@ -473,9 +490,43 @@ int main(int argc, char* argv[])
     }
     std::cout << std::string(95, '-') << std::endl;
 
+    if (replay)
+    {
+        std::cout << "Trace replay: " << replay->GetNSent() << " packets sent, "
+                  << replay->GetNUnmapped() << " records unmapped" << std::endl;
+    }
+
+    if (matrix)
+    {
+        std::cout << "Traffic matrix: " << matrix->GetNUsers() << " users, "
+                  << matrix->GetNFiles() << " files, " << matrix->GetNPackets()
+                  << " packets sent" << std::endl;
+    }
+
+    if (g_telemetry)
+    {
+        g_telemetry->Stop();
+    }
+
     monitor->SerializeToXmlFile("hap-sat-hap-stats.xml", true, true);
+
+    if (statsWriter)
+    {
+        // The aggregator writes its open windows on dispose, before the file is closed
+        g_utRxThroughput->Dispose();
+        std::cout << "Statistics: " << g_utRxThroughput->GetNSamples() << " samples, "
+                  << g_utRxThroughput->GetNPoints() << " points written to " << statsFile
+                  << std::endl;
+        g_utRxThroughput = nullptr;
+        statsWriter->Dispose();
+    }
     std::cout << "\n=== End of Simulation ===" << std::endl;
 
+    if (g_telemetry)
+    {
+        g_telemetry->Dispose();
+        g_telemetry = nullptr;
+    }
     Simulator::Destroy();
     return 0;
 }
\ No newline at end of file
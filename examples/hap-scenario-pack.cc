@@ -0,0 +1,51 @@
+#include "ns3/core-module.h"
+#include "ns3/hap-beam-set-helper.h"
+#include "ns3/hap-scenario-source.h"
+
+#include <iostream>
+
+/**
+ * \file
+ *
+ * Packs an SNS3 scenario folder into a .tsk container that concurrent runs
+ * can share read-only, e.g.
+ *
+ *   ./ns3 run "hap-scenario-pack --scenario=contrib/sibgu-hap/data/scenarios/geo-33E-hap
+ *              --output=geo-33E-hap.tsk"
+ *
+ * and then hap-sat-hap --scenario=geo-33E-hap.tsk. The text gain grids are
+ * first converted to binary grids inside the folder, unless disabled.
+ */
+
+using namespace ns3;
+
+int
+main(int argc, char* argv[])
+{
+    std::string scenario("contrib/sibgu-hap/data/scenarios/geo-33E-hap");
+    std::string output;
+    bool binaryPatterns = true;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("scenario", "Scenario folder", scenario);
+    cmd.AddValue("output", "Container file, <scenario>.tsk if empty", output);
+    cmd.AddValue("binaryPatterns", "Add binary copies of the gain grids", binaryPatterns);
+    cmd.Parse(argc, argv);
+
+    if (output.empty())
+    {
+        output = scenario + ".tsk";
+    }
+    if (binaryPatterns)
+    {
+        std::cout << HapBeamSetHelper::WriteBinaryPatterns(scenario) << " binary gain grids"
+                  << std::endl;
+    }
+    HapScenarioSource::WriteArchive(scenario, output);
+
+    HapScenarioSource source;
+    source.Open(output);
+    std::cout << output << ": " << source.ListFiles("positions").size() << " position files, "
+              << source.ListFiles("antennapatterns").size() << " gain grids" << std::endl;
+    return 0;
+}
@@ -35,7 +35,19 @@
 #include "../stats/device-ip-table.h"
 #include "../model/orbiter-trajectory-validation.h"
 #include "../stats/pcap-node-tracing.h"
+#include "ns3/hap-beam-set-helper.h"
+#include "ns3/hap-contact-plan.h"
+#include "ns3/hap-contact-plan-generator.h"
+#include "ns3/hap-handover-scheduler.h"
+#include "ns3/hap-lazy-beam-manager.h"
+#include "ns3/hap-nearest-orbiter-index.h"
+#include "ns3/hap-telemetry-publisher.h"
+#include "ns3/hap-trace-context.h"
+#include <algorithm>
 #include <chrono>
+#include <fstream>
+#include <iterator>
+#include <map>
 #include <sstream> 
 #include <tuple>
 #include <vector>
@@ -44,6 +56,57 @@ using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("sat-handover-hap");
 
+static Ptr<SatAntennaGainPatternContainer> g_antennaPatterns;
+static Ptr<HapTelemetryPublisher> g_telemetry;
+static std::map<uint32_t, uint32_t> g_utBeam; // predicted beam by UT node id
+
+static uint32_t
+LocateBeam(uint32_t nodeId, uint32_t satId)
+{
+    Ptr<SatMobilityModel> mobility = NodeList::GetNode(nodeId)->GetObject<SatMobilityModel>();
+    return g_antennaPatterns->GetBestBeamId(satId, mobility->GetGeoPosition(), true);
+}
+
+static void
+BeamActivated(uint32_t satId, uint32_t beamId)
+{
+    NS_LOG_INFO(Simulator::Now().GetSeconds() << " s: beam " << beamId << " of orbiter " << satId
+                                              << " activated");
+}
+
+static void
+HandoverTrigger(uint32_t nodeId, const std::vector<uint32_t>& satIds)
+{
+    std::ostringstream ranking;
+    for (uint32_t satId : satIds)
+    {
+        ranking << " " << satId;
+    }
+    NS_LOG_INFO(Simulator::Now().GetSeconds() << " s: UT node " << nodeId
+                                              << " closest orbiters:" << ranking.str());
+}
+
+static void
+TelemetryHandover(uint32_t nodeId, const std::vector<uint32_t>& satIds)
+{
+    if (!satIds.empty())
+    {
+        g_utBeam[nodeId] = LocateBeam(nodeId, satIds.front());
+    }
+}
+
+// Bytes sent or received by a UT over its satellite interface are carried
+// by the beam predicted for the UT
+static void
+TelemetryIpv4(std::string context, Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+    auto beam = g_utBeam.find(HapNodeIdFromContext(context));
+    if (beam != g_utBeam.end() && DynamicCast<SatNetDevice>(ipv4->GetNetDevice(interface)))
+    {
+        g_telemetry->AddBeamBytes(beam->second, packet->GetSize());
+    }
+}
+
 // ============================================================================
 // main
 // ============================================================================
@@ -72,6 +135,12 @@ main(int argc, char* argv[])
     float interval = 100.0; // Time interval between CBR packets in milliseconds
     bool enablePcap = false;
     bool enableHexDump = false;
+    std::string contactPlanFile = "";
+    bool generateContactPlan = false;
+    std::string beamSetFile = "";
+    std::string activeBeamsFile = "";
+    float handoverCheckPeriod = 1.0; // seconds, ranking period without contact plan
+    bool telemetry = false;
     
 
     // Declare command line arguments
@@ -82,11 +151,35 @@ main(int argc, char* argv[])
     cmd.AddValue("simulationDuration", "Simulation duration, in seconds", simulationDuration);
     cmd.AddValue("enablePcap", "Enable PCAP", enablePcap);
     cmd.AddValue("enableHexDump", "Enable Hex-Dump", enableHexDump);
+    cmd.AddValue("contactPlanFile", "Binary contact plan file to load or generate", contactPlanFile);
+    cmd.AddValue("generateContactPlan",
+                 "Only sweep the ephemeris and write contactPlanFile, then exit",
+                 generateContactPlan);
+    cmd.AddValue("beamSetFile",
+                 "Beam ids to create, one per line, e.g. the activeBeamsFile of a previous run; "
+                 "the beams serving the terminals are always added",
+                 beamSetFile);
+    cmd.AddValue("activeBeamsFile",
+                 "Write the beams predicted for the UTs during the run, with the beams "
+                 "serving the terminals",
+                 activeBeamsFile);
+    cmd.AddValue("handoverCheckPeriod",
+                 "Period of the closest-orbiter ranking when no contactPlanFile is given, "
+                 "in seconds",
+                 handoverCheckPeriod);
+    cmd.AddValue("telemetry",
+                 "Publish predicted handovers, beam activations and per-beam throughput to "
+                 "/dev/shm/sibgu-hap-telemetry",
+                 telemetry);
 
     std::string simulationName = "sat-handover-hap";
     Ptr<SimulationHelper> simulationHelper = CreateObject<SimulationHelper>(simulationName);
     simulationHelper->AddDefaultUiArguments(cmd); // Adds default UI arguments (simulation time, etc.)
     cmd.Parse(argc, argv); // Parses command-line arguments  
+    // Read by ext-utils/bench.py
+    Simulator::ScheduleDestroy([]() {
+        std::cout << "Simulated events: " << Simulator::GetEventCount() << std::endl;
+    });
     std::string fixedOutputDir =
         SystemPath::Append("contrib/sibgu-hap/data/sims", simulationName + "/");
     SystemPath::MakeDirectories(fixedOutputDir);
@@ -103,6 +196,42 @@ main(int argc, char* argv[])
                                      46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60,
                                      61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71, 72
                                    };
+    // Beams serving the terminals at the reference orbiter position: a beam
+    // set recorded from predictions must not lose those SNS3 attaches to
+    HapBeamSetHelper beamSetHelper;
+    beamSetHelper.LoadScenario(Singleton<SatEnvVariables>::Get()->GetDataPath() + "/scenarios/" +
+                               scenarioName);
+    std::set<uint32_t> servingBeams = beamSetHelper.GetBeamSet();
+    if (!beamSetFile.empty())
+    {
+        std::ifstream beamSetInput(beamSetFile);
+        NS_ABORT_MSG_UNLESS(beamSetInput.is_open(), "Cannot open " << beamSetFile);
+        std::set<uint32_t> beamSetRead;
+        uint32_t beamId;
+        while (beamSetInput >> beamId)
+        {
+            beamSetRead.insert(beamId);
+        }
+        if (beamSetHelper.GetNUncoveredPositions() > 0)
+        {
+            NS_LOG_UNCOND("WARNING: " << beamSetHelper.GetNUncoveredPositions()
+                                      << " positions outside the antenna patterns, "
+                                      << beamSetFile << " may lack beams SNS3 hands over to");
+        }
+        std::set<uint32_t> missing;
+        std::set_difference(servingBeams.begin(),
+                            servingBeams.end(),
+                            beamSetRead.begin(),
+                            beamSetRead.end(),
+                            std::inserter(missing, missing.end()));
+        if (!missing.empty())
+        {
+            NS_LOG_UNCOND("WARNING: " << beamSetFile << " lacks " << missing.size()
+                                      << " beams serving the terminals, adding them");
+        }
+        beamSetAll = beamSetRead;
+        beamSetAll.insert(missing.begin(), missing.end());
+    }
     simulationHelper->SetBeamSet(beamSetAll);
     
     // Scenario with 3 orbiters:
@@ -119,6 +248,84 @@ main(int argc, char* argv[])
     Ptr<SatTopology> topology = Singleton<SatTopology>::Get();
     ValidateOrbiterTrajectories(scenarioName, topology);
 
+    // ========================================================================
+    // Contact plan
+    // ========================================================================
+    if (generateContactPlan)
+    {
+        NS_ABORT_MSG_IF(contactPlanFile.empty(), "generateContactPlan requires contactPlanFile");
+
+        Ptr<HapContactPlanGenerator> generator = CreateObject<HapContactPlanGenerator>();
+        generator->SetOrbiters(topology->GetOrbiterNodes());
+        generator->AddObservers(topology->GetGwNodes(), HapContactPlan::ROLE_GW);
+        generator->AddObservers(topology->GetUtNodes(), HapContactPlan::ROLE_UT);
+        generator->Sweep(Seconds(0), Seconds(simulationDuration), contactPlanFile);
+
+        // Only mobility is evaluated, no traffic is installed in this mode
+        Simulator::Stop(Seconds(simulationDuration) + MilliSeconds(1));
+        Simulator::Run();
+        Simulator::Destroy();
+        NS_LOG_UNCOND("Contact plan written to " << contactPlanFile);
+        return 0;
+    }
+
+    // The scheduler predicts the handovers for the beam manager, the SNS3
+    // handover itself is still decided by SatHandoverModule: its checks run
+    // as without the scheduler, which adds its own events instead of saving any
+    Ptr<HapHandoverScheduler> handoverScheduler = CreateObject<HapHandoverScheduler>();
+    handoverScheduler->SetAttribute("NumberClosestSats", UintegerValue(3));
+    if (!contactPlanFile.empty())
+    {
+        // Handover candidates change only at the instants of the contact plan
+        Ptr<HapContactPlan> contactPlan = CreateObject<HapContactPlan>();
+        contactPlan->Load(contactPlanFile);
+        NS_LOG_UNCOND("Contact plan loaded: " << contactPlan->GetNObservers() << " observers, "
+                                              << contactPlan->GetNOrbiters() << " orbiters");
+        handoverScheduler->SetContactPlan(contactPlan);
+    }
+    else
+    {
+        // Without contact plan all UTs are ranked together on a periodic grid,
+        // with one k-d tree rebuild per period instead of one scan per UT
+        Ptr<HapNearestOrbiterIndex> orbiterIndex = CreateObject<HapNearestOrbiterIndex>();
+        orbiterIndex->SetOrbiters(topology->GetOrbiterNodes());
+        handoverScheduler->SetAttribute("CheckPeriod", TimeValue(Seconds(handoverCheckPeriod)));
+        handoverScheduler->SetOrbiterIndex(orbiterIndex);
+    }
+    handoverScheduler->Install(topology->GetUtNodes());
+    handoverScheduler->TraceConnectWithoutContext("HandoverTrigger",
+                                                  MakeCallback(&HandoverTrigger));
+
+    // SNS3 has already built every beam of the set: record the beams predicted
+    // for the UTs, a candidate beam set for the next run
+    g_antennaPatterns = simulationHelper->GetSatelliteHelper()->GetAntennaGainPatterns();
+    Ptr<HapLazyBeamManager> beamManager = CreateObject<HapLazyBeamManager>();
+    beamManager->SetBeamLocator(MakeCallback(&LocateBeam));
+    beamManager->TraceConnectWithoutContext("BeamActivated", MakeCallback(&BeamActivated));
+    beamManager->ConnectToScheduler(handoverScheduler);
+
+    if (telemetry)
+    {
+        g_telemetry = CreateObject<HapTelemetryPublisher>();
+        g_telemetry->ConnectToScheduler(handoverScheduler);
+        beamManager->TraceConnectWithoutContext(
+            "BeamActivated",
+            MakeCallback(&HapTelemetryPublisher::BeamActivated, g_telemetry));
+        handoverScheduler->TraceConnectWithoutContext("HandoverTrigger",
+                                                      MakeCallback(&TelemetryHandover));
+        NodeContainer uts = topology->GetUtNodes();
+        for (uint32_t i = 0; i < uts.GetN(); ++i)
+        {
+            std::string path =
+                "/NodeList/" + std::to_string(uts.Get(i)->GetId()) + "/$ns3::Ipv4L3Protocol/";
+            Config::Connect(path + "Tx", MakeCallback(&TelemetryIpv4));
+            Config::Connect(path + "Rx", MakeCallback(&TelemetryIpv4));
+        }
+        g_telemetry->Start();
+        // Final snapshot at the end of the run, before the simulator is destroyed
+        Simulator::Schedule(Seconds(simulationDuration), &HapTelemetryPublisher::Stop, g_telemetry);
+    }
+
     // ========================================================================
     // Unified device-to-IP mapping table for all roles
     // ========================================================================
@@ -202,6 +409,43 @@ main(int argc, char* argv[])
         std::chrono::duration_cast<std::chrono::milliseconds>(simulationEnd - simulationStart);
     NS_LOG_UNCOND("Simulation wall-clock time: " << (simulationElapsed.count() / 1000.0)
                                                  << " s");
+    // Predictions only: SatHandoverModule still runs its periodic checks
+    NS_LOG_UNCOND("Predicted ranking changes: " << handoverScheduler->GetNTriggers()
+                                                << ", scheduler events: "
+                                                << handoverScheduler->GetNEvaluations()
+                                                << " (on top of the SNS3 handover checks)");
+    std::set<uint32_t> activeBeams = beamManager->GetActiveBeamIds();
+    NS_LOG_UNCOND("Predicted beams: " << beamManager->GetNActiveBeams() << " over all orbiters, "
+                                      << activeBeams.size() << " of " << beamSetAll.size()
+                                      << " beam ids");
+    if (!activeBeamsFile.empty())
+    {
+        // The predictions follow the closest orbiter, SNS3 may attach elsewhere
+        std::set<uint32_t> unpredicted;
+        std::set_difference(servingBeams.begin(),
+                            servingBeams.end(),
+                            activeBeams.begin(),
+                            activeBeams.end(),
+                            std::inserter(unpredicted, unpredicted.end()));
+        if (!unpredicted.empty())
+        {
+            NS_LOG_UNCOND("WARNING: " << unpredicted.size() << " beams serving the terminals "
+                                      << "were not predicted, adding them to " << activeBeamsFile);
+        }
+        activeBeams.insert(servingBeams.begin(), servingBeams.end());
+        std::ofstream output(activeBeamsFile);
+        for (uint32_t beamId : activeBeams)
+        {
+            output << beamId << std::endl;
+        }
+    }
+    if (g_telemetry)
+    {
+        NS_LOG_UNCOND("Telemetry: " << g_telemetry->GetNSnapshots() << " snapshots, "
+                                    << g_telemetry->GetNEvents() << " events");
+        g_telemetry->Dispose();
+        g_telemetry = nullptr;
+    }
 
     return 0;
 }
\ No newline at end of file
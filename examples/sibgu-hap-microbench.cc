@@ -0,0 +1,401 @@
+/*
+ * File: sibgu-hap-microbench.cc
+ * Micro-benchmarks of the kernels that dominate the sibgu-hap profiles.
+ *
+ * Every kernel is timed in batches of --iterations calls. After --warmup
+ * batches (more while the batch times still drift, e.g. while the CPU
+ * clock ramps up) --repetitions batches are recorded and reported as
+ * nanoseconds per call: min, median, 90th and 99th percentile, max.
+ *
+ * The process is pinned to the CPU it starts on, and a cpufreq governor
+ * other than "performance" is reported because it makes timings unstable.
+ * For a before/after number of an optimization:
+ *
+ *   ./ns3 run "sibgu-hap-microbench --save=before.txt"
+ *   (apply the change)
+ *   ./ns3 run "sibgu-hap-microbench --compare=before.txt"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/hap-geometry.h"
+#include "ns3/hap-isl-shortest-paths.h"
+#include "ns3/hap-trace-context.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sched.h>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("SibguHapMicrobench");
+
+// Results are accumulated here so that the kernels are not optimized away
+volatile double g_sink = 0;
+
+struct Kernel
+{
+    std::string name;
+    std::string description;
+    std::function<void(uint32_t)> run; // runs the kernel n times
+};
+
+struct Result
+{
+    std::string name;
+    double min;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+};
+
+double Percentile(const std::vector<double>& sorted, double p)
+{
+    size_t index = std::min(sorted.size() - 1, size_t(p * (sorted.size() - 1) + 0.5));
+    return sorted[index];
+}
+
+double TimeBatch(const Kernel& kernel, uint32_t iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    kernel.run(iterations);
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+}
+
+void PinToCurrentCpu()
+{
+    int cpu = sched_getcpu();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (cpu < 0 || sched_setaffinity(0, sizeof(set), &set) != 0)
+    {
+        std::cout << "Warning: cannot pin the benchmark to a CPU" << std::endl;
+        return;
+    }
+    std::ifstream governor("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                           "/cpufreq/scaling_governor");
+    std::string name;
+    if (governor >> name && name != "performance")
+    {
+        std::cout << "Warning: CPU " << cpu << " uses the '" << name
+                  << "' cpufreq governor, timings may drift; prefer 'performance'" << std::endl;
+    }
+}
+
+std::map<std::string, double> LoadMedians(const std::string& fileName)
+{
+    std::map<std::string, double> medians;
+    std::ifstream in(fileName);
+    NS_ABORT_MSG_UNLESS(in.is_open(), "Cannot open " << fileName);
+    std::string name;
+    double min;
+    double p50;
+    while (in >> name >> min >> p50)
+    {
+        medians[name] = p50;
+        in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return medians;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t warmup = 20;
+    uint32_t repetitions = 200;
+    uint32_t iterations = 10000;
+    std::string filter;
+    std::string saveFile;
+    std::string compareFile;
+    bool list = false;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("warmup", "Batches run before recording", warmup);
+    cmd.AddValue("repetitions", "Batches recorded per kernel", repetitions);
+    cmd.AddValue("iterations", "Kernel calls per batch", iterations);
+    cmd.AddValue("kernel", "Run only the kernels whose name contains this text", filter);
+    cmd.AddValue("save", "Write the results to this file", saveFile);
+    cmd.AddValue("compare", "Results file of a previous run to compare the medians with", compareFile);
+    cmd.AddValue("list", "List the kernels and exit", list);
+    cmd.Parse(argc, argv);
+    NS_ABORT_MSG_IF(repetitions == 0 || iterations == 0, "Nothing to measure");
+
+    PinToCurrentCpu();
+
+    // --- Inputs, identical from run to run ---
+    const uint32_t nInputs = 4096; // power of two, inputs are indexed with i & (nInputs - 1)
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable>();
+    random->SetStream(1);
+
+    std::vector<double> angles(nInputs);
+    std::vector<Vector> targets(nInputs);
+    std::vector<std::string> contexts(nInputs);
+    std::vector<uint32_t> nodeIds(nInputs);
+    for (uint32_t i = 0; i < nInputs; ++i)
+    {
+        angles[i] = random->GetValue(0, M_PI);
+        targets[i] = Vector(random->GetValue(-20000, 20000), random->GetValue(-20000, 20000), 0);
+        nodeIds[i] = random->GetInteger(0, 199);
+        contexts[i] = "/NodeList/" + std::to_string(nodeIds[i]) + "/$ns3::Ipv4L3Protocol/Rx";
+    }
+
+    // Moving HAPs of the wifi-moving-hap-router kind
+    NodeContainer haps;
+    haps.Create(64);
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantVelocityMobilityModel");
+    mobility.Install(haps);
+    std::vector<Ptr<MobilityModel>> hapMobility;
+    for (uint32_t i = 0; i < haps.GetN(); ++i)
+    {
+        Ptr<ConstantVelocityMobilityModel> model =
+            haps.Get(i)->GetObject<ConstantVelocityMobilityModel>();
+        model->SetPosition(Vector(i * 1000.0, 0, 20000));
+        model->SetVelocity(Vector(10, 5, 0));
+        hapMobility.push_back(model);
+    }
+
+    // Hop statistics as kept by hap-sat-hap and hap-constellation-hap
+    std::map<uint64_t, uint32_t> packetLastSender;
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> hopStats;
+    uint64_t uid = 0;
+
+    // Iridium-like +grid of 6 planes x 11 orbiters and 4 gateways, each with
+    // a feeder link declared to every orbiter and one of them up
+    const uint32_t nPlanes = 6;
+    const uint32_t nPerPlane = 11;
+    const uint32_t nOrbiters = nPlanes * nPerPlane;
+    const uint32_t nGateways = 4;
+    const double down = std::numeric_limits<double>::infinity();
+    std::vector<HapIslShortestPaths::Link> islLinks;
+    for (uint32_t plane = 0; plane < nPlanes; ++plane)
+    {
+        for (uint32_t slot = 0; slot < nPerPlane; ++slot)
+        {
+            uint32_t sat = plane * nPerPlane + slot;
+            islLinks.push_back({sat, plane * nPerPlane + (slot + 1) % nPerPlane, 1.0});
+            if (plane + 1 < nPlanes)
+            {
+                islLinks.push_back({sat, sat + nPerPlane, 1.5});
+            }
+        }
+    }
+    std::vector<uint32_t> feeder(nGateways);
+    for (uint32_t gw = 0; gw < nGateways; ++gw)
+    {
+        feeder[gw] = gw * nOrbiters / nGateways;
+        for (uint32_t sat = 0; sat < nOrbiters; ++sat)
+        {
+            islLinks.push_back({nOrbiters + gw, sat, sat == feeder[gw] ? 0.5 : down});
+        }
+    }
+    HapIslShortestPaths islPaths;
+    islPaths.SetTopology(nOrbiters + nGateways, islLinks);
+    for (uint32_t gw = 0; gw < nGateways; ++gw)
+    {
+        islPaths.AddDestination(nOrbiters + gw);
+    }
+    // Feeder handover of one gateway to the next orbiter of its plane
+    auto handover = [&](uint32_t i) {
+        uint32_t gw = i % nGateways;
+        uint32_t next = (feeder[gw] + 1) % nOrbiters;
+        islPaths.SetLinkWeight(nOrbiters + gw, next, 0.5);
+        islPaths.SetLinkWeight(nOrbiters + gw, feeder[gw], down);
+        feeder[gw] = next;
+    };
+
+    std::vector<Kernel> kernels = {
+        {"antenna-gain",
+         "off-axis angle and gain of one HAP-ground link",
+         [&](uint32_t n) {
+             Vector hap(6000, 0, 20000);
+             Vector boresight(0, 0, -20000);
+             double sum = 0;
+             for (uint32_t i = 0; i < n; ++i)
+             {
+                 const Vector& target = targets[i & (nInputs - 1)];
+                 Vector direction(target.x - hap.x, target.y - hap.y, target.z - hap.z);
+                 sum += HapCosineGain(HapOffAxisAngle(boresight, direction), 20, 2);
+             }
+             g_sink = g_sink + sum;
+         }},
+        {"directional-gain",
+         "HapCosineGain (CalculateDirectionalGain)",
+         [&](uint32_t n) {
+             double sum = 0;
+             for (uint32_t i = 0; i < n; ++i)
+             {
+                 sum += HapCosineGain(angles[i & (nInputs - 1)], 20, 2);
+             }
+             g_sink = g_sink + sum;
+         }},
+        {"node-id-from-context",
+         "HapNodeIdFromContext on IPv4 trace contexts",
+         [&](uint32_t n) {
+             uint64_t sum = 0;
+             for (uint32_t i = 0; i < n; ++i)
+             {
+                 sum += HapNodeIdFromContext(contexts[i & (nInputs - 1)]);
+             }
+             g_sink = g_sink + sum;
+         }},
+        {"hop-table-update",
+         "IPv4 Tx/Rx sender bookkeeping and hop counter",
+         [&](uint32_t n) {
+             for (uint32_t i = 0; i < n; ++i)
+             {
+                 uint32_t sender = nodeIds[i & (nInputs - 1)];
+                 uint32_t receiver = nodeIds[(i + 1) & (nInputs - 1)];
+                 packetLastSender[uid] = sender;
+                 auto it = packetLastSender.find(uid);
+                 if (it != packetLastSender.end() && it->second != receiver)
+                 {
+                     hopStats[std::make_pair(it->second, receiver)]++;
+                 }
+                 // Packets leave the table once delivered, as in a steady state
+                 packetLastSender.erase(uid > 1024 ? uid - 1024 : UINT64_MAX);
+                 ++uid;
+             }
+             g_sink = g_sink + hopStats.size();
+         }},
+        {"isl-update",
+         "feeder handover with incremental shortest-path trees",
+         [&](uint32_t n) {
+             for (uint32_t i = 0; i < n; ++i)
+             {
+                 handover(i);
+             }
+             g_sink = g_sink + islPaths.GetDistance(0, nOrbiters);
+         }},
+        {"isl-recompute",
+         "feeder handover with a full recomputation of the trees",
+         [&](uint32_t n) {
+             for (uint32_t i = 0; i < n; ++i)
+             {
+                 handover(i);
+                 islPaths.Recompute();
+             }
+             g_sink = g_sink + islPaths.GetDistance(0, nOrbiters);
+         }},
+        {"mobility-position",
+         "GetPosition of constant-velocity HAPs, each moved once per batch",
+         [&](uint32_t n) {
+             double sum = 0;
+             for (uint32_t i = 0; i < n; ++i)
+             {
+                 sum += hapMobility[i & (hapMobility.size() - 1)]->GetPosition().x;
+             }
+             g_sink = g_sink + sum;
+         }},
+    };
+
+    if (list)
+    {
+        for (const Kernel& kernel : kernels)
+        {
+            std::cout << std::left << std::setw(22) << kernel.name << kernel.description
+                      << std::endl;
+        }
+        Simulator::Destroy();
+        return 0;
+    }
+
+    std::map<std::string, double> before;
+    if (!compareFile.empty())
+    {
+        before = LoadMedians(compareFile);
+    }
+
+    // Each batch runs in its own event, 1 ms after the previous one, so that
+    // the first query of each HAP in a batch moves it as in a real run
+    std::vector<Result> results;
+    for (const Kernel& kernel : kernels)
+    {
+        if (kernel.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        std::vector<double> samples;
+        uint32_t warmed = 0;
+        double previous = 0;
+        std::function<void()> batch = [&]() {
+            double current = TimeBatch(kernel, iterations);
+            if (warmed < 10 * warmup)
+            {
+                // Warm up until two batches agree within 2%, at most 10 x warmup
+                ++warmed;
+                if (warmed >= warmup && std::abs(current - previous) < 0.02 * previous)
+                {
+                    warmed = 10 * warmup;
+                }
+                previous = current;
+            }
+            else
+            {
+                samples.push_back(current);
+            }
+            if (samples.size() < repetitions)
+            {
+                Simulator::Schedule(MilliSeconds(1), batch);
+            }
+        };
+        Simulator::Schedule(MilliSeconds(1), batch);
+        Simulator::Run();
+
+        std::sort(samples.begin(), samples.end());
+        results.push_back({kernel.name,
+                           samples.front(),
+                           Percentile(samples, 0.5),
+                           Percentile(samples, 0.9),
+                           Percentile(samples, 0.99),
+                           samples.back()});
+    }
+
+    std::cout << std::left << std::setw(22) << "kernel" << std::right << std::setw(10) << "min"
+              << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+              << std::setw(10) << "max";
+    if (!before.empty())
+    {
+        std::cout << std::setw(10) << "before" << std::setw(10) << "speedup";
+    }
+    std::cout << "   (ns per call)" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (const Result& r : results)
+    {
+        std::cout << std::left << std::setw(22) << r.name << std::right << std::setw(10) << r.min
+                  << std::setw(10) << r.p50 << std::setw(10) << r.p90 << std::setw(10) << r.p99
+                  << std::setw(10) << r.max;
+        auto it = before.find(r.name);
+        if (it != before.end())
+        {
+            std::cout << std::setw(10) << it->second << std::setw(9) << it->second / r.p50 << "x";
+        }
+        std::cout << std::endl;
+    }
+
+    if (!saveFile.empty())
+    {
+        std::ofstream out(saveFile);
+        NS_ABORT_MSG_UNLESS(out.is_open(), "Cannot create " << saveFile);
+        out << std::setprecision(3) << std::fixed;
+        for (const Result& r : results)
+        {
+            out << r.name << " " << r.min << " " << r.p50 << " " << r.p90 << " " << r.p99 << " "
+                << r.max << "\n";
+        }
+        std::cout << "Results saved to " << saveFile << std::endl;
+    }
+
+    Simulator::Destroy();
+    return 0;
+}
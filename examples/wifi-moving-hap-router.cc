@@ -21,7 +21,13 @@
 #include "ns3/applications-module.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/ipv4-list-routing-helper.h"
+#include "ns3/hap-animation-recorder.h"
+#include "ns3/hap-geometry-rate-manager.h"
+#include "ns3/hap-geometry.h"
+#include "ns3/hap-wifi-range-helper.h"
+#include <algorithm>
 #include <cmath>
+#include <memory>
 
 using namespace ns3;
 enum {HAP, UT_A, UT_B};
@@ -69,36 +75,10 @@ Vector GetVector(Vector from, Vector to)
     return Vector(to.x - from.x, to.y - from.y, to.z - from.z);
 }
 
-// Function to calculate the angle between two vectors (in radians)
-double CalculateAngle(Vector v1, Vector v2)
-{
-    double dotProduct = v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
-    double mag1 = std::sqrt(v1.x * v1.x + v1.y * v1.y + v1.z * v1.z);
-    double mag2 = std::sqrt(v2.x * v2.x + v2.y * v2.y + v2.z * v2.z);
-
-    if (mag1 * mag2 == 0) return 0.0;
-
-    double cosAngle = dotProduct / (mag1 * mag2);
-    
-    // Limit the range to avoid rounding errors
-    if (cosAngle > 1.0) cosAngle = 1.0;
-    if (cosAngle < -1.0) cosAngle = -1.0;
-
-    return std::acos(cosAngle);
-}
-
 // Gain calculation based on the beam offset angle (Cosine Antenna Model approximation)
 double CalculateDirectionalGain(double angleRad)
 {
-    // Модель: Gain = MaxGain + 10 * log10(cos(angle)^exponent)
-    double cosAngle = std::cos(angleRad);
-    if (cosAngle < 0.0) cosAngle = 0.0; // Go out from the beam.
-    
-    // To avoid error log10(0)
-    if (cosAngle < 0.01) return -20.0; // Minimum gain
-
-    double gain = g_maxAntennaGain + 10.0 * std::log10(std::pow(cosAngle, g_beamwidthExponent));
-    return gain;
+    return HapCosineGain(angleRad, g_maxAntennaGain, g_beamwidthExponent);
 }
 
 // --- HAP position and antenna gain update function ---
@@ -130,7 +110,7 @@ void UpdateHapState()
 
     // 2. Calculate the gain for Network A (HAP <-> Ground A)
     Vector vecHapToA = GetVector(hapPos, g_mobilityNodeA->GetPosition());
-    double angleA = CalculateAngle(viewVector, vecHapToA);
+    double angleA = HapOffAxisAngle(viewVector, vecHapToA);
     double gainA = CalculateDirectionalGain(angleA);
     
     g_phyHapA->SetAttribute("TxGain", DoubleValue(gainA));
@@ -138,7 +118,7 @@ void UpdateHapState()
 
     // 3. Calculate gain for Network B (HAP <-> Ground B)
     Vector vecHapToB = GetVector(hapPos, g_mobilityNodeB->GetPosition());
-    double angleB = CalculateAngle(viewVector, vecHapToB);
+    double angleB = HapOffAxisAngle(viewVector, vecHapToB);
     double gainB = CalculateDirectionalGain(angleB);
 
     g_phyHapB->SetAttribute("TxGain", DoubleValue(gainB));
@@ -168,6 +148,19 @@ int main(int argc, char* argv[])
      // --- Variables for circle center coordinates ---
     double centerX{6000.0};
     double centerY{6000.0};
+
+    // --- Long-range MAC timing ---
+    bool longRange{true};
+    double maxLinkDistance{0.0};
+
+    // --- Rate control from the HAP geometry ---
+    bool adaptiveRate{true};
+    double rateMargin{3.0};
+
+    // --- Animation output ---
+    std::string animationFile{"animation.hanm"};
+    Time animationInterval{"10s"};
+    bool netanim{false};
     
     CommandLine cmd(__FILE__);
     cmd.AddValue("phyModeA", "Wifi Phy mode Network A (2.4GHz)", phyModeA);
@@ -185,8 +178,19 @@ int main(int argc, char* argv[])
     // --- Command line options for HAP trajectory center coordinates ---
     cmd.AddValue("centerX", "X coordinate of the circle center", centerX);
     cmd.AddValue("centerY", "Y coordinate of the circle center", centerY);
+    cmd.AddValue("longRange", "Lengthen slot and ACK timeouts for the HAP link distance", longRange);
+    cmd.AddValue("maxLinkDistance", "Longest HAP-ground link for longRange (m), 0 to derive it from the trajectory", maxLinkDistance);
+    cmd.AddValue("adaptiveRate", "Select the rate from the predicted SNR instead of phyModeA/phyModeB", adaptiveRate);
+    cmd.AddValue("rateMargin", "Fading margin of the adaptive rate (dB)", rateMargin);
+    cmd.AddValue("animationFile", "Decimated animation output, converted to NetAnim XML at the end", animationFile);
+    cmd.AddValue("animationInterval", "Position sampling and flow summary period of the animation", animationInterval);
+    cmd.AddValue("netanim", "Record every packet in animation.xml with NetAnim's AnimationInterface instead", netanim);
     
     cmd.Parse(argc, argv);
+    // Read by ext-utils/bench.py
+    Simulator::ScheduleDestroy([]() {
+        std::cout << "Simulated events: " << Simulator::GetEventCount() << std::endl;
+    });
     g_circleCenter = Vector(centerX, centerY, 0.0);                                  
 
     g_maxAntennaGain = antGain;
@@ -220,9 +224,22 @@ int main(int argc, char* argv[])
     wifiPhyA.SetChannel(wifiChannelA.Create());
 
     WifiMacHelper wifiMacA;
-    wifiA.SetRemoteStationManager("ns3::ConstantRateWifiManager",
-                                  "DataMode", StringValue(phyModeA),
-                                  "ControlMode", StringValue(phyModeA));
+    if (adaptiveRate)
+    {
+        // Same path loss as the channel, without the fading
+        Ptr<LogDistancePropagationLossModel> predictionA = CreateObject<LogDistancePropagationLossModel>();
+        predictionA->SetAttribute("Exponent", DoubleValue(2.0));
+        predictionA->SetAttribute("ReferenceLoss", DoubleValue(40.0));
+        wifiA.SetRemoteStationManager("ns3::HapGeometryRateManager",
+                                      "LossModel", PointerValue(predictionA),
+                                      "FadingMargin", DoubleValue(rateMargin));
+    }
+    else
+    {
+        wifiA.SetRemoteStationManager("ns3::ConstantRateWifiManager",
+                                      "DataMode", StringValue(phyModeA),
+                                      "ControlMode", StringValue(phyModeA));
+    }
     wifiMacA.SetType("ns3::AdhocWifiMac");
     
     // Install Net A
@@ -258,9 +275,21 @@ int main(int argc, char* argv[])
     wifiPhyB.SetChannel(wifiChannelB.Create());
 
     WifiMacHelper wifiMacB;
-    wifiB.SetRemoteStationManager("ns3::ConstantRateWifiManager",
-                                  "DataMode", StringValue(phyModeB),
-                                  "ControlMode", StringValue(phyModeB));
+    if (adaptiveRate)
+    {
+        Ptr<LogDistancePropagationLossModel> predictionB = CreateObject<LogDistancePropagationLossModel>();
+        predictionB->SetAttribute("Exponent", DoubleValue(2.0));
+        predictionB->SetAttribute("ReferenceLoss", DoubleValue(46.7));
+        wifiB.SetRemoteStationManager("ns3::HapGeometryRateManager",
+                                      "LossModel", PointerValue(predictionB),
+                                      "FadingMargin", DoubleValue(rateMargin));
+    }
+    else
+    {
+        wifiB.SetRemoteStationManager("ns3::ConstantRateWifiManager",
+                                      "DataMode", StringValue(phyModeB),
+                                      "ControlMode", StringValue(phyModeB));
+    }
     wifiMacB.SetType("ns3::AdhocWifiMac");
 
     NetDeviceContainer devicesB;
@@ -295,14 +324,59 @@ int main(int argc, char* argv[])
     // Save ground station mobility models for angle calculations
     g_mobilityNodeA = nodes.Get(UT_A)->GetObject<MobilityModel>();
     g_mobilityNodeB = nodes.Get(UT_B)->GetObject<MobilityModel>();
+
+    if (adaptiveRate)
+    {
+        // Predict the SNR towards the other end of each link
+        HapGeometryRateManager::AddPeers(devicesA);
+        HapGeometryRateManager::AddPeers(devicesB);
+    }
+
+    // --- Long-range timing: responses must not arrive after the ACK timeout ---
+    if (longRange)
+    {
+        if (maxLinkDistance <= 0.0)
+        {
+            // Farthest point of the circle from either ground terminal
+            for (Ptr<MobilityModel> ground : {g_mobilityNodeA, g_mobilityNodeB})
+            {
+                Vector p = ground->GetPosition();
+                double horizontal = std::hypot(p.x - centerX, p.y - centerY) + circleRadius;
+                maxLinkDistance = std::max(maxLinkDistance, std::hypot(horizontal, hight - p.z));
+            }
+        }
+        HapWifiRangeHelper range;
+        range.SetMaxDistance(maxLinkDistance);
+        range.Install(devicesA);
+        range.Install(devicesB);
+        NS_LOG_UNCOND("Long-range timing: " << maxLinkDistance << " m, coverage class "
+                      << range.GetCoverageClass() << ", slot +"
+                      << range.GetAirPropagationTime().As(Time::US));
+    }
     
-    AnimationInterface anim("animation.xml"); // Creates input file for NetAnim tool.
-    anim.UpdateNodeDescription(HAP, "HAP");
-    anim.UpdateNodeDescription(UT_A, "Ground_A");
-    anim.UpdateNodeDescription(UT_B, "Ground_B");
-    anim.UpdateNodeSize(0, 20, 20);
-    anim.UpdateNodeSize(1, 20, 20);
-    anim.UpdateNodeSize(2, 20, 20);
+    // The full NetAnim trace of an hour of traffic is huge, so by default only
+    // decimated positions and flow summaries are recorded.
+    std::unique_ptr<AnimationInterface> anim;
+    Ptr<HapAnimationRecorder> recorder;
+    if (netanim)
+    {
+        anim = std::make_unique<AnimationInterface>("animation.xml"); // Creates input file for NetAnim tool.
+        anim->UpdateNodeDescription(HAP, "HAP");
+        anim->UpdateNodeDescription(UT_A, "Ground_A");
+        anim->UpdateNodeDescription(UT_B, "Ground_B");
+        anim->UpdateNodeSize(0, 20, 20);
+        anim->UpdateNodeSize(1, 20, 20);
+        anim->UpdateNodeSize(2, 20, 20);
+    }
+    else
+    {
+        recorder = CreateObject<HapAnimationRecorder>();
+        recorder->SetAttribute("SampleInterval", TimeValue(animationInterval));
+        recorder->SetAttribute("FlowInterval", TimeValue(animationInterval));
+        recorder->Add(nodes.Get(HAP), "HAP");
+        recorder->Add(nodes.Get(UT_A), "Ground_A");
+        recorder->Add(nodes.Get(UT_B), "Ground_B");
+    }
 
     // Set time for first HAP update
     Simulator::Schedule(Seconds(0.1), &UpdateHapState);
@@ -339,6 +413,11 @@ int main(int argc, char* argv[])
                                            interfacesB.GetAddress(0), 
                                            1);
 
+    if (recorder)
+    {
+        recorder->Start(animationFile); // Needs the IPv4 stacks for its traces.
+    }
+
     // --- Application Setup ---
     uint16_t port = 9;
     
@@ -361,6 +440,7 @@ int main(int argc, char* argv[])
     NS_LOG_UNCOND("HAP Circle Radius: " << circleRadius << " m");
     NS_LOG_UNCOND("Ground Separation: " << groundDistance << " m");
     NS_LOG_UNCOND("Using Simulated Directional Antenna (Dynamic Gain on YansWifiPhy).");
+    NS_LOG_UNCOND("Rate control: " << (adaptiveRate ? "HAP geometry (predicted SNR)" : phyModeA + " / " + phyModeB));
 
     Simulator::ScheduleWithContext(source->GetNode()->GetId(),
             Seconds(1.0),
@@ -416,6 +496,12 @@ int main(int argc, char* argv[])
     }
 
     monitor->SerializeToXmlFile("hap-results-moving-beam.xml", true, true);
+
+    if (recorder)
+    {
+        recorder->Dispose();
+        HapAnimationRecorder::ExportNetAnim(animationFile, "animation.xml");
+    }
     std::cout << "-----------------------------\n\n";
 
     Simulator::Destroy();
@@ -19,6 +19,10 @@
 #include "ns3/applications-module.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/ipv4-list-routing-helper.h"
+#include "ns3/hap-cached-propagation-loss-model.h"
+#include "ns3/hap-wifi-aggregation-helper.h"
+#include "ns3/hap-wifi-range-helper.h"
+#include <cmath>
 
 using namespace ns3;
 enum {HAP, UT_A, UT_B};
@@ -63,6 +67,13 @@ int main(int argc, char* argv[])
     // Ground separation (distance between terminal A and B on the ground)
     double groundDistance{5000.0}; 
 
+    // Slot and ACK timeouts for the HAP link distance instead of terrestrial ones
+    bool longRange{true};
+
+    // HAP backhaul: 802.11n with A-MPDU/A-MSDU sized for the link distance
+    bool backhaul{false};
+    std::string backhaulMode("HtMcs7");
+
     CommandLine cmd(__FILE__);
     cmd.AddValue("phyModeA", "Wifi Phy mode Network A (2.4GHz)", phyModeA);
     cmd.AddValue("phyModeB", "Wifi Phy mode Network B (5GHz)", phyModeB);
@@ -74,6 +85,9 @@ int main(int argc, char* argv[])
     cmd.AddValue("txPower", "Power of transmitter, (dBm)", Pdbm);
     cmd.AddValue("antGain", "Antenna gain for transmitter and reciever, (dBi)", antGain);
     cmd.AddValue("groundDistance", "Distance between ground terminals A and B (m)", groundDistance);
+    cmd.AddValue("longRange", "Lengthen slot and ACK timeouts for the HAP link distance", longRange);
+    cmd.AddValue("backhaul", "Use 802.11n with aggregation on both HAP links instead of 802.11b/a", backhaul);
+    cmd.AddValue("backhaulMode", "HT data mode of the backhaul links", backhaulMode);
     cmd.Parse(argc, argv);
 
     // NOTE: We do NOT set NonUnicastMode globally here because Network A uses DSSS 
@@ -92,7 +106,7 @@ int main(int argc, char* argv[])
     WifiHelper wifiA;
     if (verbose)
         WifiHelper::EnableLogComponents();
-    wifiA.SetStandard(WIFI_STANDARD_80211b);
+    wifiA.SetStandard(backhaul ? WIFI_STANDARD_80211n : WIFI_STANDARD_80211b);
 
     YansWifiPhyHelper wifiPhyA;
     wifiPhyA.Set("TxGain", DoubleValue(antGain));
@@ -104,23 +118,30 @@ int main(int argc, char* argv[])
     YansWifiChannelHelper wifiChannelA;
     wifiChannelA.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
     // Frequency for 2.4GHz 
-    wifiChannelA.AddPropagationLoss("ns3::LogDistancePropagationLossModel",
-                                   "Exponent", DoubleValue(2.0),
-                                   "ReferenceDistance", DoubleValue(1.0),
-                                   "ReferenceLoss", DoubleValue(40.0)
-                                   );
+    // The nodes are static: the path loss of each pair is computed once
+    Ptr<LogDistancePropagationLossModel> logDistanceA =
+        CreateObject<LogDistancePropagationLossModel>();
+    logDistanceA->SetAttribute("Exponent", DoubleValue(2.0));
+    logDistanceA->SetAttribute("ReferenceDistance", DoubleValue(1.0));
+    logDistanceA->SetAttribute("ReferenceLoss", DoubleValue(40.0));
+    wifiChannelA.AddPropagationLoss("ns3::HapCachedPropagationLossModel",
+                                   "Model", PointerValue(logDistanceA));
     wifiChannelA.AddPropagationLoss("ns3::NakagamiPropagationLossModel",
                                    "m0", DoubleValue(1.0), 
                                    "m1", DoubleValue(1.0),
                                    "m2", DoubleValue(1.0));
     
     wifiPhyA.SetChannel(wifiChannelA.Create());
+    if (backhaul)
+    {
+        wifiPhyA.Set("ChannelSettings", StringValue("{0, 20, BAND_2_4GHZ, 0}"));
+    }
 
     WifiMacHelper wifiMacA;
     wifiA.SetRemoteStationManager("ns3::ConstantRateWifiManager",
-                                  "DataMode", StringValue(phyModeA),
-                                  "ControlMode", StringValue(phyModeA));
-    wifiMacA.SetType("ns3::AdhocWifiMac");
+                                  "DataMode", StringValue(backhaul ? backhaulMode : phyModeA),
+                                  "ControlMode", StringValue(backhaul ? "HtMcs0" : phyModeA));
+    wifiMacA.SetType("ns3::AdhocWifiMac", "QosSupported", BooleanValue(backhaul));
     
     // Install Net A on HAP and Ground A
     NetDeviceContainer devicesA;
@@ -131,7 +152,7 @@ int main(int argc, char* argv[])
     // --- Network B Setup (5 GHz, 802.11a) ---
     // Connecting HAP (Node 0) <-> Ground B (Node 2)
     WifiHelper wifiB;
-    wifiB.SetStandard(WIFI_STANDARD_80211a);
+    wifiB.SetStandard(backhaul ? WIFI_STANDARD_80211n : WIFI_STANDARD_80211a);
 
     YansWifiPhyHelper wifiPhyB;
     wifiPhyB.Set("TxGain", DoubleValue(antGain));
@@ -143,23 +164,29 @@ int main(int argc, char* argv[])
     YansWifiChannelHelper wifiChannelB;
     wifiChannelB.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
     // Frequency for 5GHz ~ 5.0 or 5.9 GHz
-    wifiChannelB.AddPropagationLoss("ns3::LogDistancePropagationLossModel",
-                                   "Exponent", DoubleValue(2.0),
-                                   "ReferenceDistance", DoubleValue(1.0),
-                                   "ReferenceLoss", DoubleValue(46.7) // Approx ref loss for 5GHz
-                                  );
+    Ptr<LogDistancePropagationLossModel> logDistanceB =
+        CreateObject<LogDistancePropagationLossModel>();
+    logDistanceB->SetAttribute("Exponent", DoubleValue(2.0));
+    logDistanceB->SetAttribute("ReferenceDistance", DoubleValue(1.0));
+    logDistanceB->SetAttribute("ReferenceLoss", DoubleValue(46.7)); // Approx ref loss for 5GHz
+    wifiChannelB.AddPropagationLoss("ns3::HapCachedPropagationLossModel",
+                                   "Model", PointerValue(logDistanceB));
     wifiChannelB.AddPropagationLoss("ns3::NakagamiPropagationLossModel",
                                    "m0", DoubleValue(1.0), 
                                    "m1", DoubleValue(1.0),
                                    "m2", DoubleValue(1.0));
 
     wifiPhyB.SetChannel(wifiChannelB.Create());
+    if (backhaul)
+    {
+        wifiPhyB.Set("ChannelSettings", StringValue("{0, 20, BAND_5GHZ, 0}"));
+    }
 
     WifiMacHelper wifiMacB;
     wifiB.SetRemoteStationManager("ns3::ConstantRateWifiManager",
-                                  "DataMode", StringValue(phyModeB),
-                                  "ControlMode", StringValue(phyModeB));
-    wifiMacB.SetType("ns3::AdhocWifiMac");
+                                  "DataMode", StringValue(backhaul ? backhaulMode : phyModeB),
+                                  "ControlMode", StringValue(backhaul ? "HtMcs0" : phyModeB));
+    wifiMacB.SetType("ns3::AdhocWifiMac", "QosSupported", BooleanValue(backhaul));
 
     // Install Net B on HAP and Ground B
     NetDeviceContainer devicesB;
@@ -184,6 +211,27 @@ int main(int argc, char* argv[])
     mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
     mobility.Install(nodes);
 
+    if (longRange)
+    {
+        HapWifiRangeHelper range;
+        range.SetMaxDistance(std::hypot(groundDistance / 2, hight));
+        range.Install(devicesA);
+        range.Install(devicesB);
+        NS_LOG_UNCOND("Long-range timing: coverage class " << range.GetCoverageClass()
+                      << ", slot +" << range.GetAirPropagationTime().As(Time::US));
+    }
+
+    // Aggregation is sized from the slot, so after the long-range timing
+    if (backhaul)
+    {
+        HapWifiAggregationHelper aggregation;
+        aggregation.SetMaxDistance(std::hypot(groundDistance / 2, hight));
+        aggregation.SetDataRate(DataRate(WifiMode(backhaulMode).GetDataRate(20)));
+        aggregation.SetMsduSize(packetSize + 28); // UDP and IPv4 headers
+        aggregation.Install(devicesA);
+        aggregation.Install(devicesB);
+    }
+
 
     // --- Internet Stack & IP ---
     InternetStackHelper internet;
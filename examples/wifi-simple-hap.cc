@@ -36,11 +36,14 @@
 #include "ns3/command-line.h"
 #include "ns3/config.h"
 #include "ns3/double.h"
+#include "ns3/hap-cached-propagation-loss-model.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/log.h"
 #include "ns3/mobility-helper.h"
 #include "ns3/mobility-model.h"
+#include "ns3/pointer.h"
+#include "ns3/propagation-loss-model.h"
 #include "ns3/string.h"
 #include "ns3/yans-wifi-channel.h"
 #include "ns3/yans-wifi-helper.h"
@@ -154,10 +157,15 @@ main(int argc, char* argv[])
     // 2.0 - free space,
     // 3.0 - typical office/urban environment, 
     // 4.0 - heavy attenuation.
-    wifiChannel.AddPropagationLoss("ns3::LogDistancePropagationLossModel",
-            "Exponent", DoubleValue(2.0),
-            "ReferenceDistance", DoubleValue(1.0), // reference distance, m
-            "ReferenceLoss", DoubleValue(40.0));  // attenuation at reference distance, dB
+    Ptr<LogDistancePropagationLossModel> logDistance =
+        CreateObject<LogDistancePropagationLossModel>();
+    logDistance->SetAttribute("Exponent", DoubleValue(2.0));
+    logDistance->SetAttribute("ReferenceDistance", DoubleValue(1.0)); // reference distance, m
+    logDistance->SetAttribute("ReferenceLoss", DoubleValue(40.0)); // attenuation at reference distance, dB
+    // The nodes are static: the path loss of each pair is computed once and
+    // reused for every frame
+    wifiChannel.AddPropagationLoss("ns3::HapCachedPropagationLossModel",
+            "Model", PointerValue(logDistance));
     // ReferenceLoss 40dB at reference distance 1m is a realistic value for 2.4GHz
 
     // 2. ADD RANDOMNESS (Nakagami Fading)
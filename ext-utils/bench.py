@@ -0,0 +1,340 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Run the sibgu-hap reference scenarios and compare them against stored baselines.
+
+Every scenario is run with a fixed seed from the ns-3 root (the examples look up
+their scenario folders relative to it). For each run the script records:
+
+- wall_time_s: wall clock time of the process;
+- events: simulator events executed, printed by the examples on Simulator::Destroy();
+- events_per_sec: events / wall_time_s;
+- peak_rss_kb: peak resident set size of the process;
+- output_bytes: size of the files the scenario wrote under its output paths.
+
+Results are written as JSON. A metric outside its relative tolerance of the
+baseline is a regression and makes the script exit with status 1. Baselines
+depend on the machine: record them with --update-baselines on the machine
+that runs the comparison.
+
+Usually started through the build system:
+
+    ./ns3 build sibgu-hap-bench
+"""
+
+from __future__ import annotations
+
+import argparse
+import datetime as dt
+import json
+import os
+import platform
+import re
+import subprocess
+import sys
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+
+EVENTS_RE = re.compile(r"^Simulated events: (\d+)$", re.MULTILINE)
+
+# Metric -> True when a larger value is worse.
+METRICS = {
+    "wall_time_s": True,
+    "events": None,  # deterministic with a fixed seed: any change is reported
+    "events_per_sec": False,
+    "peak_rss_kb": True,
+    "output_bytes": True,
+}
+
+DEFAULT_TOLERANCES = {
+    "wall_time_s": 0.25,
+    "events": 0.0,
+    "events_per_sec": 0.25,
+    "peak_rss_kb": 0.15,
+    "output_bytes": 0.05,
+}
+
+SEED_ARGS = ["--RngSeed=1", "--RngRun=1"]
+
+
+@dataclass
+class Scenario:
+    name: str
+    program: str
+    args: List[str]
+    # Output locations relative to the ns-3 root; files modified during the
+    # run are counted in output_bytes.
+    outputs: List[str] = field(default_factory=list)
+    description: str = ""
+
+
+SCENARIOS = [
+    Scenario(
+        name="geo-hap-relay",
+        program="hap-sat-hap",
+        args=["--numPackets=1000", "--interval=265ms"],
+        outputs=["contrib/satellite/data/sims/hap-sat-hap"],
+        description="Two HAP gateways relaying UT traffic through a GEO satellite",
+    ),
+    Scenario(
+        name="leo-handover",
+        program="sat-handover-hap",
+        args=["--simulationDuration=10", "--interval=100"],
+        outputs=["contrib/sibgu-hap/data/sims/sat-handover-hap"],
+        description="UT handover between LEO orbiters",
+    ),
+    Scenario(
+        name="wifi-hap-router",
+        program="wifi-moving-hap-router",
+        args=["--numPackets=3600", "--interval=1s"],
+        outputs=[
+            "wifi-simple-hap-netA-*.pcap",
+            "wifi-simple-hap-netB-*.pcap",
+            "hap-results-moving-beam.xml",
+            "animation.hanm",
+            "animation.xml",
+        ],
+        description="Moving HAP routing between two 802.11 ground terminals",
+    ),
+    Scenario(
+        name="geo-large-ut-count",
+        program="hap-sat-hap",
+        args=["--numPackets=1000", "--interval=265ms", "--usersPerUt=1000"],
+        outputs=["contrib/satellite/data/sims/hap-sat-hap"],
+        description="GEO relay with 1000 on/off users behind every UT",
+    ),
+]
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(
+        description="Run the sibgu-hap reference scenarios and check them against baselines.",
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter,
+    )
+    parser.add_argument(
+        "--binary",
+        action="append",
+        default=[],
+        metavar="PROGRAM=PATH",
+        help="Executable of an example program, e.g. hap-sat-hap=build/.../ns3-hap-sat-hap",
+    )
+    parser.add_argument(
+        "--ns3-dir",
+        type=Path,
+        default=Path.cwd(),
+        help="ns-3 root directory, the working directory of the scenarios",
+    )
+    parser.add_argument(
+        "--baselines",
+        type=Path,
+        default=Path(__file__).resolve().with_name("bench-baselines.json"),
+        help="Baselines and tolerances",
+    )
+    parser.add_argument(
+        "--output",
+        type=Path,
+        default=Path("sibgu-hap-bench.json"),
+        help="JSON file of the results",
+    )
+    parser.add_argument(
+        "--scenario",
+        action="append",
+        default=[],
+        help="Run only this scenario (repeatable)",
+    )
+    parser.add_argument(
+        "--timeout",
+        type=float,
+        default=3600.0,
+        help="Time limit of one scenario, seconds",
+    )
+    parser.add_argument(
+        "--update-baselines",
+        action="store_true",
+        help="Store the results as the new baselines instead of comparing",
+    )
+    parser.add_argument("--list", action="store_true", help="List the scenarios and exit")
+    return parser.parse_args()
+
+
+def parse_binaries(values: List[str]) -> Dict[str, Path]:
+    binaries = {}
+    for value in values:
+        program, sep, path = value.partition("=")
+        if not sep:
+            raise SystemExit(f"--binary expects PROGRAM=PATH, got {value!r}")
+        binaries[program] = Path(path)
+    return binaries
+
+
+def output_files(ns3_dir: Path, patterns: List[str]) -> List[Path]:
+    files = []
+    for pattern in patterns:
+        for path in ns3_dir.glob(pattern):
+            if path.is_dir():
+                files.extend(p for p in path.rglob("*") if p.is_file())
+            elif path.is_file():
+                files.append(path)
+    return files
+
+
+def run_scenario(
+    scenario: Scenario, binary: Path, ns3_dir: Path, timeout: float
+) -> Dict[str, object]:
+    command = [str(binary)] + SEED_ARGS + scenario.args
+    log_path = ns3_dir / f"sibgu-hap-bench-{scenario.name}.log"
+    print(f"[{scenario.name}] {' '.join(command)}", flush=True)
+
+    start_wall = time.time()
+    start = time.monotonic()
+    with open(log_path, "wb") as log:
+        process = subprocess.Popen(command, cwd=ns3_dir, stdout=log, stderr=subprocess.STDOUT)
+        deadline = start + timeout
+        # os.wait4() gives the rusage of this child only, unlike
+        # RUSAGE_CHILDREN which accumulates over all scenarios
+        while True:
+            pid, status, rusage = os.wait4(process.pid, os.WNOHANG)
+            if pid:
+                break
+            if time.monotonic() > deadline:
+                process.kill()
+                pid, status, rusage = os.wait4(process.pid, 0)
+                break
+            time.sleep(0.05)
+    wall_time = time.monotonic() - start
+    process.returncode = os.waitstatus_to_exitcode(status)
+
+    text = log_path.read_text(errors="replace")
+    match = EVENTS_RE.search(text)
+    events = int(match.group(1)) if match else None
+    output_bytes = sum(
+        p.stat().st_size
+        for p in output_files(ns3_dir, scenario.outputs)
+        if p.stat().st_mtime >= start_wall - 1.0
+    )
+
+    result: Dict[str, object] = {
+        "command": command,
+        "returncode": process.returncode,
+        "log": str(log_path),
+        "wall_time_s": round(wall_time, 3),
+        "events": events,
+        "events_per_sec": round(events / wall_time, 1) if events and wall_time > 0 else None,
+        # ru_maxrss is in kilobytes on Linux
+        "peak_rss_kb": rusage.ru_maxrss,
+        "output_bytes": output_bytes,
+    }
+    if process.returncode != 0:
+        result["error"] = f"exit status {process.returncode}, see {log_path}"
+    elif events is None:
+        result["error"] = f"no 'Simulated events' line in {log_path}"
+    return result
+
+
+def compare(
+    result: Dict[str, object], baseline: Optional[Dict[str, object]], tolerances: Dict[str, float]
+) -> Tuple[str, List[str]]:
+    if "error" in result:
+        return "error", [str(result["error"])]
+    if not baseline:
+        return "no-baseline", []
+
+    regressions = []
+    for metric, larger_is_worse in METRICS.items():
+        value = result.get(metric)
+        reference = baseline.get(metric)
+        if value is None or reference is None:
+            continue
+        tolerance = tolerances.get(metric, DEFAULT_TOLERANCES[metric])
+        limit = abs(reference) * tolerance
+        delta = value - reference
+        if larger_is_worse is None:
+            failed = abs(delta) > limit
+        elif larger_is_worse:
+            failed = delta > limit
+        else:
+            failed = -delta > limit
+        if failed:
+            change = f"{delta / reference:+.1%}" if reference else f"{delta:+}"
+            regressions.append(
+                f"{metric}: {value} vs baseline {reference} ({change}, tolerance {tolerance:.0%})"
+            )
+    return ("regression" if regressions else "ok"), regressions
+
+
+def load_baselines(path: Path) -> Dict[str, object]:
+    if not path.exists():
+        return {"tolerances": dict(DEFAULT_TOLERANCES), "scenarios": {}}
+    with open(path, encoding="utf-8") as f:
+        return json.load(f)
+
+
+def main() -> int:
+    args = parse_args()
+    if args.list:
+        for scenario in SCENARIOS:
+            print(f"{scenario.name:20} {scenario.program:24} {scenario.description}")
+        return 0
+
+    binaries = parse_binaries(args.binary)
+    ns3_dir = args.ns3_dir.resolve()
+    selected = [s for s in SCENARIOS if not args.scenario or s.name in args.scenario]
+    unknown = set(args.scenario) - {s.name for s in SCENARIOS}
+    if unknown:
+        raise SystemExit(f"Unknown scenario(s): {', '.join(sorted(unknown))}")
+
+    baselines = load_baselines(args.baselines)
+    tolerances = {**DEFAULT_TOLERANCES, **baselines.get("tolerances", {})}
+    report: Dict[str, object] = {
+        "date": dt.datetime.now().isoformat(timespec="seconds"),
+        "host": platform.node(),
+        "machine": platform.machine(),
+        "tolerances": tolerances,
+        "scenarios": {},
+    }
+
+    failed = False
+    for scenario in selected:
+        binary = binaries.get(scenario.program)
+        if binary is None or not binary.exists():
+            raise SystemExit(f"No executable for {scenario.program}; pass --binary")
+        result = run_scenario(scenario, binary, ns3_dir, args.timeout)
+        status, problems = compare(result, baselines["scenarios"].get(scenario.name), tolerances)
+        result["status"] = status
+        result["regressions"] = problems
+        report["scenarios"][scenario.name] = result
+
+        summary = ", ".join(f"{m}={result[m]}" for m in METRICS)
+        print(f"[{scenario.name}] {status}: {summary}", flush=True)
+        for problem in problems:
+            print(f"[{scenario.name}]   {problem}", flush=True)
+        failed = failed or status in ("error", "regression")
+
+    with open(args.output, "w", encoding="utf-8") as f:
+        json.dump(report, f, indent=2)
+    print(f"Results written to {args.output}")
+
+    if args.update_baselines:
+        for name, result in report["scenarios"].items():
+            if "error" in result:
+                continue
+            baselines["scenarios"][name] = {
+                m: result[m] for m in METRICS if result[m] is not None
+            }
+            baselines["scenarios"][name]["recorded"] = report["date"]
+            baselines["scenarios"][name]["host"] = report["host"]
+        baselines.setdefault("tolerances", dict(DEFAULT_TOLERANCES))
+        with open(args.baselines, "w", encoding="utf-8") as f:
+            json.dump(baselines, f, indent=2)
+            f.write("\n")
+        print(f"Baselines updated in {args.baselines}")
+        return 1 if any("error" in r for r in report["scenarios"].values()) else 0
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
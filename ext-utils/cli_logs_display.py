@@ -23,6 +23,7 @@ import sys
 import argparse
 import bisect
 import re
+import time
 
 import cli_logs_parser
 
@@ -527,14 +528,61 @@ def run_display(log_filename, page_size=20):
 
     print(f"\n{Colors.BOLD}End of trace.{Colors.RESET}")
 
+def run_telemetry(telemetry_filename, page_size=20, period=1.0):
+    """
+    Живой просмотр телеметрии работающей симуляции (HapTelemetryPublisher).
+    Обновляется каждые period секунд, выход по Ctrl+C.
+    """
+    reader = cli_logs_parser.TelemetryReader(telemetry_filename)
+    recent = []
+    total_lost = 0
+    try:
+        while True:
+            snapshot = reader.snapshot()
+            events, lost = reader.events()
+            total_lost += lost
+            recent = (recent + events)[-page_size:]
+
+            clear_screen()
+            print(f"{Colors.BOLD}Live telemetry: {telemetry_filename}{Colors.RESET}")
+            print(f"Sim time: {snapshot.time:.3f} s")
+            print("-" * 60)
+            for name, value in snapshot.counters.items():
+                print(f"{name:<32} {value:>16}")
+            print("-" * 60)
+            print(f"{Colors.BOLD}{'Beam':<6} {'Mbps':>12} {'Total MB':>14}{Colors.RESET}")
+            for beam, bps in enumerate(snapshot.beam_bps):
+                if snapshot.beam_bytes[beam]:
+                    print(f"{beam:<6} {bps / 1e6:>12.3f} {snapshot.beam_bytes[beam] / 1e6:>14.3f}")
+            print("-" * 60)
+            print(f"{Colors.BOLD}{'Time':<10} {'Event':<9} {'Node':<6} {'From':<6} {'To':<6}{Colors.RESET}"
+                  f"  (lost: {total_lost})")
+            for e in recent:
+                name = cli_logs_parser.TELEMETRY_EVENT_NAMES.get(e.type, str(e.type))
+                src = '-' if e.src == 0xFFFFFFFF else e.src
+                dst = '-' if e.dst == 0xFFFFFFFF else e.dst
+                print(f"{Colors.CYAN}{e.time:<10.3f}{Colors.RESET} {name:<9} {e.node:<6} {src:<6} {dst:<6}")
+            time.sleep(period)
+    except KeyboardInterrupt:
+        pass
+
 def main():
     parser = argparse.ArgumentParser(description='Display Satellite Packet Trace')
-    parser.add_argument('log_file', type=str, help='Path to PacketTrace.log file')
+    parser.add_argument('log_file', type=str,
+                        help='Path to PacketTrace.log file, or to the telemetry file with --telemetry')
     parser.add_argument('--page-size', type=int, default=20, help='Number of lines per page')
+    parser.add_argument('--telemetry', action='store_true',
+                        help='Watch the live telemetry of a running simulation '
+                             '(e.g. /dev/shm/sibgu-hap-telemetry)')
+    parser.add_argument('--period', type=float, default=1.0,
+                        help='Refresh period of the telemetry view, seconds')
     args = parser.parse_args()
     if not os.path.exists(args.log_file):
         print(f"Error: File '{args.log_file}' not found."); sys.exit(1)
-    run_display(args.log_file, args.page_size)
+    if args.telemetry:
+        run_telemetry(args.log_file, args.page_size, args.period)
+    else:
+        run_display(args.log_file, args.page_size)
 
 if __name__ == '__main__':
     main()
\ No newline at end of file
@@ -19,6 +19,8 @@
 #
 
 import argparse
+import mmap
+import struct
 from collections import namedtuple
 
 # Структура данных для одной записи в логе
@@ -84,6 +86,78 @@ def read_trace_file(filename):
             if entry:
                 yield entry
 
+# Телеметрия ns3::HapTelemetryPublisher (см. hap-telemetry-publisher.h)
+TelemetrySnapshot = namedtuple('TelemetrySnapshot', [
+    'time', 'counters', 'beam_bps', 'beam_bytes'
+])
+TelemetryEvent = namedtuple('TelemetryEvent', ['index', 'time', 'type', 'node', 'src', 'dst'])
+
+TELEMETRY_EVENT_NAMES = {1: 'HANDOVER', 2: 'BEAM_ON'}
+
+
+class TelemetryReader:
+    """
+    Читает живую телеметрию симуляции из файла в разделяемой памяти.
+    Симуляция никогда не ждёт читателя: снимок защищён seqlock,
+    события пишутся в кольцевой буфер.
+    """
+
+    def __init__(self, filename):
+        with open(filename, 'rb') as f:
+            self.mem = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        if self.mem[0:4] != b'HTLM':
+            raise ValueError(f"{filename}: not a telemetry file")
+        (version, self.n_counters, self.n_beams,
+         self.event_capacity, _) = struct.unpack_from('=5I', self.mem, 4)
+        if version != 1:
+            raise ValueError(f"{filename}: unsupported telemetry version {version}")
+        self.counter_names = [
+            self.mem[64 + 32 * i:96 + 32 * i].split(b'\0', 1)[0].decode()
+            for i in range(self.n_counters)
+        ]
+        self.snapshot_offset = 64 + 32 * self.n_counters
+        self.snapshot_size = 8 + 8 * self.n_counters + 16 * self.n_beams
+        self.event_offset = self.snapshot_offset + self.snapshot_size
+        self.next_event = 0
+
+    def snapshot(self):
+        """Согласованный снимок счётчиков и пропускной способности лучей."""
+        while True:
+            seq = struct.unpack_from('=Q', self.mem, 24)[0]
+            if seq % 2:
+                continue
+            data = self.mem[self.snapshot_offset:self.snapshot_offset + self.snapshot_size]
+            if struct.unpack_from('=Q', self.mem, 24)[0] == seq:
+                break
+        n, b = self.n_counters, self.n_beams
+        time = struct.unpack_from('=d', data, 0)[0]
+        counters = dict(zip(self.counter_names, struct.unpack_from(f'={n}Q', data, 8)))
+        beam_bps = struct.unpack_from(f'={b}d', data, 8 + 8 * n)
+        beam_bytes = struct.unpack_from(f'={b}Q', data, 8 + 8 * n + 8 * b)
+        return TelemetrySnapshot(time, counters, beam_bps, beam_bytes)
+
+    def events(self):
+        """
+        Новые события с прошлого вызова. Возвращает (события, число потерянных):
+        при отставании больше чем на ёмкость кольца старые события теряются.
+        """
+        head = struct.unpack_from('=Q', self.mem, 32)[0]
+        lost = max(0, head - self.next_event - self.event_capacity)
+        self.next_event += lost
+        result = []
+        while self.next_event < head:
+            offset = self.event_offset + 32 * (self.next_event % self.event_capacity)
+            seq, time, typ, node, src, dst = struct.unpack_from('=Qd4I', self.mem, offset)
+            seq_after = struct.unpack_from('=Q', self.mem, offset)[0]
+            if seq != self.next_event + 1 or seq_after != seq:
+                # Слот уже перезаписан (или пишется), событие потеряно
+                lost += 1
+            else:
+                result.append(TelemetryEvent(self.next_event, time, typ, node, src, dst))
+            self.next_event += 1
+        return result, lost
+
+
 def command_line_parser():
     parser = argparse.ArgumentParser(description='Generic Satellite Packet Trace Parser')
     parser.add_argument('log_file', type=str, help='Path to PacketTrace.log file')
@@ -10,6 +10,7 @@ import argparse
 import datetime as dt
 import math
 import re
+import struct
 import warnings
 from dataclasses import dataclass
 from pathlib import Path
@@ -20,6 +21,11 @@ FILE_NAME_RE = re.compile(
     r"^stat-(global|per-gw|per-ut)-([^-]+)-(.+)-([^-]+)-(scatter|scalar)-(-?\d+)\.txt$"
 )
 
+# Binary scatter files written by ns3::HapScatterFileWriter.
+SCATTER_MAGIC = b"HSCT"
+SCATTER_INDEX_MAGIC = b"HSCI"
+SCATTER_VERSION = 1
+
 # A4 landscape margins:
 # - left: 20 mm
 # - top/right/bottom: 5 mm
@@ -103,7 +109,8 @@ class TocLink:
 def parse_args() -> argparse.Namespace:
     parser = argparse.ArgumentParser(
         description=(
-            "Parse simulation statistics (*.txt) and generate a PDF report with graphs."
+            "Parse simulation statistics (*.txt, *.hscat) and generate a PDF report with "
+            "graphs."
         ),
         formatter_class=argparse.ArgumentDefaultsHelpFormatter,
     )
@@ -225,6 +232,70 @@ def collect_stat_files(results_dir: Path) -> List[StatFile]:
     return files
 
 
+def read_scatter_index(f) -> List[Tuple[str, Dict[str, str], List[Tuple[int, int]]]]:
+    """Return (name, metadata, chunks) of every series of a binary scatter file."""
+
+    def read_u32() -> int:
+        return struct.unpack("=I", f.read(4))[0]
+
+    def read_str() -> str:
+        return f.read(read_u32()).decode("utf-8")
+
+    if f.read(4) != SCATTER_MAGIC or read_u32() != SCATTER_VERSION:
+        return []
+    f.seek(-12, 2)
+    index_offset = struct.unpack("=Q", f.read(8))[0]
+    if f.read(4) != SCATTER_INDEX_MAGIC:
+        return []
+
+    f.seek(index_offset)
+    series = []
+    for _ in range(read_u32()):
+        name = read_str()
+        metadata = {}
+        for _ in range(read_u32()):
+            key = read_str()
+            metadata[key] = read_str()
+        chunks = [struct.unpack("=QI", f.read(12)) for _ in range(read_u32())]
+        series.append((name, metadata, chunks))
+    return series
+
+
+def read_scatter_series(f, chunks: List[Tuple[int, int]]) -> List[Tuple[float, float]]:
+    rows: List[Tuple[float, float]] = []
+    for offset, count in chunks:
+        f.seek(offset)
+        rows.extend(struct.iter_unpack("=dd", f.read(16 * count)))
+    return rows
+
+
+def collect_binary_stat_files(results_dir: Path) -> List[StatFile]:
+    """Series of binary scatter files, named like the text files they replace."""
+    files: List[StatFile] = []
+    for path in sorted(results_dir.glob("*.hscat")):
+        with path.open("rb") as f:
+            for name, metadata, chunks in read_scatter_index(f):
+                parsed_name = parse_file_name(Path(name + ".txt"))
+                if parsed_name is None or not chunks:
+                    continue
+
+                scope, direction, measurement, metric, fmt, entity_id = parsed_name
+                files.append(
+                    StatFile(
+                        path=path.with_name(name),
+                        scope=scope,
+                        direction=direction,
+                        measurement=measurement,
+                        metric=metric,
+                        fmt=fmt,
+                        entity_id=entity_id,
+                        metadata=metadata,
+                        rows=read_scatter_series(f, chunks),
+                    )
+                )
+    return files
+
+
 def parse_loss_stat_rows(path: Path) -> Tuple[str, str, List[Tuple[str, float]]]:
     label_name = "label"
     value_name = "value"
@@ -1962,7 +2033,7 @@ def main() -> None:
     else:
         print("[INFO] cartopy DownloadWarning suppression: OFF")
 
-    stat_files = collect_stat_files(results_dir)
+    stat_files = collect_stat_files(results_dir) + collect_binary_stat_files(results_dir)
     loss_stat_files = collect_loss_stat_files(results_dir)
     xml_files = find_xml_files(results_dir)
     sat_coordinates = parse_sat_coordinates(results_dir)
@@ -0,0 +1,416 @@
+#include "hap-beam-set-helper.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/system-path.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapBeamSetHelper");
+
+namespace
+{
+
+const char PATTERNS_FOLDER[] = "antennapatterns";  //!< text gain grids, read by SNS3
+const char BINARY_FOLDER[] = "binarypatterns";     //!< binary gain grids
+const char GRID_MAGIC[4] = {'H', 'A', 'G', 'B'};   //!< binary gain grid signature
+const uint32_t GRID_VERSION = 2;                   //!< binary gain grid version
+const uint64_t GRID_HEADER_SIZE = 64;              //!< binary gain grid header
+
+/**
+ * \param fileName gain grid file name, <prefix>_<beamId><extension>
+ * \param extension expected extension
+ * \return beam id, 0 if the name does not match
+ */
+uint32_t
+GetBeamId(const std::string& fileName, const std::string& extension)
+{
+    std::size_t underscore = fileName.rfind('_');
+    if (underscore == std::string::npos || fileName.size() <= extension.size() ||
+        fileName.compare(fileName.size() - extension.size(), extension.size(), extension) != 0)
+    {
+        return 0;
+    }
+    std::size_t dot = fileName.size() - extension.size();
+    if (dot <= underscore + 1)
+    {
+        return 0;
+    }
+    std::string number = fileName.substr(underscore + 1, dot - underscore - 1);
+    if (number.find_first_not_of("0123456789") != std::string::npos)
+    {
+        return 0;
+    }
+    return std::stoul(number);
+}
+
+} // namespace
+
+HapBeamSetHelper::HapBeamSetHelper()
+    : m_nUncovered(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapBeamSetHelper::LoadScenario(std::string scenarioPath)
+{
+    NS_LOG_FUNCTION(this << scenarioPath);
+
+    m_source.Open(scenarioPath);
+    m_gwPositions = ReadPositions(m_source.ReadFile("positions/gw_positions.txt"));
+    if (m_source.HasFile("positions/ut_positions.txt"))
+    {
+        std::vector<LatLon> uts = ReadPositions(m_source.ReadFile("positions/ut_positions.txt"));
+        m_userPositions.insert(m_userPositions.end(), uts.begin(), uts.end());
+    }
+
+    std::istringstream conf(m_source.ReadFile("beams/fwdConf.txt"));
+    std::string line;
+    while (std::getline(conf, line))
+    {
+        std::istringstream fields(line);
+        uint32_t beamId;
+        uint32_t userChannel;
+        uint32_t gwId;
+        if (fields >> beamId >> userChannel >> gwId)
+        {
+            m_beamGw[beamId] = gwId;
+        }
+    }
+
+    // Binary grids are listed last, so that they replace the text ones they
+    // were converted from
+    m_patterns.clear();
+    std::vector<std::pair<std::string, std::string>> folders{{PATTERNS_FOLDER, ".txt"},
+                                                             {BINARY_FOLDER, ".bin"}};
+    for (const auto& [folder, extension] : folders)
+    {
+        for (const std::string& fileName : m_source.ListFiles(folder))
+        {
+            uint32_t beamId = GetBeamId(fileName, extension);
+            if (beamId == 0)
+            {
+                continue;
+            }
+            std::string name = folder + "/" + fileName;
+            std::string text = std::string(PATTERNS_FOLDER) + "/" +
+                               fileName.substr(0, fileName.size() - extension.size()) + ".txt";
+            if (extension == ".bin" && m_source.HasFile(text) && !IsConvertedFrom(name, text))
+            {
+                NS_LOG_WARN("Gain grid " << name << " is out of date, " << text << " is used");
+                continue;
+            }
+            m_patterns[beamId] = name;
+        }
+    }
+
+    NS_LOG_INFO("Scenario " << scenarioPath << ": " << m_gwPositions.size() << " GWs, "
+                            << m_userPositions.size() << " user positions, " << m_beamGw.size()
+                            << " beams, " << m_patterns.size() << " gain grids");
+}
+
+uint32_t
+HapBeamSetHelper::WriteBinaryPatterns(std::string scenarioPath)
+{
+    NS_LOG_FUNCTION(scenarioPath);
+    HapScenarioSource source;
+    source.Open(scenarioPath);
+    NS_ABORT_MSG_IF(source.IsArchive(), "Binary grids are written into a scenario folder");
+    std::string binaryPath = SystemPath::Append(scenarioPath, BINARY_FOLDER);
+    SystemPath::MakeDirectories(binaryPath);
+
+    uint32_t nGrids = 0;
+    for (const std::string& fileName : source.ListFiles(PATTERNS_FOLDER))
+    {
+        if (GetBeamId(fileName, ".txt") == 0)
+        {
+            continue;
+        }
+        std::string name = std::string(PATTERNS_FOLDER) + "/" + fileName;
+        HapScenarioSource::File file = source.GetFile(name);
+        GainGrid grid = ReadGainGrid(file, name);
+
+        std::string binaryFile =
+            SystemPath::Append(binaryPath, fileName.substr(0, fileName.size() - 4) + ".bin");
+        std::ofstream out(binaryFile, std::ios::binary);
+        NS_ABORT_MSG_UNLESS(out.is_open(), "Cannot create gain grid " << binaryFile);
+        uint32_t header[4];
+        std::memcpy(&header[0], GRID_MAGIC, sizeof(GRID_MAGIC));
+        header[1] = GRID_VERSION;
+        header[2] = grid.nLat;
+        header[3] = grid.nLon;
+        double frame[4] = {grid.lat0, grid.lon0, grid.latStep, grid.lonStep};
+        uint64_t textSize = file.size;
+        uint32_t textCheck[2] = {HapScenarioSource::GetCrc32(file), 0};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(frame), sizeof(frame));
+        out.write(reinterpret_cast<const char*>(&textSize), sizeof(textSize));
+        out.write(reinterpret_cast<const char*>(textCheck), sizeof(textCheck));
+        std::vector<float> gains(grid.gains.begin(), grid.gains.end());
+        out.write(reinterpret_cast<const char*>(gains.data()), gains.size() * sizeof(float));
+        NS_ABORT_MSG_UNLESS(out, "Cannot write gain grid " << binaryFile);
+        ++nGrids;
+    }
+    NS_LOG_INFO(nGrids << " binary gain grids written to " << binaryPath);
+    return nGrids;
+}
+
+void
+HapBeamSetHelper::AddUserPosition(double latitude, double longitude)
+{
+    NS_LOG_FUNCTION(this << latitude << longitude);
+    m_userPositions.emplace_back(latitude, longitude);
+}
+
+std::set<uint32_t>
+HapBeamSetHelper::GetBeamSet()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(m_beamGw.empty(), "No beams loaded, call LoadScenario() first");
+
+    // GW positions are queried too, to pick the GW's own beam when it is needed
+    std::vector<LatLon> positions = m_userPositions;
+    positions.insert(positions.end(), m_gwPositions.begin(), m_gwPositions.end());
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<uint32_t> bestBeam(positions.size(), 0);
+    std::vector<double> bestGain(positions.size(), nan);
+    // Best beam of each GW position among the beams of that GW
+    std::map<uint32_t, std::pair<uint32_t, double>> gwBeam;
+
+    // One pass per grid keeps only one pattern in memory at a time
+    for (const auto& [beamId, fileName] : m_patterns)
+    {
+        auto gw = m_beamGw.find(beamId);
+        if (gw == m_beamGw.end())
+        {
+            continue;
+        }
+        std::vector<double> gains =
+            ReadGains(ReadGainGrid(m_source.GetFile(fileName), fileName), positions);
+        for (std::size_t i = 0; i < m_userPositions.size(); ++i)
+        {
+            if (!std::isnan(gains[i]) && (std::isnan(bestGain[i]) || gains[i] > bestGain[i]))
+            {
+                bestGain[i] = gains[i];
+                bestBeam[i] = beamId;
+            }
+        }
+
+        uint32_t gwId = gw->second;
+        double gwGain = (gwId >= 1 && gwId <= m_gwPositions.size())
+                            ? gains[m_userPositions.size() + gwId - 1]
+                            : nan;
+        auto current = gwBeam.find(gwId);
+        if (current == gwBeam.end() ||
+            (!std::isnan(gwGain) && (std::isnan(current->second.second) ||
+                                     gwGain > current->second.second)))
+        {
+            gwBeam[gwId] = std::make_pair(beamId, gwGain);
+        }
+    }
+
+    std::set<uint32_t> beams;
+    m_nUncovered = 0;
+    for (std::size_t i = 0; i < m_userPositions.size(); ++i)
+    {
+        if (bestBeam[i] == 0)
+        {
+            NS_LOG_WARN("Position " << m_userPositions[i].first << " " << m_userPositions[i].second
+                                    << " is outside every beam");
+            ++m_nUncovered;
+            continue;
+        }
+        beams.insert(bestBeam[i]);
+    }
+
+    std::set<uint32_t> servedGws;
+    for (uint32_t beamId : beams)
+    {
+        servedGws.insert(m_beamGw[beamId]);
+    }
+    for (const auto& [gwId, beam] : gwBeam)
+    {
+        if (servedGws.count(gwId) == 0)
+        {
+            beams.insert(beam.first);
+        }
+    }
+
+    NS_LOG_INFO("Beam set of " << beams.size() << " beams, " << m_nUncovered
+                               << " uncovered positions");
+    return beams;
+}
+
+uint32_t
+HapBeamSetHelper::GetNUncoveredPositions() const
+{
+    return m_nUncovered;
+}
+
+std::vector<HapBeamSetHelper::LatLon>
+HapBeamSetHelper::ReadPositions(const std::string& text)
+{
+    std::istringstream file(text);
+    std::vector<LatLon> positions;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        double latitude;
+        double longitude;
+        if (fields >> latitude >> longitude)
+        {
+            positions.emplace_back(latitude, longitude);
+        }
+    }
+    return positions;
+}
+
+bool
+HapBeamSetHelper::IsConvertedFrom(const std::string& binary, const std::string& text)
+{
+    HapScenarioSource::File file = m_source.GetFile(binary);
+    if (file.size < GRID_HEADER_SIZE || std::memcmp(file.data, GRID_MAGIC, sizeof(GRID_MAGIC)) != 0)
+    {
+        return false;
+    }
+    uint32_t version;
+    uint64_t textSize;
+    uint32_t textCrc;
+    std::memcpy(&version, file.data + 4, sizeof(version));
+    std::memcpy(&textSize, file.data + 48, sizeof(textSize));
+    std::memcpy(&textCrc, file.data + 56, sizeof(textCrc));
+    if (version != GRID_VERSION)
+    {
+        return false;
+    }
+    // The size rules out most edits without reading the text grid
+    HapScenarioSource::File source = m_source.GetFile(text);
+    return source.size == textSize && HapScenarioSource::GetCrc32(source) == textCrc;
+}
+
+double
+HapBeamSetHelper::GainGrid::Get(std::size_t index) const
+{
+    if (!packed)
+    {
+        return gains[index];
+    }
+    float gain;
+    std::memcpy(&gain, packed + index * sizeof(float), sizeof(gain));
+    return gain;
+}
+
+HapBeamSetHelper::GainGrid
+HapBeamSetHelper::ReadGainGrid(HapScenarioSource::File file, const std::string& name)
+{
+    GainGrid grid;
+    grid.packed = nullptr;
+    if (file.size >= GRID_HEADER_SIZE &&
+        std::memcmp(file.data, GRID_MAGIC, sizeof(GRID_MAGIC)) == 0)
+    {
+        uint32_t header[4];
+        double frame[4];
+        std::memcpy(header, file.data, sizeof(header));
+        std::memcpy(frame, file.data + sizeof(header), sizeof(frame));
+        NS_ABORT_MSG_IF(header[1] != GRID_VERSION, "Unsupported gain grid " << name);
+        grid.nLat = header[2];
+        grid.nLon = header[3];
+        grid.lat0 = frame[0];
+        grid.lon0 = frame[1];
+        grid.latStep = frame[2];
+        grid.lonStep = frame[3];
+        NS_ABORT_MSG_IF(grid.nLat < 2 || grid.nLon < 2 ||
+                            file.size < GRID_HEADER_SIZE + uint64_t(grid.nLat) * grid.nLon *
+                                                               sizeof(float),
+                        "Truncated gain grid " << name);
+        grid.packed = file.data + GRID_HEADER_SIZE;
+        return grid;
+    }
+
+    // Text grids are regular, latitude-major: "latitude longitude gain_dB", NaN outside the beam
+    std::string text(reinterpret_cast<const char*>(file.data), file.size);
+    std::vector<double> lat;
+    std::vector<double> lon;
+    const char* p = text.c_str();
+    char* end = nullptr;
+    while (true)
+    {
+        double values[3];
+        uint32_t n = 0;
+        for (; n < 3; ++n)
+        {
+            values[n] = std::strtod(p, &end);
+            if (end == p)
+            {
+                break;
+            }
+            p = end;
+        }
+        if (n < 3)
+        {
+            break;
+        }
+        lat.push_back(values[0]);
+        lon.push_back(values[1]);
+        grid.gains.push_back(std::pow(10.0, values[2] / 10.0));
+    }
+    NS_ABORT_MSG_IF(grid.gains.size() < 4, "Antenna pattern " << name << " is too small");
+
+    std::size_t nLon = 1;
+    while (nLon < lat.size() && lat[nLon] == lat[0])
+    {
+        ++nLon;
+    }
+    std::size_t nLat = grid.gains.size() / nLon;
+    NS_ABORT_MSG_IF(nLon < 2 || nLat < 2 || nLat * nLon != grid.gains.size(),
+                    "Antenna pattern " << name << " is not a regular grid");
+    grid.nLat = nLat;
+    grid.nLon = nLon;
+    grid.lat0 = lat[0];
+    grid.lon0 = lon[0];
+    grid.latStep = lat[nLon] - lat[0];
+    grid.lonStep = lon[1] - lon[0];
+    return grid;
+}
+
+std::vector<double>
+HapBeamSetHelper::ReadGains(const GainGrid& grid, const std::vector<LatLon>& positions)
+{
+    std::size_t nLat = grid.nLat;
+    std::size_t nLon = grid.nLon;
+    std::vector<double> result(positions.size(), std::numeric_limits<double>::quiet_NaN());
+    for (std::size_t i = 0; i < positions.size(); ++i)
+    {
+        // Bilinear interpolation of the linear gain, as SNS3 does
+        double y = (positions[i].first - grid.lat0) / grid.latStep;
+        double x = (positions[i].second - grid.lon0) / grid.lonStep;
+        if (y < 0 || x < 0 || y > nLat - 1 || x > nLon - 1)
+        {
+            continue;
+        }
+        std::size_t y0 = std::min<std::size_t>(std::floor(y), nLat - 2);
+        std::size_t x0 = std::min<std::size_t>(std::floor(x), nLon - 2);
+        double fy = y - y0;
+        double fx = x - x0;
+        double g00 = grid.Get(y0 * nLon + x0);
+        double g01 = grid.Get(y0 * nLon + x0 + 1);
+        double g10 = grid.Get((y0 + 1) * nLon + x0);
+        double g11 = grid.Get((y0 + 1) * nLon + x0 + 1);
+        result[i] = (1 - fy) * ((1 - fx) * g00 + fx * g01) + fy * ((1 - fx) * g10 + fx * g11);
+    }
+    return result;
+}
+
+} // namespace ns3
@@ -0,0 +1,148 @@
+#ifndef SIBGU_HAP_HAP_BEAM_SET_HELPER_H
+#define SIBGU_HAP_HAP_BEAM_SET_HELPER_H
+
+#include "ns3/hap-scenario-source.h"
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Computes the smallest beam set covering the configured terminals.
+ *
+ * Reads from an SNS3 scenario folder or .tsk container (see
+ * HapScenarioSource) the GW and UT positions (positions/gw_positions.txt,
+ * positions/ut_positions.txt), the beam to GW mapping (beams/fwdConf.txt)
+ * and the antenna gain grids (antennapatterns/<name>_<beamId>.txt). Every UT
+ * position, and every extra position added with AddUserPosition() (e.g.
+ * HAPs), is served by the beam with the highest gain at that position, as
+ * SNS3 does when it attaches the terminal, so that beam must be in the set.
+ * Every GW referenced by the beam configuration needs at least one of its
+ * beams: a beam already required by a terminal is reused, otherwise the beam
+ * of that GW with the highest gain at the GW position is added.
+ *
+ * The result is meant for SimulationHelper::SetBeamSet(). The gain grids are
+ * evaluated in the frame of antennapatterns/GeoPos.in, i.e. for the orbiter
+ * at its reference position.
+ *
+ * Text gain grids are parsed on every run. WriteBinaryPatterns() stores them
+ * once as binarypatterns/<name>_<beamId>.bin, next to the text grids that SNS3
+ * still reads; a binary grid is then used instead of the text one and
+ * sampled in place from the mapped file, as long as the text grid it was
+ * converted from is unchanged. A binary grid is a 64-byte header ("HAGB",
+ * version, number of latitudes, number of longitudes, then the first
+ * latitude, first longitude, latitude step and longitude step as doubles,
+ * then the size and CRC-32 of the text grid and 4 zero bytes) followed by
+ * the float linear gains, latitude-major, in host byte order.
+ */
+class HapBeamSetHelper
+{
+  public:
+    HapBeamSetHelper();
+
+    /**
+     * \brief Read the positions, beam configuration and list of antenna patterns.
+     * \param scenarioPath path of the scenario folder or container, e.g.
+     *        contrib/sibgu-hap/data/scenarios/geo-33E-hap
+     */
+    void LoadScenario(std::string scenarioPath);
+
+    /**
+     * \brief Convert the text gain grids of a scenario folder to binary grids.
+     * \param scenarioPath path of the scenario folder
+     * \return number of grids written
+     */
+    static uint32_t WriteBinaryPatterns(std::string scenarioPath);
+
+    /**
+     * \brief Add a position that must be covered, besides those of ut_positions.txt.
+     * \param latitude latitude in degrees
+     * \param longitude longitude in degrees
+     */
+    void AddUserPosition(double latitude, double longitude);
+
+    /**
+     * \brief Compute the beam set.
+     * \return beam ids, suitable for SimulationHelper::SetBeamSet()
+     */
+    std::set<uint32_t> GetBeamSet();
+
+    /**
+     * \return number of user positions outside every beam in the last
+     *         GetBeamSet() call
+     */
+    uint32_t GetNUncoveredPositions() const;
+
+  private:
+    /// Latitude and longitude in degrees.
+    typedef std::pair<double, double> LatLon;
+
+    /**
+     * Regular gain grid, latitude-major.
+     */
+    struct GainGrid
+    {
+        uint32_t nLat;             //!< number of latitudes
+        uint32_t nLon;             //!< number of longitudes
+        double lat0;               //!< first latitude, degrees
+        double lon0;               //!< first longitude, degrees
+        double latStep;            //!< latitude step, degrees
+        double lonStep;            //!< longitude step, degrees
+        std::vector<double> gains; //!< linear gains of a text grid
+        const uint8_t* packed;     //!< float linear gains of a binary grid, or null
+
+        /**
+         * \param index latitude index * nLon + longitude index
+         * \return linear gain, NaN outside the beam
+         */
+        double Get(std::size_t index) const;
+    };
+
+    /**
+     * \brief Read a positions file, one "latitude longitude altitude" per line.
+     * \param text contents of the file
+     * \return positions, in file order
+     */
+    static std::vector<LatLon> ReadPositions(const std::string& text);
+
+    /**
+     * \param binary binary gain grid name in m_source
+     * \param text text gain grid name in m_source
+     * \return true if the binary grid was converted from the current text grid
+     */
+    bool IsConvertedFrom(const std::string& binary, const std::string& text);
+
+    /**
+     * \brief Decode a binary gain grid, or parse a text one.
+     * \param file contents of the grid
+     * \param name file name, for the error messages
+     * \return the grid; a binary grid points into file
+     */
+    static GainGrid ReadGainGrid(HapScenarioSource::File file, const std::string& name);
+
+    /**
+     * \brief Evaluate one gain grid at the given positions.
+     * \param grid gain grid
+     * \param positions query positions
+     * \return linear gain per position, NaN outside the pattern
+     */
+    static std::vector<double> ReadGains(const GainGrid& grid,
+                                         const std::vector<LatLon>& positions);
+
+    HapScenarioSource m_source;             //!< scenario files
+    std::vector<LatLon> m_gwPositions;      //!< GW positions, index gwId - 1
+    std::vector<LatLon> m_userPositions;    //!< positions served by their best beam
+    std::map<uint32_t, uint32_t> m_beamGw;  //!< beam id to GW id
+    std::map<uint32_t, std::string> m_patterns; //!< beam id to gain grid name in m_source
+    uint32_t m_nUncovered;                  //!< uncovered user positions
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_BEAM_SET_HELPER_H
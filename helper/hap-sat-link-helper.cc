@@ -0,0 +1,64 @@
+#include "hap-sat-link-helper.h"
+
+#include "ns3/hap-sat-link-channel.h"
+#include "ns3/hap-sat-link-net-device.h"
+#include "ns3/log.h"
+#include "ns3/mac48-address.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapSatLinkHelper");
+
+HapSatLinkHelper::HapSatLinkHelper()
+{
+    m_deviceFactory.SetTypeId("ns3::HapSatLinkNetDevice");
+    m_channelFactory.SetTypeId("ns3::HapSatLinkChannel");
+}
+
+void
+HapSatLinkHelper::SetDeviceAttribute(std::string name, const AttributeValue& value)
+{
+    m_deviceFactory.Set(name, value);
+}
+
+void
+HapSatLinkHelper::SetChannelAttribute(std::string name, const AttributeValue& value)
+{
+    m_channelFactory.Set(name, value);
+}
+
+NetDeviceContainer
+HapSatLinkHelper::Install(Ptr<Node> a, Ptr<Node> b) const
+{
+    NS_LOG_FUNCTION(this << a << b);
+
+    Ptr<HapSatLinkChannel> channel = m_channelFactory.Create<HapSatLinkChannel>();
+    NetDeviceContainer devices;
+    for (Ptr<Node> node : {a, b})
+    {
+        Ptr<HapSatLinkNetDevice> device = m_deviceFactory.Create<HapSatLinkNetDevice>();
+        device->SetAddress(Mac48Address::Allocate());
+        node->AddDevice(device);
+        device->Attach(channel);
+        devices.Add(device);
+    }
+    return devices;
+}
+
+int64_t
+HapSatLinkHelper::AssignStreams(NetDeviceContainer devices, int64_t stream)
+{
+    int64_t current = stream;
+    for (uint32_t i = 0; i < devices.GetN(); ++i)
+    {
+        Ptr<HapSatLinkNetDevice> device = DynamicCast<HapSatLinkNetDevice>(devices.Get(i));
+        if (device)
+        {
+            current += device->AssignStreams(current);
+        }
+    }
+    return current - stream;
+}
+
+} // namespace ns3
@@ -0,0 +1,62 @@
+#ifndef SIBGU_HAP_HAP_SAT_LINK_HELPER_H
+#define SIBGU_HAP_HAP_SAT_LINK_HELPER_H
+
+#include "ns3/net-device-container.h"
+#include "ns3/node.h"
+#include "ns3/object-factory.h"
+
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Builds HapSatLinkNetDevice pairs joined by a HapSatLinkChannel.
+ *
+ * Device attributes (DataRate, QueueSize, MaxBatchSize, TxPower,
+ * AntennaGain, ...) apply to both ends; use SetDeviceAttribute() between
+ * two Install() calls for asymmetric links, as for the uplink and the
+ * downlink of a feeder link.
+ */
+class HapSatLinkHelper
+{
+  public:
+    HapSatLinkHelper();
+
+    /**
+     * \param name attribute of ns3::HapSatLinkNetDevice
+     * \param value its value
+     */
+    void SetDeviceAttribute(std::string name, const AttributeValue& value);
+
+    /**
+     * \param name attribute of ns3::HapSatLinkChannel
+     * \param value its value
+     */
+    void SetChannelAttribute(std::string name, const AttributeValue& value);
+
+    /**
+     * \brief Join two nodes with a new link.
+     * \param a first node, e.g. the HAP
+     * \param b second node, e.g. the satellite
+     * \return the device of a, then that of b
+     */
+    NetDeviceContainer Install(Ptr<Node> a, Ptr<Node> b) const;
+
+    /**
+     * \brief Assign fixed random variable streams to the devices.
+     * \param devices devices of Install()
+     * \param stream first stream index to use
+     * \return number of stream indices assigned
+     */
+    static int64_t AssignStreams(NetDeviceContainer devices, int64_t stream);
+
+  private:
+    ObjectFactory m_deviceFactory;  //!< device factory
+    ObjectFactory m_channelFactory; //!< channel factory
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_SAT_LINK_HELPER_H
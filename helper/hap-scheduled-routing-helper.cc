@@ -0,0 +1,54 @@
+#include "hap-scheduled-routing-helper.h"
+
+#include "ns3/ipv4-list-routing.h"
+#include "ns3/log.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapScheduledRoutingHelper");
+
+HapScheduledRoutingHelper::HapScheduledRoutingHelper()
+{
+}
+
+HapScheduledRoutingHelper*
+HapScheduledRoutingHelper::Copy() const
+{
+    return new HapScheduledRoutingHelper(*this);
+}
+
+Ptr<Ipv4RoutingProtocol>
+HapScheduledRoutingHelper::Create(Ptr<Node> node) const
+{
+    NS_LOG_FUNCTION(this << node);
+    return CreateObject<HapScheduledRouting>();
+}
+
+Ptr<HapScheduledRouting>
+HapScheduledRoutingHelper::GetScheduledRouting(Ptr<Ipv4> ipv4)
+{
+    Ptr<Ipv4RoutingProtocol> protocol = ipv4->GetRoutingProtocol();
+    Ptr<HapScheduledRouting> routing = DynamicCast<HapScheduledRouting>(protocol);
+    if (routing)
+    {
+        return routing;
+    }
+    Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(protocol);
+    if (!list)
+    {
+        return nullptr;
+    }
+    for (uint32_t i = 0; i < list->GetNRoutingProtocols(); ++i)
+    {
+        int16_t priority;
+        routing = DynamicCast<HapScheduledRouting>(list->GetRoutingProtocol(i, priority));
+        if (routing)
+        {
+            return routing;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace ns3
@@ -0,0 +1,46 @@
+#ifndef SIBGU_HAP_HAP_SCHEDULED_ROUTING_HELPER_H
+#define SIBGU_HAP_HAP_SCHEDULED_ROUTING_HELPER_H
+
+#include "ns3/hap-scheduled-routing.h"
+#include "ns3/ipv4-routing-helper.h"
+#include "ns3/ipv4.h"
+#include "ns3/node.h"
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Creates HapScheduledRouting on the nodes of an InternetStackHelper.
+ *
+ * Add it to an Ipv4ListRoutingHelper with a higher priority than
+ * Ipv4StaticRoutingHelper, which keeps local delivery and the fixed routes.
+ */
+class HapScheduledRoutingHelper : public Ipv4RoutingHelper
+{
+  public:
+    HapScheduledRoutingHelper();
+
+    /**
+     * \return a copy of this helper, for Ipv4ListRoutingHelper
+     */
+    HapScheduledRoutingHelper* Copy() const override;
+
+    /**
+     * \param node the node
+     * \return a new HapScheduledRouting
+     */
+    Ptr<Ipv4RoutingProtocol> Create(Ptr<Node> node) const override;
+
+    /**
+     * \brief Find the HapScheduledRouting of a node.
+     *
+     * \param ipv4 IPv4 of the node
+     * \return the protocol, directly installed or in an Ipv4ListRouting; null if none
+     */
+    static Ptr<HapScheduledRouting> GetScheduledRouting(Ptr<Ipv4> ipv4);
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_SCHEDULED_ROUTING_HELPER_H
@@ -0,0 +1,161 @@
+#include "hap-wifi-aggregation-helper.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/uinteger.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-phy.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapWifiAggregationHelper");
+
+namespace
+{
+
+/// Speed of light in vacuum [m/s].
+const double SPEED_OF_LIGHT = 299792458.0;
+
+/// AIFSN of the best effort queue.
+const uint32_t BE_AIFSN = 3;
+
+/// Mean backoff of the best effort queue, CWmin / 2 [slots].
+const double BE_MEAN_BACKOFF = 7.5;
+
+/// Preambles of the A-MPDU and the block ACK, and the block ACK itself.
+const Time RESPONSE_OVERHEAD = MicroSeconds(100);
+
+/// Longest PPDU of HT and VHT, aPPDUMaxTime.
+const Time PPDU_MAX_TIME = MicroSeconds(5484);
+
+/// A-MSDU subframe header and padding [bytes].
+const uint32_t AMSDU_SUBFRAME_OVERHEAD = 16;
+
+/// MAC header and FCS of a QoS data MPDU, with the A-MPDU delimiter [bytes].
+const uint32_t MPDU_OVERHEAD = 34;
+
+} // namespace
+
+HapWifiAggregationHelper::HapWifiAggregationHelper()
+    : m_maxDistance(0),
+      m_rate("65Mbps"),
+      m_msduSize(1500),
+      m_efficiency(0.9)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapWifiAggregationHelper::SetMaxDistance(double maxDistance)
+{
+    NS_ABORT_MSG_IF(maxDistance < 0, "Negative link distance " << maxDistance);
+    m_maxDistance = maxDistance;
+}
+
+void
+HapWifiAggregationHelper::SetDataRate(DataRate rate)
+{
+    NS_ABORT_MSG_IF(rate.GetBitRate() == 0, "Null data rate");
+    m_rate = rate;
+}
+
+void
+HapWifiAggregationHelper::SetMsduSize(uint32_t msduSize)
+{
+    NS_ABORT_MSG_IF(msduSize == 0, "Null MSDU size");
+    m_msduSize = msduSize;
+}
+
+void
+HapWifiAggregationHelper::SetEfficiency(double efficiency)
+{
+    NS_ABORT_MSG_UNLESS(efficiency > 0 && efficiency < 1, "Efficiency must be in (0, 1)");
+    m_efficiency = efficiency;
+}
+
+HapWifiAggregationHelper::Profile
+HapWifiAggregationHelper::GetProfile(WifiStandard standard, Time slot, Time sifs) const
+{
+    NS_ABORT_MSG_IF(standard < WIFI_STANDARD_80211n,
+                    "Aggregation needs 802.11n or later, not " << standard);
+
+    // Limits of the standard: A-MPDU size, A-MSDU size (an HT MPDU inside
+    // an A-MPDU is limited to 4095 bytes) and block ACK window
+    uint32_t ampduLimit = 65535;
+    uint32_t amsduLimit = 4095;
+    uint32_t bufferLimit = 64;
+    if (standard >= WIFI_STANDARD_80211ac)
+    {
+        ampduLimit = 1048575;
+        amsduLimit = 11398;
+    }
+    if (standard >= WIFI_STANDARD_80211ax)
+    {
+        ampduLimit = 6500631;
+        bufferLimit = 256;
+    }
+
+    Profile profile;
+    Time roundTrip = Seconds(2 * m_maxDistance / SPEED_OF_LIGHT);
+    profile.overhead = sifs * 2 + slot * BE_AIFSN + slot * BE_MEAN_BACKOFF + RESPONSE_OVERHEAD +
+                       roundTrip;
+    Time airtime = profile.overhead * (m_efficiency / (1 - m_efficiency));
+    airtime = std::min(airtime, PPDU_MAX_TIME);
+
+    uint64_t bytes = m_rate.GetBitRate() * airtime.GetSeconds() / 8;
+    uint32_t mpduSize = m_msduSize + MPDU_OVERHEAD;
+    bytes = std::clamp<uint64_t>(bytes, mpduSize, ampduLimit);
+
+    // A-MSDUs only when single-MSDU MPDUs would overflow the window
+    uint32_t nMsdus = std::max<uint64_t>(1, bytes / mpduSize);
+    uint32_t msdusPerMpdu = (nMsdus + bufferLimit - 1) / bufferLimit;
+    uint32_t subframeSize = m_msduSize + AMSDU_SUBFRAME_OVERHEAD;
+    msdusPerMpdu = std::min(msdusPerMpdu, std::max(1u, amsduLimit / subframeSize));
+    profile.maxAmsduSize = msdusPerMpdu > 1 ? msdusPerMpdu * subframeSize : 0;
+    if (profile.maxAmsduSize)
+    {
+        mpduSize = profile.maxAmsduSize + MPDU_OVERHEAD;
+    }
+
+    uint32_t nMpdus = std::clamp<uint64_t>(bytes / mpduSize, 1, bufferLimit);
+    profile.bufferSize = nMpdus;
+    profile.maxAmpduSize = std::min<uint64_t>(uint64_t(nMpdus) * mpduSize, ampduLimit);
+    profile.airtime = Seconds(profile.maxAmpduSize * 8.0 / m_rate.GetBitRate());
+    return profile;
+}
+
+void
+HapWifiAggregationHelper::Install(NetDeviceContainer devices) const
+{
+    NS_LOG_FUNCTION(this);
+    for (auto it = devices.Begin(); it != devices.End(); ++it)
+    {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(*it);
+        if (!device || !device->GetMac()->GetQosSupported())
+        {
+            continue;
+        }
+        Ptr<WifiPhy> phy = device->GetPhy();
+        Profile profile = GetProfile(phy->GetStandard(), phy->GetSlot(), phy->GetSifs());
+        NS_LOG_INFO("Node " << device->GetNode()->GetId() << ": A-MPDU " << profile.maxAmpduSize
+                            << " bytes, A-MSDU " << profile.maxAmsduSize << " bytes, window "
+                            << profile.bufferSize << ", airtime " << profile.airtime.As(Time::US)
+                            << " per " << profile.overhead.As(Time::US) << " of overhead");
+
+        Ptr<WifiMac> mac = device->GetMac();
+        for (std::string ac : {"BE", "BK"})
+        {
+            mac->SetAttribute(ac + "_MaxAmpduSize", UintegerValue(profile.maxAmpduSize));
+            mac->SetAttribute(ac + "_MaxAmsduSize", UintegerValue(profile.maxAmsduSize));
+        }
+        mac->SetAttribute("MpduBufferSize", UintegerValue(profile.bufferSize));
+    }
+}
+
+} // namespace ns3
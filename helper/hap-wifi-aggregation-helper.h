@@ -0,0 +1,96 @@
+#ifndef SIBGU_HAP_HAP_WIFI_AGGREGATION_HELPER_H
+#define SIBGU_HAP_HAP_WIFI_AGGREGATION_HELPER_H
+
+#include "ns3/data-rate.h"
+#include "ns3/net-device-container.h"
+#include "ns3/nstime.h"
+#include "ns3/wifi-standards.h"
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief A-MPDU/A-MSDU aggregation sized for HAP backhaul links.
+ *
+ * Every channel access on a HAP link costs AIFS, the mean backoff, the
+ * preambles, SIFS and the block ACK, plus the round trip over the link
+ * distance. With the slot lengthened by HapWifiRangeHelper this overhead
+ * reaches about a millisecond, against 185 us of airtime for a 1500 byte
+ * frame at 65 Mbps.
+ *
+ * The helper sizes one A-MPDU per access so that its airtime is
+ * Efficiency / (1 - Efficiency) times the overhead (the bandwidth-delay
+ * product of the exchange), within the PPDU duration limit and the
+ * A-MPDU size limit of the standard. MSDUs are packed in A-MSDUs once
+ * the A-MPDU would need more MPDUs than the block ACK window holds, and
+ * the window (MpduBufferSize) is set to the number of MPDUs in flight.
+ *
+ * Install() applies the sizes to the BE and BK queues of QoS (HT or later)
+ * WifiNetDevices; run it after HapWifiRangeHelper::Install(), as the
+ * overhead is computed from the PHY slot and SIFS.
+ */
+class HapWifiAggregationHelper
+{
+  public:
+    /// Aggregation sizes of one device.
+    struct Profile
+    {
+        uint32_t maxAmpduSize; //!< A-MPDU size [bytes]
+        uint16_t maxAmsduSize; //!< A-MSDU size [bytes], 0 if MSDUs are not aggregated
+        uint16_t bufferSize;   //!< block ACK window [MPDUs]
+        Time airtime;          //!< airtime of a full A-MPDU
+        Time overhead;         //!< time per channel access besides the A-MPDU
+    };
+
+    HapWifiAggregationHelper();
+
+    /**
+     * \param maxDistance longest link of the devices [m]
+     */
+    void SetMaxDistance(double maxDistance);
+
+    /**
+     * \param rate PHY rate of the data frames
+     */
+    void SetDataRate(DataRate rate);
+
+    /**
+     * \param msduSize size of the MSDUs, e.g. IP packets [bytes]
+     */
+    void SetMsduSize(uint32_t msduSize);
+
+    /**
+     * \param efficiency share of the channel access time spent on data, in (0, 1)
+     */
+    void SetEfficiency(double efficiency);
+
+    /**
+     * \brief Compute the aggregation sizes.
+     * \param standard PHY standard, at least 802.11n
+     * \param slot PHY slot
+     * \param sifs PHY SIFS
+     * \return aggregation sizes
+     */
+    Profile GetProfile(WifiStandard standard, Time slot, Time sifs) const;
+
+    /**
+     * \brief Enable aggregation on the devices.
+     *
+     * Non-Wi-Fi and non-QoS devices are ignored; a QoS device with a
+     * standard older than 802.11n is an error.
+     *
+     * \param devices the devices
+     */
+    void Install(NetDeviceContainer devices) const;
+
+  private:
+    double m_maxDistance; //!< longest link [m]
+    DataRate m_rate;      //!< data frame rate
+    uint32_t m_msduSize;  //!< MSDU size [bytes]
+    double m_efficiency;  //!< target data share of the access time
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_WIFI_AGGREGATION_HELPER_H
@@ -0,0 +1,83 @@
+#include "hap-wifi-range-helper.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-phy.h"
+
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapWifiRangeHelper");
+
+namespace
+{
+
+/// Speed of light in vacuum [m/s].
+const double SPEED_OF_LIGHT = 299792458.0;
+
+/// Air propagation time of one coverage class [us].
+const double COVERAGE_CLASS_STEP_US = 3.0;
+
+} // namespace
+
+HapWifiRangeHelper::HapWifiRangeHelper()
+    : m_maxDistance(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapWifiRangeHelper::SetMaxDistance(double maxDistance)
+{
+    NS_LOG_FUNCTION(this << maxDistance);
+    NS_ABORT_MSG_IF(maxDistance < 0, "Negative link distance " << maxDistance);
+    m_maxDistance = maxDistance;
+}
+
+double
+HapWifiRangeHelper::GetMaxDistance() const
+{
+    return m_maxDistance;
+}
+
+uint32_t
+HapWifiRangeHelper::GetCoverageClass() const
+{
+    double roundTripUs = 2 * m_maxDistance / SPEED_OF_LIGHT * 1e6;
+    return std::ceil(roundTripUs / COVERAGE_CLASS_STEP_US);
+}
+
+Time
+HapWifiRangeHelper::GetAirPropagationTime() const
+{
+    return MicroSeconds(COVERAGE_CLASS_STEP_US * GetCoverageClass());
+}
+
+void
+HapWifiRangeHelper::Install(NetDeviceContainer devices) const
+{
+    NS_LOG_FUNCTION(this);
+    Time airPropagationTime = GetAirPropagationTime();
+    for (auto it = devices.Begin(); it != devices.End(); ++it)
+    {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(*it);
+        if (!device)
+        {
+            continue;
+        }
+        for (uint8_t linkId = 0; linkId < device->GetNPhys(); ++linkId)
+        {
+            Ptr<WifiPhy> phy = device->GetPhy(linkId);
+            Time slot = phy->GetSlot() + airPropagationTime;
+            NS_LOG_INFO("Node " << device->GetNode()->GetId() << " link " << +linkId << ": slot "
+                                << phy->GetSlot().As(Time::US) << " -> " << slot.As(Time::US));
+            phy->SetSlot(slot);
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,69 @@
+#ifndef SIBGU_HAP_HAP_WIFI_RANGE_HELPER_H
+#define SIBGU_HAP_HAP_WIFI_RANGE_HELPER_H
+
+#include "ns3/net-device-container.h"
+#include "ns3/nstime.h"
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Long-distance timing profile of Wi-Fi devices on HAP links.
+ *
+ * WifiMac and its frame exchange managers are configured for terrestrial
+ * distances: the ACK and CTS timeouts are SIFS + slot + PHY header, with a
+ * slot that allows about 1 us of air propagation. A 20 km HAP-ground link
+ * has a round trip of 133 us, so every response arrives after its timeout
+ * and each frame is retried until it is dropped.
+ *
+ * Like the 802.11 coverage classes (aAirPropagationTime in steps of 3 us),
+ * the helper lengthens the slot of the PHYs by the round trip time over the
+ * maximum link distance, rounded up to 3 us. The ACK, block ACK and CTS
+ * timeouts, EIFS and the backoff slots all follow the PHY slot. Unlike
+ * 802.11, the coverage class is not capped at 31 (about 14 km).
+ *
+ * Install() must run once, after WifiHelper::Install(): it adds the
+ * propagation time to the slot the standard configured.
+ */
+class HapWifiRangeHelper
+{
+  public:
+    HapWifiRangeHelper();
+
+    /**
+     * \param maxDistance longest link of the devices [m]
+     */
+    void SetMaxDistance(double maxDistance);
+
+    /**
+     * \return longest link of the devices [m]
+     */
+    double GetMaxDistance() const;
+
+    /**
+     * \return coverage class, the round trip time in units of 3 us rounded up
+     */
+    uint32_t GetCoverageClass() const;
+
+    /**
+     * \return air propagation time added to the slot
+     */
+    Time GetAirPropagationTime() const;
+
+    /**
+     * \brief Lengthen the slot of every Wi-Fi PHY of the devices.
+     *
+     * Devices other than WifiNetDevice are ignored.
+     *
+     * \param devices the devices
+     */
+    void Install(NetDeviceContainer devices) const;
+
+  private:
+    double m_maxDistance; //!< longest link [m]
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_WIFI_RANGE_HELPER_H
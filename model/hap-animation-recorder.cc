@@ -0,0 +1,439 @@
+#include "hap-animation-recorder.h"
+
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/ipv4.h"
+#include "ns3/log.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapAnimationRecorder");
+
+NS_OBJECT_ENSURE_REGISTERED(HapAnimationRecorder);
+
+namespace
+{
+
+/// File signature of an animation recording.
+const char ANIMATION_MAGIC[4] = {'H', 'A', 'N', 'M'};
+/// Current binary format version.
+const uint32_t ANIMATION_VERSION = 1;
+/// Frame of node positions.
+const uint8_t FRAME_POSITIONS = 1;
+/// Frame of flow summaries.
+const uint8_t FRAME_FLOWS = 2;
+
+template <typename T>
+void
+WriteRaw(std::ofstream& out, T value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T
+ReadRaw(std::ifstream& in, const std::string& fileName)
+{
+    T value{};
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    NS_ABORT_MSG_UNLESS(in.good(), "Truncated animation file: " << fileName);
+    return value;
+}
+
+/**
+ * \param value text
+ * \return value with the XML special characters escaped
+ */
+std::string
+EscapeXml(const std::string& value)
+{
+    std::string escaped;
+    for (char c : value)
+    {
+        switch (c)
+        {
+        case '&':
+            escaped += "&amp;";
+            break;
+        case '<':
+            escaped += "&lt;";
+            break;
+        case '>':
+            escaped += "&gt;";
+            break;
+        case '"':
+            escaped += "&quot;";
+            break;
+        default:
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+} // namespace
+
+TypeId
+HapAnimationRecorder::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapAnimationRecorder")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapAnimationRecorder>()
+            .AddAttribute("SampleInterval",
+                          "Period of the position samples",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&HapAnimationRecorder::m_sampleInterval),
+                          MakeTimeChecker(TimeStep(1)))
+            .AddAttribute("FlowInterval",
+                          "Period of the packet flow summaries",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&HapAnimationRecorder::m_flowInterval),
+                          MakeTimeChecker(TimeStep(1)))
+            .AddAttribute("MinDistance",
+                          "Smallest movement, in meters, for which a position is written",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&HapAnimationRecorder::m_minDistance),
+                          MakeDoubleChecker<double>(0));
+    return tid;
+}
+
+HapAnimationRecorder::HapAnimationRecorder()
+    : m_sampleInterval(Seconds(1)),
+      m_flowInterval(Seconds(1)),
+      m_minDistance(1.0),
+      m_flowIntervalNumber(0),
+      m_nPositions(0),
+      m_nFlows(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapAnimationRecorder::~HapAnimationRecorder()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapAnimationRecorder::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Stop();
+    m_nodes.clear();
+    m_index.clear();
+    m_flows.clear();
+    m_lastSender.clear();
+    Object::DoDispose();
+}
+
+void
+HapAnimationRecorder::Add(Ptr<Node> node, std::string description)
+{
+    NS_LOG_FUNCTION(this << node << description);
+    NS_ABORT_MSG_IF(m_out.is_open(), "Nodes must be added before Start()");
+    NS_ABORT_MSG_UNLESS(node->GetObject<MobilityModel>(),
+                        "Node " << node->GetId() << " has no mobility model");
+    if (m_index.emplace(node->GetId(), m_nodes.size()).second)
+    {
+        m_nodes.push_back(node);
+        m_descriptions.push_back(description);
+    }
+}
+
+void
+HapAnimationRecorder::Add(NodeContainer nodes)
+{
+    for (auto it = nodes.Begin(); it != nodes.End(); ++it)
+    {
+        Add(*it);
+    }
+}
+
+void
+HapAnimationRecorder::Start(std::string fileName)
+{
+    NS_LOG_FUNCTION(this << fileName);
+    NS_ABORT_MSG_IF(m_out.is_open(), "Animation already started");
+
+    m_out.open(fileName, std::ios::binary | std::ios::trunc);
+    NS_ABORT_MSG_UNLESS(m_out.is_open(), "Cannot create animation file: " << fileName);
+    m_out.write(ANIMATION_MAGIC, sizeof(ANIMATION_MAGIC));
+    WriteRaw<uint32_t>(m_out, ANIMATION_VERSION);
+    WriteRaw<double>(m_out, m_sampleInterval.GetSeconds());
+    WriteRaw<double>(m_out, m_flowInterval.GetSeconds());
+    WriteRaw<uint32_t>(m_out, m_nodes.size());
+    for (uint32_t i = 0; i < m_nodes.size(); ++i)
+    {
+        WriteRaw<uint32_t>(m_out, m_nodes[i]->GetId());
+        WriteRaw<uint32_t>(m_out, m_descriptions[i].size());
+        m_out.write(m_descriptions[i].data(), m_descriptions[i].size());
+    }
+
+    for (const Ptr<Node>& node : m_nodes)
+    {
+        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+        if (ipv4)
+        {
+            ipv4->TraceConnectWithoutContext("Tx",
+                                             MakeCallback(&HapAnimationRecorder::Ipv4Tx, this));
+            ipv4->TraceConnectWithoutContext("Rx",
+                                             MakeCallback(&HapAnimationRecorder::Ipv4Rx, this));
+        }
+    }
+
+    m_written.assign(m_nodes.size(), Vector());
+    m_hasWritten.assign(m_nodes.size(), false);
+    m_flowIntervalNumber = Simulator::Now().GetTimeStep() / m_flowInterval.GetTimeStep();
+    SamplePositions();
+    Time nextFlush = TimeStep(m_flowInterval.GetTimeStep() * (m_flowIntervalNumber + 1));
+    m_flowEvent = Simulator::Schedule(nextFlush - Simulator::Now(),
+                                      &HapAnimationRecorder::FlushFlows,
+                                      this);
+}
+
+void
+HapAnimationRecorder::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_out.is_open())
+    {
+        return;
+    }
+    m_sampleEvent.Cancel();
+    m_flowEvent.Cancel();
+    FlushFlows();
+    m_flowEvent.Cancel();
+    NS_ABORT_MSG_UNLESS(m_out.good(), "Failed to write animation file");
+    m_out.close();
+    NS_LOG_INFO("Animation: " << m_nPositions << " positions, " << m_nFlows << " flows");
+}
+
+void
+HapAnimationRecorder::RecordFlow(uint32_t from, uint32_t to, uint32_t bytes)
+{
+    auto sender = m_index.find(from);
+    auto receiver = m_index.find(to);
+    if (sender != m_index.end() && receiver != m_index.end())
+    {
+        AccountFlow(sender->second, receiver->second, bytes);
+    }
+}
+
+uint64_t
+HapAnimationRecorder::GetNPositions() const
+{
+    return m_nPositions;
+}
+
+uint64_t
+HapAnimationRecorder::GetNFlows() const
+{
+    return m_nFlows;
+}
+
+void
+HapAnimationRecorder::SamplePositions()
+{
+    std::vector<std::pair<uint32_t, Vector>> moved;
+    for (uint32_t i = 0; i < m_nodes.size(); ++i)
+    {
+        Vector position = m_nodes[i]->GetObject<MobilityModel>()->GetPosition();
+        if (!m_hasWritten[i] || CalculateDistance(position, m_written[i]) > m_minDistance)
+        {
+            moved.emplace_back(i, position);
+            m_written[i] = position;
+            m_hasWritten[i] = true;
+        }
+    }
+    if (!moved.empty())
+    {
+        WriteRaw<uint8_t>(m_out, FRAME_POSITIONS);
+        WriteRaw<double>(m_out, Simulator::Now().GetSeconds());
+        WriteRaw<uint32_t>(m_out, moved.size());
+        for (const auto& [index, position] : moved)
+        {
+            WriteRaw<uint32_t>(m_out, index);
+            WriteRaw<double>(m_out, position.x);
+            WriteRaw<double>(m_out, position.y);
+            WriteRaw<double>(m_out, position.z);
+        }
+        m_nPositions += moved.size();
+    }
+    m_sampleEvent =
+        Simulator::Schedule(m_sampleInterval, &HapAnimationRecorder::SamplePositions, this);
+}
+
+void
+HapAnimationRecorder::FlushFlows()
+{
+    if (!m_flows.empty())
+    {
+        WriteRaw<uint8_t>(m_out, FRAME_FLOWS);
+        Time start = TimeStep(m_flowInterval.GetTimeStep() * m_flowIntervalNumber);
+        WriteRaw<double>(m_out, start.GetSeconds());
+        WriteRaw<uint32_t>(m_out, m_flows.size());
+        for (const auto& [pair, flow] : m_flows)
+        {
+            WriteRaw<uint32_t>(m_out, pair.first);
+            WriteRaw<uint32_t>(m_out, pair.second);
+            WriteRaw<uint32_t>(m_out, flow.packets);
+            WriteRaw<uint64_t>(m_out, flow.bytes);
+        }
+        m_nFlows += m_flows.size();
+        m_flows.clear();
+    }
+
+    // Packets sent more than one interval ago are not in flight anymore
+    for (auto it = m_lastSender.begin(); it != m_lastSender.end();)
+    {
+        it = it->second.second < m_flowIntervalNumber ? m_lastSender.erase(it) : std::next(it);
+    }
+    ++m_flowIntervalNumber;
+    m_flowEvent = Simulator::Schedule(m_flowInterval, &HapAnimationRecorder::FlushFlows, this);
+}
+
+void
+HapAnimationRecorder::AccountFlow(uint32_t from, uint32_t to, uint32_t bytes)
+{
+    Flow& flow = m_flows[{from, to}];
+    ++flow.packets;
+    flow.bytes += bytes;
+}
+
+void
+HapAnimationRecorder::Ipv4Tx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t /* interface */)
+{
+    uint32_t index = m_index.at(ipv4->GetObject<Node>()->GetId());
+    m_lastSender[packet->GetUid()] = {index, m_flowIntervalNumber};
+}
+
+void
+HapAnimationRecorder::Ipv4Rx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t /* interface */)
+{
+    auto sender = m_lastSender.find(packet->GetUid());
+    uint32_t index = m_index.at(ipv4->GetObject<Node>()->GetId());
+    if (sender != m_lastSender.end() && sender->second.first != index)
+    {
+        AccountFlow(sender->second.first, index, packet->GetSize());
+    }
+}
+
+void
+HapAnimationRecorder::ExportNetAnim(std::string fileName,
+                                    std::string xmlFileName,
+                                    Time start,
+                                    Time stop)
+{
+    NS_LOG_FUNCTION(fileName << xmlFileName << start << stop);
+
+    std::ifstream in(fileName, std::ios::binary);
+    NS_ABORT_MSG_UNLESS(in.is_open(), "Cannot open animation file: " << fileName);
+    char magic[sizeof(ANIMATION_MAGIC)];
+    in.read(magic, sizeof(magic));
+    NS_ABORT_MSG_UNLESS(in.good() && std::equal(magic, magic + sizeof(magic), ANIMATION_MAGIC),
+                        "Not an animation file: " << fileName);
+    uint32_t version = ReadRaw<uint32_t>(in, fileName);
+    NS_ABORT_MSG_UNLESS(version == ANIMATION_VERSION,
+                        "Unsupported animation file version " << version << ": " << fileName);
+    ReadRaw<double>(in, fileName);
+    double flowInterval = ReadRaw<double>(in, fileName);
+    uint32_t nNodes = ReadRaw<uint32_t>(in, fileName);
+    std::vector<uint32_t> nodeIds(nNodes);
+    std::vector<std::string> descriptions(nNodes);
+    for (uint32_t i = 0; i < nNodes; ++i)
+    {
+        nodeIds[i] = ReadRaw<uint32_t>(in, fileName);
+        descriptions[i].resize(ReadRaw<uint32_t>(in, fileName));
+        in.read(&descriptions[i][0], descriptions[i].size());
+    }
+
+    std::ofstream xml(xmlFileName, std::ios::trunc);
+    NS_ABORT_MSG_UNLESS(xml.is_open(), "Cannot create NetAnim file: " << xmlFileName);
+    xml << std::setprecision(12);
+    xml << "<anim ver=\"netanim-3.108\" filetype=\"animation\" >\n";
+    xml << "<info info=\"Exported from " << EscapeXml(fileName) << "\" />\n";
+
+    // Nodes are declared at their position at the start of the window
+    std::vector<Vector> positions(nNodes);
+    double startSeconds = start.GetSeconds();
+    double stopSeconds = stop.GetSeconds();
+    bool declared = false;
+    auto declare = [&]() {
+        for (uint32_t i = 0; i < nNodes; ++i)
+        {
+            xml << "<node id=\"" << nodeIds[i] << "\" sysId=\"0\" locX=\"" << positions[i].x
+                << "\" locY=\"" << positions[i].y << "\" />\n";
+            if (!descriptions[i].empty())
+            {
+                xml << "<nu p=\"d\" t=\"" << startSeconds << "\" id=\"" << nodeIds[i]
+                    << "\" descr=\"" << EscapeXml(descriptions[i]) << "\" />\n";
+            }
+        }
+        declared = true;
+    };
+
+    uint8_t type;
+    while (in.read(reinterpret_cast<char*>(&type), sizeof(type)))
+    {
+        double time = ReadRaw<double>(in, fileName);
+        uint32_t count = ReadRaw<uint32_t>(in, fileName);
+        // Flow frames are written at the end of their interval, so frames are
+        // only nearly in time order and the whole file is read
+        bool inWindow = time >= startSeconds && time <= stopSeconds;
+        if (inWindow && !declared)
+        {
+            declare();
+        }
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (type == FRAME_POSITIONS)
+            {
+                uint32_t index = ReadRaw<uint32_t>(in, fileName);
+                Vector& position = positions.at(index);
+                position.x = ReadRaw<double>(in, fileName);
+                position.y = ReadRaw<double>(in, fileName);
+                position.z = ReadRaw<double>(in, fileName);
+                if (inWindow)
+                {
+                    xml << "<nu p=\"p\" t=\"" << time << "\" id=\"" << nodeIds[index]
+                        << "\" x=\"" << position.x << "\" y=\"" << position.y << "\" z=\""
+                        << position.z << "\" />\n";
+                }
+            }
+            else
+            {
+                NS_ABORT_MSG_UNLESS(type == FRAME_FLOWS, "Corrupt animation file: " << fileName);
+                uint32_t from = ReadRaw<uint32_t>(in, fileName);
+                uint32_t to = ReadRaw<uint32_t>(in, fileName);
+                uint32_t packets = ReadRaw<uint32_t>(in, fileName);
+                uint64_t bytes = ReadRaw<uint64_t>(in, fileName);
+                if (inWindow)
+                {
+                    // One packet crossing the whole interval stands for the flow
+                    double rx = time + flowInterval;
+                    xml << "<p fId=\"" << nodeIds.at(from) << "\" fbTx=\"" << time
+                        << "\" lbTx=\"" << time << "\" meta-info=\"" << packets << " packets, "
+                        << bytes << " bytes\" tId=\"" << nodeIds.at(to) << "\" fbRx=\"" << rx
+                        << "\" lbRx=\"" << rx << "\" />\n";
+                }
+            }
+        }
+    }
+    if (!declared)
+    {
+        declare();
+    }
+    xml << "</anim>\n";
+    NS_ABORT_MSG_UNLESS(xml.good(), "Failed to write NetAnim file: " << xmlFileName);
+}
+
+} // namespace ns3
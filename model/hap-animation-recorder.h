@@ -0,0 +1,176 @@
+#ifndef SIBGU_HAP_HAP_ANIMATION_RECORDER_H
+#define SIBGU_HAP_HAP_ANIMATION_RECORDER_H
+
+#include "ns3/event-id.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/vector.h"
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+class Ipv4;
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Decimated animation of a scenario in a compact binary file.
+ *
+ * Instead of recording every packet and position change like NetAnim's
+ * AnimationInterface, the recorder
+ *
+ * - samples node positions every SampleInterval and writes only the nodes
+ *   that moved more than MinDistance since they were last written;
+ * - counts the IPv4 packets and bytes between each pair of nodes and writes
+ *   one summary per pair every FlowInterval.
+ *
+ * The file holds a header ("HANM", version, intervals, node ids and
+ * descriptions) followed by position and flow frames in time order.
+ * ExportNetAnim() converts a time window of it to NetAnim XML, with one
+ * packet per flow summary.
+ */
+class HapAnimationRecorder : public Object
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapAnimationRecorder();
+    ~HapAnimationRecorder() override;
+
+    /**
+     * \brief Add a node to the animation; only before Start().
+     * \param node the node, with a mobility model
+     * \param description label shown by NetAnim
+     */
+    void Add(Ptr<Node> node, std::string description = "");
+
+    /**
+     * \brief Add nodes to the animation; only before Start().
+     * \param nodes the nodes, with a mobility model
+     */
+    void Add(NodeContainer nodes);
+
+    /**
+     * \brief Create the file, connect the IPv4 traces and start sampling.
+     * \param fileName output file
+     */
+    void Start(std::string fileName);
+
+    /**
+     * \brief Write the last frames and close the file; called on dispose.
+     */
+    void Stop();
+
+    /**
+     * \brief Account a packet between two nodes of the animation.
+     *
+     * Called by the IPv4 trace sinks; packets from or to other nodes are
+     * ignored.
+     *
+     * \param from sender node id
+     * \param to receiver node id
+     * \param bytes packet size
+     */
+    void RecordFlow(uint32_t from, uint32_t to, uint32_t bytes);
+
+    /**
+     * \return number of positions written
+     */
+    uint64_t GetNPositions() const;
+
+    /**
+     * \return number of flow summaries written
+     */
+    uint64_t GetNFlows() const;
+
+    /**
+     * \brief Convert a window of a recording to NetAnim XML.
+     * \param fileName recording written by a HapAnimationRecorder
+     * \param xmlFileName NetAnim XML output
+     * \param start start of the window
+     * \param stop end of the window
+     */
+    static void ExportNetAnim(std::string fileName,
+                              std::string xmlFileName,
+                              Time start = Seconds(0),
+                              Time stop = Time::Max());
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /// Packets and bytes of one node pair in the current flow interval.
+    struct Flow
+    {
+        uint32_t packets; //!< number of packets
+        uint64_t bytes;   //!< number of bytes
+    };
+
+    /**
+     * \brief Write the positions of the nodes that moved.
+     */
+    void SamplePositions();
+
+    /**
+     * \brief Write the flow summaries of the ending interval.
+     */
+    void FlushFlows();
+
+    /**
+     * \brief Account a packet between two animated nodes.
+     * \param from sender index
+     * \param to receiver index
+     * \param bytes packet size
+     */
+    void AccountFlow(uint32_t from, uint32_t to, uint32_t bytes);
+
+    /**
+     * \brief IPv4 Tx trace sink: remembers the sender of the packet.
+     * \param packet the packet
+     * \param ipv4 the IPv4 stack
+     * \param interface interface index
+     */
+    void Ipv4Tx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
+    /**
+     * \brief IPv4 Rx trace sink: accounts the packet to its last sender.
+     * \param packet the packet
+     * \param ipv4 the IPv4 stack
+     * \param interface interface index
+     */
+    void Ipv4Rx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
+    Time m_sampleInterval;                           //!< position sampling period
+    Time m_flowInterval;                             //!< flow summary period
+    double m_minDistance;                            //!< smallest movement written, m
+    std::vector<Ptr<Node>> m_nodes;                  //!< animated nodes
+    std::vector<std::string> m_descriptions;         //!< node labels
+    std::unordered_map<uint32_t, uint32_t> m_index;  //!< animation index by node id
+    std::vector<Vector> m_written;                   //!< last written position per node
+    std::vector<bool> m_hasWritten;                  //!< a position was written per node
+    std::map<std::pair<uint32_t, uint32_t>, Flow> m_flows; //!< flows of the current interval
+    std::unordered_map<uint64_t, std::pair<uint32_t, int64_t>>
+        m_lastSender;                                //!< sender index and tx interval by uid
+    int64_t m_flowIntervalNumber;                    //!< current flow interval
+    std::ofstream m_out;                             //!< output file
+    EventId m_sampleEvent;                           //!< next position sample
+    EventId m_flowEvent;                             //!< next flow flush
+    uint64_t m_nPositions;                           //!< positions written
+    uint64_t m_nFlows;                               //!< flow summaries written
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_ANIMATION_RECORDER_H
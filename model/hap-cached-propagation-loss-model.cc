@@ -0,0 +1,146 @@
+#include "hap-cached-propagation-loss-model.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapCachedPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED(HapCachedPropagationLossModel);
+
+namespace
+{
+
+/**
+ * \param model mobility model
+ * \return whether the node is not moving
+ */
+bool
+IsStatic(Ptr<MobilityModel> model)
+{
+    Vector velocity = model->GetVelocity();
+    return velocity.x == 0 && velocity.y == 0 && velocity.z == 0;
+}
+
+} // namespace
+
+TypeId
+HapCachedPropagationLossModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapCachedPropagationLossModel")
+            .SetParent<PropagationLossModel>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapCachedPropagationLossModel>()
+            .AddAttribute("Model",
+                          "Deterministic loss model whose results are cached",
+                          PointerValue(),
+                          MakePointerAccessor(&HapCachedPropagationLossModel::m_model),
+                          MakePointerChecker<PropagationLossModel>());
+    return tid;
+}
+
+HapCachedPropagationLossModel::HapCachedPropagationLossModel()
+    : m_nHits(0),
+      m_nMisses(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapCachedPropagationLossModel::~HapCachedPropagationLossModel()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapCachedPropagationLossModel::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    // Same callback as connected from the const GetVersion()
+    const HapCachedPropagationLossModel* self = this;
+    for (auto& [pointer, tracked] : m_tracked)
+    {
+        tracked.model->TraceDisconnectWithoutContext(
+            "CourseChange",
+            MakeCallback(&HapCachedPropagationLossModel::CourseChanged, self));
+    }
+    m_tracked.clear();
+    m_cache.clear();
+    m_model = nullptr;
+    PropagationLossModel::DoDispose();
+}
+
+uint64_t
+HapCachedPropagationLossModel::GetVersion(Ptr<MobilityModel> model) const
+{
+    auto [it, inserted] = m_tracked.try_emplace(PeekPointer(model), Tracked{model, 0});
+    if (inserted)
+    {
+        model->TraceConnectWithoutContext(
+            "CourseChange",
+            MakeCallback(&HapCachedPropagationLossModel::CourseChanged, this));
+    }
+    return it->second.version;
+}
+
+void
+HapCachedPropagationLossModel::CourseChanged(Ptr<const MobilityModel> model) const
+{
+    auto it = m_tracked.find(PeekPointer(model));
+    if (it != m_tracked.end())
+    {
+        ++it->second.version;
+    }
+}
+
+double
+HapCachedPropagationLossModel::DoCalcRxPower(double txPowerDbm,
+                                             Ptr<MobilityModel> a,
+                                             Ptr<MobilityModel> b) const
+{
+    NS_ABORT_MSG_UNLESS(m_model, "HapCachedPropagationLossModel needs a Model");
+    if (!IsStatic(a) || !IsStatic(b))
+    {
+        ++m_nMisses;
+        return m_model->CalcRxPower(txPowerDbm, a, b);
+    }
+
+    uint64_t versionA = GetVersion(a);
+    uint64_t versionB = GetVersion(b);
+    auto [it, inserted] = m_cache.try_emplace(Key(PeekPointer(a), PeekPointer(b)));
+    Entry& entry = it->second;
+    if (inserted || entry.txPowerDbm != txPowerDbm || entry.versionA != versionA ||
+        entry.versionB != versionB)
+    {
+        ++m_nMisses;
+        entry = {txPowerDbm, m_model->CalcRxPower(txPowerDbm, a, b) - txPowerDbm, versionA, versionB};
+    }
+    else
+    {
+        ++m_nHits;
+    }
+    return txPowerDbm + entry.gainDb;
+}
+
+int64_t
+HapCachedPropagationLossModel::DoAssignStreams(int64_t stream)
+{
+    return m_model ? m_model->AssignStreams(stream) : 0;
+}
+
+uint64_t
+HapCachedPropagationLossModel::GetNHits() const
+{
+    return m_nHits;
+}
+
+uint64_t
+HapCachedPropagationLossModel::GetNMisses() const
+{
+    return m_nMisses;
+}
+
+} // namespace ns3
@@ -0,0 +1,117 @@
+#ifndef SIBGU_HAP_HAP_CACHED_PROPAGATION_LOSS_MODEL_H
+#define SIBGU_HAP_HAP_CACHED_PROPAGATION_LOSS_MODEL_H
+
+#include "ns3/mobility-model.h"
+#include "ns3/propagation-loss-model.h"
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Memoizes a deterministic propagation loss per pair of static nodes.
+ *
+ * The wrapped Model (e.g. LogDistancePropagationLossModel) is evaluated once
+ * per (transmitter, receiver) mobility pair and transmit power; later frames
+ * on the pair reuse the result. Stochastic models such as
+ * NakagamiPropagationLossModel go after this one in the chain, so that the
+ * fading is still drawn for every frame.
+ *
+ * Only pairs of nodes with a zero velocity are cached; the loss towards a
+ * moving node is computed every time. The course change trace of each
+ * mobility model invalidates its pairs, so repositioning a static node is
+ * seen at once. The wrapped model must be deterministic.
+ */
+class HapCachedPropagationLossModel : public PropagationLossModel
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapCachedPropagationLossModel();
+    ~HapCachedPropagationLossModel() override;
+
+    /**
+     * \return number of losses served from the cache
+     */
+    uint64_t GetNHits() const;
+
+    /**
+     * \return number of losses computed by the wrapped model
+     */
+    uint64_t GetNMisses() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /// Cached loss of one pair.
+    struct Entry
+    {
+        double txPowerDbm; //!< transmit power of the computation
+        double gainDb;     //!< received minus transmit power
+        uint64_t versionA; //!< course version of the transmitter
+        uint64_t versionB; //!< course version of the receiver
+    };
+
+    /// Course version of a tracked mobility model.
+    struct Tracked
+    {
+        Ptr<MobilityModel> model; //!< the mobility model
+        uint64_t version;         //!< incremented on every course change
+    };
+
+    /// Ordered pair of mobility models.
+    typedef std::pair<const MobilityModel*, const MobilityModel*> Key;
+
+    /// Hash of a Key.
+    struct KeyHash
+    {
+        /**
+         * \param key the pair
+         * \return hash of the pair
+         */
+        std::size_t operator()(const Key& key) const
+        {
+            std::size_t h = std::hash<const void*>()(key.first);
+            return h ^ (std::hash<const void*>()(key.second) + 0x9e3779b97f4a7c15ULL + (h << 6) +
+                        (h >> 2));
+        }
+    };
+
+    double DoCalcRxPower(double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         Ptr<MobilityModel> b) const override;
+    int64_t DoAssignStreams(int64_t stream) override;
+
+    /**
+     * \brief Course version of a mobility model, tracked from its first use.
+     * \param model the mobility model
+     * \return its version
+     */
+    uint64_t GetVersion(Ptr<MobilityModel> model) const;
+
+    /**
+     * \brief CourseChange trace sink: invalidates the pairs of the model.
+     * \param model the mobility model
+     */
+    void CourseChanged(Ptr<const MobilityModel> model) const;
+
+    Ptr<PropagationLossModel> m_model; //!< wrapped deterministic model
+    mutable std::unordered_map<Key, Entry, KeyHash> m_cache;              //!< losses by pair
+    mutable std::unordered_map<const MobilityModel*, Tracked> m_tracked; //!< tracked models
+    mutable uint64_t m_nHits;   //!< losses served from the cache
+    mutable uint64_t m_nMisses; //!< losses computed
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_CACHED_PROPAGATION_LOSS_MODEL_H
@@ -0,0 +1,393 @@
+#include "hap-cbr-source.h"
+
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapCbrSource");
+
+NS_OBJECT_ENSURE_REGISTERED(HapCbrTimer);
+NS_OBJECT_ENSURE_REGISTERED(HapCbrSource);
+
+namespace
+{
+
+/// Default timer, see HapCbrTimer::GetDefault().
+Ptr<HapCbrTimer> g_defaultTimer;
+
+/// Release the default timer with the simulator.
+void
+ReleaseDefaultTimer()
+{
+    if (g_defaultTimer)
+    {
+        g_defaultTimer->Dispose();
+        g_defaultTimer = nullptr;
+    }
+}
+
+} // namespace
+
+TypeId
+HapCbrTimer::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapCbrTimer")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapCbrTimer>()
+            .AddAttribute("Granularity",
+                          "Tick length. All packets of a node due within one tick are sent by "
+                          "one event at the end of the tick. Zero sends every packet at its "
+                          "exact due time.",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&HapCbrTimer::m_granularity),
+                          MakeTimeChecker(Seconds(0)));
+    return tid;
+}
+
+bool
+HapCbrTimer::Entry::operator>(const Entry& other) const
+{
+    return tick != other.tick ? tick > other.tick : handle > other.handle;
+}
+
+HapCbrTimer::HapCbrTimer()
+    : m_granularity(Seconds(0)),
+      m_nEvents(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapCbrTimer::~HapCbrTimer()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapCbrTimer::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    for (auto& [nodeId, queue] : m_queues)
+    {
+        queue.event.Cancel();
+    }
+    m_queues.clear();
+    m_sources.clear();
+    m_freeHandles.clear();
+    Object::DoDispose();
+}
+
+Ptr<HapCbrTimer>
+HapCbrTimer::GetDefault()
+{
+    if (!g_defaultTimer)
+    {
+        g_defaultTimer = CreateObject<HapCbrTimer>();
+        Simulator::ScheduleDestroy(&ReleaseDefaultTimer);
+    }
+    return g_defaultTimer;
+}
+
+uint32_t
+HapCbrTimer::Add(HapCbrSource* source)
+{
+    NS_LOG_FUNCTION(this << source);
+    uint32_t nodeId = source->GetNode()->GetId();
+    if (m_freeHandles.empty())
+    {
+        m_sources.push_back(Source{source, nodeId, 0});
+        return m_sources.size() - 1;
+    }
+    uint32_t handle = m_freeHandles.back();
+    m_freeHandles.pop_back();
+    m_sources[handle].source = source;
+    m_sources[handle].nodeId = nodeId;
+    return handle;
+}
+
+void
+HapCbrTimer::Remove(uint32_t handle)
+{
+    NS_LOG_FUNCTION(this << handle);
+    if (handle >= m_sources.size() || !m_sources[handle].source)
+    {
+        return; // already disposed
+    }
+    // The pending entry stays in the heap and is skipped when it comes up
+    m_sources[handle].source = nullptr;
+    ++m_sources[handle].generation;
+    m_freeHandles.push_back(handle);
+}
+
+bool
+HapCbrTimer::IsStale(const Entry& entry) const
+{
+    return entry.generation != m_sources[entry.handle].generation;
+}
+
+void
+HapCbrTimer::Schedule(uint32_t handle, Time due)
+{
+    NS_ASSERT_MSG(due >= Simulator::Now(), "Packet of source " << handle << " due in the past");
+    const Source& source = m_sources[handle];
+    int64_t tick = due.GetTimeStep();
+    if (m_granularity.IsStrictlyPositive())
+    {
+        int64_t granularity = m_granularity.GetTimeStep();
+        tick = (tick + granularity - 1) / granularity;
+    }
+
+    NodeQueue& queue = m_queues[source.nodeId];
+    queue.heap.push_back(Entry{tick, handle, source.generation});
+    std::push_heap(queue.heap.begin(), queue.heap.end(), std::greater<Entry>());
+    if (!queue.firing)
+    {
+        ScheduleNode(source.nodeId, queue);
+    }
+}
+
+void
+HapCbrTimer::ScheduleNode(uint32_t nodeId, NodeQueue& queue)
+{
+    while (!queue.heap.empty() && IsStale(queue.heap.front()))
+    {
+        std::pop_heap(queue.heap.begin(), queue.heap.end(), std::greater<Entry>());
+        queue.heap.pop_back();
+    }
+    if (queue.heap.empty())
+    {
+        return;
+    }
+    int64_t tick = queue.heap.front().tick;
+    if (queue.scheduledTick >= 0 && queue.scheduledTick <= tick)
+    {
+        return;
+    }
+    queue.event.Cancel();
+    queue.scheduledTick = tick;
+    int64_t step = m_granularity.IsStrictlyPositive() ? m_granularity.GetTimeStep() : 1;
+    Time at = TimeStep(tick * step);
+    queue.event = Simulator::ScheduleWithContext(nodeId,
+                                                 at - Simulator::Now(),
+                                                 &HapCbrTimer::Fire,
+                                                 this,
+                                                 nodeId);
+}
+
+void
+HapCbrTimer::Fire(uint32_t nodeId)
+{
+    NodeQueue& queue = m_queues[nodeId];
+    int64_t tick = queue.scheduledTick;
+    queue.scheduledTick = -1;
+    ++m_nEvents;
+
+    // The next packet of a source is due at least one tick later, so the
+    // sends below only push entries behind the ones popped here
+    std::vector<HapCbrSource*> due;
+    while (!queue.heap.empty() && queue.heap.front().tick == tick)
+    {
+        const Entry& entry = queue.heap.front();
+        if (!IsStale(entry))
+        {
+            due.push_back(m_sources[entry.handle].source);
+        }
+        std::pop_heap(queue.heap.begin(), queue.heap.end(), std::greater<Entry>());
+        queue.heap.pop_back();
+    }
+    NS_LOG_LOGIC("Node " << nodeId << ", tick " << tick << ": " << due.size() << " packets");
+
+    queue.firing = true;
+    for (HapCbrSource* source : due)
+    {
+        source->SendPacket();
+    }
+    queue.firing = false;
+    ScheduleNode(nodeId, queue);
+}
+
+Time
+HapCbrTimer::GetGranularity() const
+{
+    return m_granularity;
+}
+
+uint64_t
+HapCbrTimer::GetNEvents() const
+{
+    return m_nEvents;
+}
+
+TypeId
+HapCbrSource::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapCbrSource")
+            .SetParent<Application>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapCbrSource>()
+            .AddAttribute("Remote",
+                          "The address of the destination.",
+                          AddressValue(),
+                          MakeAddressAccessor(&HapCbrSource::m_remote),
+                          MakeAddressChecker())
+            .AddAttribute("Protocol",
+                          "The type of protocol to use.",
+                          TypeIdValue(UdpSocketFactory::GetTypeId()),
+                          MakeTypeIdAccessor(&HapCbrSource::m_protocol),
+                          MakeTypeIdChecker())
+            .AddAttribute("PacketSize",
+                          "Size of the packets, in bytes.",
+                          UintegerValue(512),
+                          MakeUintegerAccessor(&HapCbrSource::m_packetSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("Interval",
+                          "Time between packets.",
+                          TimeValue(MilliSeconds(100)),
+                          MakeTimeAccessor(&HapCbrSource::m_interval),
+                          MakeTimeChecker(TimeStep(1)))
+            .AddAttribute("MaxPackets",
+                          "Number of packets to send, 0 for no limit.",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&HapCbrSource::m_maxPackets),
+                          MakeUintegerChecker<uint64_t>())
+            .AddTraceSource("Tx",
+                            "A packet has been sent.",
+                            MakeTraceSourceAccessor(&HapCbrSource::m_txTrace),
+                            "ns3::Packet::TracedCallback");
+    return tid;
+}
+
+HapCbrSource::HapCbrSource()
+    : m_packetSize(512),
+      m_interval(MilliSeconds(100)),
+      m_maxPackets(0),
+      m_handle(0),
+      m_registered(false),
+      m_nSent(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapCbrSource::~HapCbrSource()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapCbrSource::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_registered)
+    {
+        m_timer->Remove(m_handle);
+        m_registered = false;
+    }
+    m_socket = nullptr;
+    m_timer = nullptr;
+    m_pool = nullptr;
+    Application::DoDispose();
+}
+
+void
+HapCbrSource::SetTimer(Ptr<HapCbrTimer> timer)
+{
+    NS_LOG_FUNCTION(this << timer);
+    NS_ABORT_MSG_IF(m_registered, "The send timer cannot change while the source runs");
+    m_timer = timer;
+}
+
+void
+HapCbrSource::SetPayloadPool(Ptr<HapPayloadPool> pool)
+{
+    NS_LOG_FUNCTION(this << pool);
+    m_pool = pool;
+}
+
+void
+HapCbrSource::StartApplication()
+{
+    NS_LOG_FUNCTION(this);
+
+    if (!m_socket)
+    {
+        m_socket = Socket::CreateSocket(GetNode(), m_protocol);
+        int ret = Inet6SocketAddress::IsMatchingType(m_remote) ? m_socket->Bind6()
+                                                               : m_socket->Bind();
+        NS_ABORT_MSG_IF(ret == -1, "Failed to bind socket");
+        m_socket->Connect(m_remote);
+        m_socket->ShutdownRecv();
+    }
+    if (!m_timer)
+    {
+        m_timer = HapCbrTimer::GetDefault();
+    }
+    NS_ABORT_MSG_IF(m_interval < m_timer->GetGranularity(),
+                    "Interval " << m_interval.As(Time::MS) << " is shorter than the timer "
+                                << "granularity " << m_timer->GetGranularity().As(Time::MS));
+    if (!m_pool)
+    {
+        m_pool = HapPayloadPool::GetDefault();
+    }
+
+    m_handle = m_timer->Add(this);
+    m_registered = true;
+    m_nextSend = Simulator::Now();
+    m_timer->Schedule(m_handle, m_nextSend);
+}
+
+void
+HapCbrSource::StopApplication()
+{
+    NS_LOG_FUNCTION(this);
+
+    if (m_registered)
+    {
+        m_timer->Remove(m_handle);
+        m_registered = false;
+    }
+    if (m_socket)
+    {
+        m_socket->Close();
+    }
+}
+
+void
+HapCbrSource::SendPacket()
+{
+    NS_LOG_FUNCTION(this);
+
+    Ptr<Packet> packet = m_pool->Get(m_packetSize);
+    m_txTrace(packet);
+    m_socket->Send(packet);
+    ++m_nSent;
+
+    if (m_maxPackets != 0 && m_nSent >= m_maxPackets)
+    {
+        StopApplication();
+        return;
+    }
+    m_nextSend += m_interval;
+    m_timer->Schedule(m_handle, m_nextSend);
+}
+
+uint64_t
+HapCbrSource::GetNSent() const
+{
+    return m_nSent;
+}
+
+} // namespace ns3
@@ -0,0 +1,232 @@
+#ifndef SIBGU_HAP_HAP_CBR_SOURCE_H
+#define SIBGU_HAP_HAP_CBR_SOURCE_H
+
+#include "hap-payload-pool.h"
+
+#include "ns3/address.h"
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/socket.h"
+#include "ns3/traced-callback.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+class HapCbrSource;
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Send timer shared by many CBR sources.
+ *
+ * The packets of all sources of a node that are due at the same instant are
+ * sent by a single simulator event, scheduled with the node id as context
+ * like any event of that node. Sources that start together with the same
+ * interval, e.g. the flows a gateway sends to many UTs, then cost one event
+ * per packet instant instead of one per packet.
+ *
+ * By default the packets leave at their exact due time. A positive
+ * Granularity additionally batches the instants of one tick: a packet then
+ * leaves at the end of the tick it is due in, up to Granularity late, and
+ * the sources must not send faster than once per tick.
+ *
+ * Each node keeps the due ticks of its sources in a binary heap, so finding
+ * the next event of a node costs O(log n) in its number of sources. Handles
+ * of removed sources are reused.
+ */
+class HapCbrTimer : public Object
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapCbrTimer();
+    ~HapCbrTimer() override;
+
+    /**
+     * \return timer shared by all sources that do not set their own, released
+     *         at Simulator::Destroy()
+     */
+    static Ptr<HapCbrTimer> GetDefault();
+
+    /**
+     * \brief Register a source.
+     * \param source the source, installed on a node
+     * \return handle for Schedule() and Remove()
+     */
+    uint32_t Add(HapCbrSource* source);
+
+    /**
+     * \brief Unregister a source; its pending packet is dropped.
+     * \param handle handle returned by Add()
+     */
+    void Remove(uint32_t handle);
+
+    /**
+     * \brief Schedule the next packet of a source.
+     * \param handle handle returned by Add()
+     * \param due time the packet is due, not in the past; it is sent at the
+     *        end of its tick
+     */
+    void Schedule(uint32_t handle, Time due);
+
+    /**
+     * \return tick length, zero for exact send times
+     */
+    Time GetGranularity() const;
+
+    /**
+     * \return number of simulator events used so far
+     */
+    uint64_t GetNEvents() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * Pending packet of a source.
+     */
+    struct Entry
+    {
+        int64_t tick;        //!< absolute tick the packet is due in
+        uint32_t handle;     //!< source handle
+        uint32_t generation; //!< generation of the handle when scheduled
+
+        /**
+         * \param other another entry
+         * \return true if this entry is due after other, for a min-heap
+         */
+        bool operator>(const Entry& other) const;
+    };
+
+    /**
+     * Registered source.
+     */
+    struct Source
+    {
+        HapCbrSource* source; //!< the source, null once removed
+        uint32_t nodeId;      //!< node of the source
+        uint32_t generation;  //!< incremented on Remove(), invalidates its entries
+    };
+
+    /**
+     * Pending packets of the sources of one node.
+     */
+    struct NodeQueue
+    {
+        std::vector<Entry> heap;    //!< pending entries, earliest tick first
+        int64_t scheduledTick = -1; //!< tick of event, -1 if none
+        EventId event;              //!< pending event of the node
+        bool firing = false;        //!< true while Fire() runs for the node
+    };
+
+    /**
+     * \brief Send the packets of the sources of a node due in the scheduled tick.
+     * \param nodeId node id
+     */
+    void Fire(uint32_t nodeId);
+
+    /**
+     * \brief Schedule the event of a node for its earliest entry, if earlier
+     *        than the pending one.
+     * \param nodeId node id
+     * \param queue queue of the node
+     */
+    void ScheduleNode(uint32_t nodeId, NodeQueue& queue);
+
+    /**
+     * \param entry a heap entry
+     * \return true if the source of the entry was removed since it was scheduled
+     */
+    bool IsStale(const Entry& entry) const;
+
+    Time m_granularity;                               //!< tick length, zero for exact times
+    std::vector<Source> m_sources;                    //!< registered sources, by handle
+    std::vector<uint32_t> m_freeHandles;              //!< handles of removed sources
+    std::unordered_map<uint32_t, NodeQueue> m_queues; //!< pending packets by node id
+    uint64_t m_nEvents;                               //!< event counter
+};
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Constant bit rate source for large numbers of flows.
+ *
+ * Sends PacketSize-byte packets every Interval to Remote, up to MaxPackets,
+ * then closes its socket. Unlike a self-rescheduling send function, the
+ * source schedules no event of its own: its packets are sent from a shared
+ * HapCbrTimer, one simulator event per instant for all sources of a node,
+ * and the payloads come from a shared HapPayloadPool.
+ *
+ * Send instants are not accumulated on the tick grid of the timer, so a
+ * source does not drift. Interval must not be shorter than the timer
+ * granularity.
+ */
+class HapCbrSource : public Application
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapCbrSource();
+    ~HapCbrSource() override;
+
+    /**
+     * \param timer send timer to use instead of the default one
+     */
+    void SetTimer(Ptr<HapCbrTimer> timer);
+
+    /**
+     * \param pool payload pool to use instead of the default one
+     */
+    void SetPayloadPool(Ptr<HapPayloadPool> pool);
+
+    /**
+     * \brief Send the packet due now and schedule the next one.
+     *
+     * Called by the send timer.
+     */
+    void SendPacket();
+
+    /**
+     * \return number of packets sent so far
+     */
+    uint64_t GetNSent() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    void StartApplication() override;
+    void StopApplication() override;
+
+    Address m_remote;                 //!< destination address
+    TypeId m_protocol;                //!< socket factory
+    uint32_t m_packetSize;            //!< payload size
+    Time m_interval;                  //!< time between packets
+    uint64_t m_maxPackets;            //!< packets to send, 0 for no limit
+    Ptr<Socket> m_socket;             //!< sending socket
+    Ptr<HapCbrTimer> m_timer;         //!< shared send timer
+    Ptr<HapPayloadPool> m_pool;       //!< shared payloads
+    uint32_t m_handle;                //!< handle in the send timer
+    bool m_registered;                //!< true while registered in the send timer
+    Time m_nextSend;                  //!< exact due time of the next packet
+    uint64_t m_nSent;                 //!< packets sent
+
+    /// Trace of the packets sent.
+    TracedCallback<Ptr<const Packet>> m_txTrace;
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_CBR_SOURCE_H
@@ -0,0 +1,247 @@
+#include "hap-contact-plan-generator.h"
+
+#include "hap-geometry.h"
+
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapContactPlanGenerator");
+
+NS_OBJECT_ENSURE_REGISTERED(HapContactPlanGenerator);
+
+TypeId
+HapContactPlanGenerator::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapContactPlanGenerator")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapContactPlanGenerator>()
+            .AddAttribute("SamplingStep",
+                          "Time between two samples of the ephemeris.",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&HapContactPlanGenerator::m_samplingStep),
+                          MakeTimeChecker(MilliSeconds(1)))
+            .AddAttribute("GwElevationMask",
+                          "Minimum elevation of an orbiter seen from a GW, in degrees.",
+                          DoubleValue(10.0),
+                          MakeDoubleAccessor(&HapContactPlanGenerator::m_gwMask),
+                          MakeDoubleChecker<double>(-90.0, 90.0))
+            .AddAttribute("UtElevationMask",
+                          "Minimum elevation of an orbiter seen from a UT, in degrees.",
+                          DoubleValue(10.0),
+                          MakeDoubleAccessor(&HapContactPlanGenerator::m_utMask),
+                          MakeDoubleChecker<double>(-90.0, 90.0))
+            .AddAttribute("HapElevationMask",
+                          "Minimum elevation of an orbiter seen from a HAP, in degrees. "
+                          "A HAP at 20 km sees slightly below the local horizon.",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(&HapContactPlanGenerator::m_hapMask),
+                          MakeDoubleChecker<double>(-90.0, 90.0))
+            .AddAttribute("RankingDepth",
+                          "Number of closest visible orbiters recorded per observer. "
+                          "Should not be lower than SatHandoverModule::NumberClosestSats.",
+                          UintegerValue(3),
+                          MakeUintegerAccessor(&HapContactPlanGenerator::m_rankingDepth),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+HapContactPlanGenerator::HapContactPlanGenerator()
+    : m_samplingStep(Seconds(1)),
+      m_gwMask(10.0),
+      m_utMask(10.0),
+      m_hapMask(0.0),
+      m_rankingDepth(3)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapContactPlanGenerator::~HapContactPlanGenerator()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapContactPlanGenerator::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_sampleEvent.Cancel();
+    m_orbiters.clear();
+    m_observers.clear();
+    m_observerMobility.clear();
+    m_plan = nullptr;
+    Object::DoDispose();
+}
+
+void
+HapContactPlanGenerator::SetOrbiters(NodeContainer orbiters)
+{
+    NS_LOG_FUNCTION(this << orbiters.GetN());
+
+    m_orbiters.clear();
+    for (uint32_t satId = 0; satId < orbiters.GetN(); ++satId)
+    {
+        Ptr<MobilityModel> mobility = orbiters.Get(satId)->GetObject<MobilityModel>();
+        NS_ABORT_MSG_UNLESS(mobility, "Orbiter satId=" << satId << " has no mobility model");
+        m_orbiters.push_back(mobility);
+    }
+}
+
+void
+HapContactPlanGenerator::AddObservers(NodeContainer nodes, HapContactPlan::NodeRole role)
+{
+    NS_LOG_FUNCTION(this << nodes.GetN() << role);
+
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        Ptr<Node> node = nodes.Get(i);
+        Ptr<MobilityModel> mobility = node->GetObject<MobilityModel>();
+        NS_ABORT_MSG_UNLESS(mobility, "Observer node " << node->GetId() << " has no mobility model");
+        m_observers.push_back(node);
+        m_roles.push_back(role);
+        m_observerMobility.push_back(mobility);
+    }
+}
+
+Ptr<HapContactPlan>
+HapContactPlanGenerator::Sweep(Time start, Time stop, const std::string& fileName)
+{
+    NS_LOG_FUNCTION(this << start << stop << fileName);
+    NS_ABORT_MSG_IF(m_orbiters.empty(), "No orbiters set for the contact plan sweep");
+    NS_ABORT_MSG_UNLESS(start >= Simulator::Now() && start < stop, "Invalid sweep window");
+
+    m_plan = CreateObject<HapContactPlan>();
+    m_plan->Reset(m_orbiters.size(), m_rankingDepth, start, m_samplingStep, stop);
+    for (std::size_t obs = 0; obs < m_observers.size(); ++obs)
+    {
+        m_plan->AddObserver(m_observers[obs]->GetId(), m_roles[obs]);
+    }
+
+    m_openSince.assign(m_observers.size() * m_orbiters.size(), Time::Max());
+    m_lastRanking.assign(m_observers.size(), std::vector<uint32_t>());
+    m_stop = stop;
+    m_fileName = fileName;
+
+    m_sampleEvent =
+        Simulator::Schedule(start - Simulator::Now(), &HapContactPlanGenerator::Sample, this);
+    return m_plan;
+}
+
+void
+HapContactPlanGenerator::Sample()
+{
+    NS_LOG_FUNCTION(this);
+
+    Time now = Simulator::Now();
+    if (now >= m_stop)
+    {
+        Finish();
+        return;
+    }
+
+    std::vector<Vector> satPositions;
+    satPositions.reserve(m_orbiters.size());
+    for (const Ptr<MobilityModel>& orbiter : m_orbiters)
+    {
+        satPositions.push_back(orbiter->GetPosition());
+    }
+
+    std::vector<std::pair<double, uint32_t>> visible;
+    for (std::size_t obs = 0; obs < m_observers.size(); ++obs)
+    {
+        Vector position = m_observerMobility[obs]->GetPosition();
+        double mask = GetElevationMask(m_roles[obs]);
+
+        visible.clear();
+        for (uint32_t satId = 0; satId < satPositions.size(); ++satId)
+        {
+            Time& openSince = m_openSince[obs * satPositions.size() + satId];
+            bool isVisible = HapElevationAngle(position, satPositions[satId]) >= mask;
+
+            if (isVisible)
+            {
+                visible.emplace_back(HapDistanceSquared(position, satPositions[satId]), satId);
+                if (openSince == Time::Max())
+                {
+                    openSince = now;
+                }
+            }
+            else if (openSince != Time::Max())
+            {
+                m_plan->AddInterval(obs, satId, openSince, now);
+                openSince = Time::Max();
+            }
+        }
+
+        // Ties are broken by satId, so that the ranking is deterministic
+        std::size_t depth = std::min<std::size_t>(m_rankingDepth, visible.size());
+        std::partial_sort(visible.begin(), visible.begin() + depth, visible.end());
+        std::vector<uint32_t> ranking;
+        ranking.reserve(depth);
+        for (std::size_t k = 0; k < depth; ++k)
+        {
+            ranking.push_back(visible[k].second);
+        }
+
+        if (ranking != m_lastRanking[obs] || m_plan->GetRankingEpochs(obs).empty())
+        {
+            m_plan->AddRankingEpoch(obs, now, ranking);
+            m_lastRanking[obs] = std::move(ranking);
+        }
+    }
+
+    Time next = std::min(m_samplingStep, m_stop - now);
+    m_sampleEvent = Simulator::Schedule(next, &HapContactPlanGenerator::Sample, this);
+}
+
+void
+HapContactPlanGenerator::Finish()
+{
+    NS_LOG_FUNCTION(this);
+
+    for (std::size_t pair = 0; pair < m_openSince.size(); ++pair)
+    {
+        if (m_openSince[pair] != Time::Max())
+        {
+            m_plan->AddInterval(pair / m_orbiters.size(),
+                                pair % m_orbiters.size(),
+                                m_openSince[pair],
+                                m_stop);
+            m_openSince[pair] = Time::Max();
+        }
+    }
+
+    if (!m_fileName.empty())
+    {
+        m_plan->Save(m_fileName);
+        NS_LOG_INFO("Contact plan written to " << m_fileName);
+    }
+}
+
+double
+HapContactPlanGenerator::GetElevationMask(HapContactPlan::NodeRole role) const
+{
+    switch (role)
+    {
+    case HapContactPlan::ROLE_GW:
+        return m_gwMask;
+    case HapContactPlan::ROLE_UT:
+        return m_utMask;
+    case HapContactPlan::ROLE_HAP:
+        return m_hapMask;
+    }
+    return m_utMask;
+}
+
+} // namespace ns3
@@ -0,0 +1,112 @@
+#ifndef SIBGU_HAP_HAP_CONTACT_PLAN_GENERATOR_H
+#define SIBGU_HAP_HAP_CONTACT_PLAN_GENERATOR_H
+
+#include "hap-contact-plan.h"
+
+#include "ns3/event-id.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Sweeps the orbiter ephemeris against ground and HAP nodes.
+ *
+ * The generator samples the mobility models of all observers and orbiters
+ * every SamplingStep and records, per (observer, orbiter) pair, the intervals
+ * during which the orbiter elevation is above the observer mask, together
+ * with the ranking of the RankingDepth closest visible orbiters.
+ *
+ * Sampling goes through the regular mobility models, so TLE orbiters,
+ * orbiters traced from positions/sat_traces.txt and moving HAP observers are
+ * all handled the same way. The sweep runs as simulation events, so it is
+ * meant for a dedicated generation run: create the scenario, call Sweep(),
+ * run the simulator until the stop time and load the resulting file in the
+ * actual runs with HapContactPlan::Load().
+ */
+class HapContactPlanGenerator : public Object
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapContactPlanGenerator();
+    ~HapContactPlanGenerator() override;
+
+    /**
+     * \brief Set the orbiters, in satId order.
+     * \param orbiters orbiter nodes, as returned by SatTopology::GetOrbiterNodes()
+     */
+    void SetOrbiters(NodeContainer orbiters);
+
+    /**
+     * \brief Add observer nodes.
+     * \param nodes ground or HAP nodes
+     * \param role role of the nodes, selects the elevation mask
+     */
+    void AddObservers(NodeContainer nodes, HapContactPlan::NodeRole role);
+
+    /**
+     * \brief Schedule the ephemeris sweep.
+     *
+     * The plan is complete, and written to fileName if not empty, once the
+     * simulation reaches stop.
+     *
+     * \param start sweep start, absolute simulation time
+     * \param stop sweep stop, absolute simulation time
+     * \param fileName output file, may be empty
+     * \return the plan being filled
+     */
+    Ptr<HapContactPlan> Sweep(Time start, Time stop, const std::string& fileName);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * \brief Take one sample of all positions and update the plan.
+     */
+    void Sample();
+
+    /**
+     * \brief Close the open intervals and write the plan.
+     */
+    void Finish();
+
+    /**
+     * \param role observer role
+     * \return elevation mask for this role [deg]
+     */
+    double GetElevationMask(HapContactPlan::NodeRole role) const;
+
+    Time m_samplingStep;      //!< time between two samples
+    double m_gwMask;          //!< GW elevation mask [deg]
+    double m_utMask;          //!< UT elevation mask [deg]
+    double m_hapMask;         //!< HAP elevation mask [deg]
+    uint32_t m_rankingDepth;  //!< number of closest orbiters recorded
+
+    std::vector<Ptr<MobilityModel>> m_orbiters;          //!< orbiter mobility, by satId
+    std::vector<Ptr<Node>> m_observers;                  //!< observer nodes
+    std::vector<HapContactPlan::NodeRole> m_roles;       //!< observer roles
+    std::vector<Ptr<MobilityModel>> m_observerMobility;  //!< observer mobility
+    std::vector<Time> m_openSince;                       //!< open interval start per pair
+    std::vector<std::vector<uint32_t>> m_lastRanking;    //!< last recorded ranking
+    Ptr<HapContactPlan> m_plan;                          //!< plan being built
+    Time m_stop;                                         //!< sweep stop time
+    std::string m_fileName;                              //!< output file
+    EventId m_sampleEvent;                               //!< next sample event
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_CONTACT_PLAN_GENERATOR_H
@@ -0,0 +1,431 @@
+#include "hap-contact-plan.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapContactPlan");
+
+NS_OBJECT_ENSURE_REGISTERED(HapContactPlan);
+
+namespace
+{
+
+/// File signature of a binary contact plan.
+const char CONTACT_PLAN_MAGIC[4] = {'H', 'C', 'P', 'L'};
+/// Current binary format version.
+const uint32_t CONTACT_PLAN_VERSION = 2;
+/// Marker of an empty ranking slot.
+const uint32_t NO_ORBITER = 0xFFFFFFFF;
+
+template <typename T>
+void
+WriteRaw(std::ofstream& out, T value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T
+ReadRaw(std::ifstream& in, const std::string& fileName)
+{
+    T value{};
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    NS_ABORT_MSG_UNLESS(in.good(), "Truncated contact plan file: " << fileName);
+    return value;
+}
+
+} // namespace
+
+TypeId
+HapContactPlan::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::HapContactPlan")
+                            .SetParent<Object>()
+                            .SetGroupName("SibguHap")
+                            .AddConstructor<HapContactPlan>();
+    return tid;
+}
+
+HapContactPlan::HapContactPlan()
+    : m_nOrbiters(0),
+      m_rankingDepth(0),
+      m_start(Seconds(0)),
+      m_step(Seconds(1)),
+      m_end(Time::Max())
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapContactPlan::~HapContactPlan()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapContactPlan::Reset(uint32_t nOrbiters,
+                      uint32_t rankingDepth,
+                      Time start,
+                      Time step,
+                      Time end)
+{
+    NS_LOG_FUNCTION(this << nOrbiters << rankingDepth << start << step << end);
+
+    m_nOrbiters = nOrbiters;
+    m_rankingDepth = rankingDepth;
+    m_start = start;
+    m_step = step;
+    m_end = end;
+    m_observerNodeIds.clear();
+    m_observerRoles.clear();
+    m_observerIdx.clear();
+    m_intervals.clear();
+    m_rankings.clear();
+}
+
+uint32_t
+HapContactPlan::AddObserver(uint32_t nodeId, NodeRole role)
+{
+    NS_LOG_FUNCTION(this << nodeId << role);
+    NS_ABORT_MSG_IF(HasObserver(nodeId), "Node " << nodeId << " is already an observer");
+
+    uint32_t index = m_observerNodeIds.size();
+    m_observerNodeIds.push_back(nodeId);
+    m_observerRoles.push_back(role);
+    m_observerIdx[nodeId] = index;
+    m_intervals.resize(m_intervals.size() + m_nOrbiters);
+    m_rankings.emplace_back();
+    return index;
+}
+
+void
+HapContactPlan::AddInterval(uint32_t observer, uint32_t satId, Time start, Time end)
+{
+    NS_LOG_FUNCTION(this << observer << satId << start << end);
+    NS_ASSERT(start < end);
+
+    std::vector<Interval>& intervals = m_intervals[PairIndex(observer, satId)];
+    NS_ASSERT_MSG(intervals.empty() || intervals.back().end <= start,
+                  "Intervals must be added in time order");
+    intervals.push_back({start, end});
+}
+
+void
+HapContactPlan::AddRankingEpoch(uint32_t observer,
+                                Time start,
+                                const std::vector<uint32_t>& satIds)
+{
+    NS_LOG_FUNCTION(this << observer << start << satIds.size());
+    NS_ASSERT(observer < m_rankings.size());
+    NS_ASSERT(satIds.size() <= m_rankingDepth);
+
+    std::vector<RankingEpoch>& epochs = m_rankings[observer];
+    NS_ASSERT_MSG(epochs.empty() || epochs.back().start < start,
+                  "Ranking epochs must be added in time order");
+    epochs.push_back({start, satIds});
+}
+
+uint32_t
+HapContactPlan::GetNObservers() const
+{
+    return m_observerNodeIds.size();
+}
+
+uint32_t
+HapContactPlan::GetNOrbiters() const
+{
+    return m_nOrbiters;
+}
+
+uint32_t
+HapContactPlan::GetRankingDepth() const
+{
+    return m_rankingDepth;
+}
+
+Time
+HapContactPlan::GetStep() const
+{
+    return m_step;
+}
+
+Time
+HapContactPlan::GetEnd() const
+{
+    return m_end;
+}
+
+bool
+HapContactPlan::HasObserver(uint32_t nodeId) const
+{
+    return m_observerIdx.find(nodeId) != m_observerIdx.end();
+}
+
+uint32_t
+HapContactPlan::GetObserverIndex(uint32_t nodeId) const
+{
+    auto it = m_observerIdx.find(nodeId);
+    NS_ABORT_MSG_IF(it == m_observerIdx.end(), "Node " << nodeId << " is not in the contact plan");
+    return it->second;
+}
+
+uint32_t
+HapContactPlan::GetObserverNodeId(uint32_t observer) const
+{
+    NS_ASSERT(observer < m_observerNodeIds.size());
+    return m_observerNodeIds[observer];
+}
+
+HapContactPlan::NodeRole
+HapContactPlan::GetObserverRole(uint32_t observer) const
+{
+    NS_ASSERT(observer < m_observerRoles.size());
+    return m_observerRoles[observer];
+}
+
+const std::vector<HapContactPlan::Interval>&
+HapContactPlan::GetIntervals(uint32_t observer, uint32_t satId) const
+{
+    return m_intervals[PairIndex(observer, satId)];
+}
+
+bool
+HapContactPlan::IsVisible(uint32_t observer, uint32_t satId, Time t) const
+{
+    const std::vector<Interval>& intervals = GetIntervals(observer, satId);
+    auto it = std::upper_bound(intervals.begin(),
+                               intervals.end(),
+                               t,
+                               [](Time value, const Interval& i) { return value < i.start; });
+    if (it == intervals.begin())
+    {
+        return false;
+    }
+    --it;
+    return t < it->end;
+}
+
+std::vector<uint32_t>
+HapContactPlan::GetVisibleOrbiters(uint32_t observer, Time t) const
+{
+    std::vector<uint32_t> visible;
+    for (uint32_t satId = 0; satId < m_nOrbiters; ++satId)
+    {
+        if (IsVisible(observer, satId, t))
+        {
+            visible.push_back(satId);
+        }
+    }
+    return visible;
+}
+
+const std::vector<HapContactPlan::RankingEpoch>&
+HapContactPlan::GetRankingEpochs(uint32_t observer) const
+{
+    NS_ASSERT(observer < m_rankings.size());
+    return m_rankings[observer];
+}
+
+const std::vector<uint32_t>&
+HapContactPlan::GetRanking(uint32_t observer, Time t) const
+{
+    static const std::vector<uint32_t> empty;
+
+    const std::vector<RankingEpoch>& epochs = GetRankingEpochs(observer);
+    auto it = std::upper_bound(epochs.begin(),
+                               epochs.end(),
+                               t,
+                               [](Time value, const RankingEpoch& e) { return value < e.start; });
+    if (it == epochs.begin())
+    {
+        return empty;
+    }
+    return (--it)->satIds;
+}
+
+Time
+HapContactPlan::GetNextRankingChange(uint32_t observer, Time t) const
+{
+    const std::vector<RankingEpoch>& epochs = GetRankingEpochs(observer);
+    auto it = std::upper_bound(epochs.begin(),
+                               epochs.end(),
+                               t,
+                               [](Time value, const RankingEpoch& e) { return value < e.start; });
+    return it == epochs.end() ? Time::Max() : it->start;
+}
+
+Time
+HapContactPlan::GetNextContactBoundary(uint32_t observer, Time t) const
+{
+    Time next = Time::Max();
+    for (uint32_t satId = 0; satId < m_nOrbiters; ++satId)
+    {
+        for (const Interval& interval : GetIntervals(observer, satId))
+        {
+            if (interval.start > t)
+            {
+                next = std::min(next, interval.start);
+                break;
+            }
+            if (interval.end > t)
+            {
+                next = std::min(next, interval.end);
+                break;
+            }
+        }
+    }
+    return next;
+}
+
+void
+HapContactPlan::Save(const std::string& fileName) const
+{
+    NS_LOG_FUNCTION(this << fileName);
+
+    std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+    NS_ABORT_MSG_UNLESS(out.is_open(), "Cannot create contact plan file: " << fileName);
+
+    out.write(CONTACT_PLAN_MAGIC, sizeof(CONTACT_PLAN_MAGIC));
+    WriteRaw<uint32_t>(out, CONTACT_PLAN_VERSION);
+    WriteRaw<int64_t>(out, m_start.GetTimeStep());
+    WriteRaw<int64_t>(out, m_step.GetTimeStep());
+    WriteRaw<int64_t>(out, m_end.GetTimeStep());
+    WriteRaw<uint32_t>(out, GetNObservers());
+    WriteRaw<uint32_t>(out, m_nOrbiters);
+    WriteRaw<uint32_t>(out, m_rankingDepth);
+
+    for (uint32_t obs = 0; obs < GetNObservers(); ++obs)
+    {
+        WriteRaw<uint32_t>(out, m_observerNodeIds[obs]);
+        WriteRaw<uint32_t>(out, m_observerRoles[obs]);
+    }
+
+    // Only pairs with at least one contact are stored
+    uint32_t nPairs = std::count_if(m_intervals.begin(),
+                                    m_intervals.end(),
+                                    [](const std::vector<Interval>& i) { return !i.empty(); });
+    WriteRaw<uint32_t>(out, nPairs);
+    for (std::size_t pair = 0; pair < m_intervals.size(); ++pair)
+    {
+        const std::vector<Interval>& intervals = m_intervals[pair];
+        if (intervals.empty())
+        {
+            continue;
+        }
+        WriteRaw<uint32_t>(out, pair / m_nOrbiters);
+        WriteRaw<uint32_t>(out, pair % m_nOrbiters);
+        WriteRaw<uint32_t>(out, intervals.size());
+        for (const Interval& interval : intervals)
+        {
+            WriteRaw<int64_t>(out, interval.start.GetTimeStep());
+            WriteRaw<int64_t>(out, interval.end.GetTimeStep());
+        }
+    }
+
+    for (const std::vector<RankingEpoch>& epochs : m_rankings)
+    {
+        WriteRaw<uint32_t>(out, epochs.size());
+        for (const RankingEpoch& epoch : epochs)
+        {
+            WriteRaw<int64_t>(out, epoch.start.GetTimeStep());
+            for (uint32_t slot = 0; slot < m_rankingDepth; ++slot)
+            {
+                WriteRaw<uint32_t>(out,
+                                   slot < epoch.satIds.size() ? epoch.satIds[slot] : NO_ORBITER);
+            }
+        }
+    }
+
+    NS_ABORT_MSG_UNLESS(out.good(), "Failed to write contact plan file: " << fileName);
+}
+
+void
+HapContactPlan::Load(const std::string& fileName)
+{
+    NS_LOG_FUNCTION(this << fileName);
+
+    std::ifstream in(fileName, std::ios::binary);
+    NS_ABORT_MSG_UNLESS(in.is_open(), "Cannot open contact plan file: " << fileName);
+
+    char magic[sizeof(CONTACT_PLAN_MAGIC)];
+    in.read(magic, sizeof(magic));
+    NS_ABORT_MSG_UNLESS(in.good() && std::equal(magic, magic + sizeof(magic), CONTACT_PLAN_MAGIC),
+                        "Not a contact plan file: " << fileName);
+    uint32_t version = ReadRaw<uint32_t>(in, fileName);
+    NS_ABORT_MSG_UNLESS(version == CONTACT_PLAN_VERSION,
+                        "Unsupported contact plan version " << version << " in " << fileName);
+
+    Time start = TimeStep(ReadRaw<int64_t>(in, fileName));
+    Time step = TimeStep(ReadRaw<int64_t>(in, fileName));
+    Time end = TimeStep(ReadRaw<int64_t>(in, fileName));
+    uint32_t nObservers = ReadRaw<uint32_t>(in, fileName);
+    uint32_t nOrbiters = ReadRaw<uint32_t>(in, fileName);
+    uint32_t rankingDepth = ReadRaw<uint32_t>(in, fileName);
+
+    Reset(nOrbiters, rankingDepth, start, step, end);
+
+    for (uint32_t obs = 0; obs < nObservers; ++obs)
+    {
+        uint32_t nodeId = ReadRaw<uint32_t>(in, fileName);
+        uint32_t role = ReadRaw<uint32_t>(in, fileName);
+        NS_ABORT_MSG_UNLESS(role <= ROLE_HAP, "Invalid observer role in " << fileName);
+        AddObserver(nodeId, static_cast<NodeRole>(role));
+    }
+
+    uint32_t nPairs = ReadRaw<uint32_t>(in, fileName);
+    for (uint32_t pair = 0; pair < nPairs; ++pair)
+    {
+        uint32_t observer = ReadRaw<uint32_t>(in, fileName);
+        uint32_t satId = ReadRaw<uint32_t>(in, fileName);
+        uint32_t nIntervals = ReadRaw<uint32_t>(in, fileName);
+        NS_ABORT_MSG_UNLESS(observer < nObservers && satId < nOrbiters,
+                            "Invalid contact pair in " << fileName);
+
+        std::vector<Interval>& intervals = m_intervals[PairIndex(observer, satId)];
+        intervals.reserve(nIntervals);
+        for (uint32_t i = 0; i < nIntervals; ++i)
+        {
+            Time intervalStart = TimeStep(ReadRaw<int64_t>(in, fileName));
+            Time intervalEnd = TimeStep(ReadRaw<int64_t>(in, fileName));
+            intervals.push_back({intervalStart, intervalEnd});
+        }
+    }
+
+    for (uint32_t obs = 0; obs < nObservers; ++obs)
+    {
+        uint32_t nEpochs = ReadRaw<uint32_t>(in, fileName);
+        m_rankings[obs].reserve(nEpochs);
+        for (uint32_t e = 0; e < nEpochs; ++e)
+        {
+            RankingEpoch epoch;
+            epoch.start = TimeStep(ReadRaw<int64_t>(in, fileName));
+            for (uint32_t slot = 0; slot < rankingDepth; ++slot)
+            {
+                uint32_t satId = ReadRaw<uint32_t>(in, fileName);
+                if (satId != NO_ORBITER)
+                {
+                    epoch.satIds.push_back(satId);
+                }
+            }
+            m_rankings[obs].push_back(epoch);
+        }
+    }
+
+    NS_LOG_INFO("Loaded contact plan " << fileName << ": " << nObservers << " observers, "
+                                       << nOrbiters << " orbiters, " << nPairs << " pairs");
+}
+
+std::size_t
+HapContactPlan::PairIndex(uint32_t observer, uint32_t satId) const
+{
+    NS_ASSERT(observer < m_observerNodeIds.size());
+    NS_ASSERT(satId < m_nOrbiters);
+    return static_cast<std::size_t>(observer) * m_nOrbiters + satId;
+}
+
+} // namespace ns3
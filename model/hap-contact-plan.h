@@ -0,0 +1,243 @@
+#ifndef SIBGU_HAP_HAP_CONTACT_PLAN_H
+#define SIBGU_HAP_HAP_CONTACT_PLAN_H
+
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Precomputed visibility between ground/HAP nodes and orbiters.
+ *
+ * For every (observer, orbiter) pair the plan holds the list of time
+ * intervals during which the orbiter is above the observer elevation mask.
+ * For every observer it also holds the ranking epochs: the instants at which
+ * the ordered list of the closest visible orbiters changes.
+ *
+ * Observers are identified by ns-3 node id, orbiters by their index in
+ * SatTopology::GetOrbiterNodes() (the satId used by the satellite module).
+ *
+ * The plan is produced once per scenario by HapContactPlanGenerator and
+ * stored in a compact binary file, see Save() and Load().
+ */
+class HapContactPlan : public Object
+{
+  public:
+    /**
+     * Kind of observer node.
+     */
+    enum NodeRole
+    {
+        ROLE_GW = 0,
+        ROLE_UT = 1,
+        ROLE_HAP = 2
+    };
+
+    /**
+     * A visibility interval [start, end).
+     */
+    struct Interval
+    {
+        Time start; //!< first instant the orbiter is visible
+        Time end;   //!< first instant the orbiter is no longer visible
+    };
+
+    /**
+     * Ordered list of closest visible orbiters valid from a given instant.
+     */
+    struct RankingEpoch
+    {
+        Time start;                   //!< instant the ranking becomes valid
+        std::vector<uint32_t> satIds; //!< closest first, at most ranking depth entries
+    };
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapContactPlan();
+    ~HapContactPlan() override;
+
+    /**
+     * \brief Reset the plan and set its dimensions.
+     * \param nOrbiters number of orbiters
+     * \param rankingDepth number of closest orbiters kept per ranking epoch
+     * \param start time of the first sample
+     * \param step sampling step used to build the plan
+     * \param end end of the period covered by the plan, Time::Max() if open
+     */
+    void Reset(uint32_t nOrbiters,
+               uint32_t rankingDepth,
+               Time start,
+               Time step,
+               Time end = Time::Max());
+
+    /**
+     * \brief Register an observer node.
+     * \param nodeId ns-3 node id
+     * \param role observer role
+     * \return observer index
+     */
+    uint32_t AddObserver(uint32_t nodeId, NodeRole role);
+
+    /**
+     * \brief Append a visibility interval. Intervals of a pair must be added in time order.
+     * \param observer observer index
+     * \param satId orbiter index
+     * \param start interval start
+     * \param end interval end
+     */
+    void AddInterval(uint32_t observer, uint32_t satId, Time start, Time end);
+
+    /**
+     * \brief Append a ranking epoch. Epochs of an observer must be added in time order.
+     * \param observer observer index
+     * \param start epoch start
+     * \param satIds closest orbiters, closest first
+     */
+    void AddRankingEpoch(uint32_t observer, Time start, const std::vector<uint32_t>& satIds);
+
+    /**
+     * \return number of observers
+     */
+    uint32_t GetNObservers() const;
+
+    /**
+     * \return number of orbiters
+     */
+    uint32_t GetNOrbiters() const;
+
+    /**
+     * \return ranking depth
+     */
+    uint32_t GetRankingDepth() const;
+
+    /**
+     * \return sampling step the plan was built with
+     */
+    Time GetStep() const;
+
+    /**
+     * \return end of the period covered by the plan, where the last ranking
+     *         epoch ends; Time::Max() if open
+     */
+    Time GetEnd() const;
+
+    /**
+     * \param nodeId ns-3 node id
+     * \return true if the node is an observer of this plan
+     */
+    bool HasObserver(uint32_t nodeId) const;
+
+    /**
+     * \param nodeId ns-3 node id, must be an observer of this plan
+     * \return observer index
+     */
+    uint32_t GetObserverIndex(uint32_t nodeId) const;
+
+    /**
+     * \param observer observer index
+     * \return ns-3 node id of the observer
+     */
+    uint32_t GetObserverNodeId(uint32_t observer) const;
+
+    /**
+     * \param observer observer index
+     * \return observer role
+     */
+    NodeRole GetObserverRole(uint32_t observer) const;
+
+    /**
+     * \param observer observer index
+     * \param satId orbiter index
+     * \return visibility intervals of the pair, in time order
+     */
+    const std::vector<Interval>& GetIntervals(uint32_t observer, uint32_t satId) const;
+
+    /**
+     * \param observer observer index
+     * \param satId orbiter index
+     * \param t time
+     * \return true if the orbiter is visible from the observer at time t
+     */
+    bool IsVisible(uint32_t observer, uint32_t satId, Time t) const;
+
+    /**
+     * \param observer observer index
+     * \param t time
+     * \return orbiters visible from the observer at time t, ascending satId
+     */
+    std::vector<uint32_t> GetVisibleOrbiters(uint32_t observer, Time t) const;
+
+    /**
+     * \param observer observer index
+     * \return ranking epochs of the observer, in time order
+     */
+    const std::vector<RankingEpoch>& GetRankingEpochs(uint32_t observer) const;
+
+    /**
+     * \param observer observer index
+     * \param t time
+     * \return closest visible orbiters at time t, closest first
+     */
+    const std::vector<uint32_t>& GetRanking(uint32_t observer, Time t) const;
+
+    /**
+     * \param observer observer index
+     * \param t time
+     * \return first instant strictly after t at which the ranking changes,
+     *         or Time::Max() if it does not change any more
+     */
+    Time GetNextRankingChange(uint32_t observer, Time t) const;
+
+    /**
+     * \param observer observer index
+     * \param t time
+     * \return first contact boundary (any orbiter) strictly after t,
+     *         or Time::Max() if there is none
+     */
+    Time GetNextContactBoundary(uint32_t observer, Time t) const;
+
+    /**
+     * \brief Write the plan to a binary file.
+     * \param fileName output file
+     */
+    void Save(const std::string& fileName) const;
+
+    /**
+     * \brief Replace the plan with the content of a binary file.
+     * \param fileName input file
+     */
+    void Load(const std::string& fileName);
+
+  private:
+    /**
+     * \param observer observer index
+     * \param satId orbiter index
+     * \return index in m_intervals
+     */
+    std::size_t PairIndex(uint32_t observer, uint32_t satId) const;
+
+    uint32_t m_nOrbiters;                                  //!< number of orbiters
+    uint32_t m_rankingDepth;                               //!< orbiters per ranking epoch
+    Time m_start;                                          //!< first sample time
+    Time m_step;                                           //!< sampling step
+    Time m_end;                                            //!< end of the covered period
+    std::vector<uint32_t> m_observerNodeIds;               //!< node id per observer
+    std::vector<NodeRole> m_observerRoles;                 //!< role per observer
+    std::unordered_map<uint32_t, uint32_t> m_observerIdx;  //!< node id -> observer index
+    std::vector<std::vector<Interval>> m_intervals;        //!< intervals per pair
+    std::vector<std::vector<RankingEpoch>> m_rankings;     //!< ranking epochs per observer
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_CONTACT_PLAN_H
@@ -0,0 +1,217 @@
+#include "hap-gateway-association-index.h"
+
+#include "ns3/abort.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4.h"
+#include "ns3/log.h"
+#include "ns3/node-list.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapGatewayAssociationIndex");
+
+NS_OBJECT_ENSURE_REGISTERED(HapGatewayAssociationIndex);
+
+TypeId
+HapGatewayAssociationIndex::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapGatewayAssociationIndex")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapGatewayAssociationIndex>()
+            .AddTraceSource("Association",
+                            "The gateway serving a UT changed",
+                            MakeTraceSourceAccessor(&HapGatewayAssociationIndex::m_association),
+                            "ns3::HapGatewayAssociationIndex::AssociationCallback");
+    return tid;
+}
+
+HapGatewayAssociationIndex::HapGatewayAssociationIndex()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapGatewayAssociationIndex::~HapGatewayAssociationIndex()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapGatewayAssociationIndex::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_gateways = NodeContainer();
+    m_uts.clear();
+    m_locator = MakeNullCallback<uint32_t, uint32_t, uint32_t>();
+    Object::DoDispose();
+}
+
+void
+HapGatewayAssociationIndex::Build(NodeContainer uts, NodeContainer gateways)
+{
+    NS_LOG_FUNCTION(this << uts.GetN() << gateways.GetN());
+    m_gateways = gateways;
+    m_gatewayOfNode.assign(NodeList::GetNNodes(), NO_GATEWAY);
+    m_gatewayOfUt.assign(NodeList::GetNNodes(), NO_GATEWAY);
+    m_slotOfUt.assign(NodeList::GetNNodes(), 0);
+    m_indexed.assign(NodeList::GetNNodes(), false);
+    m_uts.assign(gateways.GetN() + 1, {});
+    for (uint32_t gateway = 0; gateway < gateways.GetN(); ++gateway)
+    {
+        m_gatewayOfNode[gateways.Get(gateway)->GetId()] = gateway;
+    }
+
+    for (uint32_t i = 0; i < uts.GetN(); ++i)
+    {
+        uint32_t utNodeId = uts.Get(i)->GetId();
+        NS_ABORT_MSG_IF(m_indexed[utNodeId], "UT " << utNodeId << " given twice");
+        uint32_t gateway = FindDefaultGateway(utNodeId);
+        std::vector<uint32_t>& list = GetList(gateway);
+        m_indexed[utNodeId] = true;
+        m_gatewayOfUt[utNodeId] = gateway;
+        m_slotOfUt[utNodeId] = list.size();
+        list.push_back(utNodeId);
+    }
+    NS_LOG_INFO(uts.GetN() << " UTs behind " << gateways.GetN() << " gateways, "
+                           << GetNUnassociated() << " without gateway");
+}
+
+uint32_t
+HapGatewayAssociationIndex::FindDefaultGateway(uint32_t utNodeId) const
+{
+    Ptr<Ipv4> ipv4 = NodeList::GetNode(utNodeId)->GetObject<Ipv4>();
+    NS_ABORT_MSG_IF(!ipv4, "UT " << utNodeId << " has no Ipv4 stack");
+    Ptr<Ipv4StaticRouting> routing = Ipv4StaticRoutingHelper().GetStaticRouting(ipv4);
+    if (!routing)
+    {
+        return NO_GATEWAY;
+    }
+    // Without default route the gateway is not an address of any node
+    Ipv4Address next = routing->GetDefaultRoute().GetGateway();
+    for (uint32_t gateway = 0; gateway < m_gateways.GetN(); ++gateway)
+    {
+        if (m_gateways.Get(gateway)->GetObject<Ipv4>()->GetInterfaceForAddress(next) >= 0)
+        {
+            return gateway;
+        }
+    }
+    return NO_GATEWAY;
+}
+
+std::vector<uint32_t>&
+HapGatewayAssociationIndex::GetList(uint32_t gateway)
+{
+    return gateway == NO_GATEWAY ? m_uts.back() : m_uts[gateway];
+}
+
+uint32_t
+HapGatewayAssociationIndex::GetNGateways() const
+{
+    return m_gateways.GetN();
+}
+
+Ptr<Node>
+HapGatewayAssociationIndex::GetGatewayNode(uint32_t gateway) const
+{
+    NS_ABORT_MSG_IF(gateway >= GetNGateways(), "Unknown gateway " << gateway);
+    return m_gateways.Get(gateway);
+}
+
+uint32_t
+HapGatewayAssociationIndex::GetGatewayIndex(uint32_t nodeId) const
+{
+    return nodeId < m_gatewayOfNode.size() ? m_gatewayOfNode[nodeId] : NO_GATEWAY;
+}
+
+uint32_t
+HapGatewayAssociationIndex::GetGateway(uint32_t utNodeId) const
+{
+    return utNodeId < m_gatewayOfUt.size() ? m_gatewayOfUt[utNodeId] : NO_GATEWAY;
+}
+
+const std::vector<uint32_t>&
+HapGatewayAssociationIndex::GetUts(uint32_t gateway) const
+{
+    NS_ABORT_MSG_IF(gateway >= GetNGateways(), "Unknown gateway " << gateway);
+    return m_uts[gateway];
+}
+
+uint32_t
+HapGatewayAssociationIndex::GetNUnassociated() const
+{
+    return m_uts.empty() ? 0 : m_uts.back().size();
+}
+
+void
+HapGatewayAssociationIndex::Associate(uint32_t utNodeId, uint32_t gateway)
+{
+    NS_LOG_FUNCTION(this << utNodeId << gateway);
+    NS_ABORT_MSG_IF(utNodeId >= m_indexed.size() || !m_indexed[utNodeId],
+                    "UT " << utNodeId << " is not indexed");
+    NS_ABORT_MSG_IF(gateway != NO_GATEWAY && gateway >= GetNGateways(),
+                    "Unknown gateway " << gateway);
+    uint32_t old = m_gatewayOfUt[utNodeId];
+    if (gateway == old)
+    {
+        return;
+    }
+
+    // Swap with the last UT of the old list, then append to the new one
+    std::vector<uint32_t>& from = GetList(old);
+    uint32_t last = from.back();
+    from[m_slotOfUt[utNodeId]] = last;
+    m_slotOfUt[last] = m_slotOfUt[utNodeId];
+    from.pop_back();
+
+    std::vector<uint32_t>& to = GetList(gateway);
+    m_slotOfUt[utNodeId] = to.size();
+    to.push_back(utNodeId);
+    m_gatewayOfUt[utNodeId] = gateway;
+    m_association(utNodeId, old, gateway);
+}
+
+void
+HapGatewayAssociationIndex::Refresh(uint32_t utNodeId)
+{
+    NS_LOG_FUNCTION(this << utNodeId);
+    Associate(utNodeId, FindDefaultGateway(utNodeId));
+}
+
+void
+HapGatewayAssociationIndex::SetGatewayLocator(Callback<uint32_t, uint32_t, uint32_t> locator)
+{
+    NS_LOG_FUNCTION(this);
+    m_locator = locator;
+}
+
+void
+HapGatewayAssociationIndex::ConnectToScheduler(Ptr<HapHandoverScheduler> scheduler)
+{
+    NS_LOG_FUNCTION(this << scheduler);
+    scheduler->TraceConnectWithoutContext(
+        "HandoverTrigger",
+        MakeCallback(&HapGatewayAssociationIndex::HandoverTrigger, this));
+}
+
+void
+HapGatewayAssociationIndex::HandoverTrigger(uint32_t nodeId, const std::vector<uint32_t>& satIds)
+{
+    NS_LOG_FUNCTION(this << nodeId << satIds.size());
+    if (nodeId >= m_indexed.size() || !m_indexed[nodeId])
+    {
+        return;
+    }
+    if (m_locator.IsNull())
+    {
+        Refresh(nodeId);
+    }
+    else
+    {
+        Associate(nodeId, satIds.empty() ? NO_GATEWAY : m_locator(nodeId, satIds.front()));
+    }
+}
+
+} // namespace ns3
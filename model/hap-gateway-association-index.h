@@ -0,0 +1,170 @@
+#ifndef SIBGU_HAP_HAP_GATEWAY_ASSOCIATION_INDEX_H
+#define SIBGU_HAP_HAP_GATEWAY_ASSOCIATION_INDEX_H
+
+#include "hap-handover-scheduler.h"
+
+#include "ns3/callback.h"
+#include "ns3/node-container.h"
+#include "ns3/object.h"
+#include "ns3/traced-callback.h"
+
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Which gateway serves each UT, and which UTs each gateway serves.
+ *
+ * Build() is called once after the topology is created, e.g. with
+ * SatTopology::GetUtNodes() and SatTopology::GetGwNodes(): the gateway of a
+ * UT is the owner of the next hop of its default static route. The index is
+ * then kept up to date with Associate(), Refresh() or the handover triggers
+ * of a HapHandoverScheduler, and the Association trace source reports every
+ * change.
+ *
+ * Gateways are numbered in the order of the container given to Build(), which
+ * makes the index directly usable for per-gateway statistics. Both lookups
+ * are array accesses by node id; the UTs of a gateway are kept in an
+ * unordered list from which a UT is removed by swapping it with the last one.
+ */
+class HapGatewayAssociationIndex : public Object
+{
+  public:
+    /// Marker of a UT without gateway.
+    static constexpr uint32_t NO_GATEWAY = 0xFFFFFFFF;
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapGatewayAssociationIndex();
+    ~HapGatewayAssociationIndex() override;
+
+    /**
+     * TracedCallback signature for association changes.
+     * \param [in] utNodeId node id of the UT
+     * \param [in] oldGateway previous gateway index, NO_GATEWAY if none
+     * \param [in] newGateway new gateway index, NO_GATEWAY if none
+     */
+    typedef void (*AssociationCallback)(uint32_t utNodeId,
+                                        uint32_t oldGateway,
+                                        uint32_t newGateway);
+
+    /**
+     * \brief Index the UTs by the gateway of their default route.
+     *
+     * UTs without a default route, or whose next hop is not an address of
+     * one of the gateways, are indexed without gateway.
+     *
+     * \param uts UT nodes, with an Ipv4 stack
+     * \param gateways gateway nodes, with an Ipv4 stack
+     */
+    void Build(NodeContainer uts, NodeContainer gateways);
+
+    /**
+     * \return number of gateways
+     */
+    uint32_t GetNGateways() const;
+
+    /**
+     * \param gateway gateway index
+     * \return the gateway node
+     */
+    Ptr<Node> GetGatewayNode(uint32_t gateway) const;
+
+    /**
+     * \param nodeId node id of a gateway
+     * \return its gateway index, NO_GATEWAY if the node is not a gateway
+     */
+    uint32_t GetGatewayIndex(uint32_t nodeId) const;
+
+    /**
+     * \param utNodeId node id of a UT
+     * \return index of the gateway serving the UT, NO_GATEWAY if none
+     */
+    uint32_t GetGateway(uint32_t utNodeId) const;
+
+    /**
+     * \param gateway gateway index
+     * \return node ids of the UTs served by the gateway, in no particular order
+     */
+    const std::vector<uint32_t>& GetUts(uint32_t gateway) const;
+
+    /**
+     * \return number of UTs without gateway
+     */
+    uint32_t GetNUnassociated() const;
+
+    /**
+     * \brief Move a UT to another gateway.
+     * \param utNodeId node id of an indexed UT
+     * \param gateway new gateway index, NO_GATEWAY to detach the UT
+     */
+    void Associate(uint32_t utNodeId, uint32_t gateway);
+
+    /**
+     * \brief Associate a UT again from its current default route.
+     * \param utNodeId node id of an indexed UT
+     */
+    void Refresh(uint32_t utNodeId);
+
+    /**
+     * \param locator returns the gateway index serving a UT through an
+     *        orbiter, from the UT node id and the orbiter id, NO_GATEWAY if none
+     */
+    void SetGatewayLocator(Callback<uint32_t, uint32_t, uint32_t> locator);
+
+    /**
+     * \brief Follow the handover triggers of a scheduler.
+     *
+     * On each trigger of an indexed UT, the UT is associated with the gateway
+     * that the locator returns for the closest orbiter, or, without locator,
+     * refreshed from its default route.
+     *
+     * \param scheduler handover scheduler of the UTs
+     */
+    void ConnectToScheduler(Ptr<HapHandoverScheduler> scheduler);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * \param utNodeId node id of a UT
+     * \return index of the gateway owning the next hop of its default route,
+     *         NO_GATEWAY if none
+     */
+    uint32_t FindDefaultGateway(uint32_t utNodeId) const;
+
+    /**
+     * \param gateway gateway index or NO_GATEWAY
+     * \return list of m_uts holding its UTs
+     */
+    std::vector<uint32_t>& GetList(uint32_t gateway);
+
+    /**
+     * \brief Reassociate a UT after a handover trigger.
+     * \param nodeId node id of the UT
+     * \param satIds new ranking of the closest visible orbiters, closest first
+     */
+    void HandoverTrigger(uint32_t nodeId, const std::vector<uint32_t>& satIds);
+
+    NodeContainer m_gateways;                         //!< gateway nodes, by gateway index
+    std::vector<uint32_t> m_gatewayOfNode;            //!< gateway index by node id
+    std::vector<uint32_t> m_gatewayOfUt;              //!< gateway index of each UT, by node id
+    std::vector<uint32_t> m_slotOfUt;                 //!< position in its gateway list, by node id
+    std::vector<bool> m_indexed;                      //!< the node is an indexed UT, by node id
+    std::vector<std::vector<uint32_t>> m_uts;         //!< UT node ids by gateway, then the rest
+    Callback<uint32_t, uint32_t, uint32_t> m_locator; //!< gateway of a UT through an orbiter
+
+    /// Trace source fired when the gateway of a UT changes.
+    TracedCallback<uint32_t, uint32_t, uint32_t> m_association;
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_GATEWAY_ASSOCIATION_INDEX_H
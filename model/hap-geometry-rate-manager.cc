@@ -0,0 +1,416 @@
+#include "hap-geometry-rate-manager.h"
+
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/simulator.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/wifi-tx-vector.h"
+#include "ns3/wifi-utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapGeometryRateManager");
+
+NS_OBJECT_ENSURE_REGISTERED(HapGeometryRateManager);
+
+namespace
+{
+
+/// Thermal noise density at 290 K [dBm/Hz].
+const double THERMAL_NOISE_DBM_HZ = -174.0;
+
+/// Guard interval of the non-HT modes [ns].
+const uint16_t NON_HT_GUARD_INTERVAL_NS = 800;
+
+} // namespace
+
+/// State of a peer of a HapGeometryRateManager.
+struct HapGeometryRateStation : public WifiRemoteStation
+{
+    std::vector<WifiMode> modes;      //!< supported modes, by increasing threshold
+    std::vector<double> thresholdsDb; //!< SNR threshold of each mode [dB]
+    uint32_t index;                   //!< current mode
+    double predictedDb;               //!< last predicted SNR [dB]
+    Time predictedAt;                 //!< time of the prediction
+    bool predicted;                   //!< an SNR was predicted
+    double correctionDb;              //!< feedback correction of the prediction [dB]
+    bool measured;                    //!< the correction saw a measurement
+    bool failed;                      //!< a transmission failed since the last measurement
+};
+
+TypeId
+HapGeometryRateManager::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapGeometryRateManager")
+            .SetParent<WifiRemoteStationManager>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapGeometryRateManager>()
+            .AddAttribute("LossModel",
+                          "Deterministic propagation loss to predict the SNR with",
+                          PointerValue(),
+                          MakePointerAccessor(&HapGeometryRateManager::m_lossModel),
+                          MakePointerChecker<PropagationLossModel>())
+            .AddAttribute("UpdateInterval",
+                          "Largest age of a predicted SNR",
+                          TimeValue(MilliSeconds(100)),
+                          MakeTimeAccessor(&HapGeometryRateManager::m_updateInterval),
+                          MakeTimeChecker())
+            .AddAttribute("BerThreshold",
+                          "Bit error rate the SNR thresholds of the modes are computed for",
+                          DoubleValue(1e-6),
+                          MakeDoubleAccessor(&HapGeometryRateManager::m_ber),
+                          MakeDoubleChecker<double>(0, 1))
+            .AddAttribute("FadingMargin",
+                          "Margin below the corrected SNR, dB",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(&HapGeometryRateManager::m_fadingMarginDb),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("Hysteresis",
+                          "Margin over the threshold of the next mode to step up to it, dB",
+                          DoubleValue(2.0),
+                          MakeDoubleAccessor(&HapGeometryRateManager::m_hysteresisDb),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("FeedbackWeight",
+                          "Weight of a new SNR measurement in the correction",
+                          DoubleValue(0.1),
+                          MakeDoubleAccessor(&HapGeometryRateManager::m_feedbackWeight),
+                          MakeDoubleChecker<double>(0, 1))
+            .AddAttribute("FailurePenalty",
+                          "Correction lost on every failed transmission, dB",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&HapGeometryRateManager::m_failurePenaltyDb),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("MaxCorrection",
+                          "Largest magnitude of the correction, dB",
+                          DoubleValue(20.0),
+                          MakeDoubleAccessor(&HapGeometryRateManager::m_maxCorrectionDb),
+                          MakeDoubleChecker<double>(0))
+            .AddTraceSource("Rate",
+                            "Traced value for rate changes (b/s)",
+                            MakeTraceSourceAccessor(&HapGeometryRateManager::m_currentRate),
+                            "ns3::TracedValueCallback::Uint64");
+    return tid;
+}
+
+HapGeometryRateManager::HapGeometryRateManager()
+    : m_currentRate(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapGeometryRateManager::~HapGeometryRateManager()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapGeometryRateManager::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_peers.clear();
+    m_lossModel = nullptr;
+    WifiRemoteStationManager::DoDispose();
+}
+
+void
+HapGeometryRateManager::DoInitialize()
+{
+    NS_LOG_FUNCTION(this);
+    if (GetHtSupported())
+    {
+        NS_FATAL_ERROR("HapGeometryRateManager handles non-HT modes only");
+    }
+    WifiRemoteStationManager::DoInitialize();
+}
+
+void
+HapGeometryRateManager::AddPeer(Mac48Address address, Ptr<WifiNetDevice> device)
+{
+    NS_LOG_FUNCTION(this << address << device);
+    Ptr<WifiPhy> phy = device->GetPhy();
+    DoubleValue noiseFigure;
+    phy->GetAttribute("RxNoiseFigure", noiseFigure);
+    m_peers[address] = {phy, noiseFigure.Get()};
+}
+
+void
+HapGeometryRateManager::AddPeers(const NetDeviceContainer& devices)
+{
+    for (auto it = devices.Begin(); it != devices.End(); ++it)
+    {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(*it);
+        if (!device)
+        {
+            continue;
+        }
+        Ptr<HapGeometryRateManager> manager =
+            DynamicCast<HapGeometryRateManager>(device->GetRemoteStationManager());
+        if (!manager)
+        {
+            continue;
+        }
+        for (auto peer = devices.Begin(); peer != devices.End(); ++peer)
+        {
+            Ptr<WifiNetDevice> peerDevice = DynamicCast<WifiNetDevice>(*peer);
+            if (peerDevice && peerDevice != device)
+            {
+                manager->AddPeer(Mac48Address::ConvertFrom(peerDevice->GetAddress()), peerDevice);
+            }
+        }
+    }
+}
+
+double
+HapGeometryRateManager::PredictSnr(Mac48Address address) const
+{
+    auto it = m_peers.find(address);
+    Ptr<WifiPhy> phy = GetPhy();
+    if (!m_lossModel || it == m_peers.end() || !phy)
+    {
+        return 0;
+    }
+    const Peer& peer = it->second;
+    double txPowerDbm = phy->GetTxPowerStart() + phy->GetTxGain();
+    double rxPowerDbm =
+        m_lossModel->CalcRxPower(txPowerDbm, phy->GetMobility(), peer.phy->GetMobility()) +
+        peer.phy->GetRxGain();
+    double noiseDbm = THERMAL_NOISE_DBM_HZ + 10 * std::log10(phy->GetChannelWidth() * 1e6) +
+                      peer.noiseFigureDb;
+    return rxPowerDbm - noiseDbm;
+}
+
+uint32_t
+HapGeometryRateManager::SelectMode(const std::vector<double>& thresholdsDb,
+                                   uint32_t current,
+                                   double snrDb,
+                                   double hysteresisDb)
+{
+    if (thresholdsDb.empty())
+    {
+        return 0;
+    }
+    uint32_t index = std::min<uint32_t>(current, thresholdsDb.size() - 1);
+    while (index > 0 && snrDb < thresholdsDb[index])
+    {
+        --index;
+    }
+    while (index + 1 < thresholdsDb.size() && snrDb >= thresholdsDb[index + 1] + hysteresisDb)
+    {
+        ++index;
+    }
+    return index;
+}
+
+WifiRemoteStation*
+HapGeometryRateManager::DoCreateStation() const
+{
+    NS_LOG_FUNCTION(this);
+    auto station = new HapGeometryRateStation();
+    station->index = 0;
+    station->predictedDb = 0;
+    station->predicted = false;
+    station->correctionDb = 0;
+    station->measured = false;
+    station->failed = false;
+    return station;
+}
+
+void
+HapGeometryRateManager::InitializeStation(WifiRemoteStation* st) const
+{
+    auto station = static_cast<HapGeometryRateStation*>(st);
+    if (!station->modes.empty())
+    {
+        return;
+    }
+    Ptr<WifiPhy> phy = GetPhy();
+    std::vector<WifiMode> modes;
+    std::vector<double> thresholdsDb;
+    for (uint8_t i = 0; i < GetNSupported(station); ++i)
+    {
+        WifiMode mode = GetSupported(station, i);
+        if (mode.GetModulationClass() >= WIFI_MOD_CLASS_HT)
+        {
+            continue;
+        }
+        WifiTxVector txVector;
+        txVector.SetMode(mode);
+        txVector.SetChannelWidth(GetChannelWidthForTransmission(mode, phy->GetChannelWidth()));
+        txVector.SetNss(1);
+        modes.push_back(mode);
+        thresholdsDb.push_back(RatioToDb(phy->CalculateSnr(txVector, m_ber)));
+    }
+
+    // By increasing threshold, without the modes slower than an easier one
+    std::vector<std::size_t> order(modes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&thresholdsDb](std::size_t a, std::size_t b) {
+        return thresholdsDb[a] < thresholdsDb[b];
+    });
+    uint64_t fastest = 0;
+    for (std::size_t i : order)
+    {
+        uint64_t rate = modes[i].GetDataRate(phy->GetChannelWidth());
+        if (rate > fastest)
+        {
+            station->modes.push_back(modes[i]);
+            station->thresholdsDb.push_back(thresholdsDb[i]);
+            fastest = rate;
+            NS_LOG_DEBUG(modes[i].GetUniqueName() << " needs " << thresholdsDb[i] << " dB");
+        }
+    }
+}
+
+void
+HapGeometryRateManager::UpdateMode(WifiRemoteStation* st)
+{
+    auto station = static_cast<HapGeometryRateStation*>(st);
+    InitializeStation(station);
+    Time now = Simulator::Now();
+    if (!station->predicted || now - station->predictedAt >= m_updateInterval)
+    {
+        station->predictedDb = PredictSnr(station->m_state->m_address);
+        station->predictedAt = now;
+        station->predicted = true;
+    }
+    double snrDb = station->predictedDb + station->correctionDb - m_fadingMarginDb;
+    uint32_t index = SelectMode(station->thresholdsDb, station->index, snrDb, m_hysteresisDb);
+    if (index != station->index)
+    {
+        NS_LOG_DEBUG(station->m_state->m_address << " at " << snrDb << " dB: "
+                                                 << station->modes[station->index].GetUniqueName()
+                                                 << " -> " << station->modes[index].GetUniqueName());
+        station->index = index;
+    }
+}
+
+void
+HapGeometryRateManager::DoReportRxOk(WifiRemoteStation* station, double rxSnr, WifiMode txMode)
+{
+    NS_LOG_FUNCTION(this << station << rxSnr << txMode);
+}
+
+void
+HapGeometryRateManager::DoReportRtsFailed(WifiRemoteStation* station)
+{
+    NS_LOG_FUNCTION(this << station);
+}
+
+void
+HapGeometryRateManager::DoReportDataFailed(WifiRemoteStation* st)
+{
+    NS_LOG_FUNCTION(this << st);
+    auto station = static_cast<HapGeometryRateStation*>(st);
+    // Bounded, so that an outage does not pin the rate long after it ends
+    station->correctionDb =
+        std::max(station->correctionDb - m_failurePenaltyDb, -m_maxCorrectionDb);
+    station->failed = true;
+}
+
+void
+HapGeometryRateManager::DoReportRtsOk(WifiRemoteStation* station,
+                                      double ctsSnr,
+                                      WifiMode ctsMode,
+                                      double rtsSnr)
+{
+    NS_LOG_FUNCTION(this << station << ctsSnr << ctsMode << rtsSnr);
+}
+
+void
+HapGeometryRateManager::DoReportDataOk(WifiRemoteStation* st,
+                                       double ackSnr,
+                                       WifiMode ackMode,
+                                       double dataSnr,
+                                       uint16_t dataChannelWidth,
+                                       uint8_t dataNss)
+{
+    NS_LOG_FUNCTION(this << st << ackSnr << ackMode << dataSnr << dataChannelWidth << +dataNss);
+    auto station = static_cast<HapGeometryRateStation*>(st);
+    if (dataSnr <= 0 || !station->predicted)
+    {
+        return;
+    }
+    // The peer measured the SNR of the frame sent with the current prediction
+    double errorDb = RatioToDb(dataSnr) - station->predictedDb;
+    if (station->measured && !station->failed)
+    {
+        station->correctionDb += m_feedbackWeight * (errorDb - station->correctionDb);
+    }
+    else
+    {
+        // First measurement, or first one after failures: the penalties only
+        // stood in for the missing feedback
+        station->correctionDb = errorDb;
+        station->measured = true;
+        station->failed = false;
+    }
+    station->correctionDb =
+        std::min(std::max(station->correctionDb, -m_maxCorrectionDb), m_maxCorrectionDb);
+}
+
+void
+HapGeometryRateManager::DoReportFinalRtsFailed(WifiRemoteStation* station)
+{
+    NS_LOG_FUNCTION(this << station);
+}
+
+void
+HapGeometryRateManager::DoReportFinalDataFailed(WifiRemoteStation* station)
+{
+    NS_LOG_FUNCTION(this << station);
+}
+
+WifiTxVector
+HapGeometryRateManager::DoGetDataTxVector(WifiRemoteStation* st, uint16_t allowedWidth)
+{
+    NS_LOG_FUNCTION(this << st << allowedWidth);
+    auto station = static_cast<HapGeometryRateStation*>(st);
+    UpdateMode(station);
+    WifiMode mode = station->modes.empty() ? GetDefaultMode() : station->modes[station->index];
+    uint16_t channelWidth = GetChannelWidthForTransmission(mode, allowedWidth);
+    uint64_t rate = mode.GetDataRate(channelWidth);
+    if (m_currentRate != rate)
+    {
+        m_currentRate = rate;
+    }
+    return WifiTxVector(
+        mode,
+        GetDefaultTxPowerLevel(),
+        GetPreambleForTransmission(mode.GetModulationClass(), GetShortPreambleEnabled()),
+        NON_HT_GUARD_INTERVAL_NS,
+        1,
+        1,
+        0,
+        channelWidth,
+        GetAggregation(station));
+}
+
+WifiTxVector
+HapGeometryRateManager::DoGetRtsTxVector(WifiRemoteStation* st)
+{
+    NS_LOG_FUNCTION(this << st);
+    auto station = static_cast<HapGeometryRateStation*>(st);
+    InitializeStation(station);
+    WifiMode mode = station->modes.empty() ? GetDefaultMode() : station->modes.front();
+    return WifiTxVector(
+        mode,
+        GetDefaultTxPowerLevel(),
+        GetPreambleForTransmission(mode.GetModulationClass(), GetShortPreambleEnabled()),
+        NON_HT_GUARD_INTERVAL_NS,
+        1,
+        1,
+        0,
+        GetChannelWidthForTransmission(mode, GetPhy()->GetChannelWidth()),
+        GetAggregation(station));
+}
+
+} // namespace ns3
@@ -0,0 +1,157 @@
+#ifndef SIBGU_HAP_HAP_GEOMETRY_RATE_MANAGER_H
+#define SIBGU_HAP_HAP_GEOMETRY_RATE_MANAGER_H
+
+#include "ns3/mac48-address.h"
+#include "ns3/net-device-container.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-value.h"
+#include "ns3/wifi-remote-station-manager.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace ns3
+{
+
+class PropagationLossModel;
+class WifiNetDevice;
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Rate control from the SNR predicted by the HAP link geometry.
+ *
+ * The SNR towards a peer is predicted from the positions of both nodes, the
+ * deterministic LossModel (the channel without its fading), the transmit
+ * power, the current TxGain of this PHY and RxGain of the peer PHY, which
+ * the moving HAP examples steer with the cos^n antenna, and the thermal
+ * noise of the peer. The prediction is recomputed at most once per
+ * UpdateInterval.
+ *
+ * The SNR measured by the peer on acknowledged frames closes the loop: an
+ * exponential average of the measured minus the predicted SNR corrects the
+ * prediction, and every failed transmission lowers it by FailurePenalty.
+ * The first measurement after failures replaces the correction, and the
+ * correction never exceeds MaxCorrection in magnitude.
+ * Without a LossModel or for a peer not added with AddPeer(), the correction
+ * alone drives the rate, from the lowest mode.
+ *
+ * The rate is the fastest supported mode whose SNR threshold (for
+ * BerThreshold, as in IdealWifiManager) is below the corrected SNR minus
+ * FadingMargin. It only steps up when the next mode is exceeded by
+ * Hysteresis, so that the rate does not toggle on the fading.
+ *
+ * Only non-HT modes (802.11a/b/g) are handled.
+ */
+class HapGeometryRateManager : public WifiRemoteStationManager
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapGeometryRateManager();
+    ~HapGeometryRateManager() override;
+
+    /**
+     * \brief Predict the SNR towards a peer from its device.
+     * \param address MAC address of the peer
+     * \param device the peer device, with a mobility model on its node; the
+     *        noise figure of its PHY is read now
+     */
+    void AddPeer(Mac48Address address, Ptr<WifiNetDevice> device);
+
+    /**
+     * \brief Make every HapGeometryRateManager of the devices a peer of the others.
+     *
+     * Devices other than WifiNetDevice, or with another manager, are ignored.
+     *
+     * \param devices devices sharing a channel
+     */
+    static void AddPeers(const NetDeviceContainer& devices);
+
+    /**
+     * \brief SNR predicted from the geometry, before the feedback correction.
+     * \param address MAC address of the peer
+     * \return SNR [dB]; 0 for an unknown peer or without a LossModel
+     */
+    double PredictSnr(Mac48Address address) const;
+
+    /**
+     * \brief Mode index selected for an SNR.
+     *
+     * Steps down while the SNR is below the threshold of the current mode
+     * and up while it exceeds the threshold of the next one by hysteresisDb.
+     *
+     * \param thresholdsDb SNR thresholds of the modes, increasing [dB]
+     * \param current index of the current mode
+     * \param snrDb the SNR [dB]
+     * \param hysteresisDb margin to step up [dB]
+     * \return index of the new mode
+     */
+    static uint32_t SelectMode(const std::vector<double>& thresholdsDb,
+                               uint32_t current,
+                               double snrDb,
+                               double hysteresisDb);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    void DoInitialize() override;
+    WifiRemoteStation* DoCreateStation() const override;
+    void DoReportRxOk(WifiRemoteStation* station, double rxSnr, WifiMode txMode) override;
+    void DoReportRtsFailed(WifiRemoteStation* station) override;
+    void DoReportDataFailed(WifiRemoteStation* station) override;
+    void DoReportRtsOk(WifiRemoteStation* station,
+                       double ctsSnr,
+                       WifiMode ctsMode,
+                       double rtsSnr) override;
+    void DoReportDataOk(WifiRemoteStation* station,
+                        double ackSnr,
+                        WifiMode ackMode,
+                        double dataSnr,
+                        uint16_t dataChannelWidth,
+                        uint8_t dataNss) override;
+    void DoReportFinalRtsFailed(WifiRemoteStation* station) override;
+    void DoReportFinalDataFailed(WifiRemoteStation* station) override;
+    WifiTxVector DoGetDataTxVector(WifiRemoteStation* station, uint16_t allowedWidth) override;
+    WifiTxVector DoGetRtsTxVector(WifiRemoteStation* station) override;
+
+    /// Peer of a station.
+    struct Peer
+    {
+        Ptr<WifiPhy> phy;     //!< PHY of the peer, for its position and RxGain
+        double noiseFigureDb; //!< noise figure of the peer PHY [dB]
+    };
+
+    /**
+     * \brief Build the mode list of a station on its first use.
+     * \param station the station
+     */
+    void InitializeStation(WifiRemoteStation* station) const;
+
+    /**
+     * \brief Update the mode of a station from its current SNR.
+     * \param station the station
+     */
+    void UpdateMode(WifiRemoteStation* station);
+
+    Ptr<PropagationLossModel> m_lossModel; //!< deterministic loss to predict with
+    Time m_updateInterval;                 //!< largest age of a prediction
+    double m_ber;                          //!< BER the thresholds are computed for
+    double m_fadingMarginDb;               //!< margin below the corrected SNR [dB]
+    double m_hysteresisDb;                 //!< margin to step up [dB]
+    double m_feedbackWeight;               //!< weight of a new SNR measurement
+    double m_failurePenaltyDb;             //!< correction lost per failure [dB]
+    double m_maxCorrectionDb;              //!< largest correction magnitude [dB]
+    std::map<Mac48Address, Peer> m_peers;  //!< peers by address
+
+    TracedValue<uint64_t> m_currentRate; //!< rate of the last data frame [bps]
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_GEOMETRY_RATE_MANAGER_H
@@ -0,0 +1,64 @@
+#include "hap-geometry.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+double
+HapElevationAngle(const Vector& observer, const Vector& target)
+{
+    double lx = target.x - observer.x;
+    double ly = target.y - observer.y;
+    double lz = target.z - observer.z;
+    double losLength = std::sqrt(lx * lx + ly * ly + lz * lz);
+    double upLength =
+        std::sqrt(observer.x * observer.x + observer.y * observer.y + observer.z * observer.z);
+
+    if (losLength == 0.0 || upLength == 0.0)
+    {
+        return 90.0;
+    }
+
+    double sinElevation =
+        (lx * observer.x + ly * observer.y + lz * observer.z) / (losLength * upLength);
+    sinElevation = std::clamp(sinElevation, -1.0, 1.0);
+
+    return std::asin(sinElevation) * 180.0 / M_PI;
+}
+
+double
+HapDistanceSquared(const Vector& a, const Vector& b)
+{
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    double dz = a.z - b.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+double
+HapOffAxisAngle(const Vector& boresight, const Vector& direction)
+{
+    double dot = boresight.x * direction.x + boresight.y * direction.y + boresight.z * direction.z;
+    double boresightLength = boresight.GetLength();
+    double directionLength = direction.GetLength();
+    if (boresightLength * directionLength == 0.0)
+    {
+        return 0.0;
+    }
+    return std::acos(std::clamp(dot / (boresightLength * directionLength), -1.0, 1.0));
+}
+
+double
+HapCosineGain(double angle, double maxGain, double exponent)
+{
+    double cosAngle = std::cos(angle);
+    if (cosAngle < 0.01)
+    {
+        return -20.0;
+    }
+    return maxGain + 10.0 * std::log10(std::pow(cosAngle, exponent));
+}
+
+} // namespace ns3
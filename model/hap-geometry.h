@@ -0,0 +1,58 @@
+#ifndef SIBGU_HAP_HAP_GEOMETRY_H
+#define SIBGU_HAP_HAP_GEOMETRY_H
+
+#include "ns3/vector.h"
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Elevation of a target seen from an observer, both given in ECEF.
+ *
+ * The local vertical is taken along the observer position vector
+ * (spherical Earth), which is accurate enough for visibility masks.
+ *
+ * \param observer observer ECEF position [m]
+ * \param target target ECEF position [m]
+ * \return elevation angle [deg], in [-90, 90]
+ */
+double HapElevationAngle(const Vector& observer, const Vector& target);
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Squared distance between two ECEF positions.
+ *
+ * \param a first position [m]
+ * \param b second position [m]
+ * \return squared distance [m^2]
+ */
+double HapDistanceSquared(const Vector& a, const Vector& b);
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Angle between an antenna boresight and the direction to a target.
+ *
+ * \param boresight boresight direction, any length
+ * \param direction direction to the target, any length
+ * \return angle [rad], in [0, pi]; 0 if either vector is null
+ */
+double HapOffAxisAngle(const Vector& boresight, const Vector& direction);
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Gain of a cosine-power directional antenna.
+ *
+ * Gain = maxGain + 10 log10(cos(angle)^exponent), floored at -20 dBi once
+ * cos(angle) drops below 0.01 (outside the beam).
+ *
+ * \param angle off-axis angle [rad]
+ * \param maxGain boresight gain [dBi]
+ * \param exponent beam width exponent, larger is narrower
+ * \return gain [dBi]
+ */
+double HapCosineGain(double angle, double maxGain, double exponent);
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_GEOMETRY_H
@@ -0,0 +1,230 @@
+#include "hap-handover-scheduler.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapHandoverScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED(HapHandoverScheduler);
+
+TypeId
+HapHandoverScheduler::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapHandoverScheduler")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapHandoverScheduler>()
+            .AddAttribute("NumberClosestSats",
+                          "Number of closest orbiters whose order matters for the handover "
+                          "decision. Should match SatHandoverModule::NumberClosestSats.",
+                          UintegerValue(3),
+                          MakeUintegerAccessor(&HapHandoverScheduler::m_nClosestSats),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("CheckPeriod",
+                          "Period of the evaluation grid the triggers are aligned to. "
+                          "Zero reports the exact instants of the contact plan.",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&HapHandoverScheduler::m_checkPeriod),
+                          MakeTimeChecker(Seconds(0)))
+            .AddTraceSource("HandoverTrigger",
+                            "The ranking of the closest visible orbiters of a node changed.",
+                            MakeTraceSourceAccessor(&HapHandoverScheduler::m_handoverTrigger),
+                            "ns3::HapHandoverScheduler::HandoverTriggerCallback");
+    return tid;
+}
+
+HapHandoverScheduler::HapHandoverScheduler()
+    : m_nClosestSats(3),
+      m_checkPeriod(Seconds(0)),
+      m_nEvaluations(0),
+      m_nTriggers(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapHandoverScheduler::~HapHandoverScheduler()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapHandoverScheduler::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    for (NodeState& state : m_nodes)
+    {
+        state.event.Cancel();
+    }
+    m_gridEvent.Cancel();
+    m_nodes.clear();
+    m_indexedNodes = NodeContainer();
+    m_plan = nullptr;
+    m_index = nullptr;
+    Object::DoDispose();
+}
+
+void
+HapHandoverScheduler::SetContactPlan(Ptr<HapContactPlan> plan)
+{
+    NS_LOG_FUNCTION(this << plan);
+    m_plan = plan;
+}
+
+void
+HapHandoverScheduler::SetOrbiterIndex(Ptr<HapNearestOrbiterIndex> index)
+{
+    NS_LOG_FUNCTION(this << index);
+    m_index = index;
+}
+
+void
+HapHandoverScheduler::Install(NodeContainer nodes)
+{
+    NS_LOG_FUNCTION(this << nodes.GetN());
+    if (!m_plan)
+    {
+        NS_ABORT_MSG_UNLESS(m_index,
+                            "A contact plan or an orbiter index must be set before installing "
+                            "the scheduler");
+        NS_ABORT_MSG_UNLESS(m_checkPeriod.IsStrictlyPositive(),
+                            "Ranking with an orbiter index needs a positive CheckPeriod");
+        for (uint32_t i = 0; i < nodes.GetN(); ++i)
+        {
+            NodeState state;
+            state.nodeId = nodes.Get(i)->GetId();
+            state.observer = 0;
+            m_nodes.push_back(state);
+        }
+        m_indexedNodes.Add(nodes);
+        if (m_gridEvent.IsExpired())
+        {
+            m_gridEvent = Simulator::ScheduleNow(&HapHandoverScheduler::EvaluateAll, this);
+        }
+        return;
+    }
+
+    NS_ABORT_MSG_IF(m_nClosestSats > m_plan->GetRankingDepth(),
+                    "NumberClosestSats " << m_nClosestSats << " exceeds the contact plan depth "
+                                         << m_plan->GetRankingDepth());
+
+    m_nodes.reserve(m_nodes.size() + nodes.GetN());
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        uint32_t nodeId = nodes.Get(i)->GetId();
+        NodeState state;
+        state.nodeId = nodeId;
+        state.observer = m_plan->GetObserverIndex(nodeId);
+        m_nodes.push_back(state);
+
+        std::size_t index = m_nodes.size() - 1;
+        m_nodes[index].event =
+            Simulator::ScheduleNow(&HapHandoverScheduler::Evaluate, this, index);
+    }
+}
+
+void
+HapHandoverScheduler::Evaluate(std::size_t index)
+{
+    NodeState& state = m_nodes[index];
+    Time now = Simulator::Now();
+    ++m_nEvaluations;
+
+    Update(state, GetRanking(state.observer, now));
+
+    Time next = GetNextChange(state.observer, now, state.ranking);
+    if (next == Time::Max())
+    {
+        return;
+    }
+    next = AlignToGrid(next);
+    state.event = Simulator::Schedule(next - now, &HapHandoverScheduler::Evaluate, this, index);
+}
+
+void
+HapHandoverScheduler::EvaluateAll()
+{
+    Time now = Simulator::Now();
+    ++m_nEvaluations;
+
+    // Without contact plan m_nodes and m_indexedNodes are in the same order
+    m_index->FindKClosest(m_indexedNodes, m_nClosestSats, m_batch);
+    for (std::size_t i = 0; i < m_batch.size(); ++i)
+    {
+        Update(m_nodes[i], m_batch[i]);
+    }
+
+    Time next = AlignToGrid(now + TimeStep(1));
+    m_gridEvent = Simulator::Schedule(next - now, &HapHandoverScheduler::EvaluateAll, this);
+}
+
+void
+HapHandoverScheduler::Update(NodeState& state, const std::vector<uint32_t>& ranking)
+{
+    if (ranking == state.ranking)
+    {
+        return;
+    }
+    NS_LOG_INFO("Node " << state.nodeId << " ranking changed at "
+                        << Simulator::Now().As(Time::S) << ", best orbiter "
+                        << (ranking.empty() ? -1 : static_cast<int64_t>(ranking.front())));
+    state.ranking = ranking;
+    ++m_nTriggers;
+    m_handoverTrigger(state.nodeId, state.ranking);
+}
+
+std::vector<uint32_t>
+HapHandoverScheduler::GetRanking(uint32_t observer, Time t) const
+{
+    const std::vector<uint32_t>& ranking = m_plan->GetRanking(observer, t);
+    std::size_t depth = std::min<std::size_t>(ranking.size(), m_nClosestSats);
+    return std::vector<uint32_t>(ranking.begin(), ranking.begin() + depth);
+}
+
+Time
+HapHandoverScheduler::GetNextChange(uint32_t observer,
+                                    Time t,
+                                    const std::vector<uint32_t>& current) const
+{
+    // Epochs that only reorder orbiters beyond NumberClosestSats are skipped
+    Time next = m_plan->GetNextRankingChange(observer, t);
+    while (next != Time::Max() && GetRanking(observer, next) == current)
+    {
+        next = m_plan->GetNextRankingChange(observer, next);
+    }
+    return next;
+}
+
+Time
+HapHandoverScheduler::AlignToGrid(Time t) const
+{
+    if (m_checkPeriod.IsZero())
+    {
+        return t;
+    }
+    int64_t period = m_checkPeriod.GetTimeStep();
+    int64_t steps = (t.GetTimeStep() + period - 1) / period;
+    return TimeStep(steps * period);
+}
+
+uint64_t
+HapHandoverScheduler::GetNEvaluations() const
+{
+    return m_nEvaluations;
+}
+
+uint64_t
+HapHandoverScheduler::GetNTriggers() const
+{
+    return m_nTriggers;
+}
+
+} // namespace ns3
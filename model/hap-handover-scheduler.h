@@ -0,0 +1,167 @@
+#ifndef SIBGU_HAP_HAP_HANDOVER_SCHEDULER_H
+#define SIBGU_HAP_HAP_HANDOVER_SCHEDULER_H
+
+#include "hap-contact-plan.h"
+#include "hap-nearest-orbiter-index.h"
+
+#include "ns3/event-id.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/traced-callback.h"
+
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Event-driven handover triggers computed from a contact plan.
+ *
+ * Instead of re-evaluating the satellite selection of every UT on a timer,
+ * the scheduler looks up in the HapContactPlan the next instant at which the
+ * ordered list of the NumberClosestSats closest visible orbiters of the UT
+ * changes, and schedules exactly one event for it. When the event fires the
+ * new ranking is reported through the HandoverTrigger trace source and the
+ * next change is scheduled.
+ *
+ * If CheckPeriod is not zero the events are moved to the first instant of
+ * the periodic evaluation grid (multiples of CheckPeriod) at or after the
+ * change, so that the reported instants are identical to those a periodic
+ * check with that period would produce.
+ *
+ * Without contact plan the rankings come from a HapNearestOrbiterIndex.
+ * The next change cannot be predicted then: all installed nodes are ranked
+ * together, with one batch query, at every multiple of CheckPeriod, and a
+ * trigger is reported for each node whose ranking changed. The index ranks
+ * the orbiters by distance only, without elevation mask.
+ *
+ * The scheduler only predicts handovers: it does not drive the SNS3
+ * handover, and SatHandoverModule keeps running its own checks when
+ * SatHelper::HandoversEnabled is set. The triggers are meant for state that
+ * only needs to follow the handovers, e.g. HapLazyBeamManager or
+ * HapGatewayAssociationIndex, which then costs one event per actual change.
+ */
+class HapHandoverScheduler : public Object
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapHandoverScheduler();
+    ~HapHandoverScheduler() override;
+
+    /**
+     * TracedCallback signature for handover triggers.
+     * \param [in] nodeId node id of the UT
+     * \param [in] satIds new ranking of the closest visible orbiters, closest first
+     */
+    typedef void (*HandoverTriggerCallback)(uint32_t nodeId, const std::vector<uint32_t>& satIds);
+
+    /**
+     * \param plan contact plan with the ranking epochs of the UTs
+     */
+    void SetContactPlan(Ptr<HapContactPlan> plan);
+
+    /**
+     * \param index nearest-orbiter index used when no contact plan is set
+     */
+    void SetOrbiterIndex(Ptr<HapNearestOrbiterIndex> index);
+
+    /**
+     * \brief Start scheduling handover triggers for the given nodes.
+     *
+     * With a contact plan every node must be an observer of the plan. With an
+     * orbiter index every node must have a mobility model, and CheckPeriod
+     * must be positive.
+     *
+     * \param nodes UT (or GW/HAP) nodes
+     */
+    void Install(NodeContainer nodes);
+
+    /**
+     * \return number of scheduler events run so far, over all nodes
+     */
+    uint64_t GetNEvaluations() const;
+
+    /**
+     * \return number of handover triggers reported so far, over all nodes
+     */
+    uint64_t GetNTriggers() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * State of one scheduled node.
+     */
+    struct NodeState
+    {
+        uint32_t nodeId;               //!< ns-3 node id
+        uint32_t observer;             //!< observer index in the contact plan
+        std::vector<uint32_t> ranking; //!< last reported ranking
+        EventId event;                 //!< pending evaluation
+    };
+
+    /**
+     * \brief Evaluate the ranking of a node and schedule its next evaluation.
+     * \param index index in m_nodes
+     */
+    void Evaluate(std::size_t index);
+
+    /**
+     * \brief Rank all nodes with the orbiter index and schedule the next grid instant.
+     */
+    void EvaluateAll();
+
+    /**
+     * \brief Report a trigger if the ranking of a node changed.
+     * \param state node state
+     * \param ranking current ranking
+     */
+    void Update(NodeState& state, const std::vector<uint32_t>& ranking);
+
+    /**
+     * \param observer observer index
+     * \param t time
+     * \return the ranking at t, truncated to NumberClosestSats
+     */
+    std::vector<uint32_t> GetRanking(uint32_t observer, Time t) const;
+
+    /**
+     * \param observer observer index
+     * \param t time
+     * \param current ranking valid at t
+     * \return first instant after t at which the truncated ranking differs from current
+     */
+    Time GetNextChange(uint32_t observer, Time t, const std::vector<uint32_t>& current) const;
+
+    /**
+     * \param t time
+     * \return t moved up to the evaluation grid
+     */
+    Time AlignToGrid(Time t) const;
+
+    Ptr<HapContactPlan> m_plan;                 //!< contact plan
+    Ptr<HapNearestOrbiterIndex> m_index;        //!< ranking source without contact plan
+    uint32_t m_nClosestSats;                    //!< ranking depth considered for handover
+    Time m_checkPeriod;                         //!< evaluation grid, zero for exact instants
+    std::vector<NodeState> m_nodes;             //!< scheduled nodes
+    NodeContainer m_indexedNodes;               //!< nodes ranked with the orbiter index
+    std::vector<std::vector<uint32_t>> m_batch; //!< rankings of the last batch query
+    EventId m_gridEvent;                        //!< pending batch evaluation
+    uint64_t m_nEvaluations;                    //!< evaluation counter
+    uint64_t m_nTriggers;                       //!< trigger counter
+
+    /// Trace source fired when the ranking of a node changes.
+    TracedCallback<uint32_t, const std::vector<uint32_t>&> m_handoverTrigger;
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_HANDOVER_SCHEDULER_H
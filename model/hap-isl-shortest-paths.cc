@@ -0,0 +1,299 @@
+#include "hap-isl-shortest-paths.h"
+
+#include "ns3/abort.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace ns3
+{
+
+namespace
+{
+
+/// Distance of an unreachable node.
+const double INFINITE_DISTANCE = std::numeric_limits<double>::infinity();
+
+} // namespace
+
+HapIslShortestPaths::HapIslShortestPaths()
+    : m_nSettled(0)
+{
+}
+
+void
+HapIslShortestPaths::SetTopology(uint32_t nNodes, const std::vector<Link>& links)
+{
+    m_trees.clear();
+    m_treeOf.assign(nNodes, NO_NODE);
+    m_inSubtree.assign(nNodes, false);
+    m_offsets.assign(nNodes + 1, 0);
+    for (const Link& link : links)
+    {
+        NS_ABORT_MSG_IF(link.a >= nNodes || link.b >= nNodes || link.a == link.b,
+                        "Invalid ISL link " << link.a << " - " << link.b);
+        NS_ABORT_MSG_IF(std::isnan(link.weight) || link.weight < 0,
+                        "Invalid weight " << link.weight << " of link " << link.a << " - "
+                                          << link.b);
+        ++m_offsets[link.a + 1];
+        ++m_offsets[link.b + 1];
+    }
+    for (uint32_t node = 0; node < nNodes; ++node)
+    {
+        m_offsets[node + 1] += m_offsets[node];
+    }
+
+    m_neighbors.resize(m_offsets[nNodes]);
+    m_weights.resize(m_offsets[nNodes]);
+    std::vector<uint32_t> fill(m_offsets.begin(), m_offsets.end() - 1);
+    for (const Link& link : links)
+    {
+        m_neighbors[fill[link.a]] = link.b;
+        m_weights[fill[link.a]++] = link.weight;
+        m_neighbors[fill[link.b]] = link.a;
+        m_weights[fill[link.b]++] = link.weight;
+    }
+
+    // Rows sorted by neighbour, for the slot lookup of SetLinkWeight()
+    std::vector<std::pair<uint32_t, double>> row;
+    for (uint32_t node = 0; node < nNodes; ++node)
+    {
+        row.clear();
+        for (uint32_t slot = m_offsets[node]; slot < m_offsets[node + 1]; ++slot)
+        {
+            row.emplace_back(m_neighbors[slot], m_weights[slot]);
+        }
+        std::sort(row.begin(), row.end());
+        for (std::size_t i = 0; i < row.size(); ++i)
+        {
+            NS_ABORT_MSG_IF(i > 0 && row[i].first == row[i - 1].first,
+                            "Duplicate link " << node << " - " << row[i].first);
+            m_neighbors[m_offsets[node] + i] = row[i].first;
+            m_weights[m_offsets[node] + i] = row[i].second;
+        }
+    }
+}
+
+uint32_t
+HapIslShortestPaths::GetNNodes() const
+{
+    return m_treeOf.size();
+}
+
+void
+HapIslShortestPaths::AddDestination(uint32_t destination)
+{
+    NS_ABORT_MSG_IF(destination >= GetNNodes(), "Unknown destination " << destination);
+    if (m_treeOf[destination] != NO_NODE)
+    {
+        return;
+    }
+    m_treeOf[destination] = m_trees.size();
+    m_trees.push_back({destination, {}, {}});
+    Build(m_trees.back());
+}
+
+uint32_t
+HapIslShortestPaths::FindSlot(uint32_t a, uint32_t b) const
+{
+    NS_ABORT_MSG_IF(a >= GetNNodes() || b >= GetNNodes(), "Unknown link " << a << " - " << b);
+    auto begin = m_neighbors.begin() + m_offsets[a];
+    auto end = m_neighbors.begin() + m_offsets[a + 1];
+    auto it = std::lower_bound(begin, end, b);
+    NS_ABORT_MSG_IF(it == end || *it != b, "Link " << a << " - " << b << " was not declared");
+    return it - m_neighbors.begin();
+}
+
+void
+HapIslShortestPaths::SetLinkWeight(uint32_t a, uint32_t b, double weight)
+{
+    NS_ABORT_MSG_IF(std::isnan(weight) || weight < 0,
+                    "Invalid weight " << weight << " of link " << a << " - " << b);
+    uint32_t ab = FindSlot(a, b);
+    double old = m_weights[ab];
+    if (weight == old)
+    {
+        return;
+    }
+    m_weights[ab] = weight;
+    m_weights[FindSlot(b, a)] = weight;
+    for (Tree& tree : m_trees)
+    {
+        if (weight < old)
+        {
+            Decrease(tree, a, b, weight);
+        }
+        else
+        {
+            Increase(tree, a, b);
+        }
+    }
+}
+
+double
+HapIslShortestPaths::GetLinkWeight(uint32_t a, uint32_t b) const
+{
+    return m_weights[FindSlot(a, b)];
+}
+
+const HapIslShortestPaths::Tree&
+HapIslShortestPaths::GetTree(uint32_t destination) const
+{
+    NS_ABORT_MSG_IF(destination >= GetNNodes() || m_treeOf[destination] == NO_NODE,
+                    "No shortest-path tree towards " << destination);
+    return m_trees[m_treeOf[destination]];
+}
+
+uint32_t
+HapIslShortestPaths::GetNextHop(uint32_t node, uint32_t destination) const
+{
+    return GetTree(destination).nextHop[node];
+}
+
+double
+HapIslShortestPaths::GetDistance(uint32_t node, uint32_t destination) const
+{
+    return GetTree(destination).distance[node];
+}
+
+void
+HapIslShortestPaths::Recompute()
+{
+    for (Tree& tree : m_trees)
+    {
+        Build(tree);
+    }
+}
+
+uint64_t
+HapIslShortestPaths::GetNSettled() const
+{
+    return m_nSettled;
+}
+
+void
+HapIslShortestPaths::Propagate(Tree& tree, std::vector<Entry>& queue)
+{
+    std::greater<Entry> later;
+    std::make_heap(queue.begin(), queue.end(), later);
+    while (!queue.empty())
+    {
+        std::pop_heap(queue.begin(), queue.end(), later);
+        auto [distance, node] = queue.back();
+        queue.pop_back();
+        if (distance > tree.distance[node])
+        {
+            continue; // superseded entry
+        }
+        ++m_nSettled;
+        for (uint32_t slot = m_offsets[node]; slot < m_offsets[node + 1]; ++slot)
+        {
+            uint32_t neighbor = m_neighbors[slot];
+            double candidate = distance + m_weights[slot];
+            if (candidate < tree.distance[neighbor])
+            {
+                tree.distance[neighbor] = candidate;
+                tree.nextHop[neighbor] = node;
+                queue.emplace_back(candidate, neighbor);
+                std::push_heap(queue.begin(), queue.end(), later);
+            }
+        }
+    }
+}
+
+void
+HapIslShortestPaths::Build(Tree& tree)
+{
+    tree.distance.assign(GetNNodes(), INFINITE_DISTANCE);
+    tree.nextHop.assign(GetNNodes(), NO_NODE);
+    tree.distance[tree.destination] = 0;
+    std::vector<Entry> queue{{0, tree.destination}};
+    Propagate(tree, queue);
+}
+
+void
+HapIslShortestPaths::Decrease(Tree& tree, uint32_t a, uint32_t b, double weight)
+{
+    std::vector<Entry> queue;
+    for (auto [from, to] : {std::make_pair(a, b), std::make_pair(b, a)})
+    {
+        double candidate = tree.distance[to] + weight;
+        if (candidate < tree.distance[from])
+        {
+            tree.distance[from] = candidate;
+            tree.nextHop[from] = to;
+            queue.emplace_back(candidate, from);
+        }
+    }
+    Propagate(tree, queue);
+}
+
+void
+HapIslShortestPaths::Increase(Tree& tree, uint32_t a, uint32_t b)
+{
+    // Only the subtree hanging from a tree link is affected
+    uint32_t child;
+    if (tree.nextHop[a] == b)
+    {
+        child = a;
+    }
+    else if (tree.nextHop[b] == a)
+    {
+        child = b;
+    }
+    else
+    {
+        return;
+    }
+
+    m_subtree.clear();
+    m_subtree.push_back(child);
+    m_inSubtree[child] = true;
+    for (std::size_t i = 0; i < m_subtree.size(); ++i)
+    {
+        uint32_t node = m_subtree[i];
+        for (uint32_t slot = m_offsets[node]; slot < m_offsets[node + 1]; ++slot)
+        {
+            uint32_t neighbor = m_neighbors[slot];
+            if (!m_inSubtree[neighbor] && tree.nextHop[neighbor] == node)
+            {
+                m_inSubtree[neighbor] = true;
+                m_subtree.push_back(neighbor);
+            }
+        }
+    }
+    for (uint32_t node : m_subtree)
+    {
+        tree.distance[node] = INFINITE_DISTANCE;
+        tree.nextHop[node] = NO_NODE;
+    }
+
+    // Reattach each cut node through its best neighbour outside the subtree
+    std::vector<Entry> queue;
+    for (uint32_t node : m_subtree)
+    {
+        for (uint32_t slot = m_offsets[node]; slot < m_offsets[node + 1]; ++slot)
+        {
+            uint32_t neighbor = m_neighbors[slot];
+            double candidate = tree.distance[neighbor] + m_weights[slot];
+            if (!m_inSubtree[neighbor] && candidate < tree.distance[node])
+            {
+                tree.distance[node] = candidate;
+                tree.nextHop[node] = neighbor;
+            }
+        }
+        if (tree.distance[node] < INFINITE_DISTANCE)
+        {
+            queue.emplace_back(tree.distance[node], node);
+        }
+    }
+    for (uint32_t node : m_subtree)
+    {
+        m_inSubtree[node] = false;
+    }
+    Propagate(tree, queue);
+}
+
+} // namespace ns3
@@ -0,0 +1,175 @@
+#ifndef SIBGU_HAP_HAP_ISL_SHORTEST_PATHS_H
+#define SIBGU_HAP_HAP_ISL_SHORTEST_PATHS_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Shortest-path trees towards the gateways of an ISL constellation,
+ *        updated incrementally when a link changes.
+ *
+ * The graph is undirected and stored in compressed sparse row form: the
+ * neighbours and weights of node i are the contiguous slots
+ * [offset[i], offset[i + 1]) of two flat arrays. Every link that can exist
+ * during the run (the ISLs, and the feeder links of each gateway to every
+ * orbiter it may see) is declared once in SetTopology(); a link is down while
+ * its weight is infinite.
+ *
+ * One tree is kept per destination added with AddDestination(): the distance
+ * of every node to the destination and its next hop. SetLinkWeight() repairs
+ * the trees in place. A lower weight propagates Dijkstra relaxations from
+ * the endpoints only as far as distances improve; a higher weight on a tree
+ * link invalidates the subtree below it, which is reattached to the rest of
+ * the tree and settled again by Dijkstra. Other changes cost nothing. After
+ * any sequence of updates the distances equal those of Recompute(); among
+ * next hops of equal cost the choice may differ.
+ */
+class HapIslShortestPaths
+{
+  public:
+    /// Marker of a missing next hop.
+    static constexpr uint32_t NO_NODE = 0xFFFFFFFF;
+
+    /**
+     * Undirected link between two nodes.
+     */
+    struct Link
+    {
+        uint32_t a;    //!< first node
+        uint32_t b;    //!< second node
+        double weight; //!< cost, infinite if the link is down
+    };
+
+    HapIslShortestPaths();
+
+    /**
+     * \brief Set the graph and drop the trees.
+     * \param nNodes number of nodes, ids 0 to nNodes - 1
+     * \param links every link that may be used, at most one per node pair
+     */
+    void SetTopology(uint32_t nNodes, const std::vector<Link>& links);
+
+    /**
+     * \return number of nodes
+     */
+    uint32_t GetNNodes() const;
+
+    /**
+     * \brief Keep a shortest-path tree towards a node, e.g. a gateway.
+     * \param destination the node
+     */
+    void AddDestination(uint32_t destination);
+
+    /**
+     * \brief Change the cost of a declared link and repair the trees.
+     * \param a first node
+     * \param b second node
+     * \param weight new cost, infinite to take the link down
+     */
+    void SetLinkWeight(uint32_t a, uint32_t b, double weight);
+
+    /**
+     * \param a first node
+     * \param b second node
+     * \return cost of the link
+     */
+    double GetLinkWeight(uint32_t a, uint32_t b) const;
+
+    /**
+     * \param node source node
+     * \param destination a destination added with AddDestination()
+     * \return neighbour of node on a shortest path, NO_NODE if the destination
+     *         is unreachable or is the node itself
+     */
+    uint32_t GetNextHop(uint32_t node, uint32_t destination) const;
+
+    /**
+     * \param node source node
+     * \param destination a destination added with AddDestination()
+     * \return shortest distance, infinite if unreachable
+     */
+    double GetDistance(uint32_t node, uint32_t destination) const;
+
+    /**
+     * \brief Rebuild every tree from scratch, the reference for the updates.
+     */
+    void Recompute();
+
+    /**
+     * \return number of node distances settled so far, by updates and rebuilds
+     */
+    uint64_t GetNSettled() const;
+
+  private:
+    /// Shortest-path tree towards one destination.
+    struct Tree
+    {
+        uint32_t destination;           //!< root of the tree
+        std::vector<double> distance;   //!< distance to the root, by node
+        std::vector<uint32_t> nextHop;  //!< parent in the tree, by node
+    };
+
+    /// Queue entry as (distance, node).
+    typedef std::pair<double, uint32_t> Entry;
+
+    /**
+     * \param a first node
+     * \param b second node
+     * \return slot of b in the row of a
+     */
+    uint32_t FindSlot(uint32_t a, uint32_t b) const;
+
+    /**
+     * \param destination destination node
+     * \return its tree
+     */
+    const Tree& GetTree(uint32_t destination) const;
+
+    /**
+     * \brief Settle the nodes of the queue and everything they improve.
+     * \param tree the tree
+     * \param queue min-heap of tentative distances
+     */
+    void Propagate(Tree& tree, std::vector<Entry>& queue);
+
+    /**
+     * \brief Full Dijkstra from the root of a tree.
+     * \param tree the tree
+     */
+    void Build(Tree& tree);
+
+    /**
+     * \brief Repair a tree after the weight of a link went down.
+     * \param tree the tree
+     * \param a first node
+     * \param b second node
+     * \param weight new weight
+     */
+    void Decrease(Tree& tree, uint32_t a, uint32_t b, double weight);
+
+    /**
+     * \brief Repair a tree after the weight of a link went up.
+     * \param tree the tree
+     * \param a first node
+     * \param b second node
+     */
+    void Increase(Tree& tree, uint32_t a, uint32_t b);
+
+    std::vector<uint32_t> m_offsets;   //!< row start of each node, then the slot count
+    std::vector<uint32_t> m_neighbors; //!< neighbour of each slot
+    std::vector<double> m_weights;     //!< weight of each slot
+    std::vector<Tree> m_trees;         //!< trees, in AddDestination() order
+    std::vector<uint32_t> m_treeOf;    //!< tree index by destination node, NO_NODE if none
+    std::vector<uint32_t> m_subtree;   //!< scratch: nodes cut off by an increase
+    std::vector<bool> m_inSubtree;     //!< scratch: membership of m_subtree
+    uint64_t m_nSettled;               //!< settled distance counter
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_ISL_SHORTEST_PATHS_H
@@ -0,0 +1,169 @@
+#include "hap-kd-tree.h"
+
+#include "hap-geometry.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+HapKdTree::HapKdTree()
+{
+}
+
+void
+HapKdTree::Build(const std::vector<Vector>& points)
+{
+    m_points = points;
+    m_order.resize(points.size());
+    for (uint32_t i = 0; i < m_order.size(); ++i)
+    {
+        m_order[i] = i;
+    }
+    BuildRange(0, m_order.size(), 0);
+}
+
+uint32_t
+HapKdTree::GetN() const
+{
+    return m_points.size();
+}
+
+void
+HapKdTree::BuildRange(uint32_t begin, uint32_t end, uint32_t depth)
+{
+    if (end - begin <= 1)
+    {
+        return;
+    }
+
+    uint32_t axis = depth % 3;
+    uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(m_order.begin() + begin,
+                     m_order.begin() + mid,
+                     m_order.begin() + end,
+                     [this, axis](uint32_t a, uint32_t b) {
+                         return Coordinate(m_points[a], axis) < Coordinate(m_points[b], axis);
+                     });
+
+    BuildRange(begin, mid, depth + 1);
+    BuildRange(mid + 1, end, depth + 1);
+}
+
+void
+HapKdTree::FindKClosest(const Vector& query, uint32_t k, std::vector<uint32_t>& result) const
+{
+    result.clear();
+    k = std::min<uint32_t>(k, m_points.size());
+    if (k == 0)
+    {
+        return;
+    }
+
+    std::vector<Candidate> heap;
+    heap.reserve(k + 1);
+    SearchRange(query, 0, m_order.size(), 0, k, heap);
+
+    std::sort_heap(heap.begin(), heap.end());
+    for (const Candidate& candidate : heap)
+    {
+        result.push_back(candidate.second);
+    }
+}
+
+void
+HapKdTree::SearchRange(const Vector& query,
+                       uint32_t begin,
+                       uint32_t end,
+                       uint32_t depth,
+                       uint32_t k,
+                       std::vector<Candidate>& heap) const
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    uint32_t mid = begin + (end - begin) / 2;
+    uint32_t id = m_order[mid];
+    Candidate candidate(HapDistanceSquared(query, m_points[id]), id);
+
+    if (heap.size() < k)
+    {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end());
+    }
+    else if (candidate < heap.front())
+    {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = candidate;
+        std::push_heap(heap.begin(), heap.end());
+    }
+
+    uint32_t axis = depth % 3;
+    double diff = Coordinate(query, axis) - Coordinate(m_points[id], axis);
+    bool leftFirst = diff < 0;
+
+    if (leftFirst)
+    {
+        SearchRange(query, begin, mid, depth + 1, k, heap);
+    }
+    else
+    {
+        SearchRange(query, mid + 1, end, depth + 1, k, heap);
+    }
+
+    // The far side can only hold a better candidate if the splitting plane is
+    // not farther than the current worst one; equality is kept for the id tie-break.
+    if (heap.size() < k || diff * diff <= heap.front().first)
+    {
+        if (leftFirst)
+        {
+            SearchRange(query, mid + 1, end, depth + 1, k, heap);
+        }
+        else
+        {
+            SearchRange(query, begin, mid, depth + 1, k, heap);
+        }
+    }
+}
+
+std::vector<uint32_t>
+HapKdTree::FindKClosestBruteForce(const std::vector<Vector>& points,
+                                  const Vector& query,
+                                  uint32_t k)
+{
+    std::vector<Candidate> candidates;
+    candidates.reserve(points.size());
+    for (uint32_t id = 0; id < points.size(); ++id)
+    {
+        candidates.emplace_back(HapDistanceSquared(query, points[id]), id);
+    }
+
+    k = std::min<uint32_t>(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end());
+
+    std::vector<uint32_t> result;
+    result.reserve(k);
+    for (uint32_t i = 0; i < k; ++i)
+    {
+        result.push_back(candidates[i].second);
+    }
+    return result;
+}
+
+double
+HapKdTree::Coordinate(const Vector& p, uint32_t axis)
+{
+    switch (axis)
+    {
+    case 0:
+        return p.x;
+    case 1:
+        return p.y;
+    default:
+        return p.z;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,98 @@
+#ifndef SIBGU_HAP_HAP_KD_TREE_H
+#define SIBGU_HAP_HAP_KD_TREE_H
+
+#include "ns3/vector.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Static 3-D k-d tree over ECEF points for exact k-nearest queries.
+ *
+ * The tree is stored as a flat, implicitly balanced array: the median of
+ * every range is its root, so no per-node allocation is needed and a rebuild
+ * costs O(n log n). Results are ordered by (distance, point id), which is
+ * exactly the order a brute-force scan with the same tie-break produces.
+ */
+class HapKdTree
+{
+  public:
+    HapKdTree();
+
+    /**
+     * \brief Build the tree. Point ids are the indices in the given vector.
+     * \param points point positions
+     */
+    void Build(const std::vector<Vector>& points);
+
+    /**
+     * \return number of points in the tree
+     */
+    uint32_t GetN() const;
+
+    /**
+     * \brief Find the k points closest to a query position.
+     * \param query query position
+     * \param k number of neighbours
+     * \param result ids of the closest points, closest first; cleared first
+     */
+    void FindKClosest(const Vector& query, uint32_t k, std::vector<uint32_t>& result) const;
+
+    /**
+     * \brief Reference brute-force search with the same ordering as FindKClosest().
+     * \param points point positions
+     * \param query query position
+     * \param k number of neighbours
+     * \return ids of the closest points, closest first
+     */
+    static std::vector<uint32_t> FindKClosestBruteForce(const std::vector<Vector>& points,
+                                                        const Vector& query,
+                                                        uint32_t k);
+
+  private:
+    /// Candidate as (squared distance, point id), compared lexicographically.
+    typedef std::pair<double, uint32_t> Candidate;
+
+    /**
+     * \brief Arrange m_order[begin, end) as a subtree.
+     * \param begin first index
+     * \param end past-the-end index
+     * \param depth tree depth, selects the split axis
+     */
+    void BuildRange(uint32_t begin, uint32_t end, uint32_t depth);
+
+    /**
+     * \brief Search m_order[begin, end) for neighbours.
+     * \param query query position
+     * \param begin first index
+     * \param end past-the-end index
+     * \param depth tree depth
+     * \param k number of neighbours
+     * \param heap max-heap of the best candidates so far
+     */
+    void SearchRange(const Vector& query,
+                     uint32_t begin,
+                     uint32_t end,
+                     uint32_t depth,
+                     uint32_t k,
+                     std::vector<Candidate>& heap) const;
+
+    /**
+     * \param p point
+     * \param axis 0, 1 or 2
+     * \return coordinate of p along axis
+     */
+    static double Coordinate(const Vector& p, uint32_t axis);
+
+    std::vector<Vector> m_points;  //!< point positions, by id
+    std::vector<uint32_t> m_order; //!< point ids in tree order
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_KD_TREE_H
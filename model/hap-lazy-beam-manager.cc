@@ -0,0 +1,168 @@
+#include "hap-lazy-beam-manager.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapLazyBeamManager");
+
+NS_OBJECT_ENSURE_REGISTERED(HapLazyBeamManager);
+
+TypeId
+HapLazyBeamManager::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapLazyBeamManager")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapLazyBeamManager>()
+            .AddTraceSource("BeamActivated",
+                            "A beam got its first attached node.",
+                            MakeTraceSourceAccessor(&HapLazyBeamManager::m_beamActivated),
+                            "ns3::HapLazyBeamManager::BeamActivatedCallback");
+    return tid;
+}
+
+HapLazyBeamManager::HapLazyBeamManager()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapLazyBeamManager::~HapLazyBeamManager()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapLazyBeamManager::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_installer = MakeNullCallback<void, uint32_t, uint32_t>();
+    m_locator = MakeNullCallback<uint32_t, uint32_t, uint32_t>();
+    m_beams.clear();
+    m_attachments.clear();
+    Object::DoDispose();
+}
+
+void
+HapLazyBeamManager::SetBeamInstaller(Callback<void, uint32_t, uint32_t> installer)
+{
+    NS_LOG_FUNCTION(this);
+    m_installer = installer;
+}
+
+void
+HapLazyBeamManager::SetBeamLocator(Callback<uint32_t, uint32_t, uint32_t> locator)
+{
+    NS_LOG_FUNCTION(this);
+    m_locator = locator;
+}
+
+void
+HapLazyBeamManager::ConnectToScheduler(Ptr<HapHandoverScheduler> scheduler)
+{
+    NS_LOG_FUNCTION(this << scheduler);
+    NS_ABORT_MSG_IF(m_locator.IsNull(), "A beam locator is needed to follow handover triggers");
+    scheduler->TraceConnectWithoutContext(
+        "HandoverTrigger",
+        MakeCallback(&HapLazyBeamManager::HandoverTrigger, this));
+}
+
+void
+HapLazyBeamManager::HandoverTrigger(uint32_t nodeId, const std::vector<uint32_t>& satIds)
+{
+    NS_LOG_FUNCTION(this << nodeId << satIds.size());
+    if (satIds.empty())
+    {
+        Detach(nodeId);
+        return;
+    }
+
+    uint32_t satId = satIds.front();
+    uint32_t beamId = m_locator(nodeId, satId);
+    if (beamId == 0)
+    {
+        NS_LOG_LOGIC("Node " << nodeId << " is outside every beam of orbiter " << satId);
+        Detach(nodeId);
+        return;
+    }
+    Attach(nodeId, satId, beamId);
+}
+
+void
+HapLazyBeamManager::Attach(uint32_t nodeId, uint32_t satId, uint32_t beamId)
+{
+    NS_LOG_FUNCTION(this << nodeId << satId << beamId);
+
+    BeamKey key(satId, beamId);
+    auto current = m_attachments.find(nodeId);
+    if (current != m_attachments.end() && current->second == key)
+    {
+        return;
+    }
+    Detach(nodeId);
+
+    auto beam = m_beams.find(key);
+    if (beam == m_beams.end())
+    {
+        NS_LOG_INFO("Activating beam " << beamId << " of orbiter " << satId << " for node "
+                                       << nodeId);
+        beam = m_beams.emplace(key, BeamState{Simulator::Now(), 0}).first;
+        if (!m_installer.IsNull())
+        {
+            m_installer(satId, beamId);
+        }
+        m_beamActivated(satId, beamId);
+    }
+    ++beam->second.nAttached;
+    m_attachments[nodeId] = key;
+}
+
+void
+HapLazyBeamManager::Detach(uint32_t nodeId)
+{
+    NS_LOG_FUNCTION(this << nodeId);
+
+    auto current = m_attachments.find(nodeId);
+    if (current == m_attachments.end())
+    {
+        return;
+    }
+    --m_beams[current->second].nAttached;
+    m_attachments.erase(current);
+}
+
+bool
+HapLazyBeamManager::IsActive(uint32_t satId, uint32_t beamId) const
+{
+    return m_beams.count(BeamKey(satId, beamId)) != 0;
+}
+
+uint32_t
+HapLazyBeamManager::GetNAttached(uint32_t satId, uint32_t beamId) const
+{
+    auto beam = m_beams.find(BeamKey(satId, beamId));
+    return beam == m_beams.end() ? 0 : beam->second.nAttached;
+}
+
+std::set<uint32_t>
+HapLazyBeamManager::GetActiveBeamIds() const
+{
+    std::set<uint32_t> beamIds;
+    for (const auto& [key, state] : m_beams)
+    {
+        beamIds.insert(key.second);
+    }
+    return beamIds;
+}
+
+uint32_t
+HapLazyBeamManager::GetNActiveBeams() const
+{
+    return m_beams.size();
+}
+
+} // namespace ns3
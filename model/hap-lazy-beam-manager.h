@@ -0,0 +1,155 @@
+#ifndef SIBGU_HAP_HAP_LAZY_BEAM_MANAGER_H
+#define SIBGU_HAP_HAP_LAZY_BEAM_MANAGER_H
+
+#include "hap-handover-scheduler.h"
+
+#include "ns3/callback.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/traced-callback.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Tracks which beams have terminals attached.
+ *
+ * A beam, identified by the orbiter and its beam id, is activated the first
+ * time a UT or HAP attaches to it: the installer callback is invoked once for
+ * that beam, the BeamActivated trace source fires, and the activation time is
+ * recorded. Beams that nobody ever attaches to are never activated.
+ *
+ * Attachments are reported with Attach(), or derived from a
+ * HapHandoverScheduler: on each HandoverTrigger the node is attached to the
+ * beam that the locator callback returns for the closest orbiter. Those are
+ * predictions, not the attachments SNS3 decides.
+ *
+ * Nothing is created on demand with SNS3: it builds the stacks of the whole
+ * beam set in CreateSatScenario() and offers no way to add one to a running
+ * simulation, so the installer is only a hook. The activated beams of a run
+ * are a candidate beam set for SimulationHelper::SetBeamSet() in a later run;
+ * as SNS3 may hand a terminal over to a beam that was not predicted, unite
+ * them with the HapBeamSetHelper result, as sat-handover-hap does.
+ */
+class HapLazyBeamManager : public Object
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapLazyBeamManager();
+    ~HapLazyBeamManager() override;
+
+    /**
+     * TracedCallback signature for beam activation.
+     * \param [in] satId orbiter id
+     * \param [in] beamId beam id
+     */
+    typedef void (*BeamActivatedCallback)(uint32_t satId, uint32_t beamId);
+
+    /**
+     * \param installer called once per beam, on its first attachment, with
+     *        the orbiter id and the beam id
+     */
+    void SetBeamInstaller(Callback<void, uint32_t, uint32_t> installer);
+
+    /**
+     * \param locator returns the beam id serving a node (first argument) under
+     *        an orbiter (second argument), 0 if the node is outside every beam
+     */
+    void SetBeamLocator(Callback<uint32_t, uint32_t, uint32_t> locator);
+
+    /**
+     * \brief Follow the handover triggers of a scheduler.
+     *
+     * Requires a beam locator.
+     *
+     * \param scheduler handover scheduler of the UTs or HAPs
+     */
+    void ConnectToScheduler(Ptr<HapHandoverScheduler> scheduler);
+
+    /**
+     * \brief Attach a node to a beam, activating the beam if needed.
+     *
+     * The node is detached from its previous beam.
+     *
+     * \param nodeId node id
+     * \param satId orbiter id
+     * \param beamId beam id
+     */
+    void Attach(uint32_t nodeId, uint32_t satId, uint32_t beamId);
+
+    /**
+     * \brief Detach a node from its beam. The beam stays active.
+     * \param nodeId node id
+     */
+    void Detach(uint32_t nodeId);
+
+    /**
+     * \param satId orbiter id
+     * \param beamId beam id
+     * \return true if the beam has been activated
+     */
+    bool IsActive(uint32_t satId, uint32_t beamId) const;
+
+    /**
+     * \param satId orbiter id
+     * \param beamId beam id
+     * \return number of nodes currently attached to the beam
+     */
+    uint32_t GetNAttached(uint32_t satId, uint32_t beamId) const;
+
+    /**
+     * \return ids of the activated beams over all orbiters, suitable for
+     *         SimulationHelper::SetBeamSet()
+     */
+    std::set<uint32_t> GetActiveBeamIds() const;
+
+    /**
+     * \return number of activated beams, over all orbiters
+     */
+    uint32_t GetNActiveBeams() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /// Orbiter id and beam id.
+    typedef std::pair<uint32_t, uint32_t> BeamKey;
+
+    /**
+     * State of an activated beam.
+     */
+    struct BeamState
+    {
+        Time activatedAt;   //!< time of the first attachment
+        uint32_t nAttached; //!< nodes currently attached
+    };
+
+    /**
+     * \brief HandoverTrigger sink.
+     * \param nodeId node id
+     * \param satIds closest visible orbiters, closest first
+     */
+    void HandoverTrigger(uint32_t nodeId, const std::vector<uint32_t>& satIds);
+
+    Callback<void, uint32_t, uint32_t> m_installer;   //!< beam stack installer
+    Callback<uint32_t, uint32_t, uint32_t> m_locator; //!< beam of a node under an orbiter
+    std::map<BeamKey, BeamState> m_beams;             //!< activated beams
+    std::map<uint32_t, BeamKey> m_attachments;        //!< current beam of each node
+
+    /// Trace source fired when a beam is activated.
+    TracedCallback<uint32_t, uint32_t> m_beamActivated;
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_LAZY_BEAM_MANAGER_H
@@ -0,0 +1,143 @@
+#include "hap-nearest-orbiter-index.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapNearestOrbiterIndex");
+
+NS_OBJECT_ENSURE_REGISTERED(HapNearestOrbiterIndex);
+
+TypeId
+HapNearestOrbiterIndex::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapNearestOrbiterIndex")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapNearestOrbiterIndex>()
+            .AddAttribute("RebuildPeriod",
+                          "Minimum age of the spatial index before it is rebuilt on a query. "
+                          "Zero rebuilds whenever the simulation time has advanced.",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&HapNearestOrbiterIndex::m_rebuildPeriod),
+                          MakeTimeChecker(Seconds(0)));
+    return tid;
+}
+
+HapNearestOrbiterIndex::HapNearestOrbiterIndex()
+    : m_rebuildPeriod(Seconds(0)),
+      m_builtAt(Seconds(0)),
+      m_built(false),
+      m_nRebuilds(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapNearestOrbiterIndex::~HapNearestOrbiterIndex()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapNearestOrbiterIndex::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_orbiters.clear();
+    Object::DoDispose();
+}
+
+void
+HapNearestOrbiterIndex::SetOrbiters(NodeContainer orbiters)
+{
+    NS_LOG_FUNCTION(this << orbiters.GetN());
+
+    m_orbiters.clear();
+    for (uint32_t satId = 0; satId < orbiters.GetN(); ++satId)
+    {
+        Ptr<MobilityModel> mobility = orbiters.Get(satId)->GetObject<MobilityModel>();
+        NS_ABORT_MSG_UNLESS(mobility, "Orbiter satId=" << satId << " has no mobility model");
+        m_orbiters.push_back(mobility);
+    }
+    m_built = false;
+}
+
+void
+HapNearestOrbiterIndex::Rebuild()
+{
+    NS_LOG_FUNCTION(this);
+
+    m_positions.resize(m_orbiters.size());
+    for (uint32_t satId = 0; satId < m_orbiters.size(); ++satId)
+    {
+        m_positions[satId] = m_orbiters[satId]->GetPosition();
+    }
+    m_tree.Build(m_positions);
+    m_builtAt = Simulator::Now();
+    m_built = true;
+    ++m_nRebuilds;
+}
+
+void
+HapNearestOrbiterIndex::RebuildIfStale()
+{
+    Time age = Simulator::Now() - m_builtAt;
+    if (!m_built || (m_rebuildPeriod.IsZero() ? age.IsStrictlyPositive() : age >= m_rebuildPeriod))
+    {
+        Rebuild();
+    }
+}
+
+std::vector<uint32_t>
+HapNearestOrbiterIndex::FindKClosest(const Vector& position, uint32_t k)
+{
+    RebuildIfStale();
+
+    std::vector<uint32_t> result;
+    m_tree.FindKClosest(position, k, result);
+    return result;
+}
+
+void
+HapNearestOrbiterIndex::FindKClosest(const std::vector<Vector>& positions,
+                                     uint32_t k,
+                                     std::vector<std::vector<uint32_t>>& result)
+{
+    NS_LOG_FUNCTION(this << positions.size() << k);
+
+    RebuildIfStale();
+
+    result.resize(positions.size());
+    for (std::size_t i = 0; i < positions.size(); ++i)
+    {
+        m_tree.FindKClosest(positions[i], k, result[i]);
+    }
+}
+
+void
+HapNearestOrbiterIndex::FindKClosest(NodeContainer nodes,
+                                     uint32_t k,
+                                     std::vector<std::vector<uint32_t>>& result)
+{
+    std::vector<Vector> positions;
+    positions.reserve(nodes.GetN());
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        Ptr<MobilityModel> mobility = nodes.Get(i)->GetObject<MobilityModel>();
+        NS_ABORT_MSG_UNLESS(mobility, "Node " << nodes.Get(i)->GetId() << " has no mobility model");
+        positions.push_back(mobility->GetPosition());
+    }
+    FindKClosest(positions, k, result);
+}
+
+uint64_t
+HapNearestOrbiterIndex::GetNRebuilds() const
+{
+    return m_nRebuilds;
+}
+
+} // namespace ns3
@@ -0,0 +1,107 @@
+#ifndef SIBGU_HAP_HAP_NEAREST_ORBITER_INDEX_H
+#define SIBGU_HAP_HAP_NEAREST_ORBITER_INDEX_H
+
+#include "hap-kd-tree.h"
+
+#include "ns3/mobility-model.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief k-nearest-orbiter service for handover decisions.
+ *
+ * Keeps a HapKdTree over the orbiter positions and answers "which k orbiters
+ * are closest to this node" in O(k log n) instead of the O(n) scan done per
+ * UT by the handover module. The tree is rebuilt lazily, on the first query
+ * after RebuildPeriod has elapsed since the last rebuild.
+ *
+ * With the default RebuildPeriod of zero the tree is rebuilt whenever the
+ * simulation time has advanced, so the candidates are always those of a
+ * brute-force scan. A positive period matching
+ * SatSGP4MobilityModel::UpdatePositionPeriod is equally exact, since the
+ * orbiters do not move in between.
+ */
+class HapNearestOrbiterIndex : public Object
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapNearestOrbiterIndex();
+    ~HapNearestOrbiterIndex() override;
+
+    /**
+     * \brief Set the orbiters, in satId order.
+     * \param orbiters orbiter nodes, as returned by SatTopology::GetOrbiterNodes()
+     */
+    void SetOrbiters(NodeContainer orbiters);
+
+    /**
+     * \brief Find the k orbiters closest to a position.
+     * \param position ECEF position
+     * \param k number of orbiters
+     * \return satIds, closest first
+     */
+    std::vector<uint32_t> FindKClosest(const Vector& position, uint32_t k);
+
+    /**
+     * \brief Batch query for many positions at the current time.
+     * \param positions ECEF positions
+     * \param k number of orbiters
+     * \param result satIds per position, closest first
+     */
+    void FindKClosest(const std::vector<Vector>& positions,
+                      uint32_t k,
+                      std::vector<std::vector<uint32_t>>& result);
+
+    /**
+     * \brief Batch query for all nodes of a container, e.g. all UTs.
+     * \param nodes nodes with a mobility model
+     * \param k number of orbiters
+     * \param result satIds per node, in container order, closest first
+     */
+    void FindKClosest(NodeContainer nodes,
+                      uint32_t k,
+                      std::vector<std::vector<uint32_t>>& result);
+
+    /**
+     * \brief Force a rebuild of the spatial index from the current positions.
+     */
+    void Rebuild();
+
+    /**
+     * \return number of rebuilds done so far
+     */
+    uint64_t GetNRebuilds() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * \brief Rebuild the index if it is older than the rebuild period.
+     */
+    void RebuildIfStale();
+
+    Time m_rebuildPeriod;                       //!< minimum age of the index before a rebuild
+    std::vector<Ptr<MobilityModel>> m_orbiters; //!< orbiter mobility, by satId
+    std::vector<Vector> m_positions;            //!< orbiter positions at the last rebuild
+    HapKdTree m_tree;                           //!< spatial index
+    Time m_builtAt;                             //!< time of the last rebuild
+    bool m_built;                               //!< true once the index has been built
+    uint64_t m_nRebuilds;                       //!< rebuild counter
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_NEAREST_ORBITER_INDEX_H
@@ -0,0 +1,84 @@
+#include "hap-payload-pool.h"
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapPayloadPool");
+
+NS_OBJECT_ENSURE_REGISTERED(HapPayloadPool);
+
+namespace
+{
+
+/// Default pool, see HapPayloadPool::GetDefault().
+Ptr<HapPayloadPool> g_defaultPool;
+
+/// Release the default pool with the simulator.
+void
+ReleaseDefaultPool()
+{
+    if (g_defaultPool)
+    {
+        g_defaultPool->Dispose();
+        g_defaultPool = nullptr;
+    }
+}
+
+} // namespace
+
+TypeId
+HapPayloadPool::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::HapPayloadPool")
+                            .SetParent<Object>()
+                            .SetGroupName("SibguHap")
+                            .AddConstructor<HapPayloadPool>();
+    return tid;
+}
+
+HapPayloadPool::HapPayloadPool()
+    : m_nPackets(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapPayloadPool::~HapPayloadPool()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapPayloadPool::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Object::DoDispose();
+}
+
+Ptr<HapPayloadPool>
+HapPayloadPool::GetDefault()
+{
+    if (!g_defaultPool)
+    {
+        g_defaultPool = CreateObject<HapPayloadPool>();
+        Simulator::ScheduleDestroy(&ReleaseDefaultPool);
+    }
+    return g_defaultPool;
+}
+
+Ptr<Packet>
+HapPayloadPool::Get(uint32_t size)
+{
+    ++m_nPackets;
+    return Create<Packet>(size);
+}
+
+uint64_t
+HapPayloadPool::GetNPackets() const
+{
+    return m_nPackets;
+}
+
+} // namespace ns3
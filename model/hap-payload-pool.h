@@ -0,0 +1,60 @@
+#ifndef SIBGU_HAP_HAP_PAYLOAD_POOL_H
+#define SIBGU_HAP_HAP_PAYLOAD_POOL_H
+
+#include "ns3/object.h"
+#include "ns3/packet.h"
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Shared zero-filled payloads for synthetic traffic.
+ *
+ * Every packet is created anew, so it gets its own UID for the hop
+ * statistics and flow matching keyed by it; Packet::Copy() of a template
+ * would keep the template's UID. The payload lives in the zero area of the
+ * ns-3 buffer, which records only its size: a synthetic packet costs the
+ * Packet object and an empty buffer whatever its size, headers are written
+ * around the payload, and the zero bytes are produced only when a consumer
+ * copies or serializes the packet, e.g. a PCAP writer.
+ */
+class HapPayloadPool : public Object
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapPayloadPool();
+    ~HapPayloadPool() override;
+
+    /**
+     * \return pool shared by all sources that do not set their own, released
+     *         at Simulator::Destroy()
+     */
+    static Ptr<HapPayloadPool> GetDefault();
+
+    /**
+     * \param size payload size in bytes
+     * \return a new packet with a zero-filled payload of the given size
+     */
+    Ptr<Packet> Get(uint32_t size);
+
+    /**
+     * \return number of packets handed out so far
+     */
+    uint64_t GetNPackets() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    uint64_t m_nPackets; //!< packets handed out
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_PAYLOAD_POOL_H
@@ -0,0 +1,170 @@
+#include "hap-range-transmit-filter.h"
+
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/simulator.h"
+#include "ns3/spectrum-phy.h"
+#include "ns3/spectrum-signal-parameters.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapRangeTransmitFilter");
+
+NS_OBJECT_ENSURE_REGISTERED(HapRangeTransmitFilter);
+
+TypeId
+HapRangeTransmitFilter::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapRangeTransmitFilter")
+            .SetParent<SpectrumTransmitFilter>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapRangeTransmitFilter>()
+            .AddAttribute("MaxRange",
+                          "Receivers farther than this from the transmitter are culled, m. "
+                          "Zero disables culling.",
+                          DoubleValue(0),
+                          MakeDoubleAccessor(&HapRangeTransmitFilter::m_maxRange),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("MaxSpeed",
+                          "Largest speed of the nodes on the channel, m/s",
+                          DoubleValue(0),
+                          MakeDoubleAccessor(&HapRangeTransmitFilter::m_maxSpeed),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("UpdateInterval",
+                          "Largest age of a cached position before it is read again",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&HapRangeTransmitFilter::m_updateInterval),
+                          MakeTimeChecker(Seconds(0)));
+    return tid;
+}
+
+HapRangeTransmitFilter::HapRangeTransmitFilter()
+    : m_maxRange(0),
+      m_maxSpeed(0),
+      m_updateInterval(Seconds(1)),
+      m_nCulled(0),
+      m_nPassed(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapRangeTransmitFilter::~HapRangeTransmitFilter()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapRangeTransmitFilter::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_positions.clear();
+    SpectrumTransmitFilter::DoDispose();
+}
+
+const HapRangeTransmitFilter::Position&
+HapRangeTransmitFilter::GetPosition(Ptr<const SpectrumPhy> phy)
+{
+    Position& entry = m_positions[PeekPointer(phy)];
+    Time now = Simulator::Now();
+    if (!entry.valid)
+    {
+        entry.mobility = phy->GetMobility();
+    }
+    if (entry.mobility && (!entry.valid || now - entry.updatedAt >= m_updateInterval))
+    {
+        entry.position = entry.mobility->GetPosition();
+        entry.updatedAt = now;
+    }
+    entry.valid = true;
+    return entry;
+}
+
+bool
+HapRangeTransmitFilter::DoFilter(Ptr<const SpectrumSignalParameters> params,
+                                 Ptr<const SpectrumPhy> receiverPhy)
+{
+    if (m_maxRange <= 0 || !params->txPhy)
+    {
+        return false;
+    }
+
+    const Position& tx = GetPosition(params->txPhy);
+    const Position& rx = GetPosition(receiverPhy);
+    if (!tx.mobility || !rx.mobility)
+    {
+        ++m_nPassed;
+        return false;
+    }
+
+    // Both nodes may have moved towards each other since their positions were read
+    double range = m_maxRange + 2 * m_maxSpeed * m_updateInterval.GetSeconds();
+    double dx = tx.position.x - rx.position.x;
+    double dy = tx.position.y - rx.position.y;
+    double dz = tx.position.z - rx.position.z;
+    if (dx * dx + dy * dy + dz * dz > range * range)
+    {
+        ++m_nCulled;
+        return true;
+    }
+    ++m_nPassed;
+    return false;
+}
+
+int64_t
+HapRangeTransmitFilter::DoAssignStreams(int64_t /* stream */)
+{
+    return 0;
+}
+
+uint64_t
+HapRangeTransmitFilter::GetNCulled() const
+{
+    return m_nCulled;
+}
+
+uint64_t
+HapRangeTransmitFilter::GetNPassed() const
+{
+    return m_nPassed;
+}
+
+double
+HapRangeTransmitFilter::GetRange(Ptr<PropagationLossModel> loss,
+                                 double txPowerDbm,
+                                 double rxSensitivityDbm,
+                                 double maxDistance)
+{
+    Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel>();
+    a->SetPosition(Vector(0, 0, 0));
+
+    b->SetPosition(Vector(maxDistance, 0, 0));
+    if (loss->CalcRxPower(txPowerDbm, a, b) >= rxSensitivityDbm)
+    {
+        return maxDistance;
+    }
+
+    double low = 0;
+    double high = maxDistance;
+    while (high - low > 1e-6 * high)
+    {
+        double middle = (low + high) / 2;
+        b->SetPosition(Vector(middle, 0, 0));
+        if (loss->CalcRxPower(txPowerDbm, a, b) >= rxSensitivityDbm)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    // Round up: culling a receiver at the edge would change the results
+    return high;
+}
+
+} // namespace ns3
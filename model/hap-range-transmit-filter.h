@@ -0,0 +1,112 @@
+#ifndef SIBGU_HAP_HAP_RANGE_TRANSMIT_FILTER_H
+#define SIBGU_HAP_HAP_RANGE_TRANSMIT_FILTER_H
+
+#include "ns3/mobility-model.h"
+#include "ns3/nstime.h"
+#include "ns3/spectrum-transmit-filter.h"
+#include "ns3/vector.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace ns3
+{
+
+class PropagationLossModel;
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Reception culling of a spectrum channel by transmitter-receiver distance.
+ *
+ * A channel delivers every transmission to every PHY attached to it and runs
+ * the whole propagation loss chain for each, so with many HAP groups on one
+ * channel most of the work goes to receivers hundreds of kilometres away
+ * that can never decode the signal. Added to a SpectrumChannel, this filter
+ * drops the receivers farther than MaxRange from the transmitter before the
+ * loss models run and before any reception event is scheduled.
+ *
+ * Positions are cached per PHY and read again from the mobility model once
+ * they are older than UpdateInterval, so a culling decision costs a hash
+ * lookup and a distance. For moving nodes MaxSpeed widens the range by the
+ * distance two nodes can close between two updates, so that no receiver in
+ * range is ever culled. GetRange() derives MaxRange from a link budget.
+ *
+ * YansWifiChannel has no such hook: it schedules a reception for every PHY,
+ * even one whose loss model returns -inf. Wi-Fi devices that need culling
+ * therefore use SpectrumWifiPhy on a spectrum channel with the same loss and
+ * delay models, as hap-sat-hap-simple does with --spectrumGround --culling.
+ */
+class HapRangeTransmitFilter : public SpectrumTransmitFilter
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapRangeTransmitFilter();
+    ~HapRangeTransmitFilter() override;
+
+    /**
+     * \return number of receptions culled
+     */
+    uint64_t GetNCulled() const;
+
+    /**
+     * \return number of receptions passed to the channel
+     */
+    uint64_t GetNPassed() const;
+
+    /**
+     * \brief Largest distance at which a receiver can reach its sensitivity.
+     *
+     * Found by bisection, so the loss model must be deterministic and grow
+     * with the distance (free space, log-distance, Friis, ...).
+     *
+     * \param loss propagation loss chain of the channel
+     * \param txPowerDbm transmit power plus the transmit and receive antenna gains, dBm
+     * \param rxSensitivityDbm receiver sensitivity, dBm
+     * \param maxDistance returned when the receiver is reached even this far, m
+     * \return range in m
+     */
+    static double GetRange(Ptr<PropagationLossModel> loss,
+                           double txPowerDbm,
+                           double rxSensitivityDbm,
+                           double maxDistance);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /// Cached position of one PHY.
+    struct Position
+    {
+        Ptr<MobilityModel> mobility; //!< mobility model of the PHY, null if none
+        Vector position;             //!< position at updatedAt
+        Time updatedAt;              //!< time of the last read
+        bool valid;                  //!< position was read at least once
+    };
+
+    bool DoFilter(Ptr<const SpectrumSignalParameters> params,
+                  Ptr<const SpectrumPhy> receiverPhy) override;
+    int64_t DoAssignStreams(int64_t stream) override;
+
+    /**
+     * \brief Cached position of a PHY, read again if stale.
+     * \param phy the PHY
+     * \return the cache entry
+     */
+    const Position& GetPosition(Ptr<const SpectrumPhy> phy);
+
+    double m_maxRange;     //!< culling distance, m; 0 disables culling
+    double m_maxSpeed;     //!< largest node speed, m/s
+    Time m_updateInterval; //!< largest age of a cached position
+    std::unordered_map<const SpectrumPhy*, Position> m_positions; //!< positions by PHY
+    uint64_t m_nCulled;    //!< receptions culled
+    uint64_t m_nPassed;    //!< receptions passed
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_RANGE_TRANSMIT_FILTER_H
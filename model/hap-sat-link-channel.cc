@@ -0,0 +1,153 @@
+#include "hap-sat-link-channel.h"
+
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapSatLinkChannel");
+
+NS_OBJECT_ENSURE_REGISTERED(HapSatLinkChannel);
+
+namespace
+{
+
+const double SPEED_OF_LIGHT = 299792458.0; //!< m/s
+
+} // namespace
+
+TypeId
+HapSatLinkChannel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapSatLinkChannel")
+            .SetParent<Channel>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapSatLinkChannel>()
+            .AddAttribute("Frequency",
+                          "Carrier frequency, Hz",
+                          DoubleValue(28e9),
+                          MakeDoubleAccessor(&HapSatLinkChannel::m_frequency),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("AdditionalLoss",
+                          "Rain, gas and pointing losses on top of the free-space loss, dB",
+                          DoubleValue(0),
+                          MakeDoubleAccessor(&HapSatLinkChannel::m_additionalLoss),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("Delay",
+                          "Propagation delay when a node has no mobility model",
+                          TimeValue(MilliSeconds(119)),
+                          MakeTimeAccessor(&HapSatLinkChannel::m_delay),
+                          MakeTimeChecker(Seconds(0)));
+    return tid;
+}
+
+HapSatLinkChannel::HapSatLinkChannel()
+    : m_frequency(28e9),
+      m_additionalLoss(0),
+      m_delay(MilliSeconds(119))
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapSatLinkChannel::~HapSatLinkChannel()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapSatLinkChannel::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_devices.clear();
+    Channel::DoDispose();
+}
+
+void
+HapSatLinkChannel::Attach(Ptr<HapSatLinkNetDevice> device)
+{
+    NS_LOG_FUNCTION(this << device);
+    NS_ABORT_MSG_IF(m_devices.size() == 2, "A HAP-satellite link has two ends");
+    m_devices.push_back(device);
+}
+
+Ptr<HapSatLinkNetDevice>
+HapSatLinkChannel::GetPeer(Ptr<const HapSatLinkNetDevice> src) const
+{
+    if (m_devices.size() < 2)
+    {
+        return nullptr;
+    }
+    return m_devices[0] == src ? m_devices[1] : m_devices[0];
+}
+
+double
+HapSatLinkChannel::GetDistance(Ptr<const HapSatLinkNetDevice> src) const
+{
+    Ptr<HapSatLinkNetDevice> dst = GetPeer(src);
+    Ptr<MobilityModel> a = src->GetNode()->GetObject<MobilityModel>();
+    Ptr<MobilityModel> b = dst ? dst->GetNode()->GetObject<MobilityModel>() : nullptr;
+    if (a && b)
+    {
+        return a->GetDistanceFrom(b);
+    }
+    return m_delay.GetSeconds() * SPEED_OF_LIGHT;
+}
+
+double
+HapSatLinkChannel::GetPathLoss(double distance) const
+{
+    double fspl = 20 * std::log10(4 * M_PI * distance * m_frequency / SPEED_OF_LIGHT);
+    return std::max(fspl, 0.0) + m_additionalLoss;
+}
+
+void
+HapSatLinkChannel::Transmit(Ptr<HapSatLinkNetDevice> src,
+                            const std::vector<HapSatLinkNetDevice::Frame>& burst,
+                            Time txTime,
+                            double eirpDbm) const
+{
+    NS_LOG_FUNCTION(this << src << burst.size() << txTime << eirpDbm);
+    Ptr<HapSatLinkNetDevice> dst = GetPeer(src);
+    NS_ABORT_MSG_UNLESS(dst, "Transmission on a link with one end");
+
+    double distance = GetDistance(src);
+    Time delay = Seconds(distance / SPEED_OF_LIGHT);
+    double rxPowerDbm = eirpDbm - GetPathLoss(distance);
+    // The receiver gets its own copies, as on a PointToPointChannel, so that
+    // it never shares a packet with the queues or traces of the sender
+    std::vector<HapSatLinkNetDevice::Frame> received;
+    received.reserve(burst.size());
+    for (const HapSatLinkNetDevice::Frame& frame : burst)
+    {
+        received.push_back({frame.packet->Copy(), frame.protocol});
+    }
+    Simulator::ScheduleWithContext(dst->GetNode()->GetId(),
+                                   txTime + delay,
+                                   &HapSatLinkNetDevice::Receive,
+                                   dst,
+                                   received,
+                                   rxPowerDbm);
+}
+
+std::size_t
+HapSatLinkChannel::GetNDevices() const
+{
+    return m_devices.size();
+}
+
+Ptr<NetDevice>
+HapSatLinkChannel::GetDevice(std::size_t i) const
+{
+    return m_devices.at(i);
+}
+
+} // namespace ns3
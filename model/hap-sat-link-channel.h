@@ -0,0 +1,87 @@
+#ifndef SIBGU_HAP_HAP_SAT_LINK_CHANNEL_H
+#define SIBGU_HAP_HAP_SAT_LINK_CHANNEL_H
+
+#include "hap-sat-link-net-device.h"
+
+#include "ns3/channel.h"
+#include "ns3/nstime.h"
+
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Point-to-point HAP-satellite feeder link between two HapSatLinkNetDevices.
+ *
+ * The distance is taken at the start of every burst from the mobility
+ * models of the two nodes, so the propagation delay and the free-space loss
+ * follow the geometry. Without a mobility model on both nodes the distance
+ * is Delay times the speed of light. AdditionalLoss stands for rain, gas
+ * and pointing losses on top of the free-space loss at Frequency.
+ */
+class HapSatLinkChannel : public Channel
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapSatLinkChannel();
+    ~HapSatLinkChannel() override;
+
+    /**
+     * \brief Attach a device; a channel holds two.
+     * \param device the device
+     */
+    void Attach(Ptr<HapSatLinkNetDevice> device);
+
+    /**
+     * \brief Deliver a copy of a burst to the other end of the link.
+     * \param src transmitting device
+     * \param burst frames of the burst
+     * \param txTime transmission time of the whole burst
+     * \param eirpDbm transmit power plus antenna gain, dBm
+     */
+    void Transmit(Ptr<HapSatLinkNetDevice> src,
+                  const std::vector<HapSatLinkNetDevice::Frame>& burst,
+                  Time txTime,
+                  double eirpDbm) const;
+
+    /**
+     * \param src one end of the link
+     * \return current distance between the two ends, m
+     */
+    double GetDistance(Ptr<const HapSatLinkNetDevice> src) const;
+
+    /**
+     * \param distance link distance, m
+     * \return free-space loss at Frequency plus AdditionalLoss, dB
+     */
+    double GetPathLoss(double distance) const;
+
+    /**
+     * \param src one end of the link
+     * \return device at the other end, null if not attached yet
+     */
+    Ptr<HapSatLinkNetDevice> GetPeer(Ptr<const HapSatLinkNetDevice> src) const;
+
+    std::size_t GetNDevices() const override;
+    Ptr<NetDevice> GetDevice(std::size_t i) const override;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    double m_frequency;      //!< carrier frequency, Hz
+    double m_additionalLoss; //!< losses on top of free space, dB
+    Time m_delay;            //!< delay without mobility models
+    std::vector<Ptr<HapSatLinkNetDevice>> m_devices; //!< the two ends
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_SAT_LINK_CHANNEL_H
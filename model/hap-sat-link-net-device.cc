@@ -0,0 +1,405 @@
+#include "hap-sat-link-net-device.h"
+
+#include "hap-sat-link-channel.h"
+
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapSatLinkNetDevice");
+
+NS_OBJECT_ENSURE_REGISTERED(HapSatLinkNetDevice);
+
+namespace
+{
+
+const double BOLTZMANN_DBW = -228.6; //!< Boltzmann constant, dBW/(K Hz)
+
+} // namespace
+
+TypeId
+HapSatLinkNetDevice::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapSatLinkNetDevice")
+            .SetParent<NetDevice>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapSatLinkNetDevice>()
+            .AddAttribute("Mtu",
+                          "MAC-level maximum transmission unit",
+                          UintegerValue(1500),
+                          MakeUintegerAccessor(&HapSatLinkNetDevice::SetMtu,
+                                               &HapSatLinkNetDevice::GetMtu),
+                          MakeUintegerChecker<uint16_t>())
+            .AddAttribute("Address",
+                          "MAC address of the device",
+                          Mac48AddressValue(Mac48Address("ff:ff:ff:ff:ff:ff")),
+                          MakeMac48AddressAccessor(&HapSatLinkNetDevice::m_address),
+                          MakeMac48AddressChecker())
+            .AddAttribute("DataRate",
+                          "Capacity of the link",
+                          DataRateValue(DataRate("100Mbps")),
+                          MakeDataRateAccessor(&HapSatLinkNetDevice::m_dataRate),
+                          MakeDataRateChecker())
+            .AddAttribute("QueueSize",
+                          "Limit of the transmit queue, in packets or bytes",
+                          QueueSizeValue(QueueSize("100p")),
+                          MakeQueueSizeAccessor(&HapSatLinkNetDevice::m_queueSize),
+                          MakeQueueSizeChecker())
+            .AddAttribute("MaxBatchSize",
+                          "Largest number of frames sent back to back as one burst",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&HapSatLinkNetDevice::m_maxBatchSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("TxPower",
+                          "Transmit power, dBm",
+                          DoubleValue(45),
+                          MakeDoubleAccessor(&HapSatLinkNetDevice::m_txPower),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("AntennaGain",
+                          "Transmit and receive antenna gain, dBi",
+                          DoubleValue(45),
+                          MakeDoubleAccessor(&HapSatLinkNetDevice::m_antennaGain),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("NoiseTemperature",
+                          "System noise temperature of the receiver, K",
+                          DoubleValue(500),
+                          MakeDoubleAccessor(&HapSatLinkNetDevice::m_noiseTemperature),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("CodingGain",
+                          "Eb/N0 gain of the channel coding over uncoded QPSK, dB",
+                          DoubleValue(0),
+                          MakeDoubleAccessor(&HapSatLinkNetDevice::m_codingGain),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("ReceiveErrorModel",
+                          "Receive error model applied on top of the link budget",
+                          PointerValue(),
+                          MakePointerAccessor(&HapSatLinkNetDevice::m_receiveErrorModel),
+                          MakePointerChecker<ErrorModel>())
+            .AddTraceSource("MacTx",
+                            "A frame was accepted for transmission",
+                            MakeTraceSourceAccessor(&HapSatLinkNetDevice::m_macTxTrace),
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("MacTxDrop",
+                            "A frame was dropped because the queue was full",
+                            MakeTraceSourceAccessor(&HapSatLinkNetDevice::m_macTxDropTrace),
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("MacRx",
+                            "A frame was received and passed up",
+                            MakeTraceSourceAccessor(&HapSatLinkNetDevice::m_macRxTrace),
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("PhyRxDrop",
+                            "A frame was lost on the link",
+                            MakeTraceSourceAccessor(&HapSatLinkNetDevice::m_phyRxDropTrace),
+                            "ns3::Packet::TracedCallback");
+    return tid;
+}
+
+HapSatLinkNetDevice::HapSatLinkNetDevice()
+    : m_ifIndex(0),
+      m_mtu(1500),
+      m_maxBatchSize(1),
+      m_txPower(45),
+      m_antennaGain(45),
+      m_noiseTemperature(500),
+      m_codingGain(0),
+      m_queueBytes(0),
+      m_busy(false),
+      m_nBursts(0)
+{
+    NS_LOG_FUNCTION(this);
+    m_random = CreateObject<UniformRandomVariable>();
+}
+
+HapSatLinkNetDevice::~HapSatLinkNetDevice()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapSatLinkNetDevice::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_node = nullptr;
+    m_channel = nullptr;
+    m_receiveErrorModel = nullptr;
+    m_random = nullptr;
+    m_queue.clear();
+    NetDevice::DoDispose();
+}
+
+void
+HapSatLinkNetDevice::Attach(Ptr<HapSatLinkChannel> channel)
+{
+    NS_LOG_FUNCTION(this << channel);
+    m_channel = channel;
+    m_channel->Attach(this);
+    if (m_channel->GetNDevices() == 2)
+    {
+        m_linkChangeCallbacks();
+        m_channel->GetPeer(this)->m_linkChangeCallbacks();
+    }
+}
+
+int64_t
+HapSatLinkNetDevice::AssignStreams(int64_t stream)
+{
+    m_random->SetStream(stream);
+    return 1;
+}
+
+uint64_t
+HapSatLinkNetDevice::GetNBursts() const
+{
+    return m_nBursts;
+}
+
+double
+HapSatLinkNetDevice::GetFrameErrorRate(double rxPowerDbm, uint32_t bytes) const
+{
+    double noiseDensity = BOLTZMANN_DBW + 10 * std::log10(m_noiseTemperature) + 30; // dBm/Hz
+    double ebNo = rxPowerDbm + m_antennaGain - noiseDensity -
+                  10 * std::log10(m_dataRate.GetBitRate()) + m_codingGain;
+    double ber = 0.5 * std::erfc(std::sqrt(std::pow(10, ebNo / 10)));
+    if (ber <= 0)
+    {
+        return 0;
+    }
+    // 1 - (1 - ber)^bits without losing the small values
+    return -std::expm1(8.0 * bytes * std::log1p(-std::min(ber, 0.5)));
+}
+
+bool
+HapSatLinkNetDevice::HasRoom(uint32_t bytes) const
+{
+    if (m_queueSize.GetUnit() == QueueSizeUnit::PACKETS)
+    {
+        return m_queue.size() < m_queueSize.GetValue();
+    }
+    return m_queueBytes + bytes <= m_queueSize.GetValue();
+}
+
+bool
+HapSatLinkNetDevice::Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber)
+{
+    NS_LOG_FUNCTION(this << packet << dest << protocolNumber);
+    if (!IsLinkUp() || !HasRoom(packet->GetSize()))
+    {
+        m_macTxDropTrace(packet);
+        return false;
+    }
+    m_macTxTrace(packet);
+    m_queue.push_back({packet, protocolNumber});
+    m_queueBytes += packet->GetSize();
+    if (!m_busy)
+    {
+        StartTransmission();
+    }
+    return true;
+}
+
+bool
+HapSatLinkNetDevice::SendFrom(Ptr<Packet> packet,
+                              const Address& /* source */,
+                              const Address& dest,
+                              uint16_t protocolNumber)
+{
+    return Send(packet, dest, protocolNumber);
+}
+
+void
+HapSatLinkNetDevice::StartTransmission()
+{
+    NS_LOG_FUNCTION(this);
+    std::vector<Frame> burst;
+    uint64_t bytes = 0;
+    while (!m_queue.empty() && burst.size() < m_maxBatchSize)
+    {
+        bytes += m_queue.front().packet->GetSize();
+        burst.push_back(std::move(m_queue.front()));
+        m_queue.pop_front();
+    }
+    m_queueBytes -= bytes;
+
+    Time txTime = m_dataRate.CalculateBytesTxTime(bytes);
+    m_busy = true;
+    ++m_nBursts;
+    m_channel->Transmit(this, burst, txTime, m_txPower + m_antennaGain);
+    Simulator::Schedule(txTime, &HapSatLinkNetDevice::TransmitComplete, this);
+}
+
+void
+HapSatLinkNetDevice::TransmitComplete()
+{
+    m_busy = false;
+    if (!m_queue.empty())
+    {
+        StartTransmission();
+    }
+}
+
+void
+HapSatLinkNetDevice::Receive(const std::vector<Frame>& burst, double rxPowerDbm)
+{
+    NS_LOG_FUNCTION(this << burst.size() << rxPowerDbm);
+    Address from = m_channel->GetPeer(this)->GetAddress();
+    for (const Frame& frame : burst)
+    {
+        if (m_random->GetValue() < GetFrameErrorRate(rxPowerDbm, frame.packet->GetSize()) ||
+            (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt(frame.packet)))
+        {
+            m_phyRxDropTrace(frame.packet);
+            continue;
+        }
+        m_macRxTrace(frame.packet);
+        if (!m_promiscCallback.IsNull())
+        {
+            m_promiscCallback(this, frame.packet, frame.protocol, from, m_address, PACKET_HOST);
+        }
+        m_rxCallback(this, frame.packet, frame.protocol, from);
+    }
+}
+
+void
+HapSatLinkNetDevice::SetIfIndex(const uint32_t index)
+{
+    m_ifIndex = index;
+}
+
+uint32_t
+HapSatLinkNetDevice::GetIfIndex() const
+{
+    return m_ifIndex;
+}
+
+Ptr<Channel>
+HapSatLinkNetDevice::GetChannel() const
+{
+    return m_channel;
+}
+
+void
+HapSatLinkNetDevice::SetAddress(Address address)
+{
+    m_address = Mac48Address::ConvertFrom(address);
+}
+
+Address
+HapSatLinkNetDevice::GetAddress() const
+{
+    return m_address;
+}
+
+bool
+HapSatLinkNetDevice::SetMtu(const uint16_t mtu)
+{
+    m_mtu = mtu;
+    return true;
+}
+
+uint16_t
+HapSatLinkNetDevice::GetMtu() const
+{
+    return m_mtu;
+}
+
+bool
+HapSatLinkNetDevice::IsLinkUp() const
+{
+    return m_channel && m_channel->GetNDevices() == 2;
+}
+
+void
+HapSatLinkNetDevice::AddLinkChangeCallback(Callback<void> callback)
+{
+    m_linkChangeCallbacks.ConnectWithoutContext(callback);
+}
+
+bool
+HapSatLinkNetDevice::IsBroadcast() const
+{
+    return true;
+}
+
+Address
+HapSatLinkNetDevice::GetBroadcast() const
+{
+    return Mac48Address("ff:ff:ff:ff:ff:ff");
+}
+
+bool
+HapSatLinkNetDevice::IsMulticast() const
+{
+    return true;
+}
+
+Address
+HapSatLinkNetDevice::GetMulticast(Ipv4Address /* multicastGroup */) const
+{
+    return Mac48Address("01:00:5e:00:00:00");
+}
+
+Address
+HapSatLinkNetDevice::GetMulticast(Ipv6Address /* addr */) const
+{
+    return Mac48Address("33:33:00:00:00:00");
+}
+
+bool
+HapSatLinkNetDevice::IsPointToPoint() const
+{
+    return true;
+}
+
+bool
+HapSatLinkNetDevice::IsBridge() const
+{
+    return false;
+}
+
+Ptr<Node>
+HapSatLinkNetDevice::GetNode() const
+{
+    return m_node;
+}
+
+void
+HapSatLinkNetDevice::SetNode(Ptr<Node> node)
+{
+    m_node = node;
+}
+
+bool
+HapSatLinkNetDevice::NeedsArp() const
+{
+    return false;
+}
+
+void
+HapSatLinkNetDevice::SetReceiveCallback(NetDevice::ReceiveCallback cb)
+{
+    m_rxCallback = cb;
+}
+
+void
+HapSatLinkNetDevice::SetPromiscReceiveCallback(NetDevice::PromiscReceiveCallback cb)
+{
+    m_promiscCallback = cb;
+}
+
+bool
+HapSatLinkNetDevice::SupportsSendFrom() const
+{
+    return false;
+}
+
+} // namespace ns3
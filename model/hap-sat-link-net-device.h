@@ -0,0 +1,173 @@
+#ifndef SIBGU_HAP_HAP_SAT_LINK_NET_DEVICE_H
+#define SIBGU_HAP_HAP_SAT_LINK_NET_DEVICE_H
+
+#include "ns3/data-rate.h"
+#include "ns3/error-model.h"
+#include "ns3/mac48-address.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/queue-size.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/traced-callback.h"
+
+#include <deque>
+#include <vector>
+
+namespace ns3
+{
+
+class HapSatLinkChannel;
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Abstract Ka-band HAP-satellite feeder link terminal.
+ *
+ * Stands in for a full PHY/MAC on the HAP-GEO links: a frame costs its
+ * size at DataRate on the transmitter and the propagation delay of the
+ * HapSatLinkChannel, and is lost with the frame error rate of the link
+ * budget. There is no contention, acknowledgement or OFDM error model.
+ *
+ * Frames wait in a finite drop-tail queue of QueueSize. The transmitter
+ * takes up to MaxBatchSize frames from the queue at a time and sends them
+ * back to back as one burst, which costs one transmit-complete and one
+ * receive event instead of two per frame. All frames of a burst are
+ * delivered when its last bit arrives; with MaxBatchSize 1 every frame is
+ * delivered at its own time.
+ *
+ * The frame error rate follows from the Eb/N0 at the receiver:
+ * received power (EIRP of the sender, path loss of the channel, AntennaGain
+ * of the receiver) over the noise density at NoiseTemperature and DataRate,
+ * improved by CodingGain, with the QPSK bit error rate
+ * 0.5 erfc(sqrt(Eb/N0)) applied to every bit of the frame.
+ */
+class HapSatLinkNetDevice : public NetDevice
+{
+  public:
+    /// Frame on the link: a packet and its protocol number.
+    struct Frame
+    {
+        Ptr<Packet> packet; //!< the packet
+        uint16_t protocol;  //!< protocol number, as given to Send()
+    };
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapSatLinkNetDevice();
+    ~HapSatLinkNetDevice() override;
+
+    /**
+     * \brief Attach the device to a link.
+     * \param channel the link
+     */
+    void Attach(Ptr<HapSatLinkChannel> channel);
+
+    /**
+     * \brief Receive a burst; called by the channel at the end of the burst.
+     * \param burst frames of the burst
+     * \param rxPowerDbm received power before the receive antenna gain, dBm
+     */
+    void Receive(const std::vector<Frame>& burst, double rxPowerDbm);
+
+    /**
+     * \param rxPowerDbm received power before the receive antenna gain, dBm
+     * \param bytes frame size
+     * \return probability that the frame is lost
+     */
+    double GetFrameErrorRate(double rxPowerDbm, uint32_t bytes) const;
+
+    /**
+     * \return number of bursts transmitted
+     */
+    uint64_t GetNBursts() const;
+
+    /**
+     * \brief Assign a fixed random variable stream number.
+     * \param stream first stream index to use
+     * \return number of stream indices assigned
+     */
+    int64_t AssignStreams(int64_t stream);
+
+    // NetDevice
+    void SetIfIndex(const uint32_t index) override;
+    uint32_t GetIfIndex() const override;
+    Ptr<Channel> GetChannel() const override;
+    void SetAddress(Address address) override;
+    Address GetAddress() const override;
+    bool SetMtu(const uint16_t mtu) override;
+    uint16_t GetMtu() const override;
+    bool IsLinkUp() const override;
+    void AddLinkChangeCallback(Callback<void> callback) override;
+    bool IsBroadcast() const override;
+    Address GetBroadcast() const override;
+    bool IsMulticast() const override;
+    Address GetMulticast(Ipv4Address multicastGroup) const override;
+    Address GetMulticast(Ipv6Address addr) const override;
+    bool IsPointToPoint() const override;
+    bool IsBridge() const override;
+    bool Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber) override;
+    bool SendFrom(Ptr<Packet> packet,
+                  const Address& source,
+                  const Address& dest,
+                  uint16_t protocolNumber) override;
+    Ptr<Node> GetNode() const override;
+    void SetNode(Ptr<Node> node) override;
+    bool NeedsArp() const override;
+    void SetReceiveCallback(NetDevice::ReceiveCallback cb) override;
+    void SetPromiscReceiveCallback(NetDevice::PromiscReceiveCallback cb) override;
+    bool SupportsSendFrom() const override;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * \brief Send the next burst from the queue.
+     */
+    void StartTransmission();
+
+    /**
+     * \brief The burst left the transmitter.
+     */
+    void TransmitComplete();
+
+    /**
+     * \param bytes frame size
+     * \return whether one more frame of this size fits in the queue
+     */
+    bool HasRoom(uint32_t bytes) const;
+
+    Ptr<Node> m_node;                 //!< owner node
+    Ptr<HapSatLinkChannel> m_channel; //!< the link
+    Mac48Address m_address;           //!< MAC address
+    uint32_t m_ifIndex;               //!< interface index
+    uint16_t m_mtu;                   //!< MTU
+    DataRate m_dataRate;              //!< link capacity
+    QueueSize m_queueSize;            //!< queue limit, packets or bytes
+    uint32_t m_maxBatchSize;          //!< frames per burst
+    double m_txPower;                 //!< transmit power, dBm
+    double m_antennaGain;             //!< antenna gain, dBi
+    double m_noiseTemperature;        //!< system noise temperature, K
+    double m_codingGain;              //!< coding gain, dB
+    Ptr<ErrorModel> m_receiveErrorModel; //!< extra receive errors
+    Ptr<UniformRandomVariable> m_random; //!< frame error draws
+    std::deque<Frame> m_queue;        //!< frames waiting
+    uint64_t m_queueBytes;            //!< bytes waiting
+    bool m_busy;                      //!< a burst is being transmitted
+    uint64_t m_nBursts;               //!< bursts transmitted
+    NetDevice::ReceiveCallback m_rxCallback;              //!< upper layer
+    NetDevice::PromiscReceiveCallback m_promiscCallback;  //!< promiscuous upper layer
+    TracedCallback<> m_linkChangeCallbacks;               //!< link up callbacks
+    TracedCallback<Ptr<const Packet>> m_macTxTrace;       //!< frame accepted for transmission
+    TracedCallback<Ptr<const Packet>> m_macTxDropTrace;   //!< frame dropped, queue full
+    TracedCallback<Ptr<const Packet>> m_macRxTrace;       //!< frame received
+    TracedCallback<Ptr<const Packet>> m_phyRxDropTrace;   //!< frame lost on the link
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_SAT_LINK_NET_DEVICE_H
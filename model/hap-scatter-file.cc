@@ -0,0 +1,344 @@
+#include "hap-scatter-file.h"
+
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapScatterFile");
+
+NS_OBJECT_ENSURE_REGISTERED(HapScatterFileWriter);
+
+namespace
+{
+
+/// File signature of a binary scatter file.
+const char SCATTER_MAGIC[4] = {'H', 'S', 'C', 'T'};
+/// Signature closing the trailer.
+const char SCATTER_INDEX_MAGIC[4] = {'H', 'S', 'C', 'I'};
+/// Current binary format version.
+const uint32_t SCATTER_VERSION = 1;
+/// Trailer size: index offset and signature.
+const uint32_t SCATTER_TRAILER_SIZE = sizeof(uint64_t) + sizeof(SCATTER_INDEX_MAGIC);
+
+template <typename T>
+void
+WriteRaw(std::ofstream& out, T value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void
+WriteString(std::ofstream& out, const std::string& value)
+{
+    WriteRaw<uint32_t>(out, value.size());
+    out.write(value.data(), value.size());
+}
+
+template <typename T>
+T
+ReadRaw(std::ifstream& in, const std::string& fileName)
+{
+    T value{};
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    NS_ABORT_MSG_UNLESS(in.good(), "Truncated scatter file: " << fileName);
+    return value;
+}
+
+std::string
+ReadString(std::ifstream& in, const std::string& fileName)
+{
+    std::string value(ReadRaw<uint32_t>(in, fileName), '\0');
+    in.read(&value[0], value.size());
+    NS_ABORT_MSG_UNLESS(in.good(), "Truncated scatter file: " << fileName);
+    return value;
+}
+
+} // namespace
+
+TypeId
+HapScatterFileWriter::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapScatterFileWriter")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapScatterFileWriter>()
+            .AddAttribute("ChunkSize",
+                          "Number of points buffered per series before they are written",
+                          UintegerValue(512),
+                          MakeUintegerAccessor(&HapScatterFileWriter::m_chunkSize),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+HapScatterFileWriter::HapScatterFileWriter()
+    : m_chunkSize(512),
+      m_nPoints(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapScatterFileWriter::~HapScatterFileWriter()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapScatterFileWriter::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_out.is_open())
+    {
+        Close();
+    }
+    m_series.clear();
+    m_byName.clear();
+    Object::DoDispose();
+}
+
+void
+HapScatterFileWriter::Open(std::string fileName)
+{
+    NS_LOG_FUNCTION(this << fileName);
+    NS_ABORT_MSG_IF(m_out.is_open(), "Scatter file already open: " << m_fileName);
+
+    m_fileName = fileName;
+    m_out.open(fileName, std::ios::binary | std::ios::trunc);
+    NS_ABORT_MSG_UNLESS(m_out.is_open(), "Cannot create scatter file: " << fileName);
+    m_out.write(SCATTER_MAGIC, sizeof(SCATTER_MAGIC));
+    WriteRaw<uint32_t>(m_out, SCATTER_VERSION);
+}
+
+void
+HapScatterFileWriter::Close()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_UNLESS(m_out.is_open(), "Scatter file not open");
+
+    for (uint32_t index = 0; index < m_series.size(); ++index)
+    {
+        Flush(index);
+    }
+
+    uint64_t indexOffset = m_out.tellp();
+    WriteRaw<uint32_t>(m_out, m_series.size());
+    for (const Series& series : m_series)
+    {
+        WriteString(m_out, series.name);
+        WriteRaw<uint32_t>(m_out, series.metadata.size());
+        for (const auto& [key, value] : series.metadata)
+        {
+            WriteString(m_out, key);
+            WriteString(m_out, value);
+        }
+        WriteRaw<uint32_t>(m_out, series.chunks.size());
+        for (const Chunk& chunk : series.chunks)
+        {
+            WriteRaw<uint64_t>(m_out, chunk.offset);
+            WriteRaw<uint32_t>(m_out, chunk.count);
+        }
+    }
+    WriteRaw<uint64_t>(m_out, indexOffset);
+    m_out.write(SCATTER_INDEX_MAGIC, sizeof(SCATTER_INDEX_MAGIC));
+
+    NS_ABORT_MSG_UNLESS(m_out.good(), "Failed to write scatter file: " << m_fileName);
+    m_out.close();
+    NS_LOG_INFO("Wrote scatter file " << m_fileName << ": " << m_series.size() << " series, "
+                                      << m_nPoints << " points");
+}
+
+uint32_t
+HapScatterFileWriter::AddSeries(std::string name, const Metadata& metadata)
+{
+    NS_LOG_FUNCTION(this << name);
+    NS_ABORT_MSG_IF(m_byName.count(name), "Duplicate scatter series: " << name);
+
+    uint32_t index = m_series.size();
+    m_series.push_back({name, metadata, {}, {}});
+    m_series.back().points.reserve(2 * m_chunkSize);
+    m_byName.emplace(name, index);
+    return index;
+}
+
+void
+HapScatterFileWriter::Write(uint32_t series, double time, double value)
+{
+    NS_ASSERT_MSG(series < m_series.size(), "Unknown scatter series " << series);
+    std::vector<double>& points = m_series[series].points;
+    points.push_back(time);
+    points.push_back(value);
+    ++m_nPoints;
+    if (points.size() >= 2 * m_chunkSize)
+    {
+        Flush(series);
+    }
+}
+
+void
+HapScatterFileWriter::Write2d(std::string context, double time, double value)
+{
+    auto it = m_byName.find(context);
+    uint32_t series = it != m_byName.end() ? it->second : AddSeries(context);
+    Write(series, time, value);
+}
+
+uint32_t
+HapScatterFileWriter::GetNSeries() const
+{
+    return m_series.size();
+}
+
+uint64_t
+HapScatterFileWriter::GetNPoints() const
+{
+    return m_nPoints;
+}
+
+void
+HapScatterFileWriter::Flush(uint32_t index)
+{
+    Series& series = m_series[index];
+    if (series.points.empty())
+    {
+        return;
+    }
+    NS_ABORT_MSG_UNLESS(m_out.is_open(), "Scatter file not open");
+
+    uint32_t count = series.points.size() / 2;
+    WriteRaw<uint32_t>(m_out, index);
+    WriteRaw<uint32_t>(m_out, count);
+    series.chunks.push_back({static_cast<uint64_t>(m_out.tellp()), count});
+    m_out.write(reinterpret_cast<const char*>(series.points.data()),
+                series.points.size() * sizeof(double));
+    series.points.clear();
+}
+
+HapScatterFileReader::HapScatterFileReader()
+{
+}
+
+void
+HapScatterFileReader::Open(std::string fileName)
+{
+    NS_LOG_FUNCTION(this << fileName);
+
+    m_fileName = fileName;
+    m_series.clear();
+    m_byName.clear();
+    if (m_in.is_open())
+    {
+        m_in.close();
+    }
+    m_in.open(fileName, std::ios::binary);
+    NS_ABORT_MSG_UNLESS(m_in.is_open(), "Cannot open scatter file: " << fileName);
+
+    char magic[sizeof(SCATTER_MAGIC)];
+    m_in.read(magic, sizeof(magic));
+    NS_ABORT_MSG_UNLESS(m_in.good() && std::equal(magic, magic + sizeof(magic), SCATTER_MAGIC),
+                        "Not a scatter file: " << fileName);
+    uint32_t version = ReadRaw<uint32_t>(m_in, fileName);
+    NS_ABORT_MSG_UNLESS(version == SCATTER_VERSION,
+                        "Unsupported scatter file version " << version << ": " << fileName);
+
+    m_in.seekg(-static_cast<std::streamoff>(SCATTER_TRAILER_SIZE), std::ios::end);
+    uint64_t indexOffset = ReadRaw<uint64_t>(m_in, fileName);
+    m_in.read(magic, sizeof(magic));
+    NS_ABORT_MSG_UNLESS(m_in.good() &&
+                            std::equal(magic, magic + sizeof(magic), SCATTER_INDEX_MAGIC),
+                        "Scatter file without index (not closed?): " << fileName);
+
+    m_in.seekg(indexOffset);
+    uint32_t nSeries = ReadRaw<uint32_t>(m_in, fileName);
+    m_series.resize(nSeries);
+    for (uint32_t index = 0; index < nSeries; ++index)
+    {
+        Series& series = m_series[index];
+        series.name = ReadString(m_in, fileName);
+        uint32_t nMetadata = ReadRaw<uint32_t>(m_in, fileName);
+        for (uint32_t i = 0; i < nMetadata; ++i)
+        {
+            std::string key = ReadString(m_in, fileName);
+            series.metadata[key] = ReadString(m_in, fileName);
+        }
+        uint32_t nChunks = ReadRaw<uint32_t>(m_in, fileName);
+        series.nPoints = 0;
+        for (uint32_t i = 0; i < nChunks; ++i)
+        {
+            uint64_t offset = ReadRaw<uint64_t>(m_in, fileName);
+            uint32_t count = ReadRaw<uint32_t>(m_in, fileName);
+            series.chunks.emplace_back(offset, count);
+            series.nPoints += count;
+        }
+        m_byName.emplace(series.name, index);
+    }
+    NS_LOG_INFO("Opened scatter file " << fileName << ": " << nSeries << " series");
+}
+
+std::vector<std::string>
+HapScatterFileReader::GetSeriesNames() const
+{
+    std::vector<std::string> names;
+    names.reserve(m_series.size());
+    for (const Series& series : m_series)
+    {
+        names.push_back(series.name);
+    }
+    return names;
+}
+
+bool
+HapScatterFileReader::HasSeries(std::string name) const
+{
+    return m_byName.count(name) > 0;
+}
+
+HapScatterFileWriter::Metadata
+HapScatterFileReader::GetMetadata(std::string name) const
+{
+    return Find(name).metadata;
+}
+
+uint64_t
+HapScatterFileReader::GetNPoints(std::string name) const
+{
+    return Find(name).nPoints;
+}
+
+std::vector<HapScatterFileReader::Point>
+HapScatterFileReader::ReadSeries(std::string name)
+{
+    NS_LOG_FUNCTION(this << name);
+    const Series& series = Find(name);
+
+    std::vector<Point> points;
+    points.reserve(series.nPoints);
+    std::vector<double> chunk;
+    for (const auto& [offset, count] : series.chunks)
+    {
+        chunk.resize(2 * count);
+        m_in.seekg(offset);
+        m_in.read(reinterpret_cast<char*>(chunk.data()), chunk.size() * sizeof(double));
+        NS_ABORT_MSG_UNLESS(m_in.good(), "Truncated scatter file: " << m_fileName);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            points.emplace_back(chunk[2 * i], chunk[2 * i + 1]);
+        }
+    }
+    return points;
+}
+
+const HapScatterFileReader::Series&
+HapScatterFileReader::Find(std::string name) const
+{
+    auto it = m_byName.find(name);
+    NS_ABORT_MSG_IF(it == m_byName.end(), "No series " << name << " in " << m_fileName);
+    return m_series[it->second];
+}
+
+} // namespace ns3
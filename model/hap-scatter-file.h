@@ -0,0 +1,213 @@
+#ifndef SIBGU_HAP_HAP_SCATTER_FILE_H
+#define SIBGU_HAP_HAP_SCATTER_FILE_H
+
+#include "ns3/object.h"
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Binary scatter statistics, all series of a run in one file.
+ *
+ * Replaces one text scatter file per series. The file holds:
+ *
+ * - a header: "HSCT" and the format version;
+ * - chunks of one series: series index, number of points, then packed
+ *   (time, value) float64 pairs in host byte order;
+ * - a footer index: for each series its name, metadata and the offset and
+ *   size of each of its chunks;
+ * - a trailer: offset of the index and "HSCI".
+ *
+ * Points are buffered per series and written ChunkSize at a time, so a
+ * series can be read back with a few seeks, see HapScatterFileReader.
+ *
+ * hap-sat-hap writes the per-UT IP throughput in this format, through a
+ * HapWindowAggregator. ext-utils/genreport.py reads every *.hscat file of a
+ * results folder; series named like the SNS3 text statistics files, e.g.
+ * stat-per-ut-fwd-ip-throughput-scatter-1, are reported as those would be.
+ */
+class HapScatterFileWriter : public Object
+{
+  public:
+    /// Series metadata, shown by the report generator like the "% key: value"
+    /// header lines of text scatter files.
+    typedef std::map<std::string, std::string> Metadata;
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapScatterFileWriter();
+    ~HapScatterFileWriter() override;
+
+    /**
+     * \brief Create the output file.
+     * \param fileName output file
+     */
+    void Open(std::string fileName);
+
+    /**
+     * \brief Flush the pending points and write the index.
+     *
+     * Called on dispose if the file is still open.
+     */
+    void Close();
+
+    /**
+     * \brief Declare a series.
+     * \param name series name, unique in the file
+     * \param metadata series metadata
+     * \return series index for Write()
+     */
+    uint32_t AddSeries(std::string name, const Metadata& metadata = Metadata());
+
+    /**
+     * \brief Append a point to a series.
+     * \param series index returned by AddSeries()
+     * \param time abscissa, usually seconds
+     * \param value ordinate
+     */
+    void Write(uint32_t series, double time, double value);
+
+    /**
+     * \brief Append a point to the series named by a trace context.
+     *
+     * Same signature as the Write2d() sinks of the ns-3 file aggregators;
+     * the series is created on first use.
+     *
+     * \param context series name
+     * \param time abscissa, usually seconds
+     * \param value ordinate
+     */
+    void Write2d(std::string context, double time, double value);
+
+    /**
+     * \return number of series
+     */
+    uint32_t GetNSeries() const;
+
+    /**
+     * \return number of points written so far, flushed or not
+     */
+    uint64_t GetNPoints() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /// Chunk location in the file.
+    struct Chunk
+    {
+        uint64_t offset; //!< file offset of the first point
+        uint32_t count;  //!< number of points
+    };
+
+    /// Series being written.
+    struct Series
+    {
+        std::string name;           //!< series name
+        Metadata metadata;          //!< series metadata
+        std::vector<double> points; //!< pending time, value pairs
+        std::vector<Chunk> chunks;  //!< chunks already written
+    };
+
+    /**
+     * \brief Write the pending points of a series as one chunk.
+     * \param index series index
+     */
+    void Flush(uint32_t index);
+
+    std::string m_fileName;                                //!< output file
+    std::ofstream m_out;                                   //!< output stream
+    uint32_t m_chunkSize;                                  //!< points per chunk
+    std::vector<Series> m_series;                          //!< series by index
+    std::unordered_map<std::string, uint32_t> m_byName;    //!< series index by name
+    uint64_t m_nPoints;                                    //!< points written
+};
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Reader of files written by HapScatterFileWriter.
+ *
+ * Open() reads the trailer and the index only; ReadSeries() then reads the
+ * chunks of the requested series and nothing else.
+ */
+class HapScatterFileReader
+{
+  public:
+    /// One (time, value) point.
+    typedef std::pair<double, double> Point;
+
+    HapScatterFileReader();
+
+    /**
+     * \brief Open a file and load its index.
+     * \param fileName scatter file
+     */
+    void Open(std::string fileName);
+
+    /**
+     * \return series names, in the order they were declared
+     */
+    std::vector<std::string> GetSeriesNames() const;
+
+    /**
+     * \param name series name
+     * \return true if the file has the series
+     */
+    bool HasSeries(std::string name) const;
+
+    /**
+     * \param name series name
+     * \return series metadata
+     */
+    HapScatterFileWriter::Metadata GetMetadata(std::string name) const;
+
+    /**
+     * \param name series name
+     * \return number of points of the series
+     */
+    uint64_t GetNPoints(std::string name) const;
+
+    /**
+     * \param name series name
+     * \return points of the series, in write order
+     */
+    std::vector<Point> ReadSeries(std::string name);
+
+  private:
+    /// Indexed series.
+    struct Series
+    {
+        std::string name;                                   //!< series name
+        HapScatterFileWriter::Metadata metadata;            //!< series metadata
+        std::vector<std::pair<uint64_t, uint32_t>> chunks;  //!< chunk offset and point count
+        uint64_t nPoints;                                   //!< total points
+    };
+
+    /**
+     * \param name series name
+     * \return the indexed series, aborts if missing
+     */
+    const Series& Find(std::string name) const;
+
+    std::string m_fileName;                             //!< open file
+    std::ifstream m_in;                                 //!< input stream
+    std::vector<Series> m_series;                       //!< index
+    std::unordered_map<std::string, uint32_t> m_byName; //!< series index by name
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_SCATTER_FILE_H
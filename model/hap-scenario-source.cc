@@ -0,0 +1,573 @@
+#include "hap-scenario-source.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/system-path.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapScenarioSource");
+
+namespace
+{
+
+const uint32_t ZIP_LOCAL_MAGIC = 0x04034b50;   //!< local file header
+const uint32_t ZIP_CENTRAL_MAGIC = 0x02014b50; //!< central directory header
+const uint32_t ZIP_END_MAGIC = 0x06054b50;     //!< end of central directory
+const uint32_t ZIP_LOCAL_SIZE = 30;            //!< local file header, without name
+const uint32_t ZIP_CENTRAL_SIZE = 46;          //!< central directory header, without name
+const uint32_t ZIP_END_SIZE = 22;              //!< end of central directory, without comment
+const uint16_t ZIP_STORED = 0;                 //!< no compression
+const uint16_t ZIP_VERSION = 10;               //!< version needed for stored entries
+const uint8_t EMPTY_FILE[1] = {0};             //!< contents of empty files
+
+/**
+ * \param data bytes
+ * \param size number of bytes
+ * \return CRC-32 of the bytes, as in zip archives
+ */
+uint32_t
+Crc32(const uint8_t* data, uint64_t size)
+{
+    static uint32_t table[256];
+    static bool ready = false;
+    if (!ready)
+    {
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (uint32_t k = 0; k < 8; ++k)
+            {
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        ready = true;
+    }
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint64_t i = 0; i < size; ++i)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+/**
+ * \param name entry name of a container
+ * \return true if the entry stays below the scenario root once extracted
+ */
+bool
+IsSafeName(const std::string& name)
+{
+    if (name.front() == '/')
+    {
+        return false;
+    }
+    std::size_t begin = 0;
+    while (begin <= name.size())
+    {
+        std::size_t end = std::min(name.find('/', begin), name.size());
+        if (name.compare(begin, end - begin, "..") == 0)
+        {
+            return false;
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
+/**
+ * \param path file or folder
+ * \return true if path is a folder
+ */
+bool
+IsDirectory(const std::string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+/**
+ * \param path file
+ * \return true if path is a regular file
+ */
+bool
+IsRegularFile(const std::string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+/**
+ * \param fileName file to map
+ * \return mapped contents
+ */
+HapScenarioSource::File
+MapFile(const std::string& fileName)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    NS_ABORT_MSG_IF(fd < 0, "Cannot open scenario file " << fileName);
+    struct stat info;
+    NS_ABORT_MSG_IF(fstat(fd, &info) != 0, "Cannot stat scenario file " << fileName);
+    HapScenarioSource::File file{EMPTY_FILE, static_cast<uint64_t>(info.st_size)};
+    if (file.size > 0)
+    {
+        void* data = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        NS_ABORT_MSG_IF(data == MAP_FAILED, "Cannot map scenario file " << fileName);
+        file.data = static_cast<const uint8_t*>(data);
+    }
+    close(fd);
+    return file;
+}
+
+/**
+ * \param folder folder
+ * \param prefix name of the folder in the archive, empty for the root
+ * \param names filled with the names of the files below the folder
+ */
+void
+CollectFiles(const std::string& folder, const std::string& prefix, std::vector<std::string>& names)
+{
+    for (const std::string& entry : SystemPath::ReadFiles(folder))
+    {
+        std::string path = SystemPath::Append(folder, entry);
+        std::string name = prefix.empty() ? entry : prefix + "/" + entry;
+        if (IsDirectory(path))
+        {
+            CollectFiles(path, name, names);
+        }
+        else if (IsRegularFile(path))
+        {
+            names.push_back(name);
+        }
+    }
+}
+
+/**
+ * \param path file or folder, removed with its contents
+ */
+void
+RemoveTree(const std::string& path)
+{
+    if (IsDirectory(path))
+    {
+        for (const std::string& entry : SystemPath::ReadFiles(path))
+        {
+            RemoveTree(SystemPath::Append(path, entry));
+        }
+        rmdir(path.c_str());
+    }
+    else
+    {
+        unlink(path.c_str());
+    }
+}
+
+/**
+ * \param out output stream
+ * \param value value written in little-endian order
+ */
+void
+WriteU16(std::ostream& out, uint16_t value)
+{
+    char bytes[2] = {char(value & 0xFF), char(value >> 8)};
+    out.write(bytes, sizeof(bytes));
+}
+
+/**
+ * \param out output stream
+ * \param value value written in little-endian order
+ */
+void
+WriteU32(std::ostream& out, uint32_t value)
+{
+    WriteU16(out, value & 0xFFFF);
+    WriteU16(out, value >> 16);
+}
+
+} // namespace
+
+HapScenarioSource::HapScenarioSource()
+    : m_data(nullptr),
+      m_size(0),
+      m_digest(0)
+{
+}
+
+HapScenarioSource::~HapScenarioSource()
+{
+    Close();
+}
+
+void
+HapScenarioSource::Open(std::string path)
+{
+    NS_LOG_FUNCTION(this << path);
+    Close();
+    m_path = path;
+    if (IsDirectory(path))
+    {
+        return;
+    }
+
+    File archive = MapFile(path);
+    NS_ABORT_MSG_IF(archive.size < ZIP_END_SIZE, "Scenario container " << path << " is too short");
+    m_data = archive.data;
+    m_size = archive.size;
+    IndexArchive();
+    NS_LOG_INFO("Scenario container " << path << ": " << m_files.size() << " files");
+}
+
+void
+HapScenarioSource::Close()
+{
+    if (m_data)
+    {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_data = nullptr;
+    }
+    for (const File& file : m_mappings)
+    {
+        munmap(const_cast<uint8_t*>(file.data), file.size);
+    }
+    m_mappings.clear();
+    m_files.clear();
+    m_size = 0;
+    m_digest = 0;
+}
+
+uint16_t
+HapScenarioSource::ReadU16(uint64_t offset) const
+{
+    NS_ABORT_MSG_IF(offset + 2 > m_size, "Truncated scenario container " << m_path);
+    return uint16_t(m_data[offset]) | (uint16_t(m_data[offset + 1]) << 8);
+}
+
+uint32_t
+HapScenarioSource::ReadU32(uint64_t offset) const
+{
+    return uint32_t(ReadU16(offset)) | (uint32_t(ReadU16(offset + 2)) << 16);
+}
+
+void
+HapScenarioSource::IndexArchive()
+{
+    // The end record is followed only by the archive comment, at most 64 KiB
+    uint64_t end = m_size - ZIP_END_SIZE;
+    uint64_t lowest = m_size > ZIP_END_SIZE + 0xFFFF ? m_size - ZIP_END_SIZE - 0xFFFF : 0;
+    while (ReadU32(end) != ZIP_END_MAGIC)
+    {
+        NS_ABORT_MSG_IF(end == lowest, m_path << " is not a scenario container");
+        --end;
+    }
+    uint32_t nEntries = ReadU16(end + 10);
+    uint32_t directorySize = ReadU32(end + 12);
+    uint64_t offset = ReadU32(end + 16);
+    NS_ABORT_MSG_IF(nEntries == 0xFFFF || offset == 0xFFFFFFFF,
+                    "ZIP64 container " << m_path << " is not supported");
+    NS_ABORT_MSG_IF(offset + directorySize > end, "Corrupted central directory in " << m_path);
+
+    // FNV-1a of the central directory, which holds the CRC of every entry
+    m_digest = 0xcbf29ce484222325;
+    for (uint64_t i = offset; i < offset + directorySize; ++i)
+    {
+        m_digest = (m_digest ^ m_data[i]) * 0x100000001b3;
+    }
+
+    std::map<std::string, File> files;
+    for (uint32_t entry = 0; entry < nEntries; ++entry)
+    {
+        NS_ABORT_MSG_IF(ReadU32(offset) != ZIP_CENTRAL_MAGIC,
+                        "Corrupted central directory in " << m_path);
+        uint16_t method = ReadU16(offset + 10);
+        uint64_t compressedSize = ReadU32(offset + 20);
+        uint64_t size = ReadU32(offset + 24);
+        uint16_t nameLength = ReadU16(offset + 28);
+        uint16_t extraLength = ReadU16(offset + 30);
+        uint16_t commentLength = ReadU16(offset + 32);
+        uint64_t local = ReadU32(offset + 42);
+        NS_ABORT_MSG_IF(offset + ZIP_CENTRAL_SIZE + nameLength > m_size,
+                        "Corrupted central directory in " << m_path);
+        std::string name(reinterpret_cast<const char*>(m_data + offset + ZIP_CENTRAL_SIZE),
+                         nameLength);
+        offset += ZIP_CENTRAL_SIZE + nameLength + extraLength + commentLength;
+        if (name.empty() || name.back() == '/')
+        {
+            continue; // folder entry
+        }
+        NS_ABORT_MSG_UNLESS(IsSafeName(name),
+                            "Entry " << name << " of " << m_path
+                                     << " is outside the scenario root");
+        NS_ABORT_MSG_IF(method != ZIP_STORED || compressedSize != size,
+                        "Entry " << name << " of " << m_path
+                                 << " is compressed, pack the container with zip -0");
+        NS_ABORT_MSG_IF(size == 0xFFFFFFFF || local == 0xFFFFFFFF,
+                        "ZIP64 entry " << name << " of " << m_path << " is not supported");
+        NS_ABORT_MSG_IF(ReadU32(local) != ZIP_LOCAL_MAGIC,
+                        "Corrupted entry " << name << " in " << m_path);
+        uint64_t data = local + ZIP_LOCAL_SIZE + ReadU16(local + 26) + ReadU16(local + 28);
+        NS_ABORT_MSG_IF(data + size > m_size, "Truncated entry " << name << " in " << m_path);
+        files[name] = File{m_data + data, size};
+    }
+
+    // Strip a top-level folder common to every entry
+    std::string root;
+    for (const auto& [name, file] : files)
+    {
+        std::size_t slash = name.find('/');
+        std::string first = slash == std::string::npos ? "" : name.substr(0, slash + 1);
+        if (first.empty() || (!root.empty() && first != root))
+        {
+            root.clear();
+            break;
+        }
+        root = first;
+    }
+    for (const auto& [name, file] : files)
+    {
+        m_files[name.substr(root.size())] = file;
+    }
+}
+
+uint32_t
+HapScenarioSource::GetCrc32(File file)
+{
+    return Crc32(file.data, file.size);
+}
+
+bool
+HapScenarioSource::IsArchive() const
+{
+    return m_data != nullptr;
+}
+
+std::string
+HapScenarioSource::GetPath() const
+{
+    return m_path;
+}
+
+bool
+HapScenarioSource::HasFile(std::string name) const
+{
+    if (IsArchive())
+    {
+        return m_files.count(name) > 0;
+    }
+    return IsRegularFile(SystemPath::Append(m_path, name));
+}
+
+HapScenarioSource::File
+HapScenarioSource::GetFile(std::string name)
+{
+    NS_LOG_FUNCTION(this << name);
+    NS_ABORT_MSG_IF(m_path.empty(), "No scenario open");
+    auto it = m_files.find(name);
+    if (it != m_files.end())
+    {
+        return it->second;
+    }
+    NS_ABORT_MSG_IF(IsArchive(), "No file " << name << " in " << m_path);
+
+    File file = MapFile(SystemPath::Append(m_path, name));
+    if (file.size > 0)
+    {
+        m_mappings.push_back(file);
+    }
+    m_files[name] = file;
+    return file;
+}
+
+std::string
+HapScenarioSource::ReadFile(std::string name)
+{
+    File file = GetFile(name);
+    return std::string(reinterpret_cast<const char*>(file.data), file.size);
+}
+
+std::vector<std::string>
+HapScenarioSource::ListFiles(std::string folder) const
+{
+    std::vector<std::string> names;
+    if (IsArchive())
+    {
+        std::string prefix = folder.empty() ? "" : folder + "/";
+        for (auto it = m_files.lower_bound(prefix);
+             it != m_files.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+             ++it)
+        {
+            std::string name = it->first.substr(prefix.size());
+            if (name.find('/') == std::string::npos)
+            {
+                names.push_back(name);
+            }
+        }
+        return names;
+    }
+
+    std::string path = SystemPath::Append(m_path, folder);
+    if (!IsDirectory(path))
+    {
+        return names;
+    }
+    for (const std::string& name : SystemPath::ReadFiles(path))
+    {
+        if (IsRegularFile(SystemPath::Append(path, name)))
+        {
+            names.push_back(name);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+std::string
+HapScenarioSource::GetDirectory(std::string cacheDir)
+{
+    NS_LOG_FUNCTION(this << cacheDir);
+    NS_ABORT_MSG_IF(m_path.empty(), "No scenario open");
+    if (!IsArchive())
+    {
+        return m_path;
+    }
+
+    std::string stem = m_path.substr(m_path.find_last_of('/') + 1);
+    stem = stem.substr(0, stem.rfind('.'));
+    std::ostringstream digest;
+    digest << std::hex << std::setw(16) << std::setfill('0') << m_digest;
+    std::string folder = SystemPath::Append(cacheDir, stem + "-" + digest.str());
+    if (IsDirectory(folder))
+    {
+        return folder;
+    }
+
+    std::string staging = folder + ".tmp." + std::to_string(getpid());
+    for (const auto& [name, file] : m_files)
+    {
+        std::string path = SystemPath::Append(staging, name);
+        SystemPath::MakeDirectories(path.substr(0, path.find_last_of('/')));
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(file.data), file.size);
+        NS_ABORT_MSG_UNLESS(out, "Cannot write " << path);
+    }
+    SystemPath::MakeDirectories(staging);
+    if (rename(staging.c_str(), folder.c_str()) != 0)
+    {
+        // Another run extracted the same container first
+        NS_ABORT_MSG_UNLESS(IsDirectory(folder), "Cannot extract " << m_path << " to " << folder);
+        RemoveTree(staging);
+    }
+    NS_LOG_INFO("Scenario container " << m_path << " extracted to " << folder);
+    return folder;
+}
+
+std::string
+HapScenarioSource::GetRelativePath(std::string from, std::string to)
+{
+    char buffer[PATH_MAX];
+    NS_ABORT_MSG_IF(!realpath(from.c_str(), buffer), "Cannot resolve " << from);
+    std::list<std::string> fromParts = SystemPath::Split(buffer);
+    NS_ABORT_MSG_IF(!realpath(to.c_str(), buffer), "Cannot resolve " << to);
+    std::list<std::string> toParts = SystemPath::Split(buffer);
+
+    auto fromIt = fromParts.begin();
+    auto toIt = toParts.begin();
+    while (fromIt != fromParts.end() && toIt != toParts.end() && *fromIt == *toIt)
+    {
+        ++fromIt;
+        ++toIt;
+    }
+    std::list<std::string> parts(std::distance(fromIt, fromParts.end()), "..");
+    parts.insert(parts.end(), toIt, toParts.end());
+    return parts.empty() ? "." : SystemPath::Join(parts.begin(), parts.end());
+}
+
+void
+HapScenarioSource::WriteArchive(std::string folder, std::string fileName)
+{
+    NS_LOG_FUNCTION(folder << fileName);
+    NS_ABORT_MSG_UNLESS(IsDirectory(folder), "Scenario folder " << folder << " not found");
+    std::vector<std::string> names;
+    CollectFiles(folder, "", names);
+    std::sort(names.begin(), names.end());
+
+    std::ofstream out(fileName, std::ios::binary);
+    NS_ABORT_MSG_UNLESS(out.is_open(), "Cannot create scenario container " << fileName);
+    std::vector<uint32_t> crcs;
+    std::vector<uint32_t> sizes;
+    std::vector<uint32_t> offsets;
+    for (const std::string& name : names)
+    {
+        std::ifstream in(SystemPath::Append(folder, name), std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+        NS_ABORT_MSG_IF(contents.size() >= 0xFFFFFFFF, "File " << name << " is too large");
+        offsets.push_back(out.tellp());
+        crcs.push_back(Crc32(reinterpret_cast<const uint8_t*>(contents.data()), contents.size()));
+        sizes.push_back(contents.size());
+
+        WriteU32(out, ZIP_LOCAL_MAGIC);
+        WriteU16(out, ZIP_VERSION);
+        WriteU16(out, 0); // flags
+        WriteU16(out, ZIP_STORED);
+        WriteU32(out, 0); // modification time and date
+        WriteU32(out, crcs.back());
+        WriteU32(out, sizes.back());
+        WriteU32(out, sizes.back());
+        WriteU16(out, name.size());
+        WriteU16(out, 0); // extra field
+        out << name << contents;
+    }
+
+    uint64_t directory = out.tellp();
+    for (std::size_t i = 0; i < names.size(); ++i)
+    {
+        WriteU32(out, ZIP_CENTRAL_MAGIC);
+        WriteU16(out, ZIP_VERSION); // made by
+        WriteU16(out, ZIP_VERSION);
+        WriteU16(out, 0); // flags
+        WriteU16(out, ZIP_STORED);
+        WriteU32(out, 0); // modification time and date
+        WriteU32(out, crcs[i]);
+        WriteU32(out, sizes[i]);
+        WriteU32(out, sizes[i]);
+        WriteU16(out, names[i].size());
+        WriteU16(out, 0); // extra field
+        WriteU16(out, 0); // comment
+        WriteU16(out, 0); // disk
+        WriteU16(out, 0); // internal attributes
+        WriteU32(out, 0); // external attributes
+        WriteU32(out, offsets[i]);
+        out << names[i];
+    }
+    uint64_t end = out.tellp();
+    NS_ABORT_MSG_IF(end >= 0xFFFFFFFF || names.size() >= 0xFFFF,
+                    "Scenario container " << fileName << " would need ZIP64");
+
+    WriteU32(out, ZIP_END_MAGIC);
+    WriteU16(out, 0); // disk
+    WriteU16(out, 0); // disk of the central directory
+    WriteU16(out, names.size());
+    WriteU16(out, names.size());
+    WriteU32(out, end - directory);
+    WriteU32(out, directory);
+    WriteU16(out, 0); // comment
+    NS_ABORT_MSG_UNLESS(out, "Cannot write scenario container " << fileName);
+}
+
+} // namespace ns3
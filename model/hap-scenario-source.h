@@ -0,0 +1,157 @@
+#ifndef SIBGU_HAP_HAP_SCENARIO_SOURCE_H
+#define SIBGU_HAP_HAP_SCENARIO_SOURCE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Read-only access to the files of an SNS3 scenario, from a folder or a .tsk container.
+ *
+ * A .tsk container is a zip archive whose entries are stored uncompressed
+ * (zip -0), written e.g. by WriteArchive(). The whole archive is
+ * memory-mapped read-only and its central directory is indexed once, so a
+ * file is returned as a pointer into the mapping without any copy, and
+ * concurrent runs share the same pages. If every entry lies under the same
+ * top-level folder, that folder is stripped from the names. A container
+ * with an absolute entry name, or one with a .. component, is rejected.
+ *
+ * Names are relative to the scenario root with '/' separators, e.g.
+ * positions/ut_positions.txt. With a folder the files are mapped on
+ * demand and stay mapped until Close().
+ *
+ * SNS3 itself only reads scenarios below its data path. GetDirectory()
+ * gives a folder holding the scenario, extracting a container once into a
+ * cache shared by concurrent runs, and GetRelativePath() turns it into the
+ * location expected by SimulationHelper::LoadScenario().
+ */
+class HapScenarioSource
+{
+  public:
+    /**
+     * Contents of a file.
+     */
+    struct File
+    {
+        const uint8_t* data; //!< first byte, valid until Close()
+        uint64_t size;       //!< size, bytes
+    };
+
+    HapScenarioSource();
+    ~HapScenarioSource();
+
+    HapScenarioSource(const HapScenarioSource&) = delete;
+    HapScenarioSource& operator=(const HapScenarioSource&) = delete;
+
+    /**
+     * \brief Open a scenario folder or container.
+     * \param path folder, or container file
+     */
+    void Open(std::string path);
+
+    /**
+     * \brief Unmap everything.
+     */
+    void Close();
+
+    /**
+     * \return true if a container is open, false for a folder
+     */
+    bool IsArchive() const;
+
+    /**
+     * \return path given to Open()
+     */
+    std::string GetPath() const;
+
+    /**
+     * \param name file name relative to the scenario root
+     * \return true if the file exists
+     */
+    bool HasFile(std::string name) const;
+
+    /**
+     * \param name file name relative to the scenario root
+     * \return contents of the file
+     */
+    File GetFile(std::string name);
+
+    /**
+     * \param name file name relative to the scenario root
+     * \return copy of the contents of the file
+     */
+    std::string ReadFile(std::string name);
+
+    /**
+     * \param folder folder relative to the scenario root, e.g. antennapatterns
+     * \return names of the files directly in the folder, sorted
+     */
+    std::vector<std::string> ListFiles(std::string folder) const;
+
+    /**
+     * \brief Folder holding the scenario, for readers that need real files.
+     *
+     * A folder is returned as is. A container is extracted into
+     * cacheDir/<archive stem>-<digest of its index>, unless already there;
+     * concurrent extractions write to private folders and the first rename
+     * wins, so readers never see a partial scenario.
+     *
+     * \param cacheDir folder of the extracted containers
+     * \return scenario folder
+     */
+    std::string GetDirectory(std::string cacheDir);
+
+    /**
+     * \param file contents of a file
+     * \return CRC-32 of the contents, as stored in a container
+     */
+    static uint32_t GetCrc32(File file);
+
+    /**
+     * \param from folder
+     * \param to folder
+     * \return path of to relative to from, both resolved first
+     */
+    static std::string GetRelativePath(std::string from, std::string to);
+
+    /**
+     * \brief Write the files of a folder, recursively, as a container.
+     * \param folder scenario folder
+     * \param fileName container file
+     */
+    static void WriteArchive(std::string folder, std::string fileName);
+
+  private:
+    /**
+     * \brief Index the central directory of the mapped container.
+     */
+    void IndexArchive();
+
+    /**
+     * \param offset byte offset in the container
+     * \return little-endian 16-bit field
+     */
+    uint16_t ReadU16(uint64_t offset) const;
+
+    /**
+     * \param offset byte offset in the container
+     * \return little-endian 32-bit field
+     */
+    uint32_t ReadU32(uint64_t offset) const;
+
+    std::string m_path;                     //!< opened folder or container
+    const uint8_t* m_data;                  //!< mapped container
+    uint64_t m_size;                        //!< container size
+    uint64_t m_digest;                      //!< digest of the container index
+    std::map<std::string, File> m_files;    //!< files of the container, or mapped so far
+    std::vector<File> m_mappings;           //!< files mapped from a folder
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_SCENARIO_SOURCE_H
@@ -0,0 +1,406 @@
+#include "hap-scheduled-routing.h"
+
+#include "ns3/abort.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/log.h"
+#include "ns3/names.h"
+#include "ns3/node.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <tuple>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapScheduledRouting");
+
+NS_OBJECT_ENSURE_REGISTERED(HapScheduledRouting);
+
+TypeId
+HapScheduledRouting::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::HapScheduledRouting")
+                            .SetParent<Ipv4RoutingProtocol>()
+                            .SetGroupName("SibguHap")
+                            .AddConstructor<HapScheduledRouting>();
+    return tid;
+}
+
+HapScheduledRouting::HapScheduledRouting()
+    : m_current(nullptr),
+      m_next(0),
+      m_started(false),
+      m_nSwitches(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapScheduledRouting::~HapScheduledRouting()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapScheduledRouting::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_event.Cancel();
+    m_current = nullptr;
+    m_routes.clear();
+    m_tables.clear();
+    m_epochs.clear();
+    m_ipv4 = nullptr;
+    Ipv4RoutingProtocol::DoDispose();
+}
+
+void
+HapScheduledRouting::AddNetworkRouteTo(Time start,
+                                       Time end,
+                                       Ipv4Address network,
+                                       Ipv4Mask mask,
+                                       Ipv4Address gateway,
+                                       uint32_t interface)
+{
+    NS_LOG_FUNCTION(this << start << end << network << mask << gateway << interface);
+    NS_ABORT_MSG_UNLESS(start < end, "Empty route interval [" << start << ", " << end << ")");
+    m_routes.push_back({start, end, {network.CombineMask(mask), mask, gateway, interface}});
+    if (m_started)
+    {
+        Start();
+    }
+}
+
+void
+HapScheduledRouting::AddContactPlanRoutes(Ptr<HapContactPlan> plan,
+                                          uint32_t nodeId,
+                                          Ipv4Address network,
+                                          Ipv4Mask mask,
+                                          const std::map<uint32_t, NextHop>& nextHops)
+{
+    NS_LOG_FUNCTION(this << plan << nodeId << network << mask << nextHops.size());
+    const std::vector<HapContactPlan::RankingEpoch>& epochs =
+        plan->GetRankingEpochs(plan->GetObserverIndex(nodeId));
+
+    // Consecutive epochs through the same orbiter make one route
+    const NextHop* current = nullptr;
+    Time start;
+    for (std::size_t i = 0; i <= epochs.size(); ++i)
+    {
+        const NextHop* best = nullptr;
+        if (i < epochs.size())
+        {
+            for (uint32_t satId : epochs[i].satIds)
+            {
+                auto it = nextHops.find(satId);
+                if (it != nextHops.end())
+                {
+                    best = &it->second;
+                    break;
+                }
+            }
+        }
+        if (best == current)
+        {
+            continue;
+        }
+        // The last epoch lasts until the end of the plan, not for ever
+        Time boundary = i < epochs.size() ? epochs[i].start : plan->GetEnd();
+        if (current)
+        {
+            AddNetworkRouteTo(start, boundary, network, mask, current->gateway, current->interface);
+        }
+        current = best;
+        start = boundary;
+    }
+}
+
+uint32_t
+HapScheduledRouting::GetNTables() const
+{
+    return m_tables.size();
+}
+
+uint64_t
+HapScheduledRouting::GetNSwitches() const
+{
+    return m_nSwitches;
+}
+
+void
+HapScheduledRouting::Compile()
+{
+    NS_LOG_FUNCTION(this);
+    m_tables.clear();
+    m_epochs.clear();
+
+    std::vector<Time> boundaries;
+    for (const ScheduledRoute& route : m_routes)
+    {
+        boundaries.push_back(route.start);
+        if (route.end != Time::Max())
+        {
+            boundaries.push_back(route.end);
+        }
+    }
+    std::sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+    std::vector<std::size_t> byStart(m_routes.size());
+    for (std::size_t i = 0; i < byStart.size(); ++i)
+    {
+        byStart[i] = i;
+    }
+    std::stable_sort(byStart.begin(), byStart.end(), [this](std::size_t a, std::size_t b) {
+        return m_routes[a].start < m_routes[b].start;
+    });
+
+    // Sweep the boundaries; each distinct set of valid routes is one table,
+    // shared by all the epochs with these routes
+    std::map<std::vector<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>>, uint32_t> tableOf;
+    std::vector<std::size_t> active;
+    std::size_t nextRoute = 0;
+    for (Time t : boundaries)
+    {
+        active.erase(std::remove_if(active.begin(),
+                                    active.end(),
+                                    [this, t](std::size_t i) { return m_routes[i].end <= t; }),
+                     active.end());
+        while (nextRoute < byStart.size() && m_routes[byStart[nextRoute]].start <= t)
+        {
+            if (m_routes[byStart[nextRoute]].end > t)
+            {
+                active.push_back(byStart[nextRoute]);
+            }
+            ++nextRoute;
+        }
+        std::vector<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>> key;
+        for (std::size_t i : active)
+        {
+            const Route& route = m_routes[i].route;
+            key.emplace_back(route.network.Get(),
+                             route.mask.Get(),
+                             route.gateway.Get(),
+                             route.interface);
+        }
+        std::sort(key.begin(), key.end());
+        key.erase(std::unique(key.begin(), key.end()), key.end());
+
+        auto [it, inserted] = tableOf.try_emplace(key, m_tables.size());
+        if (inserted)
+        {
+            Table table;
+            for (const auto& [network, mask, gateway, interface] : key)
+            {
+                table.push_back(
+                    {Ipv4Address(network), Ipv4Mask(mask), Ipv4Address(gateway), interface});
+            }
+            std::stable_sort(table.begin(), table.end(), [](const Route& a, const Route& b) {
+                return a.mask.GetPrefixLength() > b.mask.GetPrefixLength();
+            });
+            m_tables.push_back(table);
+        }
+        if (m_epochs.empty() || m_epochs.back().table != it->second)
+        {
+            m_epochs.push_back({t, it->second});
+        }
+    }
+    NS_LOG_INFO(m_routes.size() << " routes, " << m_tables.size() << " tables, "
+                                << m_epochs.size() << " epochs");
+}
+
+void
+HapScheduledRouting::Start()
+{
+    NS_LOG_FUNCTION(this);
+    m_event.Cancel();
+    Compile();
+    m_started = true;
+
+    Time now = Simulator::Now();
+    auto it = std::upper_bound(m_epochs.begin(),
+                               m_epochs.end(),
+                               now,
+                               [](Time value, const Epoch& e) { return value < e.start; });
+    m_next = it - m_epochs.begin();
+    m_current = m_next > 0 ? &m_tables[m_epochs[m_next - 1].table] : nullptr;
+    ScheduleNext();
+}
+
+void
+HapScheduledRouting::Switch()
+{
+    m_current = &m_tables[m_epochs[m_next].table];
+    ++m_next;
+    ++m_nSwitches;
+    NS_LOG_INFO("Switched to table " << m_epochs[m_next - 1].table << " at "
+                                     << Simulator::Now().As(Time::S));
+    ScheduleNext();
+}
+
+void
+HapScheduledRouting::ScheduleNext()
+{
+    if (m_next < m_epochs.size())
+    {
+        m_event = Simulator::Schedule(m_epochs[m_next].start - Simulator::Now(),
+                                      &HapScheduledRouting::Switch,
+                                      this);
+    }
+}
+
+const HapScheduledRouting::Route*
+HapScheduledRouting::Lookup(Ipv4Address destination, Ptr<const NetDevice> oif) const
+{
+    if (!m_current)
+    {
+        return nullptr;
+    }
+    for (const Route& route : *m_current)
+    {
+        if (!route.mask.IsMatch(destination, route.network) || !m_ipv4->IsUp(route.interface))
+        {
+            continue;
+        }
+        if (oif && m_ipv4->GetNetDevice(route.interface) != oif)
+        {
+            continue;
+        }
+        return &route;
+    }
+    return nullptr;
+}
+
+Ptr<Ipv4Route>
+HapScheduledRouting::MakeRoute(const Route& route, Ipv4Address destination) const
+{
+    Ptr<Ipv4Route> rtentry = Create<Ipv4Route>();
+    rtentry->SetDestination(destination);
+    rtentry->SetSource(m_ipv4->GetAddress(route.interface, 0).GetLocal());
+    rtentry->SetGateway(route.gateway);
+    rtentry->SetOutputDevice(m_ipv4->GetNetDevice(route.interface));
+    return rtentry;
+}
+
+Ptr<Ipv4Route>
+HapScheduledRouting::RouteOutput(Ptr<Packet> p,
+                                 const Ipv4Header& header,
+                                 Ptr<NetDevice> oif,
+                                 Socket::SocketErrno& sockerr)
+{
+    NS_LOG_FUNCTION(this << p << header << oif);
+    Ipv4Address destination = header.GetDestination();
+    const Route* route = destination.IsMulticast() ? nullptr : Lookup(destination, oif);
+    if (!route)
+    {
+        sockerr = Socket::ERROR_NOROUTETOHOST;
+        return nullptr;
+    }
+    sockerr = Socket::ERROR_NOTERROR;
+    return MakeRoute(*route, destination);
+}
+
+bool
+HapScheduledRouting::RouteInput(Ptr<const Packet> p,
+                                const Ipv4Header& header,
+                                Ptr<const NetDevice> idev,
+                                const UnicastForwardCallback& ucb,
+                                const MulticastForwardCallback& mcb,
+                                const LocalDeliverCallback& lcb,
+                                const ErrorCallback& ecb)
+{
+    NS_LOG_FUNCTION(this << p << header << idev);
+    Ipv4Address destination = header.GetDestination();
+    if (destination.IsMulticast() || destination.IsBroadcast())
+    {
+        return false;
+    }
+    int32_t iif = m_ipv4->GetInterfaceForDevice(idev);
+    if (iif < 0 || !m_ipv4->IsForwarding(iif))
+    {
+        return false;
+    }
+    const Route* route = Lookup(destination, nullptr);
+    if (!route)
+    {
+        return false;
+    }
+    ucb(MakeRoute(*route, destination), p, header);
+    return true;
+}
+
+void
+HapScheduledRouting::NotifyInterfaceUp(uint32_t interface)
+{
+    NS_LOG_FUNCTION(this << interface);
+}
+
+void
+HapScheduledRouting::NotifyInterfaceDown(uint32_t interface)
+{
+    NS_LOG_FUNCTION(this << interface);
+}
+
+void
+HapScheduledRouting::NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address)
+{
+    NS_LOG_FUNCTION(this << interface << address);
+}
+
+void
+HapScheduledRouting::NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address)
+{
+    NS_LOG_FUNCTION(this << interface << address);
+}
+
+void
+HapScheduledRouting::SetIpv4(Ptr<Ipv4> ipv4)
+{
+    NS_LOG_FUNCTION(this << ipv4);
+    NS_ASSERT(!m_ipv4 && ipv4);
+    m_ipv4 = ipv4;
+    // Routes may still be added until the simulation starts
+    m_event = Simulator::ScheduleNow(&HapScheduledRouting::Start, this);
+}
+
+void
+HapScheduledRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+{
+    std::ostream* os = stream->GetStream();
+    *os << "Node: " << m_ipv4->GetObject<Node>()->GetId() << ", Time: " << Now().As(unit)
+        << ", Local time: " << m_ipv4->GetObject<Node>()->GetLocalTime().As(unit)
+        << ", HapScheduledRouting table " << (m_next > 0 ? m_epochs[m_next - 1].table : 0)
+        << " of " << m_tables.size() << std::endl;
+    if (!m_current || m_current->empty())
+    {
+        *os << "No scheduled route" << std::endl << std::endl;
+        return;
+    }
+    *os << "Destination     Gateway         Genmask         Iface" << std::endl;
+    for (const Route& route : *m_current)
+    {
+        std::ostringstream destination;
+        std::ostringstream gateway;
+        std::ostringstream mask;
+        destination << route.network;
+        gateway << route.gateway;
+        mask << route.mask;
+        *os << std::setiosflags(std::ios::left) << std::setw(16) << destination.str()
+            << std::setw(16) << gateway.str() << std::setw(16) << mask.str();
+        if (!Names::FindName(m_ipv4->GetNetDevice(route.interface)).empty())
+        {
+            *os << Names::FindName(m_ipv4->GetNetDevice(route.interface));
+        }
+        else
+        {
+            *os << route.interface;
+        }
+        *os << std::endl;
+    }
+    *os << std::endl;
+}
+
+} // namespace ns3
@@ -0,0 +1,200 @@
+#ifndef SIBGU_HAP_HAP_SCHEDULED_ROUTING_H
+#define SIBGU_HAP_HAP_SCHEDULED_ROUTING_H
+
+#include "hap-contact-plan.h"
+
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4.h"
+#include "ns3/nstime.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Time-varying routing that follows a precomputed contact schedule.
+ *
+ * Routes are added with the interval during which they are valid, either
+ * directly or from the ranking epochs of a HapContactPlan: towards a
+ * destination, the node forwards through the best ranked orbiter it has a
+ * next hop for. When the simulation starts the routes are compiled into one
+ * forwarding table per distinct set of valid routes, and a single event per
+ * boundary switches the current table, which is a pointer assignment. No
+ * control traffic is exchanged and nothing is recomputed during the run.
+ *
+ * Lookups take the longest prefix of the current table. The protocol only
+ * forwards: it is meant to be added to an Ipv4ListRouting above
+ * Ipv4StaticRouting, which handles local delivery and the fixed routes, so
+ * that destinations without a scheduled route fall through to them.
+ */
+class HapScheduledRouting : public Ipv4RoutingProtocol
+{
+  public:
+    /**
+     * Next hop towards an orbiter.
+     */
+    struct NextHop
+    {
+        Ipv4Address gateway; //!< next hop address
+        uint32_t interface;  //!< output interface
+    };
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapScheduledRouting();
+    ~HapScheduledRouting() override;
+
+    /**
+     * \brief Add a route valid during [start, end).
+     * \param start first instant of the route
+     * \param end first instant the route is no longer valid, Time::Max() for ever
+     * \param network destination network
+     * \param mask destination mask
+     * \param gateway next hop address
+     * \param interface output interface
+     */
+    void AddNetworkRouteTo(Time start,
+                           Time end,
+                           Ipv4Address network,
+                           Ipv4Mask mask,
+                           Ipv4Address gateway,
+                           uint32_t interface);
+
+    /**
+     * \brief Add the routes towards a destination over the contacts of a node.
+     *
+     * During each ranking epoch of the node the route goes through the best
+     * ranked orbiter found in nextHops; epochs without one have no route.
+     * The last epoch ends at HapContactPlan::GetEnd(): past the plan no
+     * route is known.
+     *
+     * \param plan contact plan with the ranking epochs of the node
+     * \param nodeId node id of the observer in the plan
+     * \param network destination network
+     * \param mask destination mask
+     * \param nextHops next hop towards each orbiter, by satId
+     */
+    void AddContactPlanRoutes(Ptr<HapContactPlan> plan,
+                              uint32_t nodeId,
+                              Ipv4Address network,
+                              Ipv4Mask mask,
+                              const std::map<uint32_t, NextHop>& nextHops);
+
+    /**
+     * \return number of distinct forwarding tables compiled
+     */
+    uint32_t GetNTables() const;
+
+    /**
+     * \return number of table switches so far
+     */
+    uint64_t GetNSwitches() const;
+
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                               const Ipv4Header& header,
+                               Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override;
+    bool RouteInput(Ptr<const Packet> p,
+                    const Ipv4Header& header,
+                    Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb,
+                    const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb,
+                    const ErrorCallback& ecb) override;
+    void NotifyInterfaceUp(uint32_t interface) override;
+    void NotifyInterfaceDown(uint32_t interface) override;
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override;
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override;
+    void SetIpv4(Ptr<Ipv4> ipv4) override;
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+                           Time::Unit unit = Time::S) const override;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /// Entry of a forwarding table.
+    struct Route
+    {
+        Ipv4Address network; //!< destination network
+        Ipv4Mask mask;       //!< destination mask
+        Ipv4Address gateway; //!< next hop address
+        uint32_t interface;  //!< output interface
+    };
+
+    /// Route with its validity.
+    struct ScheduledRoute
+    {
+        Time start;  //!< first instant of the route
+        Time end;    //!< first instant the route is no longer valid
+        Route route; //!< the route
+    };
+
+    /// Forwarding table, longest prefix first.
+    typedef std::vector<Route> Table;
+
+    /// Table valid from an instant.
+    struct Epoch
+    {
+        Time start;     //!< instant the table becomes current
+        uint32_t table; //!< index in m_tables
+    };
+
+    /**
+     * \brief Compile the routes into tables and schedule the first switch.
+     */
+    void Start();
+
+    /**
+     * \brief Build m_tables and m_epochs from m_routes.
+     */
+    void Compile();
+
+    /**
+     * \brief Make the table of the epoch m_next current and schedule the next switch.
+     */
+    void Switch();
+
+    /**
+     * \brief Schedule the switch to the epoch m_next, if any.
+     */
+    void ScheduleNext();
+
+    /**
+     * \param destination destination address
+     * \param oif required output device, or null
+     * \return first route of the current table matching the destination
+     */
+    const Route* Lookup(Ipv4Address destination, Ptr<const NetDevice> oif) const;
+
+    /**
+     * \param route table entry
+     * \param destination destination address
+     * \return the ns-3 route
+     */
+    Ptr<Ipv4Route> MakeRoute(const Route& route, Ipv4Address destination) const;
+
+    Ptr<Ipv4> m_ipv4;                     //!< IPv4 of the node
+    std::vector<ScheduledRoute> m_routes; //!< routes with their validity
+    std::vector<Table> m_tables;          //!< distinct forwarding tables
+    std::vector<Epoch> m_epochs;          //!< table switches, in time order
+    const Table* m_current;               //!< current table, null before the first epoch
+    std::size_t m_next;                   //!< next epoch to switch to
+    EventId m_event;                      //!< pending switch
+    bool m_started;                       //!< the routes were compiled
+    uint64_t m_nSwitches;                 //!< switch counter
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_SCHEDULED_ROUTING_H
@@ -0,0 +1,312 @@
+#include "hap-telemetry-publisher.h"
+
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapTelemetryPublisher");
+
+NS_OBJECT_ENSURE_REGISTERED(HapTelemetryPublisher);
+
+namespace
+{
+
+const char TELEMETRY_MAGIC[4] = {'H', 'T', 'L', 'M'}; //!< file signature
+const uint32_t TELEMETRY_VERSION = 1;                 //!< layout version
+const uint64_t TELEMETRY_HEADER_SIZE = 64;            //!< header size
+const uint64_t TELEMETRY_SEQUENCE_OFFSET = 24;        //!< snapshot sequence in the header
+const uint64_t TELEMETRY_HEAD_OFFSET = 32;            //!< events written, in the header
+const uint64_t TELEMETRY_NAME_SIZE = 32;              //!< counter name slot
+const uint64_t TELEMETRY_EVENT_SIZE = 32;             //!< event ring slot
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && sizeof(std::atomic<uint64_t>) == 8,
+              "Shared 64-bit counters must be lock-free");
+
+/**
+ * \param base mapped file
+ * \param offset 8-byte aligned offset
+ * \return 64-bit atomic at the offset
+ */
+std::atomic<uint64_t>*
+AtomicAt(uint8_t* base, uint64_t offset)
+{
+    return reinterpret_cast<std::atomic<uint64_t>*>(base + offset);
+}
+
+} // namespace
+
+TypeId
+HapTelemetryPublisher::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapTelemetryPublisher")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapTelemetryPublisher>()
+            .AddAttribute("Path",
+                          "Shared memory file of the telemetry",
+                          StringValue("/dev/shm/sibgu-hap-telemetry"),
+                          MakeStringAccessor(&HapTelemetryPublisher::m_path),
+                          MakeStringChecker())
+            .AddAttribute("Interval",
+                          "Simulation time between two snapshots",
+                          TimeValue(MilliSeconds(100)),
+                          MakeTimeAccessor(&HapTelemetryPublisher::m_interval),
+                          MakeTimeChecker(TimeStep(1)))
+            .AddAttribute("MaxBeams",
+                          "Number of beam slots; larger beam ids are not published",
+                          UintegerValue(100),
+                          MakeUintegerAccessor(&HapTelemetryPublisher::m_maxBeams),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("EventCapacity",
+                          "Number of slots of the event ring",
+                          UintegerValue(4096),
+                          MakeUintegerAccessor(&HapTelemetryPublisher::m_eventCapacity),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("Unlink",
+                          "Remove the shared memory file on dispose",
+                          BooleanValue(true),
+                          MakeBooleanAccessor(&HapTelemetryPublisher::m_unlink),
+                          MakeBooleanChecker());
+    return tid;
+}
+
+HapTelemetryPublisher::HapTelemetryPublisher()
+    : m_interval(MilliSeconds(100)),
+      m_maxBeams(100),
+      m_eventCapacity(4096),
+      m_unlink(true),
+      m_base(nullptr),
+      m_size(0),
+      m_snapshotOffset(0),
+      m_eventOffset(0),
+      m_nSnapshots(0),
+      m_nEvents(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapTelemetryPublisher::~HapTelemetryPublisher()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapTelemetryPublisher::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_publishEvent.Cancel();
+    Close();
+    Object::DoDispose();
+}
+
+uint32_t
+HapTelemetryPublisher::AddCounter(std::string name)
+{
+    NS_LOG_FUNCTION(this << name);
+    NS_ABORT_MSG_IF(m_base, "Counters must be added before Start()");
+    m_counterNames.push_back(name);
+    m_counters.push_back(0);
+    return m_counters.size() - 1;
+}
+
+void
+HapTelemetryPublisher::Start()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(m_base, "Telemetry already started");
+
+    uint32_t nCounters = m_counters.size();
+    m_beamBytes.assign(m_maxBeams, 0);
+    m_publishedBytes.assign(m_maxBeams, 0);
+    m_snapshotOffset = TELEMETRY_HEADER_SIZE + TELEMETRY_NAME_SIZE * nCounters;
+    m_eventOffset = m_snapshotOffset + 8 + 8 * uint64_t(nCounters) + 16 * uint64_t(m_maxBeams);
+    m_size = m_eventOffset + TELEMETRY_EVENT_SIZE * m_eventCapacity;
+
+    int fd = open(m_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    NS_ABORT_MSG_IF(fd < 0, "Cannot create telemetry file " << m_path);
+    NS_ABORT_MSG_IF(ftruncate(fd, m_size) != 0, "Cannot size telemetry file " << m_path);
+    void* base = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    NS_ABORT_MSG_IF(base == MAP_FAILED, "Cannot map telemetry file " << m_path);
+    m_base = static_cast<uint8_t*>(base);
+
+    // The file is zero-filled; the magic is written last so that a viewer
+    // never sees a partial header
+    uint32_t header[5] = {TELEMETRY_VERSION, nCounters, m_maxBeams, m_eventCapacity, 0};
+    std::memcpy(m_base + 4, header, sizeof(header));
+    for (uint32_t i = 0; i < nCounters; ++i)
+    {
+        std::strncpy(reinterpret_cast<char*>(m_base + TELEMETRY_HEADER_SIZE +
+                                             TELEMETRY_NAME_SIZE * i),
+                     m_counterNames[i].c_str(),
+                     TELEMETRY_NAME_SIZE - 1);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(m_base, TELEMETRY_MAGIC, sizeof(TELEMETRY_MAGIC));
+
+    NS_LOG_INFO("Telemetry in " << m_path << ": " << nCounters << " counters, " << m_maxBeams
+                                << " beams, " << m_eventCapacity << " events");
+    m_publishEvent = Simulator::Schedule(m_interval, &HapTelemetryPublisher::Publish, this);
+}
+
+void
+HapTelemetryPublisher::Increment(uint32_t counter, uint64_t n)
+{
+    NS_ASSERT_MSG(counter < m_counters.size(), "Unknown counter " << counter);
+    m_counters[counter] += n;
+}
+
+void
+HapTelemetryPublisher::AddBeamBytes(uint32_t beamId, uint64_t bytes)
+{
+    if (beamId < m_beamBytes.size())
+    {
+        m_beamBytes[beamId] += bytes;
+    }
+}
+
+void
+HapTelemetryPublisher::PublishEvent(EventType type, uint32_t node, uint32_t from, uint32_t to)
+{
+    if (!m_base)
+    {
+        return;
+    }
+
+    uint64_t index = m_nEvents++;
+    uint64_t offset = m_eventOffset + TELEMETRY_EVENT_SIZE * (index % m_eventCapacity);
+    std::atomic<uint64_t>* sequence = AtomicAt(m_base, offset);
+
+    // A zero sequence marks the slot as being rewritten
+    sequence->store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    double time = Simulator::Now().GetSeconds();
+    uint32_t fields[4] = {type, node, from, to};
+    std::memcpy(m_base + offset + 8, &time, sizeof(time));
+    std::memcpy(m_base + offset + 16, fields, sizeof(fields));
+    sequence->store(index + 1, std::memory_order_release);
+    AtomicAt(m_base, TELEMETRY_HEAD_OFFSET)->store(m_nEvents, std::memory_order_release);
+}
+
+void
+HapTelemetryPublisher::HandoverTrigger(uint32_t nodeId, const std::vector<uint32_t>& satIds)
+{
+    uint32_t best = satIds.empty() ? UINT32_MAX : satIds.front();
+    auto [it, inserted] = m_bestOrbiter.emplace(nodeId, best);
+    if (inserted || it->second != best)
+    {
+        PublishEvent(HANDOVER, nodeId, inserted ? UINT32_MAX : it->second, best);
+        it->second = best;
+    }
+}
+
+void
+HapTelemetryPublisher::ConnectToScheduler(Ptr<HapHandoverScheduler> scheduler)
+{
+    NS_LOG_FUNCTION(this << scheduler);
+    scheduler->TraceConnectWithoutContext(
+        "HandoverTrigger",
+        MakeCallback(&HapTelemetryPublisher::HandoverTrigger, this));
+}
+
+void
+HapTelemetryPublisher::BeamActivated(uint32_t satId, uint32_t beamId)
+{
+    PublishEvent(BEAM_ACTIVATED, 0, satId, beamId);
+}
+
+uint64_t
+HapTelemetryPublisher::GetNSnapshots() const
+{
+    return m_nSnapshots;
+}
+
+uint64_t
+HapTelemetryPublisher::GetNEvents() const
+{
+    return m_nEvents;
+}
+
+void
+HapTelemetryPublisher::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_base && !m_publishEvent.IsExpired())
+    {
+        m_publishEvent.Cancel();
+        WriteSnapshot();
+    }
+}
+
+void
+HapTelemetryPublisher::Publish()
+{
+    WriteSnapshot();
+    // Once the other events are exhausted or Simulator::Stop() has been
+    // reached, this snapshot is the last one
+    if (Simulator::IsFinished())
+    {
+        NS_LOG_INFO("Simulation finished, telemetry stopped after " << m_nSnapshots
+                                                                    << " snapshots");
+        return;
+    }
+    m_publishEvent = Simulator::Schedule(m_interval, &HapTelemetryPublisher::Publish, this);
+}
+
+void
+HapTelemetryPublisher::WriteSnapshot()
+{
+    std::atomic<uint64_t>* sequence = AtomicAt(m_base, TELEMETRY_SEQUENCE_OFFSET);
+    uint64_t seq = sequence->load(std::memory_order_relaxed);
+    sequence->store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint8_t* p = m_base + m_snapshotOffset;
+    double time = Simulator::Now().GetSeconds();
+    std::memcpy(p, &time, sizeof(time));
+    p += sizeof(time);
+    std::memcpy(p, m_counters.data(), m_counters.size() * sizeof(uint64_t));
+    p += m_counters.size() * sizeof(uint64_t);
+    double seconds = m_interval.GetSeconds();
+    for (uint32_t beam = 0; beam < m_maxBeams; ++beam)
+    {
+        double bps = (m_beamBytes[beam] - m_publishedBytes[beam]) * 8.0 / seconds;
+        std::memcpy(p + sizeof(double) * beam, &bps, sizeof(bps));
+    }
+    p += sizeof(double) * m_maxBeams;
+    std::memcpy(p, m_beamBytes.data(), m_maxBeams * sizeof(uint64_t));
+    m_publishedBytes = m_beamBytes;
+
+    sequence->store(seq + 2, std::memory_order_release);
+    ++m_nSnapshots;
+}
+
+void
+HapTelemetryPublisher::Close()
+{
+    if (!m_base)
+    {
+        return;
+    }
+    munmap(m_base, m_size);
+    m_base = nullptr;
+    if (m_unlink)
+    {
+        unlink(m_path.c_str());
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,176 @@
+#ifndef SIBGU_HAP_HAP_TELEMETRY_PUBLISHER_H
+#define SIBGU_HAP_HAP_TELEMETRY_PUBLISHER_H
+
+#include "hap-handover-scheduler.h"
+
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Live telemetry of a running simulation in shared memory.
+ *
+ * Counters, per-beam throughput and handover events are published in a
+ * memory-mapped file (by default under /dev/shm) that an external viewer
+ * maps read-only and polls; nothing is written to disk and the viewer
+ * never blocks the simulation. The layout, in host byte order, is:
+ *
+ * - header (64 bytes): "HTLM", version, number of counters, number of
+ *   beams, event ring capacity, reserved, snapshot sequence (u64), number
+ *   of events written (u64), padding;
+ * - counter names: 32 bytes each, NUL-padded;
+ * - snapshot: simulation time (f64), counters (u64), beam throughput in
+ *   bps over the last Interval (f64), beam bytes since start (u64);
+ * - event ring: EventCapacity slots of 32 bytes: sequence (u64), time
+ *   (f64), type, node, from, to (u32).
+ *
+ * The snapshot is rewritten every Interval of simulation time under a
+ * seqlock: the sequence is odd while it is written, so a reader retries
+ * if the sequence is odd or changed during its copy. Events are written
+ * as they happen; a slot holds event n once its sequence reads n + 1, and
+ * a reader more than EventCapacity events behind has lost the oldest ones.
+ */
+class HapTelemetryPublisher : public Object
+{
+  public:
+    /// Event types of the ring.
+    enum EventType
+    {
+        HANDOVER = 1,       //!< node: UT, from/to: previous and new best orbiter
+        BEAM_ACTIVATED = 2  //!< from: orbiter, to: beam
+    };
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapTelemetryPublisher();
+    ~HapTelemetryPublisher() override;
+
+    /**
+     * \brief Declare a counter; only before Start().
+     * \param name counter name, at most 31 characters are published
+     * \return counter index for Increment()
+     */
+    uint32_t AddCounter(std::string name);
+
+    /**
+     * \brief Create the shared memory file and schedule the snapshots.
+     *
+     * Snapshots are published until Stop(), or until no other event is
+     * left or the simulation is stopping, so the publisher never keeps a run
+     * alive by itself.
+     */
+    void Start();
+
+    /**
+     * \brief Publish a last snapshot and stop; the file stays mapped until
+     *        dispose, so viewers keep the final state.
+     */
+    void Stop();
+
+    /**
+     * \param counter index returned by AddCounter()
+     * \param n increment
+     */
+    void Increment(uint32_t counter, uint64_t n = 1);
+
+    /**
+     * \brief Account bytes carried by a beam.
+     * \param beamId beam id, below MaxBeams
+     * \param bytes number of bytes
+     */
+    void AddBeamBytes(uint32_t beamId, uint64_t bytes);
+
+    /**
+     * \brief Publish an event.
+     * \param type event type
+     * \param node node id
+     * \param from first event parameter
+     * \param to second event parameter
+     */
+    void PublishEvent(EventType type, uint32_t node, uint32_t from, uint32_t to);
+
+    /**
+     * \brief Sink for HapHandoverScheduler::HandoverTrigger.
+     * \param nodeId node id of the UT
+     * \param satIds new ranking of the closest visible orbiters
+     */
+    void HandoverTrigger(uint32_t nodeId, const std::vector<uint32_t>& satIds);
+
+    /**
+     * \brief Publish the handovers predicted by a scheduler.
+     * \param scheduler handover scheduler of the UTs
+     */
+    void ConnectToScheduler(Ptr<HapHandoverScheduler> scheduler);
+
+    /**
+     * \brief Sink for HapLazyBeamManager::BeamActivated.
+     * \param satId orbiter id
+     * \param beamId beam id
+     */
+    void BeamActivated(uint32_t satId, uint32_t beamId);
+
+    /**
+     * \return number of snapshots published
+     */
+    uint64_t GetNSnapshots() const;
+
+    /**
+     * \return number of events published
+     */
+    uint64_t GetNEvents() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * \brief Write the snapshot under the seqlock.
+     */
+    void WriteSnapshot();
+
+    /**
+     * \brief Write the snapshot and schedule the next one, unless the
+     *        simulation is finishing.
+     */
+    void Publish();
+
+    /**
+     * \brief Unmap the file and, with Unlink set, remove it.
+     */
+    void Close();
+
+    std::string m_path;                       //!< shared memory file
+    Time m_interval;                          //!< snapshot period
+    uint32_t m_maxBeams;                      //!< number of beam slots
+    uint32_t m_eventCapacity;                 //!< event ring slots
+    bool m_unlink;                            //!< remove the file on dispose
+    std::vector<std::string> m_counterNames;  //!< counter names
+    std::vector<uint64_t> m_counters;         //!< counter values
+    std::vector<uint64_t> m_beamBytes;        //!< bytes per beam since start
+    std::vector<uint64_t> m_publishedBytes;   //!< bytes per beam at the last snapshot
+    std::unordered_map<uint32_t, uint32_t> m_bestOrbiter; //!< best orbiter per UT
+    uint8_t* m_base;                          //!< mapped file, null before Start()
+    uint64_t m_size;                          //!< mapped size
+    uint64_t m_snapshotOffset;                //!< snapshot offset in the file
+    uint64_t m_eventOffset;                   //!< event ring offset in the file
+    uint64_t m_nSnapshots;                    //!< snapshots published
+    uint64_t m_nEvents;                       //!< events published
+    EventId m_publishEvent;                   //!< next snapshot
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_TELEMETRY_PUBLISHER_H
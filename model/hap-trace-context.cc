@@ -0,0 +1,20 @@
+#include "hap-trace-context.h"
+
+#include <cstdlib>
+
+namespace ns3
+{
+
+uint32_t
+HapNodeIdFromContext(const std::string& context)
+{
+    static const std::string prefix = "/NodeList/";
+    size_t pos = context.find(prefix);
+    if (pos == std::string::npos)
+    {
+        return UINT32_MAX;
+    }
+    return std::strtoul(context.c_str() + pos + prefix.size(), nullptr, 10);
+}
+
+} // namespace ns3
@@ -0,0 +1,21 @@
+#ifndef SIBGU_HAP_HAP_TRACE_CONTEXT_H
+#define SIBGU_HAP_HAP_TRACE_CONTEXT_H
+
+#include <cstdint>
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Node id of a Config trace context such as "/NodeList/12/$ns3::Ipv4L3Protocol/Rx".
+ *
+ * \param context trace context
+ * \return node id, or UINT32_MAX if the context has no /NodeList/ element
+ */
+uint32_t HapNodeIdFromContext(const std::string& context);
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_TRACE_CONTEXT_H
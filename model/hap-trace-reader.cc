@@ -0,0 +1,301 @@
+#include "hap-trace-reader.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapTraceReader");
+
+namespace
+{
+
+const uint32_t PCAP_MAGIC_US = 0xa1b2c3d4;        //!< pcap, microsecond timestamps
+const uint32_t PCAP_MAGIC_NS = 0xa1b23c4d;        //!< pcap, nanosecond timestamps
+const uint32_t PCAP_HEADER_SIZE = 24;             //!< pcap global header
+const uint32_t PCAP_RECORD_HEADER_SIZE = 16;      //!< pcap per-packet header
+const uint32_t LINKTYPE_ETHERNET = 1;             //!< Ethernet II
+const uint32_t LINKTYPE_RAW = 101;                //!< raw IP
+const uint32_t LINKTYPE_LINUX_SLL = 113;          //!< Linux cooked capture
+const uint32_t LINKTYPE_IPV4 = 228;               //!< raw IPv4
+const char BINARY_MAGIC[4] = {'H', 'T', 'R', 'B'}; //!< compact binary trace
+const uint32_t BINARY_VERSION = 1;                //!< compact binary trace version
+const uint32_t BINARY_HEADER_SIZE = 16;           //!< compact binary header
+const uint32_t BINARY_RECORD_SIZE = 24;           //!< compact binary record
+
+/**
+ * \param p first byte
+ * \return big-endian 16-bit field
+ */
+uint16_t
+ReadNtohU16(const uint8_t* p)
+{
+    return (uint16_t(p[0]) << 8) | p[1];
+}
+
+/**
+ * \param p first byte
+ * \return big-endian 32-bit field
+ */
+uint32_t
+ReadNtohU32(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+} // namespace
+
+HapTraceReader::HapTraceReader()
+    : m_data(nullptr),
+      m_size(0),
+      m_offset(0),
+      m_released(0),
+      m_format(FORMAT_BINARY),
+      m_swapped(false),
+      m_nanoseconds(false),
+      m_linkType(0),
+      m_recordSize(BINARY_RECORD_SIZE)
+{
+}
+
+HapTraceReader::~HapTraceReader()
+{
+    Close();
+}
+
+void
+HapTraceReader::Open(std::string fileName)
+{
+    NS_LOG_FUNCTION(this << fileName);
+    Close();
+
+    int fd = open(fileName.c_str(), O_RDONLY);
+    NS_ABORT_MSG_IF(fd < 0, "Cannot open trace " << fileName);
+    struct stat info;
+    NS_ABORT_MSG_IF(fstat(fd, &info) != 0, "Cannot stat trace " << fileName);
+    m_size = info.st_size;
+    NS_ABORT_MSG_IF(m_size < BINARY_HEADER_SIZE, "Trace " << fileName << " is too short");
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    NS_ABORT_MSG_IF(data == MAP_FAILED, "Cannot map trace " << fileName);
+    m_data = static_cast<const uint8_t*>(data);
+    m_fileName = fileName;
+    madvise(data, m_size, MADV_SEQUENTIAL);
+
+    uint32_t magic;
+    std::memcpy(&magic, m_data, sizeof(magic));
+    if (std::memcmp(m_data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0)
+    {
+        uint32_t version;
+        std::memcpy(&version, m_data + 4, sizeof(version));
+        std::memcpy(&m_recordSize, m_data + 8, sizeof(m_recordSize));
+        NS_ABORT_MSG_IF(version != BINARY_VERSION || m_recordSize < BINARY_RECORD_SIZE,
+                        "Unsupported binary trace " << fileName);
+        m_format = FORMAT_BINARY;
+        m_offset = BINARY_HEADER_SIZE;
+    }
+    else
+    {
+        m_swapped = (magic == __builtin_bswap32(PCAP_MAGIC_US) ||
+                     magic == __builtin_bswap32(PCAP_MAGIC_NS));
+        uint32_t native = m_swapped ? __builtin_bswap32(magic) : magic;
+        NS_ABORT_MSG_IF(native != PCAP_MAGIC_US && native != PCAP_MAGIC_NS,
+                        "Trace " << fileName << " is neither pcap nor binary trace");
+        NS_ABORT_MSG_IF(m_size < PCAP_HEADER_SIZE, "Truncated pcap header in " << fileName);
+        m_format = FORMAT_PCAP;
+        m_nanoseconds = (native == PCAP_MAGIC_NS);
+        m_linkType = PcapU32(20) & 0x0fffffff;
+        NS_ABORT_MSG_IF(m_linkType != LINKTYPE_ETHERNET && m_linkType != LINKTYPE_RAW &&
+                            m_linkType != LINKTYPE_LINUX_SLL && m_linkType != LINKTYPE_IPV4,
+                        "Unsupported pcap link type " << m_linkType << " in " << fileName);
+        m_offset = PCAP_HEADER_SIZE;
+    }
+    m_released = 0;
+}
+
+void
+HapTraceReader::Close()
+{
+    if (m_data)
+    {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_data = nullptr;
+    }
+    m_size = 0;
+    m_offset = 0;
+}
+
+bool
+HapTraceReader::Next(Record& record)
+{
+    NS_ABORT_MSG_UNLESS(m_data, "No trace open");
+    return m_format == FORMAT_PCAP ? NextPcap(record) : NextBinary(record);
+}
+
+uint32_t
+HapTraceReader::ReadBatch(std::vector<Record>& batch, uint32_t maxRecords)
+{
+    uint32_t n = 0;
+    Record record;
+    while (n < maxRecords && Next(record))
+    {
+        batch.push_back(record);
+        ++n;
+    }
+    return n;
+}
+
+void
+HapTraceReader::Advise(uint64_t lookAhead)
+{
+    uint64_t page = sysconf(_SC_PAGESIZE);
+    uint64_t consumed = m_offset / page * page;
+    if (consumed > m_released)
+    {
+        madvise(const_cast<uint8_t*>(m_data) + m_released, consumed - m_released, MADV_DONTNEED);
+        m_released = consumed;
+    }
+    uint64_t end = std::min(m_size, m_offset + lookAhead);
+    if (end > consumed)
+    {
+        madvise(const_cast<uint8_t*>(m_data) + consumed, end - consumed, MADV_WILLNEED);
+    }
+}
+
+HapTraceReader::Format
+HapTraceReader::GetFormat() const
+{
+    return m_format;
+}
+
+uint64_t
+HapTraceReader::GetOffset() const
+{
+    return m_offset;
+}
+
+uint64_t
+HapTraceReader::GetSize() const
+{
+    return m_size;
+}
+
+uint32_t
+HapTraceReader::PcapU32(uint64_t offset) const
+{
+    uint32_t value;
+    std::memcpy(&value, m_data + offset, sizeof(value));
+    return m_swapped ? __builtin_bswap32(value) : value;
+}
+
+bool
+HapTraceReader::NextPcap(Record& record)
+{
+    while (m_offset + PCAP_RECORD_HEADER_SIZE <= m_size)
+    {
+        uint32_t seconds = PcapU32(m_offset);
+        uint32_t fraction = PcapU32(m_offset + 4);
+        uint32_t captured = PcapU32(m_offset + 8);
+        const uint8_t* frame = m_data + m_offset + PCAP_RECORD_HEADER_SIZE;
+        if (m_offset + PCAP_RECORD_HEADER_SIZE + captured > m_size)
+        {
+            NS_LOG_WARN("Truncated last packet in " << m_fileName);
+            m_offset = m_size;
+            return false;
+        }
+        m_offset += PCAP_RECORD_HEADER_SIZE + captured;
+
+        uint32_t ipOffset = 0;
+        uint16_t etherType = 0x0800;
+        if (m_linkType == LINKTYPE_ETHERNET)
+        {
+            if (captured < 14)
+            {
+                continue;
+            }
+            etherType = ReadNtohU16(frame + 12);
+            ipOffset = 14;
+            if (etherType == 0x8100 && captured >= 18)
+            {
+                etherType = ReadNtohU16(frame + 16);
+                ipOffset = 18;
+            }
+        }
+        else if (m_linkType == LINKTYPE_LINUX_SLL)
+        {
+            if (captured < 16)
+            {
+                continue;
+            }
+            etherType = ReadNtohU16(frame + 14);
+            ipOffset = 16;
+        }
+        if (etherType != 0x0800 || captured < ipOffset + 20 || (frame[ipOffset] >> 4) != 4)
+        {
+            continue;
+        }
+
+        const uint8_t* ip = frame + ipOffset;
+        record.timeNs =
+            int64_t(seconds) * 1000000000 + (m_nanoseconds ? fraction : fraction * int64_t(1000));
+        record.size = ReadNtohU16(ip + 2);
+        record.protocol = ip[9];
+        record.source = ReadNtohU32(ip + 12);
+        record.destination = ReadNtohU32(ip + 16);
+        return true;
+    }
+    return false;
+}
+
+bool
+HapTraceReader::NextBinary(Record& record)
+{
+    if (m_offset + m_recordSize > m_size)
+    {
+        return false;
+    }
+    const uint8_t* p = m_data + m_offset;
+    std::memcpy(&record.timeNs, p, 8);
+    std::memcpy(&record.source, p + 8, 4);
+    std::memcpy(&record.destination, p + 12, 4);
+    std::memcpy(&record.size, p + 16, 4);
+    record.protocol = p[20];
+    m_offset += m_recordSize;
+    return true;
+}
+
+void
+HapTraceReader::WriteBinary(std::string fileName, const std::vector<Record>& records)
+{
+    std::ofstream file(fileName, std::ios::binary);
+    NS_ABORT_MSG_UNLESS(file.is_open(), "Cannot write trace " << fileName);
+
+    uint32_t reserved = 0;
+    file.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    file.write(reinterpret_cast<const char*>(&BINARY_VERSION), 4);
+    file.write(reinterpret_cast<const char*>(&BINARY_RECORD_SIZE), 4);
+    file.write(reinterpret_cast<const char*>(&reserved), 4);
+
+    for (const Record& record : records)
+    {
+        uint8_t p[BINARY_RECORD_SIZE] = {};
+        std::memcpy(p, &record.timeNs, 8);
+        std::memcpy(p + 8, &record.source, 4);
+        std::memcpy(p + 12, &record.destination, 4);
+        std::memcpy(p + 16, &record.size, 4);
+        p[20] = record.protocol;
+        file.write(reinterpret_cast<const char*>(p), sizeof(p));
+    }
+    NS_ABORT_MSG_UNLESS(file.good(), "Error writing trace " << fileName);
+}
+
+} // namespace ns3
@@ -0,0 +1,145 @@
+#ifndef SIBGU_HAP_HAP_TRACE_READER_H
+#define SIBGU_HAP_HAP_TRACE_READER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Zero-copy sequential reader of packet traces.
+ *
+ * The file is memory-mapped read-only and decoded in place, so traces much
+ * larger than the RAM can be replayed: only the pages around the read
+ * position are resident. Two formats are recognized by their magic number:
+ *
+ * - libpcap captures (micro- or nanosecond timestamps, either byte order)
+ *   with Ethernet, Linux cooked or raw IPv4 link types; non-IPv4 frames are
+ *   skipped;
+ * - compact binary flow traces written by WriteBinary(): a 16-byte header
+ *   ("HTRB", version, record size, reserved) followed by fixed-size records
+ *   in host byte order.
+ */
+class HapTraceReader
+{
+  public:
+    /**
+     * One IPv4 packet of the trace.
+     */
+    struct Record
+    {
+        int64_t timeNs;      //!< capture time, nanoseconds
+        uint32_t source;     //!< IPv4 source address, host byte order
+        uint32_t destination; //!< IPv4 destination address, host byte order
+        uint32_t size;       //!< IPv4 total length, bytes
+        uint8_t protocol;    //!< IP protocol number
+    };
+
+    /// File formats.
+    enum Format
+    {
+        FORMAT_PCAP,
+        FORMAT_BINARY
+    };
+
+    HapTraceReader();
+    ~HapTraceReader();
+
+    HapTraceReader(const HapTraceReader&) = delete;
+    HapTraceReader& operator=(const HapTraceReader&) = delete;
+
+    /**
+     * \brief Map a trace file and detect its format.
+     * \param fileName trace file
+     */
+    void Open(std::string fileName);
+
+    /**
+     * \brief Unmap the file.
+     */
+    void Close();
+
+    /**
+     * \brief Decode the next IPv4 packet.
+     * \param record filled with the packet
+     * \return false at the end of the trace
+     */
+    bool Next(Record& record);
+
+    /**
+     * \brief Decode up to maxRecords packets, appended to batch.
+     * \param batch output records
+     * \param maxRecords maximum number of records
+     * \return number of records appended
+     */
+    uint32_t ReadBatch(std::vector<Record>& batch, uint32_t maxRecords);
+
+    /**
+     * \brief Hint the kernel about the access pattern around the read position.
+     *
+     * Pages before the read position are released and the next lookAhead
+     * bytes are prefetched.
+     *
+     * \param lookAhead prefetch window, bytes
+     */
+    void Advise(uint64_t lookAhead);
+
+    /**
+     * \return format of the open file
+     */
+    Format GetFormat() const;
+
+    /**
+     * \return read position, bytes from the start of the file
+     */
+    uint64_t GetOffset() const;
+
+    /**
+     * \return file size, bytes
+     */
+    uint64_t GetSize() const;
+
+    /**
+     * \brief Write records as a compact binary flow trace.
+     * \param fileName output file
+     * \param records records, in time order
+     */
+    static void WriteBinary(std::string fileName, const std::vector<Record>& records);
+
+  private:
+    /**
+     * \param offset byte offset in the file
+     * \return 32-bit field of the pcap file, converted to host byte order
+     */
+    uint32_t PcapU32(uint64_t offset) const;
+
+    /**
+     * \param record filled with the packet
+     * \return false at the end of the trace
+     */
+    bool NextPcap(Record& record);
+
+    /**
+     * \param record filled with the packet
+     * \return false at the end of the trace
+     */
+    bool NextBinary(Record& record);
+
+    std::string m_fileName;   //!< mapped file
+    const uint8_t* m_data;    //!< mapped file contents
+    uint64_t m_size;          //!< file size
+    uint64_t m_offset;        //!< read position
+    uint64_t m_released;      //!< pages before this offset were released
+    Format m_format;          //!< file format
+    bool m_swapped;           //!< pcap written with the other byte order
+    bool m_nanoseconds;       //!< pcap timestamps in nanoseconds
+    uint32_t m_linkType;      //!< pcap link type
+    uint32_t m_recordSize;    //!< binary record size
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_TRACE_READER_H
@@ -0,0 +1,256 @@
+#include "hap-trace-replay.h"
+
+#include "ns3/abort.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapTraceReplay");
+
+NS_OBJECT_ENSURE_REGISTERED(HapTraceReplay);
+
+namespace
+{
+
+/// IPv4 and UDP header bytes of a replayed packet.
+const uint32_t IP_UDP_HEADER_SIZE = 28;
+
+} // namespace
+
+TypeId
+HapTraceReplay::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapTraceReplay")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapTraceReplay>()
+            .AddAttribute("BatchSize",
+                          "Number of trace records decoded at a time.",
+                          UintegerValue(4096),
+                          MakeUintegerAccessor(&HapTraceReplay::m_batchSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("LookAhead",
+                          "Number of bytes of the trace file prefetched ahead of the read "
+                          "position.",
+                          UintegerValue(16 * 1024 * 1024),
+                          MakeUintegerAccessor(&HapTraceReplay::m_lookAhead),
+                          MakeUintegerChecker<uint64_t>())
+            .AddAttribute("Port",
+                          "Destination UDP port of the replayed packets.",
+                          UintegerValue(9),
+                          MakeUintegerAccessor(&HapTraceReplay::m_port),
+                          MakeUintegerChecker<uint16_t>());
+    return tid;
+}
+
+HapTraceReplay::HapTraceReplay()
+    : m_batchSize(4096),
+      m_lookAhead(16 * 1024 * 1024),
+      m_port(9),
+      m_next(0),
+      m_firstTimeNs(0),
+      m_nSent(0),
+      m_nUnmapped(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapTraceReplay::~HapTraceReplay()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapTraceReplay::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_event.Cancel();
+    m_reader.Close();
+    m_sourceRules.clear();
+    m_destinationRules.clear();
+    m_batch.clear();
+    m_sockets.clear();
+    m_nodeAddresses.clear();
+    m_pool = nullptr;
+    Object::DoDispose();
+}
+
+void
+HapTraceReplay::Open(std::string fileName)
+{
+    NS_LOG_FUNCTION(this << fileName);
+    m_reader.Open(fileName);
+    m_batch.clear();
+    m_next = 0;
+}
+
+void
+HapTraceReplay::AddSourceRule(Ipv4Address network, Ipv4Mask mask, NodeContainer nodes)
+{
+    NS_LOG_FUNCTION(this << network << mask << nodes.GetN());
+    NS_ABORT_MSG_IF(nodes.GetN() == 0, "Empty source rule");
+    m_sourceRules.push_back(Rule{network, mask, nodes});
+}
+
+void
+HapTraceReplay::AddDestinationRule(Ipv4Address network, Ipv4Mask mask, NodeContainer nodes)
+{
+    NS_LOG_FUNCTION(this << network << mask << nodes.GetN());
+    NS_ABORT_MSG_IF(nodes.GetN() == 0, "Empty destination rule");
+    m_destinationRules.push_back(Rule{network, mask, nodes});
+}
+
+void
+HapTraceReplay::Start(Time start)
+{
+    NS_LOG_FUNCTION(this << start);
+    NS_ABORT_MSG_IF(m_sourceRules.empty() || m_destinationRules.empty(),
+                    "Source and destination rules are needed to replay a trace");
+
+    if (!m_pool)
+    {
+        m_pool = HapPayloadPool::GetDefault();
+    }
+    if (!Refill())
+    {
+        NS_LOG_WARN("Empty trace");
+        return;
+    }
+    m_start = start;
+    m_firstTimeNs = m_batch.front().timeNs;
+    m_lastDue = start;
+    m_event = Simulator::Schedule(start - Simulator::Now(), &HapTraceReplay::SendDue, this);
+}
+
+bool
+HapTraceReplay::Refill()
+{
+    m_batch.clear();
+    m_next = 0;
+    m_reader.ReadBatch(m_batch, m_batchSize);
+    m_reader.Advise(m_lookAhead);
+    // Captures are nearly sorted; out-of-order records within a batch are sorted
+    // here, earlier ones across batches are sent without delay
+    std::stable_sort(m_batch.begin(),
+                     m_batch.end(),
+                     [](const HapTraceReader::Record& a, const HapTraceReader::Record& b) {
+                         return a.timeNs < b.timeNs;
+                     });
+    NS_LOG_LOGIC("Decoded " << m_batch.size() << " records, offset " << m_reader.GetOffset()
+                            << " of " << m_reader.GetSize());
+    return !m_batch.empty();
+}
+
+Time
+HapTraceReplay::GetDueTime(const HapTraceReader::Record& record) const
+{
+    return std::max(m_lastDue, m_start + NanoSeconds(record.timeNs - m_firstTimeNs));
+}
+
+void
+HapTraceReplay::SendDue()
+{
+    Time now = Simulator::Now();
+    while (true)
+    {
+        if (m_next == m_batch.size() && !Refill())
+        {
+            NS_LOG_INFO("Trace replay finished: " << m_nSent << " packets sent, " << m_nUnmapped
+                                                  << " records unmapped");
+            return;
+        }
+
+        const HapTraceReader::Record& record = m_batch[m_next];
+        Time due = GetDueTime(record);
+        Ptr<Node> source = Map(m_sourceRules, record.source);
+        Ptr<Node> destination = Map(m_destinationRules, record.destination);
+        if (!source || !destination || source == destination)
+        {
+            ++m_nUnmapped;
+            ++m_next;
+            continue;
+        }
+        // The packets of a node are sent in its context, so the event moves
+        // to the next sender instead of sending on its behalf
+        if (due > now || source->GetId() != Simulator::GetContext())
+        {
+            m_event = Simulator::ScheduleWithContext(source->GetId(),
+                                                     due - now,
+                                                     &HapTraceReplay::SendDue,
+                                                     this);
+            return;
+        }
+        m_lastDue = due;
+        ++m_next;
+
+        auto address = m_nodeAddresses.find(destination->GetId());
+        if (address == m_nodeAddresses.end())
+        {
+            Ptr<Ipv4> ipv4 = destination->GetObject<Ipv4>();
+            NS_ABORT_MSG_UNLESS(ipv4 && ipv4->GetNInterfaces() > 1,
+                                "Node " << destination->GetId() << " has no IPv4 interface");
+            address =
+                m_nodeAddresses.emplace(destination->GetId(), ipv4->GetAddress(1, 0).GetLocal())
+                    .first;
+        }
+
+        uint32_t payload = record.size > IP_UDP_HEADER_SIZE ? record.size - IP_UDP_HEADER_SIZE : 0;
+        GetSocket(source)->SendTo(m_pool->Get(payload),
+                                  0,
+                                  InetSocketAddress(address->second, m_port));
+        ++m_nSent;
+    }
+}
+
+Ptr<Node>
+HapTraceReplay::Map(const std::vector<Rule>& rules, uint32_t address)
+{
+    Ipv4Address ipv4(address);
+    for (const Rule& rule : rules)
+    {
+        if (rule.mask.IsMatch(ipv4, rule.network))
+        {
+            uint32_t host = address & ~rule.mask.Get();
+            return rule.nodes.Get(host % rule.nodes.GetN());
+        }
+    }
+    return nullptr;
+}
+
+Ptr<Socket>
+HapTraceReplay::GetSocket(Ptr<Node> node)
+{
+    auto it = m_sockets.find(node->GetId());
+    if (it == m_sockets.end())
+    {
+        Ptr<Socket> socket = Socket::CreateSocket(node, UdpSocketFactory::GetTypeId());
+        NS_ABORT_MSG_IF(socket->Bind() == -1, "Failed to bind socket on node " << node->GetId());
+        socket->ShutdownRecv();
+        it = m_sockets.emplace(node->GetId(), socket).first;
+    }
+    return it->second;
+}
+
+uint64_t
+HapTraceReplay::GetNSent() const
+{
+    return m_nSent;
+}
+
+uint64_t
+HapTraceReplay::GetNUnmapped() const
+{
+    return m_nUnmapped;
+}
+
+} // namespace ns3
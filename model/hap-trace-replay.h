@@ -0,0 +1,154 @@
+#ifndef SIBGU_HAP_HAP_TRACE_REPLAY_H
+#define SIBGU_HAP_HAP_TRACE_REPLAY_H
+
+#include "hap-payload-pool.h"
+#include "hap-trace-reader.h"
+
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/socket.h"
+
+#include <map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Replays a packet trace between simulated nodes.
+ *
+ * The trace is read with a HapTraceReader, so the file is never loaded in
+ * memory: records are decoded BatchSize at a time, the next LookAhead bytes
+ * of the file are prefetched and the consumed pages are released.
+ *
+ * The addresses of the trace are mapped onto nodes by rules: a record whose
+ * source matches a source rule is sent by one of the nodes of that rule,
+ * chosen by the host part of the address, to the node chosen in the same
+ * way by the first destination rule matching its destination. Records
+ * matching no rule, or whose source and destination map onto the same node,
+ * are skipped. Each packet is a UDP datagram whose IP packet has the size of
+ * the original one.
+ *
+ * Only one event is pending at any time. It runs in the context of the
+ * sending node, sends the records due at its instant as long as they come
+ * from that node, and schedules itself in the context of the next sender.
+ */
+class HapTraceReplay : public Object
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapTraceReplay();
+    ~HapTraceReplay() override;
+
+    /**
+     * \param fileName pcap or compact binary trace
+     */
+    void Open(std::string fileName);
+
+    /**
+     * \brief Map trace sources in a prefix onto nodes.
+     * \param network network address of the prefix
+     * \param mask network mask of the prefix
+     * \param nodes sending nodes, with IPv4
+     */
+    void AddSourceRule(Ipv4Address network, Ipv4Mask mask, NodeContainer nodes);
+
+    /**
+     * \brief Map trace destinations in a prefix onto nodes.
+     * \param network network address of the prefix
+     * \param mask network mask of the prefix
+     * \param nodes receiving nodes, with IPv4
+     */
+    void AddDestinationRule(Ipv4Address network, Ipv4Mask mask, NodeContainer nodes);
+
+    /**
+     * \brief Start the replay: the first record of the trace is sent at start.
+     * \param start simulation time of the first record
+     */
+    void Start(Time start);
+
+    /**
+     * \return number of packets sent
+     */
+    uint64_t GetNSent() const;
+
+    /**
+     * \return number of records skipped, unmapped or mapped onto a single node
+     */
+    uint64_t GetNUnmapped() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * Address mapping rule.
+     */
+    struct Rule
+    {
+        Ipv4Address network; //!< network address
+        Ipv4Mask mask;       //!< network mask
+        NodeContainer nodes; //!< nodes the prefix is mapped onto
+    };
+
+    /**
+     * \param rules rules to search
+     * \param address trace address, host byte order
+     * \return mapped node, null if no rule matches
+     */
+    static Ptr<Node> Map(const std::vector<Rule>& rules, uint32_t address);
+
+    /**
+     * \brief Decode the next batch of records.
+     * \return false at the end of the trace
+     */
+    bool Refill();
+
+    /**
+     * \brief Send the records due now and schedule the next ones.
+     */
+    void SendDue();
+
+    /**
+     * \param record trace record
+     * \return simulation time the record is due at
+     */
+    Time GetDueTime(const HapTraceReader::Record& record) const;
+
+    /**
+     * \param node sending node
+     * \return UDP socket of the node, created on first use
+     */
+    Ptr<Socket> GetSocket(Ptr<Node> node);
+
+    uint32_t m_batchSize;      //!< records decoded at a time
+    uint64_t m_lookAhead;      //!< bytes of the file prefetched
+    uint16_t m_port;           //!< destination UDP port
+    HapTraceReader m_reader;   //!< trace reader
+    std::vector<Rule> m_sourceRules;      //!< source mapping rules
+    std::vector<Rule> m_destinationRules; //!< destination mapping rules
+    std::vector<HapTraceReader::Record> m_batch; //!< decoded records
+    std::size_t m_next;        //!< next record of m_batch
+    Time m_start;              //!< simulation time of the first record
+    int64_t m_firstTimeNs;     //!< trace time of the first record
+    Time m_lastDue;            //!< due time of the last record sent
+    EventId m_event;           //!< pending send event
+    std::map<uint32_t, Ptr<Socket>> m_sockets;        //!< socket per node id
+    std::map<uint32_t, Ipv4Address> m_nodeAddresses; //!< address per node id
+    Ptr<HapPayloadPool> m_pool; //!< payloads
+    uint64_t m_nSent;          //!< packets sent
+    uint64_t m_nUnmapped;      //!< records skipped
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_TRACE_REPLAY_H
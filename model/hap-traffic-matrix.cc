@@ -0,0 +1,398 @@
+#include "hap-traffic-matrix.h"
+
+#include "ns3/abort.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapTrafficMatrix");
+
+NS_OBJECT_ENSURE_REGISTERED(HapDemandProfile);
+NS_OBJECT_ENSURE_REGISTERED(HapTrafficMatrix);
+
+TypeId
+HapDemandProfile::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapDemandProfile")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapDemandProfile>()
+            .AddAttribute("OffTime",
+                          "Duration of the OFF periods between two files, seconds.",
+                          StringValue("ns3::ExponentialRandomVariable[Mean=30.0]"),
+                          MakePointerAccessor(&HapDemandProfile::m_offTime),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("FileSize",
+                          "Size of the files, bytes.",
+                          StringValue("ns3::ParetoRandomVariable[Scale=20000.0|Shape=1.5|"
+                                      "Bound=10000000.0]"),
+                          MakePointerAccessor(&HapDemandProfile::m_fileSize),
+                          MakePointerChecker<RandomVariableStream>())
+            .AddAttribute("DataRate",
+                          "Sending rate during the ON periods.",
+                          DataRateValue(DataRate("2Mbps")),
+                          MakeDataRateAccessor(&HapDemandProfile::m_dataRate),
+                          MakeDataRateChecker())
+            .AddAttribute("PacketSize",
+                          "Payload size of the packets; the last packet of a file may be "
+                          "shorter.",
+                          UintegerValue(1000),
+                          MakeUintegerAccessor(&HapDemandProfile::m_packetSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("DiurnalOffset",
+                          "Time of the diurnal period at simulation time 0.",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&HapDemandProfile::m_diurnalOffset),
+                          MakeTimeChecker());
+    return tid;
+}
+
+HapDemandProfile::HapDemandProfile()
+    : m_packetSize(1000),
+      m_period(Hours(24))
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapDemandProfile::~HapDemandProfile()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapDemandProfile::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_offTime = nullptr;
+    m_fileSize = nullptr;
+    Object::DoDispose();
+}
+
+void
+HapDemandProfile::SetDiurnalProfile(std::vector<double> weights, Time period)
+{
+    NS_LOG_FUNCTION(this << weights.size() << period);
+    NS_ABORT_MSG_IF(!weights.empty() && period.IsZero(), "Diurnal period must be positive");
+    double largest = weights.empty() ? 0 : *std::max_element(weights.begin(), weights.end());
+    NS_ABORT_MSG_IF(!weights.empty() && largest <= 0, "Diurnal profile has no positive weight");
+    for (double& weight : weights)
+    {
+        NS_ABORT_MSG_IF(weight < 0, "Negative diurnal weight");
+        weight /= largest;
+    }
+    m_weights = std::move(weights);
+    m_period = period;
+}
+
+double
+HapDemandProfile::GetRelativeWeight(Time t) const
+{
+    if (m_weights.empty())
+    {
+        return 1;
+    }
+    int64_t period = m_period.GetTimeStep();
+    int64_t phase = (t + m_diurnalOffset).GetTimeStep() % period;
+    if (phase < 0)
+    {
+        phase += period;
+    }
+    auto interval = static_cast<std::size_t>(static_cast<double>(phase) / period *
+                                             m_weights.size());
+    return m_weights[std::min(interval, m_weights.size() - 1)];
+}
+
+Time
+HapDemandProfile::GetOffTime() const
+{
+    return Seconds(m_offTime->GetValue());
+}
+
+uint64_t
+HapDemandProfile::GetFileSize() const
+{
+    return std::max<uint64_t>(1, std::llround(m_fileSize->GetValue()));
+}
+
+DataRate
+HapDemandProfile::GetDataRate() const
+{
+    return m_dataRate;
+}
+
+uint32_t
+HapDemandProfile::GetPacketSize() const
+{
+    return m_packetSize;
+}
+
+int64_t
+HapDemandProfile::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+    m_offTime->SetStream(stream);
+    m_fileSize->SetStream(stream + 1);
+    return 2;
+}
+
+TypeId
+HapTrafficMatrix::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapTrafficMatrix")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapTrafficMatrix>()
+            .AddAttribute("Port",
+                          "Destination UDP port on the sinks.",
+                          UintegerValue(9),
+                          MakeUintegerAccessor(&HapTrafficMatrix::m_port),
+                          MakeUintegerChecker<uint16_t>())
+            .AddTraceSource("Tx",
+                            "A packet has been sent by a user.",
+                            MakeTraceSourceAccessor(&HapTrafficMatrix::m_txTrace),
+                            "ns3::HapTrafficMatrix::TxTracedCallback");
+    return tid;
+}
+
+HapTrafficMatrix::HapTrafficMatrix()
+    : m_port(9),
+      m_nFiles(0),
+      m_nPackets(0),
+      m_nBytes(0)
+{
+    NS_LOG_FUNCTION(this);
+    m_thinning = CreateObject<UniformRandomVariable>();
+}
+
+HapTrafficMatrix::~HapTrafficMatrix()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapTrafficMatrix::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    for (User& user : m_users)
+    {
+        user.event.Cancel();
+    }
+    m_users.clear();
+    m_profiles.clear();
+    m_sockets.clear();
+    m_thinning = nullptr;
+    m_pool = nullptr;
+    Object::DoDispose();
+}
+
+uint32_t
+HapTrafficMatrix::AddDemand(NodeContainer sources,
+                            NodeContainer sinks,
+                            uint32_t usersPerSource,
+                            Ptr<HapDemandProfile> profile)
+{
+    NS_LOG_FUNCTION(this << sources.GetN() << sinks.GetN() << usersPerSource);
+    NS_ABORT_MSG_IF(sinks.GetN() == 0, "Demand without sinks");
+    NS_ABORT_MSG_UNLESS(profile, "Demand without profile");
+
+    auto profileIndex = static_cast<uint32_t>(m_profiles.size());
+    m_profiles.push_back(profile);
+
+    std::vector<uint32_t> sinkIndices;
+    for (auto it = sinks.Begin(); it != sinks.End(); ++it)
+    {
+        sinkIndices.push_back(GetSinkAddress(*it));
+    }
+
+    auto first = static_cast<uint32_t>(m_users.size());
+    m_users.reserve(m_users.size() + std::size_t(sources.GetN()) * usersPerSource);
+    uint32_t k = 0;
+    for (auto it = sources.Begin(); it != sources.End(); ++it)
+    {
+        uint32_t socket = GetSocket(*it);
+        for (uint32_t i = 0; i < usersPerSource; ++i, ++k)
+        {
+            m_users.push_back(
+                User{profileIndex, socket, sinkIndices[k % sinkIndices.size()], 0, EventId()});
+        }
+    }
+    return first;
+}
+
+void
+HapTrafficMatrix::Start(Time start, Time stop)
+{
+    NS_LOG_FUNCTION(this << start << stop);
+    m_stop = stop;
+    if (!m_pool)
+    {
+        m_pool = HapPayloadPool::GetDefault();
+    }
+    Time delay = start - Simulator::Now();
+    for (uint32_t user = 0; user < m_users.size(); ++user)
+    {
+        // The OFF periods are memoryless by default, so starting every user
+        // in an OFF period does not synchronize the first requests
+        Time due = delay + m_profiles[m_users[user].profile]->GetOffTime();
+        if (Simulator::Now() + due < m_stop)
+        {
+            m_users[user].event = Simulator::ScheduleWithContext(GetContext(user),
+                                                                 due,
+                                                                 &HapTrafficMatrix::Request,
+                                                                 this,
+                                                                 user);
+        }
+    }
+}
+
+void
+HapTrafficMatrix::ScheduleRequest(uint32_t user)
+{
+    Time due = m_profiles[m_users[user].profile]->GetOffTime();
+    if (Simulator::Now() + due < m_stop)
+    {
+        m_users[user].event = Simulator::ScheduleWithContext(GetContext(user),
+                                                             due,
+                                                             &HapTrafficMatrix::Request,
+                                                             this,
+                                                             user);
+    }
+}
+
+void
+HapTrafficMatrix::Request(uint32_t user)
+{
+    User& state = m_users[user];
+    const Ptr<HapDemandProfile>& profile = m_profiles[state.profile];
+    if (m_thinning->GetValue() >= profile->GetRelativeWeight(Simulator::Now()))
+    {
+        ScheduleRequest(user);
+        return;
+    }
+    state.remaining = profile->GetFileSize();
+    ++m_nFiles;
+    NS_LOG_LOGIC("User " << user << " requests " << state.remaining << " bytes");
+    SendPacket(user);
+}
+
+void
+HapTrafficMatrix::SendPacket(uint32_t user)
+{
+    User& state = m_users[user];
+    const Ptr<HapDemandProfile>& profile = m_profiles[state.profile];
+
+    auto size =
+        static_cast<uint32_t>(std::min<uint64_t>(profile->GetPacketSize(), state.remaining));
+    Ptr<Packet> packet = m_pool->Get(size);
+    m_sockets[state.socket]->SendTo(packet, 0, m_sinkAddresses[state.sink]);
+    m_txTrace(packet, user);
+    state.remaining -= size;
+    ++m_nPackets;
+    m_nBytes += size;
+
+    if (state.remaining == 0)
+    {
+        ScheduleRequest(user);
+        return;
+    }
+    Time due = profile->GetDataRate().CalculateBytesTxTime(size);
+    if (Simulator::Now() + due < m_stop)
+    {
+        state.event = Simulator::ScheduleWithContext(GetContext(user),
+                                                     due,
+                                                     &HapTrafficMatrix::SendPacket,
+                                                     this,
+                                                     user);
+    }
+}
+
+uint32_t
+HapTrafficMatrix::GetSocket(Ptr<Node> node)
+{
+    auto it = m_socketIndex.find(node->GetId());
+    if (it == m_socketIndex.end())
+    {
+        Ptr<Socket> socket = Socket::CreateSocket(node, UdpSocketFactory::GetTypeId());
+        NS_ABORT_MSG_IF(socket->Bind() == -1, "Failed to bind socket on node " << node->GetId());
+        socket->ShutdownRecv();
+        it = m_socketIndex.emplace(node->GetId(), m_sockets.size()).first;
+        m_sockets.push_back(socket);
+    }
+    return it->second;
+}
+
+uint32_t
+HapTrafficMatrix::GetContext(uint32_t user) const
+{
+    // Events of a user run in its node context, like those of an application
+    return m_sockets[m_users[user].socket]->GetNode()->GetId();
+}
+
+uint32_t
+HapTrafficMatrix::GetSinkAddress(Ptr<Node> node)
+{
+    auto it = m_sinkIndex.find(node->GetId());
+    if (it == m_sinkIndex.end())
+    {
+        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+        NS_ABORT_MSG_UNLESS(ipv4 && ipv4->GetNInterfaces() > 1,
+                            "Sink node " << node->GetId() << " has no IPv4 interface");
+        it = m_sinkIndex.emplace(node->GetId(), m_sinkAddresses.size()).first;
+        m_sinkAddresses.emplace_back(
+            InetSocketAddress(ipv4->GetAddress(1, 0).GetLocal(), m_port));
+    }
+    return it->second;
+}
+
+int64_t
+HapTrafficMatrix::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+    int64_t used = 0;
+    m_thinning->SetStream(stream + used++);
+    for (const Ptr<HapDemandProfile>& profile : m_profiles)
+    {
+        used += profile->AssignStreams(stream + used);
+    }
+    return used;
+}
+
+uint32_t
+HapTrafficMatrix::GetNUsers() const
+{
+    return m_users.size();
+}
+
+uint64_t
+HapTrafficMatrix::GetNFiles() const
+{
+    return m_nFiles;
+}
+
+uint64_t
+HapTrafficMatrix::GetNPackets() const
+{
+    return m_nPackets;
+}
+
+uint64_t
+HapTrafficMatrix::GetNBytes() const
+{
+    return m_nBytes;
+}
+
+} // namespace ns3
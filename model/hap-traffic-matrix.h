@@ -0,0 +1,255 @@
+#ifndef SIBGU_HAP_HAP_TRAFFIC_MATRIX_H
+#define SIBGU_HAP_HAP_TRAFFIC_MATRIX_H
+
+#include "hap-payload-pool.h"
+
+#include "ns3/address.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/socket.h"
+#include "ns3/traced-callback.h"
+
+#include <map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Demand of a population of users, e.g. the users of a beam or of a HAP.
+ *
+ * Each user alternates between OFF periods, drawn from OffTime (exponential,
+ * so file requests form a Poisson process), and ON periods in which a file of
+ * FileSize bytes (Pareto, heavy-tailed) is sent at DataRate in PacketSize
+ * packets.
+ *
+ * An optional diurnal profile scales the request rate: the period is split
+ * in as many equal intervals as the profile has weights, and requests are
+ * thinned by the weight of the current interval relative to the largest one.
+ */
+class HapDemandProfile : public Object
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapDemandProfile();
+    ~HapDemandProfile() override;
+
+    /**
+     * \param weights relative request rate of each interval of the period
+     * \param period profile period, typically one day
+     */
+    void SetDiurnalProfile(std::vector<double> weights, Time period = Hours(24));
+
+    /**
+     * \param t simulation time
+     * \return weight at t relative to the largest one, in [0, 1]
+     */
+    double GetRelativeWeight(Time t) const;
+
+    /**
+     * \return duration of the next OFF period
+     */
+    Time GetOffTime() const;
+
+    /**
+     * \return size of the next file, bytes, at least 1
+     */
+    uint64_t GetFileSize() const;
+
+    /**
+     * \return sending rate during ON periods
+     */
+    DataRate GetDataRate() const;
+
+    /**
+     * \return size of the packets
+     */
+    uint32_t GetPacketSize() const;
+
+    /**
+     * \brief Assign fixed random variable streams.
+     * \param stream first stream index to use
+     * \return number of stream indices used
+     */
+    int64_t AssignStreams(int64_t stream);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    Ptr<RandomVariableStream> m_offTime;  //!< OFF period duration, seconds
+    Ptr<RandomVariableStream> m_fileSize; //!< file size, bytes
+    DataRate m_dataRate;                  //!< ON rate
+    uint32_t m_packetSize;                //!< packet size
+    Time m_diurnalOffset;                 //!< time of the period at simulation time 0
+    Time m_period;                        //!< diurnal period
+    std::vector<double> m_weights;        //!< diurnal weights, normalized to the largest
+};
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Lazy traffic generator for large user populations.
+ *
+ * Demands attach a number of users to each source node and spread them over
+ * sink nodes. Users are plain records, not applications: a source node has
+ * one UDP socket shared by all its users, and each user has at most one
+ * pending simulator event, either its next file request or its next packet.
+ * Setting up thousands of users is therefore cheap in memory and events.
+ *
+ * The sinks are addressed at the first address of their first IPv4 interface
+ * and are expected to listen on Port.
+ */
+class HapTrafficMatrix : public Object
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapTrafficMatrix();
+    ~HapTrafficMatrix() override;
+
+    /**
+     * \brief Add users.
+     *
+     * Each source node gets usersPerSource users; the users are assigned to
+     * the sinks round-robin.
+     *
+     * \param sources nodes the users send from, with IPv4
+     * \param sinks nodes the users send to, with IPv4
+     * \param usersPerSource number of users per source node
+     * \param profile demand of the users
+     * \return id of the first user added; ids are consecutive
+     */
+    uint32_t AddDemand(NodeContainer sources,
+                       NodeContainer sinks,
+                       uint32_t usersPerSource,
+                       Ptr<HapDemandProfile> profile);
+
+    /**
+     * \brief Schedule the first request of every user.
+     * \param start earliest time of the first requests
+     * \param stop no packet is sent from this time on
+     */
+    void Start(Time start, Time stop);
+
+    /**
+     * \brief Assign fixed random variable streams to the demand profiles.
+     * \param stream first stream index to use
+     * \return number of stream indices used
+     */
+    int64_t AssignStreams(int64_t stream);
+
+    /**
+     * \return number of users
+     */
+    uint32_t GetNUsers() const;
+
+    /**
+     * \return number of files requested so far
+     */
+    uint64_t GetNFiles() const;
+
+    /**
+     * \return number of packets sent so far
+     */
+    uint64_t GetNPackets() const;
+
+    /**
+     * \return number of payload bytes sent so far
+     */
+    uint64_t GetNBytes() const;
+
+    /**
+     * TracedCallback signature for packets sent by a user.
+     *
+     * \param [in] packet the packet
+     * \param [in] user user id
+     */
+    typedef void (*TxTracedCallback)(Ptr<const Packet> packet, uint32_t user);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * State of a user.
+     */
+    struct User
+    {
+        uint32_t profile;   //!< index in m_profiles
+        uint32_t socket;    //!< index in m_sockets
+        uint32_t sink;      //!< index in m_sinkAddresses
+        uint64_t remaining; //!< bytes left in the current file, 0 when OFF
+        EventId event;      //!< pending event
+    };
+
+    /**
+     * \brief Request a file, unless thinned out by the diurnal profile.
+     * \param user user id
+     */
+    void Request(uint32_t user);
+
+    /**
+     * \brief Send the next packet of the current file.
+     * \param user user id
+     */
+    void SendPacket(uint32_t user);
+
+    /**
+     * \brief Schedule the next request of a user after an OFF period.
+     * \param user user id
+     */
+    void ScheduleRequest(uint32_t user);
+
+    /**
+     * \param node source node
+     * \return index of the socket of the node, created on first use
+     */
+    uint32_t GetSocket(Ptr<Node> node);
+
+    /**
+     * \param user user id
+     * \return id of the source node of the user, context of its events
+     */
+    uint32_t GetContext(uint32_t user) const;
+
+    /**
+     * \param node sink node
+     * \return index of the address of the node, added on first use
+     */
+    uint32_t GetSinkAddress(Ptr<Node> node);
+
+    uint16_t m_port;                             //!< destination UDP port
+    Time m_stop;                                 //!< end of the traffic
+    std::vector<User> m_users;                   //!< users
+    std::vector<Ptr<HapDemandProfile>> m_profiles; //!< demand profiles
+    std::vector<Ptr<Socket>> m_sockets;          //!< source sockets
+    std::map<uint32_t, uint32_t> m_socketIndex;  //!< socket index by node id
+    std::vector<Address> m_sinkAddresses;        //!< sink socket addresses
+    std::map<uint32_t, uint32_t> m_sinkIndex;    //!< sink address index by node id
+    Ptr<UniformRandomVariable> m_thinning;       //!< diurnal thinning
+    Ptr<HapPayloadPool> m_pool;                  //!< payloads
+    uint64_t m_nFiles;                           //!< files requested
+    uint64_t m_nPackets;                         //!< packets sent
+    uint64_t m_nBytes;                           //!< bytes sent
+
+    /// Trace of the packets sent.
+    TracedCallback<Ptr<const Packet>, uint32_t> m_txTrace;
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_TRAFFIC_MATRIX_H
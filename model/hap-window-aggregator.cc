@@ -0,0 +1,234 @@
+#include "hap-window-aggregator.h"
+
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("HapWindowAggregator");
+
+NS_OBJECT_ENSURE_REGISTERED(HapWindowAggregator);
+
+TypeId
+HapWindowAggregator::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::HapWindowAggregator")
+            .SetParent<Object>()
+            .SetGroupName("SibguHap")
+            .AddConstructor<HapWindowAggregator>()
+            .AddAttribute("Window",
+                          "Length of the aggregation windows",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&HapWindowAggregator::m_window),
+                          MakeTimeChecker(TimeStep(1)))
+            .AddAttribute("Statistic",
+                          "Value written for each window",
+                          EnumValue(HapWindowAggregator::RATE),
+                          MakeEnumAccessor<Statistic>(&HapWindowAggregator::m_statistic),
+                          MakeEnumChecker(HapWindowAggregator::SUM,
+                                          "Sum",
+                                          HapWindowAggregator::MEAN,
+                                          "Mean",
+                                          HapWindowAggregator::MIN,
+                                          "Min",
+                                          HapWindowAggregator::MAX,
+                                          "Max",
+                                          HapWindowAggregator::COUNT,
+                                          "Count",
+                                          HapWindowAggregator::RATE,
+                                          "Rate"))
+            .AddAttribute("Raw",
+                          "Write every sample instead of one point per window",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&HapWindowAggregator::m_raw),
+                          MakeBooleanChecker());
+    return tid;
+}
+
+HapWindowAggregator::HapWindowAggregator()
+    : m_window(Seconds(1)),
+      m_statistic(RATE),
+      m_raw(false),
+      m_nSamples(0),
+      m_nPoints(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HapWindowAggregator::~HapWindowAggregator()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+HapWindowAggregator::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_writer)
+    {
+        Flush();
+    }
+    m_writer = nullptr;
+    m_series.clear();
+    m_byName.clear();
+    Object::DoDispose();
+}
+
+void
+HapWindowAggregator::SetWriter(Ptr<HapScatterFileWriter> writer)
+{
+    NS_LOG_FUNCTION(this << writer);
+    NS_ABORT_MSG_UNLESS(m_series.empty(), "Writer must be set before the series are added");
+    m_writer = writer;
+}
+
+uint32_t
+HapWindowAggregator::AddSeries(std::string name, const HapScatterFileWriter::Metadata& metadata)
+{
+    NS_LOG_FUNCTION(this << name);
+    NS_ABORT_MSG_UNLESS(m_writer, "No scatter file writer");
+
+    HapScatterFileWriter::Metadata windowMetadata = metadata;
+    if (!m_raw)
+    {
+        static const char* names[] = {"sum", "mean", "min", "max", "count", "rate"};
+        windowMetadata["window"] = std::to_string(m_window.GetSeconds()) + " s";
+        windowMetadata["statistic"] = names[m_statistic];
+    }
+
+    uint32_t index = m_series.size();
+    m_series.push_back({m_writer->AddSeries(name, windowMetadata), -1, 0, 0, 0, 0});
+    m_byName.emplace(name, index);
+    return index;
+}
+
+void
+HapWindowAggregator::Add(uint32_t series, double value)
+{
+    Add(series, Simulator::Now(), value);
+}
+
+void
+HapWindowAggregator::Add(uint32_t series, Time time, double value)
+{
+    NS_ASSERT_MSG(series < m_series.size(), "Unknown series " << series);
+    ++m_nSamples;
+    Series& s = m_series[series];
+    if (m_raw)
+    {
+        m_writer->Write(s.output, time.GetSeconds(), value);
+        ++m_nPoints;
+        return;
+    }
+
+    int64_t window = time.GetTimeStep() / m_window.GetTimeStep();
+    if (window != s.window)
+    {
+        NS_ASSERT_MSG(window > s.window, "Samples of a series must be in time order");
+        int64_t last = s.window;
+        Close(s, GetEnd(last));
+        if (last >= 0 && (m_statistic == SUM || m_statistic == COUNT || m_statistic == RATE))
+        {
+            for (int64_t empty = last + 1; empty < window; ++empty)
+            {
+                Emit(s, GetEnd(empty), 0);
+            }
+        }
+        s.window = window;
+        s.min = value;
+        s.max = value;
+    }
+    s.sum += value;
+    s.min = std::min(s.min, value);
+    s.max = std::max(s.max, value);
+    ++s.count;
+}
+
+void
+HapWindowAggregator::Write2d(std::string context, double time, double value)
+{
+    auto it = m_byName.find(context);
+    uint32_t series = it != m_byName.end() ? it->second : AddSeries(context);
+    Add(series, Seconds(time), value);
+}
+
+void
+HapWindowAggregator::Flush()
+{
+    NS_LOG_FUNCTION(this);
+    for (Series& series : m_series)
+    {
+        // The run may end within the open window, which is then shortened
+        Time start = TimeStep(m_window.GetTimeStep() * series.window);
+        Time now = Simulator::Now();
+        Close(series, now > start && now < start + m_window ? now : start + m_window);
+    }
+}
+
+uint64_t
+HapWindowAggregator::GetNSamples() const
+{
+    return m_nSamples;
+}
+
+uint64_t
+HapWindowAggregator::GetNPoints() const
+{
+    return m_nPoints;
+}
+
+void
+HapWindowAggregator::Close(Series& series, Time end)
+{
+    if (series.count > 0)
+    {
+        switch (m_statistic)
+        {
+        case SUM:
+            Emit(series, end, series.sum);
+            break;
+        case MEAN:
+            Emit(series, end, series.sum / series.count);
+            break;
+        case MIN:
+            Emit(series, end, series.min);
+            break;
+        case MAX:
+            Emit(series, end, series.max);
+            break;
+        case COUNT:
+            Emit(series, end, series.count);
+            break;
+        case RATE: {
+            Time start = TimeStep(m_window.GetTimeStep() * series.window);
+            Emit(series, end, series.sum / (end - start).GetSeconds());
+            break;
+        }
+        }
+    }
+    series.window = -1;
+    series.sum = 0;
+    series.count = 0;
+}
+
+Time
+HapWindowAggregator::GetEnd(int64_t window) const
+{
+    return TimeStep(m_window.GetTimeStep() * (window + 1));
+}
+
+void
+HapWindowAggregator::Emit(const Series& series, Time time, double value)
+{
+    m_writer->Write(series.output, time.GetSeconds(), value);
+    ++m_nPoints;
+}
+
+} // namespace ns3
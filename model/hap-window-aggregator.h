@@ -0,0 +1,174 @@
+#ifndef SIBGU_HAP_HAP_WINDOW_AGGREGATOR_H
+#define SIBGU_HAP_HAP_WINDOW_AGGREGATOR_H
+
+#include "hap-scatter-file.h"
+
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup sibgu-hap
+ * \brief Reduces per-event samples to one point per time window.
+ *
+ * Samples are accumulated per series over windows of Window, aligned on
+ * time 0, and one point per window is written to a HapScatterFileWriter,
+ * at the end time of the window. The output therefore grows with the run
+ * length over Window instead of with the number of samples. A window is
+ * written when the first sample of a later window arrives, or by Flush().
+ * If the simulation time at Flush() falls within the open window, that
+ * window is cut there: its point is written at the current time and its
+ * rate computed over the elapsed part only.
+ *
+ * Statistic selects the value written: sum, mean, minimum, maximum, count
+ * of the samples, or their sum per second (rate, e.g. bits into bps). For
+ * sum, count and rate, empty windows between two samples are written as
+ * zeros; for the others they are skipped.
+ *
+ * With Raw set every sample is written as is, at its own time.
+ *
+ * The aggregator is fed by trace sinks, with Add(), or by any data
+ * collection object whose output is connected to Write2d(). SatStatsHelper
+ * creates its own file aggregators internally and offers no way to replace
+ * them, so the SNS3 statistics cannot be routed through it; hap-sat-hap
+ * instead feeds the per-UT IP Rx throughput from the Ipv4L3Protocol Rx
+ * trace and writes it next to the SNS3 files, for ext-utils/genreport.py.
+ */
+class HapWindowAggregator : public Object
+{
+  public:
+    /// Value written for each window.
+    enum Statistic
+    {
+        SUM,
+        MEAN,
+        MIN,
+        MAX,
+        COUNT,
+        RATE
+    };
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    HapWindowAggregator();
+    ~HapWindowAggregator() override;
+
+    /**
+     * \param writer file the windows are written to
+     */
+    void SetWriter(Ptr<HapScatterFileWriter> writer);
+
+    /**
+     * \brief Declare a series, also declared in the writer.
+     * \param name series name
+     * \param metadata series metadata; window and statistic are added to it
+     * \return series index for Add()
+     */
+    uint32_t AddSeries(std::string name,
+                       const HapScatterFileWriter::Metadata& metadata =
+                           HapScatterFileWriter::Metadata());
+
+    /**
+     * \brief Add a sample at the current simulation time.
+     * \param series index returned by AddSeries()
+     * \param value sample
+     */
+    void Add(uint32_t series, double value);
+
+    /**
+     * \brief Add a sample.
+     * \param series index returned by AddSeries()
+     * \param time sample time, not earlier than the previous sample of the series
+     * \param value sample
+     */
+    void Add(uint32_t series, Time time, double value);
+
+    /**
+     * \brief Add a sample to the series named by a trace context.
+     *
+     * Same signature as HapScatterFileWriter::Write2d(); the series is
+     * created on first use.
+     *
+     * \param context series name
+     * \param time sample time, seconds
+     * \param value sample
+     */
+    void Write2d(std::string context, double time, double value);
+
+    /**
+     * \brief Write the open window of every series.
+     *
+     * Called on dispose, which must therefore happen before the writer is
+     * closed.
+     */
+    void Flush();
+
+    /**
+     * \return number of samples added
+     */
+    uint64_t GetNSamples() const;
+
+    /**
+     * \return number of points written
+     */
+    uint64_t GetNPoints() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /// Open window of a series.
+    struct Series
+    {
+        uint32_t output; //!< writer series index
+        int64_t window;  //!< open window number, -1 if none
+        double sum;      //!< sum of the samples
+        double min;      //!< smallest sample
+        double max;      //!< largest sample
+        uint64_t count;  //!< number of samples
+    };
+
+    /**
+     * \brief Write the open window of a series and close it.
+     * \param series the series
+     * \param end end of the part of the window covered, time of the point
+     */
+    void Close(Series& series, Time end);
+
+    /**
+     * \param window window number
+     * \return end time of the window
+     */
+    Time GetEnd(int64_t window) const;
+
+    /**
+     * \brief Write a window point.
+     * \param series the series
+     * \param time point time
+     * \param value point value
+     */
+    void Emit(const Series& series, Time time, double value);
+
+    Time m_window;                                      //!< window length
+    Statistic m_statistic;                              //!< value written per window
+    bool m_raw;                                         //!< write samples as is
+    Ptr<HapScatterFileWriter> m_writer;                 //!< output file
+    std::vector<Series> m_series;                       //!< series by index
+    std::unordered_map<std::string, uint32_t> m_byName; //!< series index by name
+    uint64_t m_nSamples;                                //!< samples added
+    uint64_t m_nPoints;                                 //!< points written
+};
+
+} // namespace ns3
+
+#endif // SIBGU_HAP_HAP_WINDOW_AGGREGATOR_H
@@ -1,9 +1,72 @@
 
 // Include a header file from your module to test.
+#include "ns3/hap-animation-recorder.h"
+#include "ns3/hap-beam-set-helper.h"
+#include "ns3/hap-cached-propagation-loss-model.h"
+#include "ns3/hap-cbr-source.h"
+#include "ns3/hap-contact-plan.h"
+#include "ns3/hap-gateway-association-index.h"
+#include "ns3/hap-geometry-rate-manager.h"
+#include "ns3/hap-geometry.h"
+#include "ns3/hap-handover-scheduler.h"
+#include "ns3/hap-isl-shortest-paths.h"
+#include "ns3/hap-kd-tree.h"
+#include "ns3/hap-lazy-beam-manager.h"
+#include "ns3/hap-nearest-orbiter-index.h"
+#include "ns3/hap-payload-pool.h"
+#include "ns3/hap-range-transmit-filter.h"
+#include "ns3/hap-sat-link-helper.h"
+#include "ns3/hap-sat-link-net-device.h"
+#include "ns3/hap-scatter-file.h"
+#include "ns3/hap-scenario-source.h"
+#include "ns3/hap-scheduled-routing-helper.h"
+#include "ns3/hap-telemetry-publisher.h"
+#include "ns3/hap-trace-context.h"
+#include "ns3/hap-trace-reader.h"
+#include "ns3/hap-traffic-matrix.h"
+#include "ns3/hap-wifi-aggregation-helper.h"
+#include "ns3/hap-wifi-range-helper.h"
+#include "ns3/hap-window-aggregator.h"
 #include "ns3/sibgu-hap.h"
 
 // An essential include is test.h
+#include "ns3/boolean.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/half-duplex-ideal-phy.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-list-routing-helper.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/pointer.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/spectrum-signal-parameters.h"
+#include "ns3/string.h"
+#include "ns3/system-path.h"
 #include "ns3/test.h"
+#include "ns3/uinteger.h"
+#include "ns3/wifi-helper.h"
+#include "ns3/wifi-mac-helper.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/yans-wifi-helper.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <vector>
 
 // Do not put your test classes in namespace ns3.  You may find it useful
 // to use the using directive to access the ns3 namespace directly
@@ -57,6 +120,2016 @@ SibguHapTestCase1::DoRun()
     NS_TEST_ASSERT_MSG_EQ_TOL(0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+/**
+ * \ingroup sibgu-hap-tests
+ * Contact plan queries and binary round trip
+ */
+class HapContactPlanTestCase : public TestCase
+{
+  public:
+    HapContactPlanTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapContactPlanTestCase::HapContactPlanTestCase()
+    : TestCase("Contact plan intervals, rankings and file round trip")
+{
+}
+
+void
+HapContactPlanTestCase::DoRun()
+{
+    Ptr<HapContactPlan> plan = CreateObject<HapContactPlan>();
+    plan->Reset(3, 2, Seconds(0), Seconds(1));
+    uint32_t ut = plan->AddObserver(7, HapContactPlan::ROLE_UT);
+    uint32_t hap = plan->AddObserver(9, HapContactPlan::ROLE_HAP);
+    plan->AddInterval(ut, 0, Seconds(0), Seconds(10));
+    plan->AddInterval(ut, 2, Seconds(5), Seconds(20));
+    plan->AddInterval(ut, 2, Seconds(30), Seconds(40));
+    plan->AddInterval(hap, 1, Seconds(0), Seconds(100));
+    plan->AddRankingEpoch(ut, Seconds(0), {0});
+    plan->AddRankingEpoch(ut, Seconds(5), {0, 2});
+    plan->AddRankingEpoch(ut, Seconds(10), {2});
+    plan->AddRankingEpoch(hap, Seconds(0), {1});
+
+    std::string fileName = CreateTempDirFilename("contact-plan.bin");
+    plan->Save(fileName);
+
+    Ptr<HapContactPlan> loaded = CreateObject<HapContactPlan>();
+    loaded->Load(fileName);
+
+    NS_TEST_ASSERT_MSG_EQ(loaded->GetNObservers(), 2, "Wrong number of observers");
+    NS_TEST_ASSERT_MSG_EQ(loaded->GetNOrbiters(), 3, "Wrong number of orbiters");
+    uint32_t loadedUt = loaded->GetObserverIndex(7);
+    NS_TEST_ASSERT_MSG_EQ(loaded->GetObserverRole(loadedUt), HapContactPlan::ROLE_UT, "Wrong role");
+    NS_TEST_ASSERT_MSG_EQ(loaded->IsVisible(loadedUt, 2, Seconds(4)), false, "Not visible yet");
+    NS_TEST_ASSERT_MSG_EQ(loaded->IsVisible(loadedUt, 2, Seconds(5)), true, "Interval start");
+    NS_TEST_ASSERT_MSG_EQ(loaded->IsVisible(loadedUt, 2, Seconds(20)), false, "Interval end");
+    NS_TEST_ASSERT_MSG_EQ(loaded->IsVisible(loadedUt, 2, Seconds(35)), true, "Second interval");
+    NS_TEST_ASSERT_MSG_EQ(loaded->GetVisibleOrbiters(loadedUt, Seconds(7)).size(), 2, "Visible set");
+    NS_TEST_ASSERT_MSG_EQ(loaded->GetRanking(loadedUt, Seconds(7)).size(), 2, "Ranking size");
+    NS_TEST_ASSERT_MSG_EQ(loaded->GetRanking(loadedUt, Seconds(12)).front(), 2, "Ranking head");
+    NS_TEST_ASSERT_MSG_EQ(loaded->GetNextRankingChange(loadedUt, Seconds(5)),
+                          Seconds(10),
+                          "Next ranking change");
+    NS_TEST_ASSERT_MSG_EQ(loaded->GetNextRankingChange(loadedUt, Seconds(10)),
+                          Time::Max(),
+                          "No further ranking change");
+    NS_TEST_ASSERT_MSG_EQ(loaded->GetNextContactBoundary(loadedUt, Seconds(12)),
+                          Seconds(20),
+                          "Next contact boundary");
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * k-d tree nearest orbiters must match a brute-force scan
+ */
+class HapKdTreeTestCase : public TestCase
+{
+  public:
+    HapKdTreeTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapKdTreeTestCase::HapKdTreeTestCase()
+    : TestCase("k-d tree k-closest equals brute force")
+{
+}
+
+void
+HapKdTreeTestCase::DoRun()
+{
+    Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+    rng->SetStream(1);
+
+    std::vector<Vector> orbiters;
+    for (uint32_t i = 0; i < 351; ++i)
+    {
+        orbiters.emplace_back(rng->GetValue(-8e6, 8e6),
+                              rng->GetValue(-8e6, 8e6),
+                              rng->GetValue(-8e6, 8e6));
+    }
+    // Duplicated positions exercise the tie-break on satId
+    orbiters.push_back(orbiters[10]);
+    orbiters.push_back(orbiters[20]);
+
+    HapKdTree tree;
+    tree.Build(orbiters);
+
+    std::vector<uint32_t> result;
+    for (uint32_t q = 0; q < 500; ++q)
+    {
+        Vector query = (q % 10 == 0) ? orbiters[q % orbiters.size()]
+                                     : Vector(rng->GetValue(-7e6, 7e6),
+                                              rng->GetValue(-7e6, 7e6),
+                                              rng->GetValue(-7e6, 7e6));
+        uint32_t k = 1 + q % 4;
+        tree.FindKClosest(query, k, result);
+        std::vector<uint32_t> expected = HapKdTree::FindKClosestBruteForce(orbiters, query, k);
+        NS_TEST_ASSERT_MSG_EQ((result == expected), true, "k-d tree differs from brute force");
+    }
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Handover triggers fire once per ranking change, optionally on a check grid
+ */
+class HapHandoverSchedulerTestCase : public TestCase
+{
+  public:
+    HapHandoverSchedulerTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Run the scheduler over a small contact plan.
+     * \param checkPeriod CheckPeriod attribute
+     * \param nEvaluations filled with the number of evaluations
+     */
+    void RunScheduler(Time checkPeriod, uint64_t& nEvaluations);
+
+    /**
+     * HandoverTrigger sink.
+     * \param nodeId node id
+     * \param satIds new ranking
+     */
+    void Trigger(uint32_t nodeId, const std::vector<uint32_t>& satIds);
+
+    std::vector<Time> m_triggers;                  //!< instants of the triggers
+    std::vector<std::vector<uint32_t>> m_rankings; //!< rankings of the triggers
+};
+
+HapHandoverSchedulerTestCase::HapHandoverSchedulerTestCase()
+    : TestCase("Handover scheduler triggers only on ranking changes")
+{
+}
+
+void
+HapHandoverSchedulerTestCase::Trigger(uint32_t nodeId, const std::vector<uint32_t>& satIds)
+{
+    m_triggers.push_back(Simulator::Now());
+    m_rankings.push_back(satIds);
+}
+
+void
+HapHandoverSchedulerTestCase::RunScheduler(Time checkPeriod, uint64_t& nEvaluations)
+{
+    NodeContainer uts;
+    uts.Create(1);
+
+    Ptr<HapContactPlan> plan = CreateObject<HapContactPlan>();
+    plan->Reset(4, 3, Seconds(0), Seconds(1));
+    uint32_t ut = plan->AddObserver(uts.Get(0)->GetId(), HapContactPlan::ROLE_UT);
+    plan->AddRankingEpoch(ut, Seconds(0), {0, 1, 2});
+    // Reorders only beyond the two closest orbiters: no trigger
+    plan->AddRankingEpoch(ut, Seconds(3), {0, 1, 3});
+    // Changes off the sampling step of the plan
+    plan->AddRankingEpoch(ut, MilliSeconds(7250), {1, 0, 3});
+    plan->AddRankingEpoch(ut, MilliSeconds(12500), {1, 2, 3});
+
+    Ptr<HapHandoverScheduler> scheduler = CreateObject<HapHandoverScheduler>();
+    scheduler->SetAttribute("NumberClosestSats", UintegerValue(2));
+    scheduler->SetAttribute("CheckPeriod", TimeValue(checkPeriod));
+    scheduler->SetContactPlan(plan);
+    scheduler->TraceConnectWithoutContext(
+        "HandoverTrigger",
+        MakeCallback(&HapHandoverSchedulerTestCase::Trigger, this));
+    scheduler->Install(uts);
+
+    m_triggers.clear();
+    m_rankings.clear();
+    Simulator::Stop(Seconds(20));
+    Simulator::Run();
+    nEvaluations = scheduler->GetNEvaluations();
+    scheduler->Dispose();
+    Simulator::Destroy();
+}
+
+void
+HapHandoverSchedulerTestCase::DoRun()
+{
+    uint64_t nEvaluations = 0;
+    std::vector<std::vector<uint32_t>> rankings{{0, 1}, {1, 0}, {1, 2}};
+
+    RunScheduler(Seconds(0), nEvaluations);
+    std::vector<Time> exact{Seconds(0), MilliSeconds(7250), MilliSeconds(12500)};
+    NS_TEST_ASSERT_MSG_EQ(m_triggers.size(), 3, "Initial ranking plus two changes");
+    for (std::size_t i = 0; i < exact.size(); ++i)
+    {
+        NS_TEST_ASSERT_MSG_EQ(m_triggers[i], exact[i], "Trigger at the exact ranking change");
+        NS_TEST_ASSERT_MSG_EQ((m_rankings[i] == rankings[i]), true, "Wrong ranking reported");
+    }
+    NS_TEST_ASSERT_MSG_EQ(nEvaluations, 3, "One evaluation per trigger");
+
+    RunScheduler(Seconds(5), nEvaluations);
+    std::vector<Time> grid{Seconds(0), Seconds(10), Seconds(15)};
+    NS_TEST_ASSERT_MSG_EQ(m_triggers.size(), 3, "Initial ranking plus two changes");
+    for (std::size_t i = 0; i < grid.size(); ++i)
+    {
+        NS_TEST_ASSERT_MSG_EQ(m_triggers[i], grid[i], "Trigger on the check grid");
+        NS_TEST_ASSERT_MSG_EQ((m_rankings[i] == rankings[i]), true, "Wrong ranking reported");
+    }
+    NS_TEST_ASSERT_MSG_EQ(nEvaluations, 3, "One evaluation per trigger");
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Nearest-orbiter batch queries match a brute-force scan across rebuilds
+ */
+class HapNearestOrbiterIndexTestCase : public TestCase
+{
+  public:
+    HapNearestOrbiterIndexTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Compare batch queries of both indexes with brute force.
+     */
+    void Check();
+
+    /**
+     * HandoverTrigger sink.
+     * \param nodeId node id
+     * \param satIds new ranking
+     */
+    void Trigger(uint32_t nodeId, const std::vector<uint32_t>& satIds);
+
+    NodeContainer m_orbiters;                      //!< moving orbiters
+    std::vector<Vector> m_queries;                 //!< query positions
+    std::vector<Vector> m_snapshot;                //!< positions at the last periodic rebuild
+    Ptr<HapNearestOrbiterIndex> m_exact;           //!< index rebuilt whenever time advances
+    Ptr<HapNearestOrbiterIndex> m_periodic;        //!< index rebuilt every 10 s
+    std::vector<Time> m_triggers;                  //!< instants of the triggers
+    std::vector<std::vector<uint32_t>> m_rankings; //!< rankings of the triggers
+};
+
+HapNearestOrbiterIndexTestCase::HapNearestOrbiterIndexTestCase()
+    : TestCase("Nearest-orbiter index equals brute force across rebuilds")
+{
+}
+
+void
+HapNearestOrbiterIndexTestCase::Check()
+{
+    std::vector<Vector> positions;
+    for (uint32_t satId = 0; satId < m_orbiters.GetN(); ++satId)
+    {
+        positions.push_back(m_orbiters.Get(satId)->GetObject<MobilityModel>()->GetPosition());
+    }
+    // The periodic index is rebuilt at 0 s and 10 s only
+    if (Simulator::Now() == Seconds(0) || Simulator::Now() == Seconds(10))
+    {
+        m_snapshot = positions;
+    }
+
+    std::vector<std::vector<uint32_t>> exact;
+    std::vector<std::vector<uint32_t>> periodic;
+    m_exact->FindKClosest(m_queries, 5, exact);
+    m_periodic->FindKClosest(m_queries, 5, periodic);
+    for (std::size_t q = 0; q < m_queries.size(); ++q)
+    {
+        NS_TEST_ASSERT_MSG_EQ(
+            (exact[q] == HapKdTree::FindKClosestBruteForce(positions, m_queries[q], 5)),
+            true,
+            "Index differs from brute force at " << Simulator::Now().As(Time::S));
+        NS_TEST_ASSERT_MSG_EQ(
+            (periodic[q] == HapKdTree::FindKClosestBruteForce(m_snapshot, m_queries[q], 5)),
+            true,
+            "Periodic index differs from its last rebuild at " << Simulator::Now().As(Time::S));
+    }
+}
+
+void
+HapNearestOrbiterIndexTestCase::Trigger(uint32_t nodeId, const std::vector<uint32_t>& satIds)
+{
+    m_triggers.push_back(Simulator::Now());
+    m_rankings.push_back(satIds);
+}
+
+void
+HapNearestOrbiterIndexTestCase::DoRun()
+{
+    Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+    rng->SetStream(2);
+
+    m_orbiters.Create(60);
+    for (uint32_t satId = 0; satId < m_orbiters.GetN(); ++satId)
+    {
+        Ptr<ConstantVelocityMobilityModel> mobility =
+            CreateObject<ConstantVelocityMobilityModel>();
+        mobility->SetPosition(Vector(rng->GetValue(-7e6, 7e6),
+                                     rng->GetValue(-7e6, 7e6),
+                                     rng->GetValue(-7e6, 7e6)));
+        mobility->SetVelocity(Vector(rng->GetValue(-7e3, 7e3),
+                                     rng->GetValue(-7e3, 7e3),
+                                     rng->GetValue(-7e3, 7e3)));
+        m_orbiters.Get(satId)->AggregateObject(mobility);
+    }
+    for (uint32_t q = 0; q < 50; ++q)
+    {
+        m_queries.emplace_back(rng->GetValue(-6.4e6, 6.4e6),
+                               rng->GetValue(-6.4e6, 6.4e6),
+                               rng->GetValue(-6.4e6, 6.4e6));
+    }
+
+    m_exact = CreateObject<HapNearestOrbiterIndex>();
+    m_exact->SetOrbiters(m_orbiters);
+    m_periodic = CreateObject<HapNearestOrbiterIndex>();
+    m_periodic->SetAttribute("RebuildPeriod", TimeValue(Seconds(10)));
+    m_periodic->SetOrbiters(m_orbiters);
+
+    for (double t : {0.0, 4.0, 10.0, 13.0})
+    {
+        Simulator::Schedule(Seconds(t), &HapNearestOrbiterIndexTestCase::Check, this);
+    }
+    Simulator::Run();
+    Simulator::Destroy();
+    NS_TEST_ASSERT_MSG_EQ(m_exact->GetNRebuilds(), 4, "One rebuild per query time");
+    NS_TEST_ASSERT_MSG_EQ(m_periodic->GetNRebuilds(), 2, "One rebuild per period");
+
+    // Orbiter 1 overtakes orbiter 0 at 10 s, seen on the next 4 s grid instant
+    NodeContainer orbiters;
+    orbiters.Create(2);
+    NodeContainer uts;
+    uts.Create(1);
+    Ptr<ConstantPositionMobilityModel> utMobility = CreateObject<ConstantPositionMobilityModel>();
+    uts.Get(0)->AggregateObject(utMobility);
+    Ptr<ConstantPositionMobilityModel> near = CreateObject<ConstantPositionMobilityModel>();
+    near->SetPosition(Vector(1000, 0, 0));
+    orbiters.Get(0)->AggregateObject(near);
+    Ptr<ConstantVelocityMobilityModel> far = CreateObject<ConstantVelocityMobilityModel>();
+    far->SetPosition(Vector(3000, 0, 0));
+    far->SetVelocity(Vector(-200, 0, 0));
+    orbiters.Get(1)->AggregateObject(far);
+
+    Ptr<HapNearestOrbiterIndex> index = CreateObject<HapNearestOrbiterIndex>();
+    index->SetOrbiters(orbiters);
+    Ptr<HapHandoverScheduler> scheduler = CreateObject<HapHandoverScheduler>();
+    scheduler->SetAttribute("NumberClosestSats", UintegerValue(2));
+    scheduler->SetAttribute("CheckPeriod", TimeValue(Seconds(4)));
+    scheduler->SetOrbiterIndex(index);
+    scheduler->TraceConnectWithoutContext(
+        "HandoverTrigger",
+        MakeCallback(&HapNearestOrbiterIndexTestCase::Trigger, this));
+    scheduler->Install(uts);
+
+    Simulator::Stop(Seconds(14));
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(scheduler->GetNEvaluations(), 4, "One batch query per grid instant");
+    NS_TEST_ASSERT_MSG_EQ(m_triggers.size(), 2, "Initial ranking plus one change");
+    NS_TEST_ASSERT_MSG_EQ(m_triggers[1], Seconds(12), "Trigger on the check grid");
+    NS_TEST_ASSERT_MSG_EQ((m_rankings[0] == std::vector<uint32_t>{0, 1}), true, "Wrong ranking");
+    NS_TEST_ASSERT_MSG_EQ((m_rankings[1] == std::vector<uint32_t>{1, 0}), true, "Wrong ranking");
+    scheduler->Dispose();
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Beam set selection from positions and gain grids
+ */
+class HapBeamSetHelperTestCase : public TestCase
+{
+  public:
+    HapBeamSetHelperTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapBeamSetHelperTestCase::HapBeamSetHelperTestCase()
+    : TestCase("Beam set covers user positions and configured GWs")
+{
+}
+
+void
+HapBeamSetHelperTestCase::DoRun()
+{
+    std::string scenario = CreateTempDirFilename("beam-set-scenario");
+    SystemPath::MakeDirectories(SystemPath::Append(scenario, "positions"));
+    SystemPath::MakeDirectories(SystemPath::Append(scenario, "beams"));
+    SystemPath::MakeDirectories(SystemPath::Append(scenario, "antennapatterns"));
+
+    std::ofstream(SystemPath::Append(scenario, "positions/gw_positions.txt"))
+        << "10.0 10.0 0.0\n20.0 20.0 0.0\n";
+    std::ofstream(SystemPath::Append(scenario, "positions/ut_positions.txt")) << "11.0 19.0 0.0\n";
+    // Beams 1 and 2 belong to GW 1, beam 3 to GW 2
+    std::ofstream(SystemPath::Append(scenario, "beams/fwdConf.txt"))
+        << "1 1 1 1\n2 2 1 2\n3 1 2 1\n";
+
+    // 3x3 grid over latitudes 10..20 and longitudes 10..20; beam b peaks at column b - 1
+    for (uint32_t beam = 1; beam <= 3; ++beam)
+    {
+        std::ofstream pattern(
+            SystemPath::Append(scenario,
+                               "antennapatterns/Gain_" + std::to_string(beam) + ".txt"));
+        for (uint32_t row = 0; row < 3; ++row)
+        {
+            for (uint32_t col = 0; col < 3; ++col)
+            {
+                pattern << 10 + 5 * row << " " << 10 + 5 * col << " "
+                        << (col == beam - 1 ? 30.0 : 0.0) << "\n";
+            }
+        }
+    }
+
+    HapBeamSetHelper helper;
+    helper.LoadScenario(scenario);
+    helper.AddUserPosition(15.0, 14.0);
+    helper.AddUserPosition(-30.0, 0.0);
+    std::set<uint32_t> beams = helper.GetBeamSet();
+
+    // UT in beam 3 (also serves GW 2), HAP in beam 2 (serves GW 1)
+    NS_TEST_ASSERT_MSG_EQ(beams.size(), 2, "Wrong beam set size");
+    NS_TEST_ASSERT_MSG_EQ(beams.count(2), 1, "Beam of the HAP position missing");
+    NS_TEST_ASSERT_MSG_EQ(beams.count(3), 1, "Beam of the UT position missing");
+    NS_TEST_ASSERT_MSG_EQ(helper.GetNUncoveredPositions(), 1, "Position outside the grid");
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Beams are activated once, on their first attachment
+ */
+class HapLazyBeamManagerTestCase : public TestCase
+{
+  public:
+    HapLazyBeamManagerTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Beam installer.
+     * \param satId orbiter id
+     * \param beamId beam id
+     */
+    void Install(uint32_t satId, uint32_t beamId);
+
+    uint32_t m_nInstalls; //!< installer calls
+};
+
+HapLazyBeamManagerTestCase::HapLazyBeamManagerTestCase()
+    : TestCase("Lazy beam manager activates beams on first attachment"),
+      m_nInstalls(0)
+{
+}
+
+void
+HapLazyBeamManagerTestCase::Install(uint32_t satId, uint32_t beamId)
+{
+    ++m_nInstalls;
+}
+
+void
+HapLazyBeamManagerTestCase::DoRun()
+{
+    Ptr<HapLazyBeamManager> manager = CreateObject<HapLazyBeamManager>();
+    manager->SetBeamInstaller(MakeCallback(&HapLazyBeamManagerTestCase::Install, this));
+
+    manager->Attach(1, 0, 5);
+    manager->Attach(2, 0, 5);
+    NS_TEST_ASSERT_MSG_EQ(m_nInstalls, 1, "Beam installed more than once");
+    NS_TEST_ASSERT_MSG_EQ(manager->GetNAttached(0, 5), 2, "Wrong attachment count");
+
+    // Handover of node 1 to the same beam id under another orbiter
+    manager->Attach(1, 1, 5);
+    NS_TEST_ASSERT_MSG_EQ(m_nInstalls, 2, "New orbiter beam not installed");
+    NS_TEST_ASSERT_MSG_EQ(manager->GetNAttached(0, 5), 1, "Node not detached");
+    NS_TEST_ASSERT_MSG_EQ(manager->IsActive(0, 7), false, "Unused beam active");
+    NS_TEST_ASSERT_MSG_EQ(manager->GetNActiveBeams(), 2, "Wrong number of active beams");
+    NS_TEST_ASSERT_MSG_EQ(manager->GetActiveBeamIds().size(), 1, "Wrong active beam ids");
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Pooled payloads have the requested size and distinct UIDs
+ */
+class HapPayloadPoolTestCase : public TestCase
+{
+  public:
+    HapPayloadPoolTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapPayloadPoolTestCase::HapPayloadPoolTestCase()
+    : TestCase("Payload pool hands out distinct zero-area packets")
+{
+}
+
+void
+HapPayloadPoolTestCase::DoRun()
+{
+    Ptr<HapPayloadPool> pool = CreateObject<HapPayloadPool>();
+    Ptr<Packet> a = pool->Get(1500);
+    Ptr<Packet> b = pool->Get(1500);
+    Ptr<Packet> c = pool->Get(64);
+
+    NS_TEST_ASSERT_MSG_EQ(a->GetSize(), 1500, "Wrong payload size");
+    NS_TEST_ASSERT_MSG_EQ(c->GetSize(), 64, "Wrong payload size");
+    NS_TEST_ASSERT_MSG_EQ((a->GetUid() != b->GetUid()), true, "Copies must be distinct packets");
+    NS_TEST_ASSERT_MSG_EQ(pool->GetNPackets(), 3, "Wrong number of packets");
+
+    uint8_t bytes[1500];
+    b->CopyData(bytes, sizeof(bytes));
+    NS_TEST_ASSERT_MSG_EQ(bytes[0] + bytes[749] + bytes[1499], 0, "Payload must be zero-filled");
+
+    // The payload stays in the buffer zero area, whatever its size
+    Ptr<Packet> large = pool->Get(9000);
+    NS_TEST_ASSERT_MSG_EQ(large->GetSerializedSize(),
+                          c->GetSerializedSize(),
+                          "Payload must stay in the zero area");
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Trace reader decoding of binary traces and pcap captures
+ */
+class HapTraceReaderTestCase : public TestCase
+{
+  public:
+    HapTraceReaderTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapTraceReaderTestCase::HapTraceReaderTestCase()
+    : TestCase("Trace reader decodes binary traces and raw IPv4 captures")
+{
+}
+
+void
+HapTraceReaderTestCase::DoRun()
+{
+    std::vector<HapTraceReader::Record> records;
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        records.push_back({1000 * int64_t(i), 0x0a000001 + i, 0x0a010001, 100 + i, 17});
+    }
+    std::string binary = CreateTempDirFilename("trace.htrb");
+    HapTraceReader::WriteBinary(binary, records);
+
+    HapTraceReader reader;
+    reader.Open(binary);
+    NS_TEST_ASSERT_MSG_EQ(reader.GetFormat(), HapTraceReader::FORMAT_BINARY, "Wrong format");
+    std::vector<HapTraceReader::Record> batch;
+    NS_TEST_ASSERT_MSG_EQ(reader.ReadBatch(batch, 4), 4, "Batch must be bounded");
+    NS_TEST_ASSERT_MSG_EQ(reader.ReadBatch(batch, 100), 6, "Wrong number of records");
+    NS_TEST_ASSERT_MSG_EQ(batch[7].timeNs, 7000, "Wrong time");
+    NS_TEST_ASSERT_MSG_EQ(batch[7].source, 0x0a000008, "Wrong source");
+    NS_TEST_ASSERT_MSG_EQ(batch[7].size, 107, "Wrong size");
+    reader.Advise(4096);
+    reader.Close();
+
+    // Little-endian pcap, link type raw IPv4, one 20-byte UDP packet 10.0.0.1 -> 10.0.0.2
+    const uint8_t pcap[] = {
+        0xd4, 0xc3, 0xb2, 0xa1, 2, 0, 4, 0, 0, 0, 0, 0, 0,  0, 0, 0,    0xff, 0xff, 0, 0,
+        228,  0,    0,    0,    3, 0, 0, 0, 5, 0, 0, 0, 20, 0, 0, 0,    20,   0,    0, 0,
+        0x45, 0,    0,    40,   0, 0, 0, 0, 64, 17, 0, 0, 10, 0, 0, 1,  10,   0,    0, 2,
+    };
+    std::string capture = CreateTempDirFilename("trace.pcap");
+    std::ofstream(capture, std::ios::binary)
+        .write(reinterpret_cast<const char*>(pcap), sizeof(pcap));
+
+    reader.Open(capture);
+    NS_TEST_ASSERT_MSG_EQ(reader.GetFormat(), HapTraceReader::FORMAT_PCAP, "Wrong format");
+    HapTraceReader::Record record;
+    NS_TEST_ASSERT_MSG_EQ(reader.Next(record), true, "One packet expected");
+    NS_TEST_ASSERT_MSG_EQ(record.timeNs, 3000005000, "Wrong capture time");
+    NS_TEST_ASSERT_MSG_EQ(record.source, 0x0a000001, "Wrong source");
+    NS_TEST_ASSERT_MSG_EQ(record.destination, 0x0a000002, "Wrong destination");
+    NS_TEST_ASSERT_MSG_EQ(record.size, 40, "Size is the IPv4 total length");
+    NS_TEST_ASSERT_MSG_EQ(unsigned(record.protocol), 17, "Wrong protocol");
+    NS_TEST_ASSERT_MSG_EQ(reader.Next(record), false, "End of capture expected");
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Traffic matrix users follow their demand profile
+ */
+class HapTrafficMatrixTestCase : public TestCase
+{
+  public:
+    HapTrafficMatrixTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Tx sink.
+     * \param packet packet sent
+     * \param user user id
+     */
+    void Tx(Ptr<const Packet> packet, uint32_t user);
+
+    std::vector<uint64_t> m_bytes; //!< bytes sent per user
+    uint32_t m_context;            //!< node id of the sources
+    uint32_t m_nWrongContext;      //!< packets sent outside the source context
+};
+
+HapTrafficMatrixTestCase::HapTrafficMatrixTestCase()
+    : TestCase("Traffic matrix users follow their demand profile"),
+      m_context(0),
+      m_nWrongContext(0)
+{
+}
+
+void
+HapTrafficMatrixTestCase::Tx(Ptr<const Packet> packet, uint32_t user)
+{
+    m_bytes[user] += packet->GetSize();
+    if (Simulator::GetContext() != m_context)
+    {
+        ++m_nWrongContext;
+    }
+}
+
+void
+HapTrafficMatrixTestCase::DoRun()
+{
+    Ptr<HapDemandProfile> night = CreateObject<HapDemandProfile>();
+    night->SetDiurnalProfile({1, 0, 0, 2}, Hours(24));
+    NS_TEST_ASSERT_MSG_EQ_TOL(night->GetRelativeWeight(Hours(1)), 0.5, 1e-9, "Wrong weight");
+    NS_TEST_ASSERT_MSG_EQ_TOL(night->GetRelativeWeight(Hours(9)), 0, 1e-9, "Wrong weight");
+    NS_TEST_ASSERT_MSG_EQ_TOL(night->GetRelativeWeight(Hours(42)), 1, 1e-9, "Wrong weight");
+
+    NodeContainer nodes;
+    nodes.Create(2);
+    SimpleNetDeviceHelper devices;
+    InternetStackHelper internet;
+    internet.Install(nodes);
+    Ipv4AddressHelper addresses("10.1.1.0", "255.255.255.0");
+    addresses.Assign(devices.Install(nodes));
+
+    Ptr<HapDemandProfile> busy = CreateObject<HapDemandProfile>();
+    busy->SetAttribute("OffTime", StringValue("ns3::ExponentialRandomVariable[Mean=2.0]"));
+    // Starts in the zero-weight interval
+    night->SetAttribute("DiurnalOffset", TimeValue(Hours(7)));
+
+    Ptr<HapTrafficMatrix> matrix = CreateObject<HapTrafficMatrix>();
+    uint32_t busyUser = matrix->AddDemand(nodes.Get(0), nodes.Get(1), 200, busy);
+    uint32_t nightUser = matrix->AddDemand(nodes.Get(0), nodes.Get(1), 200, night);
+    matrix->AssignStreams(1);
+    matrix->TraceConnectWithoutContext("Tx", MakeCallback(&HapTrafficMatrixTestCase::Tx, this));
+    NS_TEST_ASSERT_MSG_EQ(matrix->GetNUsers(), 400, "Wrong number of users");
+
+    m_bytes.assign(matrix->GetNUsers(), 0);
+    m_context = nodes.Get(0)->GetId();
+    matrix->Start(Seconds(0), Seconds(20));
+    Simulator::Run();
+
+    uint64_t busyBytes = 0;
+    uint64_t nightBytes = 0;
+    for (uint32_t user = 0; user < 200; ++user)
+    {
+        busyBytes += m_bytes[busyUser + user];
+        nightBytes += m_bytes[nightUser + user];
+    }
+    NS_TEST_ASSERT_MSG_GT(matrix->GetNFiles(), 0, "No file requested");
+    NS_TEST_ASSERT_MSG_EQ(busyBytes, matrix->GetNBytes(), "Only the busy users send");
+    NS_TEST_ASSERT_MSG_EQ(nightBytes, 0, "Zero-weight interval must be silent");
+    NS_TEST_ASSERT_MSG_EQ(m_nWrongContext, 0, "Users must send in the context of their node");
+    matrix->Dispose();
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Binary scatter file round trip
+ */
+class HapScatterFileTestCase : public TestCase
+{
+  public:
+    HapScatterFileTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapScatterFileTestCase::HapScatterFileTestCase()
+    : TestCase("Scatter file series are read back through the index")
+{
+}
+
+void
+HapScatterFileTestCase::DoRun()
+{
+    std::string fileName = CreateTempDirFilename("stats.hscat");
+    Ptr<HapScatterFileWriter> writer = CreateObject<HapScatterFileWriter>();
+    writer->SetAttribute("ChunkSize", UintegerValue(3));
+    writer->Open(fileName);
+    uint32_t beam = writer->AddSeries("stat-per-beam-fwd-app-throughput-scatter-1",
+                                      {{"title", "per-beam throughput"}});
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        writer->Write(beam, i, 10.0 * i);
+        writer->Write2d("stat-per-ut-fwd-app-throughput-scatter-" + std::to_string(i % 2),
+                        i,
+                        -1.0 * i);
+    }
+    NS_TEST_ASSERT_MSG_EQ(writer->GetNSeries(), 3, "Series created from contexts");
+    NS_TEST_ASSERT_MSG_EQ(writer->GetNPoints(), 20, "Wrong number of points");
+    writer->Dispose();
+
+    HapScatterFileReader reader;
+    reader.Open(fileName);
+    NS_TEST_ASSERT_MSG_EQ(reader.GetSeriesNames().size(), 3, "Wrong number of series");
+    NS_TEST_ASSERT_MSG_EQ(reader.HasSeries("stat-per-ut-fwd-app-throughput-scatter-2"),
+                          false,
+                          "Unexpected series");
+    NS_TEST_ASSERT_MSG_EQ(reader.GetMetadata("stat-per-beam-fwd-app-throughput-scatter-1")["title"],
+                          "per-beam throughput",
+                          "Metadata lost");
+
+    std::vector<HapScatterFileReader::Point> points =
+        reader.ReadSeries("stat-per-beam-fwd-app-throughput-scatter-1");
+    NS_TEST_ASSERT_MSG_EQ(points.size(), 10, "Chunks and pending points must all be read");
+    NS_TEST_ASSERT_MSG_EQ(points[9].first, 9, "Wrong time");
+    NS_TEST_ASSERT_MSG_EQ(points[9].second, 90, "Wrong value");
+
+    points = reader.ReadSeries("stat-per-ut-fwd-app-throughput-scatter-1");
+    NS_TEST_ASSERT_MSG_EQ(points.size(), 5, "Wrong number of points");
+    NS_TEST_ASSERT_MSG_EQ(points[2].first, 5, "Series interleaved");
+    NS_TEST_ASSERT_MSG_EQ(points[2].second, -5, "Series interleaved");
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Windowed aggregation of samples
+ */
+class HapWindowAggregatorTestCase : public TestCase
+{
+  public:
+    HapWindowAggregatorTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapWindowAggregatorTestCase::HapWindowAggregatorTestCase()
+    : TestCase("Window aggregator writes one point per window")
+{
+}
+
+void
+HapWindowAggregatorTestCase::DoRun()
+{
+    std::string fileName = CreateTempDirFilename("windows.hscat");
+    Ptr<HapScatterFileWriter> writer = CreateObject<HapScatterFileWriter>();
+    writer->Open(fileName);
+
+    Ptr<HapWindowAggregator> rate = CreateObject<HapWindowAggregator>();
+    rate->SetAttribute("Window", TimeValue(MilliSeconds(100)));
+    rate->SetWriter(writer);
+    uint32_t rateSeries = rate->AddSeries("rate");
+    Ptr<HapWindowAggregator> max = CreateObject<HapWindowAggregator>();
+    max->SetAttribute("Window", TimeValue(MilliSeconds(100)));
+    max->SetAttribute("Statistic", EnumValue(HapWindowAggregator::MAX));
+    max->SetWriter(writer);
+    uint32_t maxSeries = max->AddSeries("max");
+    Ptr<HapWindowAggregator> raw = CreateObject<HapWindowAggregator>();
+    raw->SetAttribute("Raw", BooleanValue(true));
+    raw->SetWriter(writer);
+    uint32_t rawSeries = raw->AddSeries("raw");
+
+    // 1000 samples in [0, 100 ms), none in [100, 300 ms), 10 in [300, 400 ms)
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        rate->Add(rateSeries, MicroSeconds(100 * i), 1);
+        max->Add(maxSeries, MicroSeconds(100 * i), i);
+        raw->Add(rawSeries, MicroSeconds(100 * i), i);
+    }
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        rate->Add(rateSeries, MilliSeconds(300 + i), 1);
+        max->Add(maxSeries, MilliSeconds(300 + i), i);
+    }
+    NS_TEST_ASSERT_MSG_EQ(rate->GetNSamples(), 1010, "Wrong number of samples");
+
+    // A run ending at 350 ms cuts the last window in half
+    Ptr<HapWindowAggregator> partial = CreateObject<HapWindowAggregator>();
+    partial->SetAttribute("Window", TimeValue(MilliSeconds(100)));
+    partial->SetWriter(writer);
+    uint32_t partialSeries = partial->AddSeries("partial");
+    Simulator::Stop(MilliSeconds(350));
+    Simulator::Run();
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        partial->Add(partialSeries, MilliSeconds(300 + i), 1);
+    }
+    partial->Dispose();
+    Simulator::Destroy();
+    rate->Dispose();
+    max->Dispose();
+    raw->Dispose();
+    writer->Dispose();
+
+    HapScatterFileReader reader;
+    reader.Open(fileName);
+    std::vector<HapScatterFileReader::Point> points = reader.ReadSeries("rate");
+    NS_TEST_ASSERT_MSG_EQ(points.size(), 4, "Empty windows must be written as zeros");
+    NS_TEST_ASSERT_MSG_EQ_TOL(points[0].first, 0.1, 1e-9, "Point at the window end");
+    NS_TEST_ASSERT_MSG_EQ_TOL(points[0].second, 10000, 1e-6, "Wrong rate");
+    NS_TEST_ASSERT_MSG_EQ_TOL(points[1].second, 0, 1e-9, "Wrong rate");
+    NS_TEST_ASSERT_MSG_EQ_TOL(points[3].second, 100, 1e-6, "Wrong rate");
+    NS_TEST_ASSERT_MSG_EQ(reader.GetMetadata("rate")["statistic"], "rate", "Wrong metadata");
+
+    points = reader.ReadSeries("max");
+    NS_TEST_ASSERT_MSG_EQ(points.size(), 2, "Empty windows must be skipped");
+    NS_TEST_ASSERT_MSG_EQ_TOL(points[0].second, 999, 1e-9, "Wrong maximum");
+    NS_TEST_ASSERT_MSG_EQ_TOL(points[1].first, 0.4, 1e-9, "Point at the window end");
+    NS_TEST_ASSERT_MSG_EQ(reader.GetNPoints("raw"), 1000, "Raw samples must all be written");
+
+    points = reader.ReadSeries("partial");
+    NS_TEST_ASSERT_MSG_EQ(points.size(), 1, "Wrong number of points");
+    NS_TEST_ASSERT_MSG_EQ_TOL(points[0].first, 0.35, 1e-9, "Point at the end of the run");
+    NS_TEST_ASSERT_MSG_EQ_TOL(points[0].second, 200, 1e-6, "Rate over the elapsed part");
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Telemetry snapshot and event ring contents
+ */
+class HapTelemetryPublisherTestCase : public TestCase
+{
+  public:
+    HapTelemetryPublisherTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapTelemetryPublisherTestCase::HapTelemetryPublisherTestCase()
+    : TestCase("Telemetry publisher fills the shared snapshot and event ring")
+{
+}
+
+void
+HapTelemetryPublisherTestCase::DoRun()
+{
+    std::string path = CreateTempDirFilename("telemetry");
+    Ptr<HapTelemetryPublisher> publisher = CreateObject<HapTelemetryPublisher>();
+    publisher->SetAttribute("Path", StringValue(path));
+    publisher->SetAttribute("Interval", TimeValue(Seconds(1)));
+    publisher->SetAttribute("MaxBeams", UintegerValue(4));
+    publisher->SetAttribute("EventCapacity", UintegerValue(2));
+    publisher->SetAttribute("Unlink", BooleanValue(false));
+    uint32_t rx = publisher->AddCounter("rx-packets");
+    publisher->Start();
+
+    Simulator::Schedule(MilliSeconds(500), [=]() {
+        publisher->Increment(rx, 3);
+        publisher->AddBeamBytes(2, 1000);
+        publisher->AddBeamBytes(9, 1000);
+        publisher->HandoverTrigger(5, {1, 2});
+        publisher->HandoverTrigger(5, {1, 3});
+        publisher->HandoverTrigger(5, {2, 1});
+        publisher->BeamActivated(2, 7);
+    });
+    Simulator::Stop(MilliSeconds(1500));
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(publisher->GetNSnapshots(), 1, "One snapshot per interval");
+    NS_TEST_ASSERT_MSG_EQ(publisher->GetNEvents(), 3, "Unchanged best orbiter is no event");
+    publisher->Dispose();
+    Simulator::Destroy();
+
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    NS_TEST_ASSERT_MSG_EQ(std::string(file.data(), 4), "HTLM", "Wrong magic");
+    uint64_t sequence;
+    std::memcpy(&sequence, file.data() + 24, sizeof(sequence));
+    NS_TEST_ASSERT_MSG_EQ(sequence, 2, "Snapshot sequence must be even");
+    NS_TEST_ASSERT_MSG_EQ(std::string(file.data() + 64), "rx-packets", "Wrong counter name");
+
+    // Snapshot at 96: time, counter, 4 beam rates, 4 beam byte totals
+    double time;
+    uint64_t counter;
+    double rate;
+    std::memcpy(&time, file.data() + 96, sizeof(time));
+    std::memcpy(&counter, file.data() + 104, sizeof(counter));
+    std::memcpy(&rate, file.data() + 112 + 2 * 8, sizeof(rate));
+    NS_TEST_ASSERT_MSG_EQ_TOL(time, 1, 1e-9, "Wrong snapshot time");
+    NS_TEST_ASSERT_MSG_EQ(counter, 3, "Wrong counter");
+    NS_TEST_ASSERT_MSG_EQ_TOL(rate, 8000, 1e-9, "Wrong beam rate");
+
+    // Event ring at 176, two slots: events 2 (beam) then 1 (handover 1 -> 2)
+    uint64_t slotSequence;
+    uint32_t fields[4];
+    std::memcpy(&slotSequence, file.data() + 176 + 32, sizeof(slotSequence));
+    std::memcpy(fields, file.data() + 176 + 32 + 16, sizeof(fields));
+    NS_TEST_ASSERT_MSG_EQ(slotSequence, 2, "Wrong event sequence");
+    NS_TEST_ASSERT_MSG_EQ(fields[0], HapTelemetryPublisher::HANDOVER, "Wrong event type");
+    NS_TEST_ASSERT_MSG_EQ(fields[2], 1, "Wrong previous orbiter");
+    NS_TEST_ASSERT_MSG_EQ(fields[3], 2, "Wrong new orbiter");
+    std::memcpy(&slotSequence, file.data() + 176, sizeof(slotSequence));
+    NS_TEST_ASSERT_MSG_EQ(slotSequence, 3, "Oldest event must be overwritten");
+
+    // Without Simulator::Stop() the snapshots end with the last other event
+    Ptr<HapTelemetryPublisher> unbounded = CreateObject<HapTelemetryPublisher>();
+    unbounded->SetAttribute("Path", StringValue(path));
+    unbounded->SetAttribute("Interval", TimeValue(Seconds(1)));
+    unbounded->Start();
+    Simulator::Schedule(MilliSeconds(2500), []() {});
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(unbounded->GetNSnapshots(), 3, "Snapshots after the last event");
+    NS_TEST_ASSERT_MSG_EQ(Simulator::Now(), Seconds(3), "Run kept alive by the snapshots");
+    unbounded->Dispose();
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Directional gain and trace context kernels shared by the examples
+ */
+class HapKernelsTestCase : public TestCase
+{
+  public:
+    HapKernelsTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapKernelsTestCase::HapKernelsTestCase()
+    : TestCase("Off-axis angle, cosine gain and node id of a trace context")
+{
+}
+
+void
+HapKernelsTestCase::DoRun()
+{
+    NS_TEST_ASSERT_MSG_EQ_TOL(HapOffAxisAngle(Vector(0, 0, -1), Vector(0, 0, -5)),
+                              0,
+                              1e-12,
+                              "Target on boresight");
+    NS_TEST_ASSERT_MSG_EQ_TOL(HapOffAxisAngle(Vector(0, 0, -1), Vector(3, 0, 0)),
+                              M_PI / 2,
+                              1e-12,
+                              "Target across the boresight");
+    NS_TEST_ASSERT_MSG_EQ(HapOffAxisAngle(Vector(), Vector(1, 0, 0)), 0, "Null boresight");
+
+    NS_TEST_ASSERT_MSG_EQ_TOL(HapCosineGain(0, 20, 2), 20, 1e-12, "Boresight gain");
+    NS_TEST_ASSERT_MSG_EQ_TOL(HapCosineGain(M_PI / 3, 20, 2),
+                              20 + 20 * std::log10(0.5),
+                              1e-9,
+                              "cos(60 deg)^2 gain");
+    NS_TEST_ASSERT_MSG_EQ(HapCosineGain(M_PI, 20, 2), -20, "Outside the beam");
+
+    NS_TEST_ASSERT_MSG_EQ(HapNodeIdFromContext("/NodeList/12/$ns3::Ipv4L3Protocol/Rx"),
+                          12,
+                          "Wrong node id");
+    NS_TEST_ASSERT_MSG_EQ(HapNodeIdFromContext("/NodeList/7"), 7, "Wrong node id");
+    NS_TEST_ASSERT_MSG_EQ(HapNodeIdFromContext("/ChannelList/3"), UINT32_MAX, "No node id");
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Animation recorder writes only moved nodes and per-interval flow summaries
+ */
+class HapAnimationRecorderTestCase : public TestCase
+{
+  public:
+    HapAnimationRecorderTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapAnimationRecorderTestCase::HapAnimationRecorderTestCase()
+    : TestCase("Animation recorder decimates positions and flows and exports NetAnim XML")
+{
+}
+
+void
+HapAnimationRecorderTestCase::DoRun()
+{
+    NodeContainer nodes;
+    nodes.Create(2);
+    Ptr<ConstantVelocityMobilityModel> hap = CreateObject<ConstantVelocityMobilityModel>();
+    hap->SetVelocity(Vector(10, 0, 0));
+    nodes.Get(0)->AggregateObject(hap);
+    Ptr<ConstantPositionMobilityModel> ground = CreateObject<ConstantPositionMobilityModel>();
+    ground->SetPosition(Vector(500, 0, 0));
+    nodes.Get(1)->AggregateObject(ground);
+    uint32_t hapId = nodes.Get(0)->GetId();
+    uint32_t groundId = nodes.Get(1)->GetId();
+
+    std::string fileName = CreateTempDirFilename("animation.hanm");
+    std::string xmlFileName = CreateTempDirFilename("animation.xml");
+    Ptr<HapAnimationRecorder> recorder = CreateObject<HapAnimationRecorder>();
+    recorder->SetAttribute("MinDistance", DoubleValue(1));
+    recorder->Add(nodes.Get(0), "HAP");
+    recorder->Add(nodes.Get(1), "Ground");
+    recorder->Start(fileName);
+
+    Simulator::Schedule(MilliSeconds(500), [=]() {
+        recorder->RecordFlow(hapId, groundId, 100);
+        recorder->RecordFlow(hapId, groundId, 100);
+        recorder->RecordFlow(hapId, groundId + 100, 100);
+    });
+    Simulator::Schedule(MilliSeconds(1500),
+                        [=]() { recorder->RecordFlow(groundId, hapId, 50); });
+    Simulator::Stop(MilliSeconds(3500));
+    Simulator::Run();
+    recorder->Dispose();
+    Simulator::Destroy();
+
+    // Both nodes at 0 s, then only the moving HAP at 1, 2 and 3 s
+    NS_TEST_ASSERT_MSG_EQ(recorder->GetNPositions(), 5, "Static node written more than once");
+    NS_TEST_ASSERT_MSG_EQ(recorder->GetNFlows(), 2, "One summary per pair and interval");
+
+    HapAnimationRecorder::ExportNetAnim(fileName, xmlFileName, Seconds(1));
+    std::ifstream in(xmlFileName);
+    std::string xml((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ostringstream node;
+    node << "<node id=\"" << hapId << "\" sysId=\"0\" locX=\"0\" locY=\"0\" />";
+    NS_TEST_ASSERT_MSG_NE(xml.find(node.str()), std::string::npos, "Missing initial position");
+    NS_TEST_ASSERT_MSG_NE(xml.find("descr=\"HAP\""), std::string::npos, "Missing description");
+    std::ostringstream position;
+    position << "<nu p=\"p\" t=\"2\" id=\"" << hapId << "\" x=\"20\" y=\"0\" z=\"0\" />";
+    NS_TEST_ASSERT_MSG_NE(xml.find(position.str()), std::string::npos, "Missing position update");
+    std::ostringstream flow;
+    flow << "<p fId=\"" << groundId << "\" fbTx=\"1\" lbTx=\"1\" meta-info=\"1 packets, 50 bytes\"";
+    NS_TEST_ASSERT_MSG_NE(xml.find(flow.str()), std::string::npos, "Missing flow summary");
+    NS_TEST_ASSERT_MSG_EQ(xml.find("2 packets"), std::string::npos, "Flow before the window");
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Wi-Fi slot lengthened by the round trip of the longest link
+ */
+class HapWifiRangeHelperTestCase : public TestCase
+{
+  public:
+    HapWifiRangeHelperTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapWifiRangeHelperTestCase::HapWifiRangeHelperTestCase()
+    : TestCase("Long-range profile derives the Wi-Fi slot from the link distance")
+{
+}
+
+void
+HapWifiRangeHelperTestCase::DoRun()
+{
+    HapWifiRangeHelper range;
+    NS_TEST_ASSERT_MSG_EQ(range.GetCoverageClass(), 0, "No distance, no extra time");
+    range.SetMaxDistance(1000);
+    NS_TEST_ASSERT_MSG_EQ(range.GetCoverageClass(), 3, "6.7 us round trip");
+    range.SetMaxDistance(20000);
+    NS_TEST_ASSERT_MSG_EQ(range.GetCoverageClass(), 45, "133.4 us round trip");
+    NS_TEST_ASSERT_MSG_EQ(range.GetAirPropagationTime(), MicroSeconds(135), "Wrong air time");
+
+    NodeContainer nodes;
+    nodes.Create(2);
+    WifiHelper wifi;
+    wifi.SetStandard(WIFI_STANDARD_80211a);
+    YansWifiPhyHelper phy;
+    phy.SetChannel(YansWifiChannelHelper::Default().Create());
+    WifiMacHelper mac;
+    mac.SetType("ns3::AdhocWifiMac");
+    NetDeviceContainer devices = wifi.Install(phy, mac, nodes);
+    Ptr<WifiPhy> wifiPhy = DynamicCast<WifiNetDevice>(devices.Get(0))->GetPhy();
+    NS_TEST_ASSERT_MSG_EQ(wifiPhy->GetSlot(), MicroSeconds(9), "802.11a slot");
+
+    range.Install(devices);
+    NS_TEST_ASSERT_MSG_EQ(wifiPhy->GetSlot(), MicroSeconds(144), "Slot must cover the round trip");
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Aggregation sized to the overhead of a channel access on HAP links
+ */
+class HapWifiAggregationHelperTestCase : public TestCase
+{
+  public:
+    HapWifiAggregationHelperTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapWifiAggregationHelperTestCase::HapWifiAggregationHelperTestCase()
+    : TestCase("Aggregation profile grows with the link distance and the rate")
+{
+}
+
+void
+HapWifiAggregationHelperTestCase::DoRun()
+{
+    HapWifiAggregationHelper aggregation;
+    aggregation.SetDataRate(DataRate("65Mbps"));
+
+    // Terrestrial link: 226.5 us of overhead, nine times that of airtime
+    HapWifiAggregationHelper::Profile profile =
+        aggregation.GetProfile(WIFI_STANDARD_80211n, MicroSeconds(9), MicroSeconds(16));
+    NS_TEST_ASSERT_MSG_EQ(profile.bufferSize, 10, "Wrong window");
+    NS_TEST_ASSERT_MSG_EQ(profile.maxAmpduSize, 10 * 1534, "Wrong A-MPDU size");
+    NS_TEST_ASSERT_MSG_EQ(profile.maxAmsduSize, 0, "No A-MSDU needed");
+
+    // 20 km with the long-range slot: limited by the PPDU duration
+    aggregation.SetMaxDistance(20000);
+    profile = aggregation.GetProfile(WIFI_STANDARD_80211n, MicroSeconds(144), MicroSeconds(16));
+    NS_TEST_ASSERT_MSG_EQ(profile.bufferSize, 29, "Wrong window");
+    NS_TEST_ASSERT_MSG_EQ(profile.maxAmpduSize, 29 * 1534, "Wrong A-MPDU size");
+    NS_TEST_ASSERT_MSG_EQ((profile.airtime <= MicroSeconds(5484)), true, "PPDU too long");
+
+    // At VHT rates the window would overflow: MSDUs are packed in A-MSDUs
+    aggregation.SetDataRate(DataRate("650Mbps"));
+    profile = aggregation.GetProfile(WIFI_STANDARD_80211ac, MicroSeconds(144), MicroSeconds(16));
+    NS_TEST_ASSERT_MSG_EQ(profile.maxAmsduSize, 5 * 1516, "Wrong A-MSDU size");
+    NS_TEST_ASSERT_MSG_EQ(profile.bufferSize, 58, "Wrong window");
+    NS_TEST_ASSERT_MSG_EQ(profile.maxAmpduSize, 58 * (5 * 1516 + 34), "Wrong A-MPDU size");
+
+    NodeContainer nodes;
+    nodes.Create(2);
+    WifiHelper wifi;
+    wifi.SetStandard(WIFI_STANDARD_80211n);
+    YansWifiPhyHelper phy;
+    phy.SetChannel(YansWifiChannelHelper::Default().Create());
+    WifiMacHelper mac;
+    mac.SetType("ns3::AdhocWifiMac", "QosSupported", BooleanValue(true));
+    NetDeviceContainer devices = wifi.Install(phy, mac, nodes);
+    aggregation.SetDataRate(DataRate("65Mbps"));
+    aggregation.Install(devices);
+    Ptr<WifiMac> wifiMac = DynamicCast<WifiNetDevice>(devices.Get(1))->GetMac();
+    NS_TEST_ASSERT_MSG_GT(wifiMac->GetMaxAmpduSize(AC_BE), 1534, "A-MPDU not enabled");
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Receivers out of range culled before the loss chain
+ */
+class HapRangeTransmitFilterTestCase : public TestCase
+{
+  public:
+    HapRangeTransmitFilterTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapRangeTransmitFilterTestCase::HapRangeTransmitFilterTestCase()
+    : TestCase("Range filter culls receivers that cannot reach their sensitivity")
+{
+}
+
+void
+HapRangeTransmitFilterTestCase::DoRun()
+{
+    // 0 dBm, 40 dB at 1 m and 20 dB per decade: -100 dBm at 1 km
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetAttribute("Exponent", DoubleValue(2));
+    loss->SetAttribute("ReferenceDistance", DoubleValue(1));
+    loss->SetAttribute("ReferenceLoss", DoubleValue(40));
+    double range = HapRangeTransmitFilter::GetRange(loss, 0, -100, 1e6);
+    NS_TEST_ASSERT_MSG_EQ_TOL(range, 1000, 0.01, "Wrong range");
+    NS_TEST_ASSERT_MSG_EQ(HapRangeTransmitFilter::GetRange(loss, 100, -100, 1e6), 1e6, "Capped");
+
+    std::vector<Ptr<HalfDuplexIdealPhy>> phys;
+    std::vector<Ptr<ConstantPositionMobilityModel>> positions;
+    for (double x : {0.0, 500.0, 2000.0})
+    {
+        Ptr<ConstantPositionMobilityModel> mobility =
+            CreateObject<ConstantPositionMobilityModel>();
+        mobility->SetPosition(Vector(x, 0, 0));
+        Ptr<HalfDuplexIdealPhy> phy = CreateObject<HalfDuplexIdealPhy>();
+        phy->SetMobility(mobility);
+        phys.push_back(phy);
+        positions.push_back(mobility);
+    }
+    Ptr<SpectrumSignalParameters> params = Create<SpectrumSignalParameters>();
+    params->txPhy = phys[0];
+
+    Ptr<HapRangeTransmitFilter> filter = CreateObject<HapRangeTransmitFilter>();
+    NS_TEST_ASSERT_MSG_EQ(filter->Filter(params, phys[2]), false, "Culling disabled by default");
+    filter->SetAttribute("MaxRange", DoubleValue(range));
+    NS_TEST_ASSERT_MSG_EQ(filter->Filter(params, phys[1]), false, "Receiver in range culled");
+    NS_TEST_ASSERT_MSG_EQ(filter->Filter(params, phys[2]), true, "Receiver out of range kept");
+
+    // The cached position is used until it is UpdateInterval old
+    positions[2]->SetPosition(Vector(800, 0, 0));
+    NS_TEST_ASSERT_MSG_EQ(filter->Filter(params, phys[2]), true, "Position read again");
+    Simulator::Schedule(Seconds(1), [&]() {
+        NS_TEST_EXPECT_MSG_EQ(filter->Filter(params, phys[2]), false, "Stale position used");
+    });
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(filter->GetNCulled(), 2, "Wrong culled count");
+    NS_TEST_ASSERT_MSG_EQ(filter->GetNPassed(), 2, "Wrong passed count");
+
+    // A moving receiver is kept as long as it could come into range before the next update
+    Ptr<HapRangeTransmitFilter> moving = CreateObject<HapRangeTransmitFilter>();
+    moving->SetAttribute("MaxRange", DoubleValue(range));
+    moving->SetAttribute("MaxSpeed", DoubleValue(300));
+    positions[2]->SetPosition(Vector(1500, 0, 0));
+    NS_TEST_ASSERT_MSG_EQ(moving->Filter(params, phys[2]), false, "Receiver may be in range");
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Abstract HAP-GEO link: capacity, geometric delay, queue, batching and link budget
+ */
+class HapSatLinkTestCase : public TestCase
+{
+  public:
+    HapSatLinkTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * \brief Send packets over a new link and run the simulation.
+     * \param helper link configuration
+     * \param nPackets packets sent at time zero
+     * \return the transmitting device
+     */
+    Ptr<HapSatLinkNetDevice> RunLink(HapSatLinkHelper& helper, uint32_t nPackets);
+
+    /**
+     * \brief Receive callback of the far end.
+     * \param device receiving device
+     * \param packet the packet
+     * \param protocol protocol number
+     * \param from sender address
+     * \return true
+     */
+    bool Receive(Ptr<NetDevice> device,
+                 Ptr<const Packet> packet,
+                 uint16_t protocol,
+                 const Address& from);
+
+    uint32_t m_received; //!< packets received
+    Time m_lastRx;       //!< time of the last reception
+};
+
+HapSatLinkTestCase::HapSatLinkTestCase()
+    : TestCase("Abstract HAP-satellite link delivers after capacity and distance")
+{
+}
+
+bool
+HapSatLinkTestCase::Receive(Ptr<NetDevice> /* device */,
+                            Ptr<const Packet> /* packet */,
+                            uint16_t /* protocol */,
+                            const Address& /* from */)
+{
+    ++m_received;
+    m_lastRx = Simulator::Now();
+    return true;
+}
+
+Ptr<HapSatLinkNetDevice>
+HapSatLinkTestCase::RunLink(HapSatLinkHelper& helper, uint32_t nPackets)
+{
+    m_received = 0;
+    m_lastRx = Seconds(0);
+
+    NodeContainer nodes;
+    nodes.Create(2);
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        Ptr<ConstantPositionMobilityModel> mobility =
+            CreateObject<ConstantPositionMobilityModel>();
+        mobility->SetPosition(Vector(0, 0, i * 35786000.0));
+        nodes.Get(i)->AggregateObject(mobility);
+    }
+    NetDeviceContainer devices = helper.Install(nodes.Get(0), nodes.Get(1));
+    HapSatLinkHelper::AssignStreams(devices, 1);
+    devices.Get(1)->SetReceiveCallback(MakeCallback(&HapSatLinkTestCase::Receive, this));
+    for (uint32_t i = 0; i < nPackets; ++i)
+    {
+        devices.Get(0)->Send(Create<Packet>(1000), devices.Get(1)->GetAddress(), 0x0800);
+    }
+    Simulator::Run();
+    return DynamicCast<HapSatLinkNetDevice>(devices.Get(0));
+}
+
+void
+HapSatLinkTestCase::DoRun()
+{
+    // 1000 bytes at 8 Mbps: 1 ms per frame, then 35786 km at the speed of light
+    double lastRx = 0.010 + 35786000.0 / 299792458.0;
+    HapSatLinkHelper helper;
+    helper.SetDeviceAttribute("DataRate", DataRateValue(DataRate("8Mbps")));
+
+    Ptr<HapSatLinkNetDevice> device = RunLink(helper, 10);
+    NS_TEST_ASSERT_MSG_EQ(m_received, 10, "Frames lost on a clear link");
+    NS_TEST_ASSERT_MSG_EQ(device->GetNBursts(), 10, "One burst per frame");
+    NS_TEST_ASSERT_MSG_EQ_TOL(m_lastRx.GetSeconds(), lastRx, 1e-9, "Wrong arrival time");
+
+    // Frame error rate from the link budget: Eb/N0 is the received power
+    // + 147.6 dB at 8 Mbps, 500 K and 45 dBi
+    NS_TEST_ASSERT_MSG_LT(device->GetFrameErrorRate(-130, 1000), 1e-6, "17.6 dB of Eb/N0");
+    NS_TEST_ASSERT_MSG_GT(device->GetFrameErrorRate(-150, 1000), 0.999, "-2.4 dB of Eb/N0");
+    Simulator::Destroy();
+
+    // The first frame leaves alone, the other nine in bursts of 4, 4 and 1
+    helper.SetDeviceAttribute("MaxBatchSize", UintegerValue(4));
+    device = RunLink(helper, 10);
+    NS_TEST_ASSERT_MSG_EQ(m_received, 10, "Frames lost in bursts");
+    NS_TEST_ASSERT_MSG_EQ(device->GetNBursts(), 4, "Frames not batched");
+    NS_TEST_ASSERT_MSG_EQ_TOL(m_lastRx.GetSeconds(), lastRx, 1e-9, "Batching changed the capacity");
+    Simulator::Destroy();
+
+    // One frame on the air, five in the queue, the rest dropped
+    helper.SetDeviceAttribute("MaxBatchSize", UintegerValue(1));
+    helper.SetDeviceAttribute("QueueSize", QueueSizeValue(QueueSize("5p")));
+    RunLink(helper, 10);
+    NS_TEST_ASSERT_MSG_EQ(m_received, 6, "Queue limit not applied");
+    Simulator::Destroy();
+
+    // Without transmit power the link is below the noise
+    helper.SetDeviceAttribute("TxPower", DoubleValue(0));
+    RunLink(helper, 10);
+    NS_TEST_ASSERT_MSG_EQ(m_received, 0, "Frames received below the noise");
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Deterministic loss cached on static pairs and invalidated on course changes
+ */
+class HapCachedPropagationLossModelTestCase : public TestCase
+{
+  public:
+    HapCachedPropagationLossModelTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapCachedPropagationLossModelTestCase::HapCachedPropagationLossModelTestCase()
+    : TestCase("Cached loss equals the wrapped model and follows position changes")
+{
+}
+
+void
+HapCachedPropagationLossModelTestCase::DoRun()
+{
+    Ptr<LogDistancePropagationLossModel> logDistance =
+        CreateObject<LogDistancePropagationLossModel>();
+    Ptr<HapCachedPropagationLossModel> cached = CreateObject<HapCachedPropagationLossModel>();
+    cached->SetAttribute("Model", PointerValue(logDistance));
+
+    Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel>();
+    a->SetPosition(Vector(0, 0, 20000));
+    b->SetPosition(Vector(2500, 0, 0));
+
+    double expected = logDistance->CalcRxPower(20, a, b);
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        NS_TEST_ASSERT_MSG_EQ_TOL(cached->CalcRxPower(20, a, b), expected, 1e-9, "Wrong loss");
+    }
+    NS_TEST_ASSERT_MSG_EQ(cached->GetNMisses(), 1, "Loss computed more than once");
+    NS_TEST_ASSERT_MSG_EQ(cached->GetNHits(), 2, "Loss not cached");
+
+    // Another transmit power and the reverse direction are distinct entries
+    NS_TEST_ASSERT_MSG_EQ_TOL(cached->CalcRxPower(10, a, b), expected - 10, 1e-9, "Power");
+    NS_TEST_ASSERT_MSG_EQ_TOL(cached->CalcRxPower(20, b, a), expected, 1e-9, "Reverse pair");
+    NS_TEST_ASSERT_MSG_EQ(cached->GetNMisses(), 3, "Wrong misses");
+
+    // Moving a terminal invalidates its pairs
+    b->SetPosition(Vector(5000, 0, 0));
+    expected = logDistance->CalcRxPower(10, a, b);
+    NS_TEST_ASSERT_MSG_EQ_TOL(cached->CalcRxPower(10, a, b), expected, 1e-9, "Stale loss");
+    NS_TEST_ASSERT_MSG_EQ(cached->GetNMisses(), 4, "Course change ignored");
+
+    // Pairs with a moving node are never cached
+    Ptr<ConstantVelocityMobilityModel> hap = CreateObject<ConstantVelocityMobilityModel>();
+    hap->SetPosition(Vector(0, 0, 20000));
+    hap->SetVelocity(Vector(10, 0, 0));
+    cached->CalcRxPower(20, hap, b);
+    cached->CalcRxPower(20, hap, b);
+    NS_TEST_ASSERT_MSG_EQ(cached->GetNMisses(), 6, "Moving node cached");
+    NS_TEST_ASSERT_MSG_EQ(cached->GetNHits(), 2, "Moving node cached");
+
+    cached->Dispose();
+    b->SetPosition(Vector(0, 0, 0)); // no callback into the disposed model
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Rate selection from the SNR predicted by the link geometry
+ */
+class HapGeometryRateManagerTestCase : public TestCase
+{
+  public:
+    HapGeometryRateManagerTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapGeometryRateManagerTestCase::HapGeometryRateManagerTestCase()
+    : TestCase("Geometry rate manager predicts the link budget and steps with hysteresis")
+{
+}
+
+void
+HapGeometryRateManagerTestCase::DoRun()
+{
+    std::vector<double> thresholds{2, 5, 9, 15};
+    NS_TEST_ASSERT_MSG_EQ(HapGeometryRateManager::SelectMode(thresholds, 0, 10, 2), 1, "Step up");
+    NS_TEST_ASSERT_MSG_EQ(HapGeometryRateManager::SelectMode(thresholds, 2, 10, 2),
+                          2,
+                          "Hysteresis must keep the current mode");
+    NS_TEST_ASSERT_MSG_EQ(HapGeometryRateManager::SelectMode(thresholds, 2, 8, 2), 1, "Step down");
+    NS_TEST_ASSERT_MSG_EQ(HapGeometryRateManager::SelectMode(thresholds, 3, -5, 2), 0, "Floor");
+    NS_TEST_ASSERT_MSG_EQ(HapGeometryRateManager::SelectMode({}, 3, 30, 2), 0, "No modes");
+
+    Ptr<LogDistancePropagationLossModel> logDistance =
+        CreateObject<LogDistancePropagationLossModel>();
+    NodeContainer nodes;
+    nodes.Create(2);
+    Ptr<ConstantPositionMobilityModel> hap = CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> ground = CreateObject<ConstantPositionMobilityModel>();
+    hap->SetPosition(Vector(0, 0, 20000));
+    ground->SetPosition(Vector(5000, 0, 0));
+    nodes.Get(0)->AggregateObject(hap);
+    nodes.Get(1)->AggregateObject(ground);
+
+    WifiHelper wifi;
+    wifi.SetStandard(WIFI_STANDARD_80211a);
+    wifi.SetRemoteStationManager("ns3::HapGeometryRateManager",
+                                 "LossModel",
+                                 PointerValue(logDistance));
+    YansWifiPhyHelper phy;
+    phy.SetChannel(YansWifiChannelHelper::Default().Create());
+    phy.Set("TxPowerStart", DoubleValue(30));
+    phy.Set("TxPowerEnd", DoubleValue(30));
+    WifiMacHelper mac;
+    mac.SetType("ns3::AdhocWifiMac");
+    NetDeviceContainer devices = wifi.Install(phy, mac, nodes);
+    HapGeometryRateManager::AddPeers(devices);
+
+    Ptr<WifiNetDevice> hapDevice = DynamicCast<WifiNetDevice>(devices.Get(0));
+    Ptr<WifiNetDevice> groundDevice = DynamicCast<WifiNetDevice>(devices.Get(1));
+    Ptr<HapGeometryRateManager> manager =
+        DynamicCast<HapGeometryRateManager>(hapDevice->GetRemoteStationManager());
+    NS_TEST_ASSERT_MSG_NE(manager, nullptr, "Manager not installed");
+    Mac48Address groundAddress = Mac48Address::ConvertFrom(groundDevice->GetAddress());
+
+    // 20 MHz of thermal noise and the default 7 dB noise figure
+    double noiseDbm = -174 + 10 * std::log10(20e6) + 7;
+    double expected = logDistance->CalcRxPower(30, hap, ground) - noiseDbm;
+    NS_TEST_ASSERT_MSG_EQ_TOL(manager->PredictSnr(groundAddress), expected, 1e-9, "Link budget");
+
+    // The steered antenna gains enter the prediction
+    hapDevice->GetPhy()->SetTxGain(10);
+    groundDevice->GetPhy()->SetRxGain(5);
+    NS_TEST_ASSERT_MSG_EQ_TOL(manager->PredictSnr(groundAddress),
+                              expected + 15,
+                              1e-9,
+                              "Antenna gains ignored");
+    NS_TEST_ASSERT_MSG_EQ(manager->PredictSnr(Mac48Address("00:00:00:00:00:42")),
+                          0,
+                          "Unknown peer");
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Forwarding tables switched at the ranking epochs of a contact plan
+ */
+class HapScheduledRoutingTestCase : public TestCase
+{
+  public:
+    HapScheduledRoutingTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Record the next hop of the current route towards 10.9.1.1
+     * \param routing the protocol
+     */
+    void Probe(Ptr<HapScheduledRouting> routing);
+
+    std::vector<Ipv4Address> m_gateways; //!< next hops, 0.0.0.0 without route
+};
+
+HapScheduledRoutingTestCase::HapScheduledRoutingTestCase()
+    : TestCase("Scheduled routing follows the best ranked orbiter of the contact plan")
+{
+}
+
+void
+HapScheduledRoutingTestCase::Probe(Ptr<HapScheduledRouting> routing)
+{
+    Ipv4Header header;
+    header.SetDestination(Ipv4Address("10.9.1.1"));
+    Socket::SocketErrno error;
+    Ptr<Ipv4Route> route = routing->RouteOutput(nullptr, header, nullptr, error);
+    m_gateways.push_back(route ? route->GetGateway() : Ipv4Address());
+}
+
+void
+HapScheduledRoutingTestCase::DoRun()
+{
+    // HAP (node 0) with one link to each of two orbiters
+    NodeContainer nodes;
+    nodes.Create(3);
+    SimpleNetDeviceHelper devices;
+    Ipv4ListRoutingHelper list;
+    list.Add(HapScheduledRoutingHelper(), 10);
+    list.Add(Ipv4StaticRoutingHelper(), 0);
+    InternetStackHelper internet;
+    internet.SetRoutingHelper(list);
+    internet.Install(nodes);
+    Ipv4AddressHelper addresses("10.0.1.0", "255.255.255.0");
+    addresses.Assign(devices.Install(NodeContainer(nodes.Get(0), nodes.Get(1))));
+    addresses.SetBase("10.0.2.0", "255.255.255.0");
+    addresses.Assign(devices.Install(NodeContainer(nodes.Get(0), nodes.Get(2))));
+
+    Ptr<HapContactPlan> plan = CreateObject<HapContactPlan>();
+    plan->Reset(2, 2, Seconds(0), Seconds(1), Seconds(60));
+    uint32_t observer = plan->AddObserver(nodes.Get(0)->GetId(), HapContactPlan::ROLE_HAP);
+    plan->AddRankingEpoch(observer, Seconds(0), {0, 1});
+    plan->AddRankingEpoch(observer, Seconds(10), {1, 0});
+    plan->AddRankingEpoch(observer, Seconds(20), {1});
+    plan->AddRankingEpoch(observer, Seconds(30), {0});
+    plan->AddRankingEpoch(observer, Seconds(40), {});
+    plan->AddRankingEpoch(observer, Seconds(50), {1});
+
+    Ptr<HapScheduledRouting> routing =
+        HapScheduledRoutingHelper::GetScheduledRouting(nodes.Get(0)->GetObject<Ipv4>());
+    NS_TEST_ASSERT_MSG_NE(routing, nullptr, "Protocol not installed");
+    std::map<uint32_t, HapScheduledRouting::NextHop> nextHops;
+    nextHops[0] = {Ipv4Address("10.0.1.2"), 1};
+    nextHops[1] = {Ipv4Address("10.0.2.2"), 2};
+    routing->AddContactPlanRoutes(plan,
+                                  nodes.Get(0)->GetId(),
+                                  Ipv4Address("10.9.0.0"),
+                                  Ipv4Mask("255.255.0.0"),
+                                  nextHops);
+
+    for (double t : {5.0, 15.0, 25.0, 35.0, 45.0, 55.0, 65.0})
+    {
+        Simulator::Schedule(Seconds(t), &HapScheduledRoutingTestCase::Probe, this, routing);
+    }
+    Simulator::Run();
+
+    std::vector<Ipv4Address> expected{Ipv4Address("10.0.1.2"),
+                                      Ipv4Address("10.0.2.2"),
+                                      Ipv4Address("10.0.2.2"),
+                                      Ipv4Address("10.0.1.2"),
+                                      Ipv4Address(),
+                                      Ipv4Address("10.0.2.2"),
+                                      Ipv4Address()};
+    NS_TEST_ASSERT_MSG_EQ(m_gateways.size(), expected.size(), "Missing probes");
+    for (std::size_t i = 0; i < expected.size(); ++i)
+    {
+        NS_TEST_ASSERT_MSG_EQ(m_gateways[i], expected[i], "Wrong next hop in probe " << i);
+    }
+    // Both orbiter routes and the empty table; the epoch at 20 s needs no
+    // switch, the end of the plan at 60 s does
+    NS_TEST_ASSERT_MSG_EQ(routing->GetNTables(), 3, "Tables must be shared between epochs");
+    NS_TEST_ASSERT_MSG_EQ(routing->GetNSwitches(), 5, "One switch per route change");
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Incremental shortest-path trees against a full recomputation
+ */
+class HapIslShortestPathsTestCase : public TestCase
+{
+  public:
+    HapIslShortestPathsTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapIslShortestPathsTestCase::HapIslShortestPathsTestCase()
+    : TestCase("ISL shortest paths follow link changes like a full recomputation")
+{
+}
+
+void
+HapIslShortestPathsTestCase::DoRun()
+{
+    // Two planes of six orbiters (0-11) and a gateway (12) seen by orbiter 0
+    const double down = std::numeric_limits<double>::infinity();
+    std::vector<HapIslShortestPaths::Link> links;
+    for (uint32_t plane = 0; plane < 2; ++plane)
+    {
+        for (uint32_t slot = 0; slot < 6; ++slot)
+        {
+            links.push_back({plane * 6 + slot, plane * 6 + (slot + 1) % 6, 1.0});
+        }
+    }
+    for (uint32_t slot = 0; slot < 6; ++slot)
+    {
+        links.push_back({slot, 6 + slot, 2.0});
+        links.push_back({12, slot, slot == 0 ? 0.5 : down});
+    }
+
+    HapIslShortestPaths paths;
+    HapIslShortestPaths reference;
+    paths.SetTopology(13, links);
+    reference.SetTopology(13, links);
+    paths.AddDestination(12);
+    reference.AddDestination(12);
+    NS_TEST_ASSERT_MSG_EQ_TOL(paths.GetDistance(9, 12), 5.5, 1e-9, "3 + 2 + 0.5");
+    NS_TEST_ASSERT_MSG_EQ(paths.GetNextHop(0, 12), 12, "Orbiter 0 is the feeder");
+    NS_TEST_ASSERT_MSG_EQ(paths.GetNextHop(12, 12), HapIslShortestPaths::NO_NODE, "Root");
+
+    // Handover of the feeder link from orbiter 0 to orbiter 3, then an ISL cut
+    std::vector<HapIslShortestPaths::Link> changes{{12, 3, 0.5}, {12, 0, down}, {3, 4, down}};
+    for (const HapIslShortestPaths::Link& change : changes)
+    {
+        paths.SetLinkWeight(change.a, change.b, change.weight);
+        reference.SetLinkWeight(change.a, change.b, change.weight);
+        reference.Recompute();
+        for (uint32_t node = 0; node < 13; ++node)
+        {
+            double distance = paths.GetDistance(node, 12);
+            NS_TEST_ASSERT_MSG_EQ_TOL(distance,
+                                      reference.GetDistance(node, 12),
+                                      1e-9,
+                                      "Node " << node << " after " << change.a << "-"
+                                              << change.b);
+            uint32_t next = paths.GetNextHop(node, 12);
+            if (node != 12)
+            {
+                NS_TEST_ASSERT_MSG_EQ_TOL(paths.GetLinkWeight(node, next) +
+                                              paths.GetDistance(next, 12),
+                                          distance,
+                                          1e-9,
+                                          "Next hop of " << node << " not on a shortest path");
+            }
+        }
+    }
+    NS_TEST_ASSERT_MSG_EQ_TOL(paths.GetDistance(4, 12), 5.5, 1e-9, "Around the cut ISL");
+    NS_TEST_ASSERT_MSG_LT(paths.GetNSettled(),
+                          reference.GetNSettled(),
+                          "Updates must settle fewer nodes than rebuilds");
+
+    // Unreachable once the last feeder link is down
+    paths.SetLinkWeight(12, 3, down);
+    NS_TEST_ASSERT_MSG_EQ(std::isinf(paths.GetDistance(7, 12)), true, "Gateway unreachable");
+    NS_TEST_ASSERT_MSG_EQ(paths.GetNextHop(7, 12), HapIslShortestPaths::NO_NODE, "No next hop");
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * UT to gateway index built from the default routes and moved by handovers
+ */
+class HapGatewayAssociationIndexTestCase : public TestCase
+{
+  public:
+    HapGatewayAssociationIndexTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Association sink.
+     * \param utNodeId node id of the UT
+     * \param oldGateway previous gateway index
+     * \param newGateway new gateway index
+     */
+    void Association(uint32_t utNodeId, uint32_t oldGateway, uint32_t newGateway);
+
+    uint32_t m_nAssociations; //!< association changes reported
+};
+
+HapGatewayAssociationIndexTestCase::HapGatewayAssociationIndexTestCase()
+    : TestCase("Gateway association index follows default routes and handovers"),
+      m_nAssociations(0)
+{
+}
+
+void
+HapGatewayAssociationIndexTestCase::Association(uint32_t utNodeId,
+                                                uint32_t oldGateway,
+                                                uint32_t newGateway)
+{
+    ++m_nAssociations;
+}
+
+void
+HapGatewayAssociationIndexTestCase::DoRun()
+{
+    // Gateway 0 with UTs 0 and 1, gateway 1 with UTs 2 and 3; UT 3 has no default route
+    NodeContainer gateways;
+    gateways.Create(2);
+    NodeContainer uts;
+    uts.Create(4);
+    InternetStackHelper internet;
+    internet.Install(gateways);
+    internet.Install(uts);
+    SimpleNetDeviceHelper devices;
+    Ipv4AddressHelper addresses("10.1.1.0", "255.255.255.0");
+    addresses.Assign(devices.Install(NodeContainer(gateways.Get(0), uts.Get(0), uts.Get(1))));
+    addresses.SetBase("10.1.2.0", "255.255.255.0");
+    addresses.Assign(devices.Install(NodeContainer(gateways.Get(1), uts.Get(2), uts.Get(3))));
+    Ipv4StaticRoutingHelper routingHelper;
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        Ptr<Ipv4StaticRouting> routing =
+            routingHelper.GetStaticRouting(uts.Get(i)->GetObject<Ipv4>());
+        routing->SetDefaultRoute(Ipv4Address(i < 2 ? "10.1.1.1" : "10.1.2.1"), 1);
+    }
+
+    Ptr<HapGatewayAssociationIndex> index = CreateObject<HapGatewayAssociationIndex>();
+    index->TraceConnectWithoutContext(
+        "Association",
+        MakeCallback(&HapGatewayAssociationIndexTestCase::Association, this));
+    index->Build(uts, gateways);
+    NS_TEST_ASSERT_MSG_EQ(index->GetNGateways(), 2, "Two gateways");
+    NS_TEST_ASSERT_MSG_EQ(index->GetGateway(uts.Get(1)->GetId()), 0, "UT 1 behind gateway 0");
+    NS_TEST_ASSERT_MSG_EQ(index->GetGateway(uts.Get(2)->GetId()), 1, "UT 2 behind gateway 1");
+    NS_TEST_ASSERT_MSG_EQ(index->GetGateway(uts.Get(3)->GetId()),
+                          HapGatewayAssociationIndex::NO_GATEWAY,
+                          "UT 3 has no default route");
+    NS_TEST_ASSERT_MSG_EQ(index->GetUts(0).size(), 2, "UTs of gateway 0");
+    NS_TEST_ASSERT_MSG_EQ(index->GetUts(1).size(), 1, "UTs of gateway 1");
+    NS_TEST_ASSERT_MSG_EQ(index->GetNUnassociated(), 1, "UT 3");
+    NS_TEST_ASSERT_MSG_EQ(index->GetGatewayIndex(gateways.Get(1)->GetId()), 1, "Gateway index");
+    NS_TEST_ASSERT_MSG_EQ(m_nAssociations, 0, "Build reports no change");
+
+    // Handover of UT 0 to gateway 1, then of UT 1 by its new default route
+    index->Associate(uts.Get(0)->GetId(), 1);
+    index->Associate(uts.Get(0)->GetId(), 1);
+    Ptr<Ipv4StaticRouting> routing = routingHelper.GetStaticRouting(uts.Get(1)->GetObject<Ipv4>());
+    for (uint32_t j = 0; j < routing->GetNRoutes(); ++j)
+    {
+        if (routing->GetRoute(j).IsDefault())
+        {
+            routing->RemoveRoute(j);
+            break;
+        }
+    }
+    routing->SetDefaultRoute(Ipv4Address("10.1.2.1"), 1);
+    index->Refresh(uts.Get(1)->GetId());
+    NS_TEST_ASSERT_MSG_EQ(index->GetUts(0).empty(), true, "Gateway 0 left without UTs");
+    NS_TEST_ASSERT_MSG_EQ(index->GetUts(1).size(), 3, "UTs of gateway 1");
+    NS_TEST_ASSERT_MSG_EQ(m_nAssociations, 2, "One report per change");
+
+    index->Associate(uts.Get(2)->GetId(), HapGatewayAssociationIndex::NO_GATEWAY);
+    NS_TEST_ASSERT_MSG_EQ(index->GetNUnassociated(), 2, "UT 2 detached");
+    for (uint32_t ut : index->GetUts(1))
+    {
+        NS_TEST_ASSERT_MSG_EQ(index->GetGateway(ut), 1, "Lists and lookups must agree");
+    }
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * Scenario read from a folder and from a .tsk container
+ */
+class HapScenarioSourceTestCase : public TestCase
+{
+  public:
+    HapScenarioSourceTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+HapScenarioSourceTestCase::HapScenarioSourceTestCase()
+    : TestCase("Scenario container and binary gain grids give the same beam set")
+{
+}
+
+void
+HapScenarioSourceTestCase::DoRun()
+{
+    std::string scenario = CreateTempDirFilename("tsk-scenario");
+    SystemPath::MakeDirectories(SystemPath::Append(scenario, "positions"));
+    SystemPath::MakeDirectories(SystemPath::Append(scenario, "beams"));
+    SystemPath::MakeDirectories(SystemPath::Append(scenario, "antennapatterns"));
+    std::ofstream(SystemPath::Append(scenario, "positions/gw_positions.txt"))
+        << "10.0 10.0 0.0\n20.0 20.0 0.0\n";
+    std::ofstream(SystemPath::Append(scenario, "positions/ut_positions.txt")) << "11.0 19.0 0.0\n";
+    std::ofstream(SystemPath::Append(scenario, "beams/fwdConf.txt"))
+        << "1 1 1 1\n2 2 1 2\n3 1 2 1\n";
+    for (uint32_t beam = 1; beam <= 3; ++beam)
+    {
+        std::ofstream pattern(
+            SystemPath::Append(scenario,
+                               "antennapatterns/Gain_" + std::to_string(beam) + ".txt"));
+        for (uint32_t row = 0; row < 3; ++row)
+        {
+            for (uint32_t col = 0; col < 3; ++col)
+            {
+                pattern << 10 + 5 * row << " " << 10 + 5 * col << " "
+                        << (col == beam - 1 ? 30.0 : 0.0) << "\n";
+            }
+        }
+    }
+    NS_TEST_ASSERT_MSG_EQ(HapBeamSetHelper::WriteBinaryPatterns(scenario), 3, "One grid per beam");
+    std::string archive = CreateTempDirFilename("scenario.tsk");
+    HapScenarioSource::WriteArchive(scenario, archive);
+
+    HapScenarioSource source;
+    source.Open(archive);
+    NS_TEST_ASSERT_MSG_EQ(source.IsArchive(), true, "Container not recognized");
+    NS_TEST_ASSERT_MSG_EQ(source.ReadFile("beams/fwdConf.txt"),
+                          "1 1 1 1\n2 2 1 2\n3 1 2 1\n",
+                          "Stored entry differs from the file");
+    NS_TEST_ASSERT_MSG_EQ(source.HasFile("binarypatterns/Gain_2.bin"), true, "Binary grid missing");
+    NS_TEST_ASSERT_MSG_EQ(source.ListFiles("antennapatterns").size(), 3, "Text grids");
+    NS_TEST_ASSERT_MSG_EQ(source.ListFiles("").empty(), true, "No file at the root");
+
+    // Same beam set as HapBeamSetHelperTestCase, from the binary grids of the container
+    for (const std::string& path : {scenario, archive})
+    {
+        HapBeamSetHelper helper;
+        helper.LoadScenario(path);
+        helper.AddUserPosition(15.0, 14.0);
+        helper.AddUserPosition(-30.0, 0.0);
+        std::set<uint32_t> beams = helper.GetBeamSet();
+        NS_TEST_ASSERT_MSG_EQ(beams.size(), 2, "Wrong beam set size from " << path);
+        NS_TEST_ASSERT_MSG_EQ(beams.count(2), 1, "Beam of the HAP position missing");
+        NS_TEST_ASSERT_MSG_EQ(beams.count(3), 1, "Beam of the UT position missing");
+        NS_TEST_ASSERT_MSG_EQ(helper.GetNUncoveredPositions(), 1, "Position outside the grid");
+    }
+
+    // An edited text grid replaces its stale binary grid: beam 1 now wins everywhere
+    {
+        std::ofstream pattern(SystemPath::Append(scenario, "antennapatterns/Gain_1.txt"));
+        for (uint32_t row = 0; row < 3; ++row)
+        {
+            for (uint32_t col = 0; col < 3; ++col)
+            {
+                pattern << 10 + 5 * row << " " << 10 + 5 * col << " 40.0\n";
+            }
+        }
+    }
+    HapBeamSetHelper edited;
+    edited.LoadScenario(scenario);
+    edited.AddUserPosition(15.0, 14.0);
+    std::set<uint32_t> beams = edited.GetBeamSet();
+    NS_TEST_ASSERT_MSG_EQ(beams.count(1), 1, "Stale binary grid used");
+    NS_TEST_ASSERT_MSG_EQ(beams.count(2), 0, "Stale binary grid used");
+
+    // Extracted once, then shared
+    std::string cache = CreateTempDirFilename("scenario-cache");
+    std::string folder = source.GetDirectory(cache);
+    NS_TEST_ASSERT_MSG_EQ(source.GetDirectory(cache), folder, "Container extracted twice");
+    std::string positions = SystemPath::Append(folder, "positions");
+    NS_TEST_ASSERT_MSG_EQ(SystemPath::Exists(SystemPath::Append(positions, "gw_positions.txt")),
+                          true,
+                          "Extracted scenario incomplete");
+    NS_TEST_ASSERT_MSG_EQ(
+        HapScenarioSource::GetRelativePath(SystemPath::Append(folder, "beams"), positions),
+        "../positions",
+        "Wrong relative path");
+}
+
+/**
+ * \ingroup sibgu-hap-tests
+ * CBR sources send on time, in their node context, one event per node instant
+ */
+class HapCbrSourceTestCase : public TestCase
+{
+  public:
+    HapCbrSourceTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Tx sink.
+     * \param context source index
+     * \param packet packet sent
+     */
+    void Tx(std::string context, Ptr<const Packet> packet);
+
+    /**
+     * Run sources from two nodes.
+     * \param granularity Granularity of the send timer
+     * \param start start time of the sources
+     * \param nEvents filled with the number of timer events
+     */
+    void RunSources(Time granularity, Time start, uint64_t& nEvents);
+
+    std::vector<std::vector<Time>> m_sends;        //!< send instants per source
+    std::vector<std::vector<uint32_t>> m_contexts; //!< event context of the sends per source
+};
+
+HapCbrSourceTestCase::HapCbrSourceTestCase()
+    : TestCase("CBR sources share one event per node and send instant")
+{
+}
+
+void
+HapCbrSourceTestCase::Tx(std::string context, Ptr<const Packet> packet)
+{
+    uint32_t source = std::stoul(context);
+    m_sends[source].push_back(Simulator::Now());
+    m_contexts[source].push_back(Simulator::GetContext());
+}
+
+void
+HapCbrSourceTestCase::RunSources(Time granularity, Time start, uint64_t& nEvents)
+{
+    NodeContainer nodes;
+    nodes.Create(2);
+    SimpleNetDeviceHelper devices;
+    InternetStackHelper internet;
+    internet.Install(nodes);
+    Ipv4AddressHelper addresses("10.1.1.0", "255.255.255.0");
+    Ipv4InterfaceContainer interfaces = addresses.Assign(devices.Install(nodes));
+
+    Ptr<HapCbrTimer> timer = CreateObject<HapCbrTimer>();
+    timer->SetAttribute("Granularity", TimeValue(granularity));
+
+    // Sources 0 and 1 are in phase on node 0, source 2 shares their first
+    // instant, source 3 runs on node 1
+    std::vector<std::pair<uint32_t, Time>> sources{{0, MilliSeconds(10)},
+                                                   {0, MilliSeconds(10)},
+                                                   {0, MilliSeconds(25)},
+                                                   {1, MilliSeconds(20)}};
+    m_sends.assign(sources.size(), {});
+    m_contexts.assign(sources.size(), {});
+    for (uint32_t i = 0; i < sources.size(); ++i)
+    {
+        uint32_t node = sources[i].first;
+        Ptr<HapCbrSource> source = CreateObject<HapCbrSource>();
+        source->SetAttribute(
+            "Remote",
+            AddressValue(InetSocketAddress(interfaces.GetAddress(1 - node), 9)));
+        source->SetAttribute("Interval", TimeValue(sources[i].second));
+        source->SetAttribute("MaxPackets", UintegerValue(5));
+        source->SetTimer(timer);
+        source->SetStartTime(start);
+        source->TraceConnect("Tx",
+                             std::to_string(i),
+                             MakeCallback(&HapCbrSourceTestCase::Tx, this));
+        nodes.Get(node)->AddApplication(source);
+    }
+
+    Simulator::Run();
+    nEvents = timer->GetNEvents();
+    Simulator::Destroy();
+}
+
+void
+HapCbrSourceTestCase::DoRun()
+{
+    std::vector<Time> intervals{MilliSeconds(10),
+                                MilliSeconds(10),
+                                MilliSeconds(25),
+                                MilliSeconds(20)};
+    std::vector<uint32_t> nodes{0, 0, 0, 1};
+
+    uint64_t nEvents = 0;
+    RunSources(Seconds(0), Seconds(1), nEvents);
+    for (uint32_t i = 0; i < intervals.size(); ++i)
+    {
+        NS_TEST_ASSERT_MSG_EQ(m_sends[i].size(), 5, "MaxPackets packets per source");
+        for (uint32_t k = 0; k < m_sends[i].size(); ++k)
+        {
+            NS_TEST_ASSERT_MSG_EQ(m_sends[i][k], Seconds(1) + intervals[i] * k, "Wrong send time");
+            NS_TEST_ASSERT_MSG_EQ(m_contexts[i][k], nodes[i], "Send outside the node context");
+        }
+    }
+    // Node 0: 5 instants of sources 0 and 1, 4 more of source 2; node 1: 5
+    NS_TEST_ASSERT_MSG_EQ(nEvents, 14, "One event per node and send instant");
+
+    // A 10 ms tick delays the packets to the end of their tick, never earlier
+    RunSources(MilliSeconds(10), MilliSeconds(1003), nEvents);
+    for (uint32_t i = 0; i < intervals.size(); ++i)
+    {
+        NS_TEST_ASSERT_MSG_EQ(m_sends[i].size(), 5, "MaxPackets packets per source");
+        for (uint32_t k = 0; k < m_sends[i].size(); ++k)
+        {
+            Time due = MilliSeconds(1003) + intervals[i] * k;
+            NS_TEST_ASSERT_MSG_EQ((m_sends[i][k] >= due && m_sends[i][k] < due + MilliSeconds(10)),
+                                  true,
+                                  "Send outside the tick of its due time");
+            NS_TEST_ASSERT_MSG_EQ(m_sends[i][k].GetTimeStep() % MilliSeconds(10).GetTimeStep(),
+                                  0,
+                                  "Send off the tick grid");
+        }
+    }
+    // Node 0: ticks 1010 to 1050 of sources 0 and 1, then 1060, 1080 and
+    // 1110 of source 2; node 1: 1010, 1030, 1050, 1070 and 1090
+    NS_TEST_ASSERT_MSG_EQ(nEvents, 13, "One event per node and tick");
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -76,6 +2149,31 @@ SibguHapTestSuite::SibguHapTestSuite()
 {
     // Duration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
     AddTestCase(new SibguHapTestCase1, TestCase::Duration::QUICK);
+    AddTestCase(new HapContactPlanTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapKdTreeTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapHandoverSchedulerTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapBeamSetHelperTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapLazyBeamManagerTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapPayloadPoolTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapTraceReaderTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapTrafficMatrixTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapScatterFileTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapWindowAggregatorTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapTelemetryPublisherTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapKernelsTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapAnimationRecorderTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapWifiRangeHelperTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapWifiAggregationHelperTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapRangeTransmitFilterTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapSatLinkTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapCachedPropagationLossModelTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapGeometryRateManagerTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapScheduledRoutingTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapIslShortestPathsTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapGatewayAssociationIndexTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapScenarioSourceTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapNearestOrbiterIndexTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new HapCbrSourceTestCase, TestCase::Duration::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite